@@ -0,0 +1,175 @@
+#include "Benchmark.h"
+#include "Lights.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	void WriteStats(std::ostringstream& out, const BenchmarkStats& s)
+	{
+		out << "{\"mean\":" << s.Mean << ",\"min\":" << s.Min << ",\"max\":" << s.Max
+			<< ",\"p50\":" << s.P50 << ",\"p95\":" << s.P95 << ",\"p99\":" << s.P99 << "}";
+	}
+
+	// Report names for each render stat, in report order
+	const std::pair<const char*, unsigned long long RenderStatsFrame::*> renderStatNames[] =
+	{
+		{ "drawCalls", &RenderStatsFrame::DrawCalls },
+		{ "triangles", &RenderStatsFrame::Triangles },
+		{ "shaderSets", &RenderStatsFrame::ShaderSets },
+		{ "srvBinds", &RenderStatsFrame::ShaderResourceBinds },
+		{ "samplerBinds", &RenderStatsFrame::SamplerBinds },
+		{ "constantBufferBytes", &RenderStatsFrame::ConstantBufferBytes },
+		{ "materialBinds", &RenderStatsFrame::MaterialBinds },
+		{ "resourcesCreated", &RenderStatsFrame::ResourcesCreated },
+	};
+}
+
+BenchmarkSettings Benchmark::ParseCommandLine(const std::string& commandLine)
+{
+	BenchmarkSettings settings;
+	std::istringstream args(commandLine);
+	std::string arg;
+	while (args >> arg)
+	{
+		if (arg == "-benchmark") settings.Enabled = true;
+		else if (arg == "-warp") settings.Warp = true;
+		else if (arg == "-nosubmit") settings.NoSubmit = true;
+		else if (arg == "-entities") args >> settings.Entities;
+		else if (arg == "-lights") args >> settings.Lights;
+		else if (arg == "-materials") args >> settings.Materials;
+		else if (arg == "-frames") args >> settings.Frames;
+		else if (arg == "-warmup") args >> settings.WarmupFrames;
+		else if (arg == "-timestep") args >> settings.TimeStep;
+		else if (arg == "-seed") args >> settings.Seed;
+		else if (arg == "-output") args >> settings.Output;
+	}
+
+	// There's always at least one of everything, and the shader
+	// has room for a fixed number of lights
+	settings.Entities = std::max(settings.Entities, 1u);
+	settings.Lights = std::min(std::max(settings.Lights, 1u), (unsigned int)MAX_LIGHTS);
+	settings.Materials = std::max(settings.Materials, 1u);
+	settings.Frames = std::max(settings.Frames, 1u);
+	if (settings.TimeStep <= 0.0f)
+		settings.TimeStep = 1.0f / 60.0f;
+	return settings;
+}
+
+BenchmarkStats Benchmark::Summarize(std::vector<double> samples)
+{
+	BenchmarkStats stats = {};
+	if (samples.empty())
+		return stats;
+
+	std::sort(samples.begin(), samples.end());
+	double total = 0.0;
+	for (double s : samples)
+		total += s;
+
+	auto percentile = [&](double p)
+		{
+			size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+			return samples[rank > 0 ? rank - 1 : 0];
+		};
+
+	stats.Mean = total / samples.size();
+	stats.Min = samples.front();
+	stats.Max = samples.back();
+	stats.P50 = percentile(50.0);
+	stats.P95 = percentile(95.0);
+	stats.P99 = percentile(99.0);
+	return stats;
+}
+
+Benchmark::Benchmark(const BenchmarkSettings& settings) :
+	settings(settings),
+	framesSeen(0)
+{
+}
+
+void Benchmark::RecordFrame(const ProfileFrame& frame, unsigned int thread, const RenderStatsFrame& stats)
+{
+	framesSeen++;
+	if (framesSeen <= settings.WarmupFrames || IsFinished())
+		return;
+
+	std::map<std::string, double> stages;
+	for (auto& e : frame.Events)
+	{
+		if (e.Thread == thread && e.Depth <= 1)
+			stages[e.Name] += (e.EndNs - e.StartNs) / 1e6;
+	}
+
+	// New stages are zero for every frame before this one
+	size_t measured = frameMs.size();
+	for (auto& s : stages)
+	{
+		if (!stageMs.count(s.first))
+			stageMs[s.first] = std::vector<double>(measured, 0.0);
+	}
+	for (auto& s : stageMs)
+	{
+		auto it = stages.find(s.first);
+		s.second.push_back(it == stages.end() ? 0.0 : it->second);
+	}
+	frameMs.push_back((frame.EndNs - frame.StartNs) / 1e6);
+	renderStats.push_back(stats);
+}
+
+bool Benchmark::IsFinished()
+{
+	return frameMs.size() >= settings.Frames;
+}
+
+std::string Benchmark::GetReport()
+{
+	std::ostringstream out;
+	out.setf(std::ios::fixed);
+	out.precision(4);
+
+	out << "{\n";
+	out << "  \"scene\": {\"entities\":" << settings.Entities << ",\"lights\":" << settings.Lights
+		<< ",\"materials\":" << settings.Materials << ",\"seed\":" << settings.Seed << "},\n";
+	out << "  \"frames\": " << frameMs.size() << ",\n";
+	out << "  \"warmupFrames\": " << settings.WarmupFrames << ",\n";
+	out << "  \"timeStep\": " << settings.TimeStep << ",\n";
+	out << "  \"device\": \"" << (settings.NoSubmit ? "warp-nosubmit" : settings.Warp ? "warp" : "hardware") << "\",\n";
+	out << "  \"frameMs\": ";
+	WriteStats(out, Summarize(frameMs));
+	out << ",\n  \"stagesMs\": {";
+
+	bool first = true;
+	for (auto& s : stageMs)
+	{
+		out << (first ? "\n" : ",\n") << "    \"" << s.first << "\": ";
+		WriteStats(out, Summarize(s.second));
+		first = false;
+	}
+	out << "\n  },\n  \"renderStats\": {";
+
+	first = true;
+	for (auto& stat : renderStatNames)
+	{
+		std::vector<double> samples;
+		for (auto& f : renderStats)
+			samples.push_back((double)(f.*stat.second));
+		out << (first ? "\n" : ",\n") << "    \"" << stat.first << "\": ";
+		WriteStats(out, Summarize(samples));
+		first = false;
+	}
+	out << "\n  }\n}\n";
+	return out.str();
+}
+
+bool Benchmark::WriteReport(const std::wstring& path)
+{
+	std::ofstream file{ std::filesystem::path(path) };
+	if (!file)
+		return false;
+	file << GetReport();
+	return (bool)file;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "Profiler.h"
+#include "RenderStats.h"
+
+// --------------------------------------------------------
+// How a benchmark run is set up, from the command line:
+//   -benchmark [-entities N] [-lights M] [-materials K]
+//   [-frames F] [-warmup W] [-timestep S] [-seed X]
+//   [-warp | -nosubmit] [-output file.json]
+//
+// Runs are part of the Windows executable and need a D3D11
+// device and a window.  -warp and -nosubmit let them run on a
+// machine without a GPU, not on one without Windows
+// --------------------------------------------------------
+struct BenchmarkSettings
+{
+	bool Enabled = false;
+	unsigned int Entities = 64;
+	unsigned int Lights = 5;
+	unsigned int Materials = 4;
+	unsigned int Frames = 600;		// Measured frames
+	unsigned int WarmupFrames = 60;	// Run first, not measured
+	float TimeStep = 1.0f / 60.0f;	// Fixed simulation step, whatever the wall clock says
+	unsigned int Seed = 1;			// Same seed, same scene
+	bool Warp = false;				// Software rasterizer, for machines without a GPU
+	bool NoSubmit = false;			// WARP, counting draws, uploads and binds but not submitting them
+	std::string Output = "benchmark.json";
+};
+
+struct BenchmarkStats
+{
+	double Mean;
+	double Min;
+	double Max;
+	double P50;
+	double P95;
+	double P99;
+};
+
+// --------------------------------------------------------
+// Collects frame times and per-stage CPU costs from the
+// profiler's frames and reports them as JSON.  Stages are
+// the main thread's top two levels of scopes (Update, each
+// render graph pass, Present...); a stage that didn't run in
+// a frame counts as zero for that frame.  Each frame's render
+// stats (draw calls, binds, uploads...) are summarized the
+// same way, so runs can be checked against call budgets
+// --------------------------------------------------------
+class Benchmark
+{
+public:
+	static BenchmarkSettings ParseCommandLine(const std::string& commandLine);
+
+	// Nearest-rank percentiles.  All zero for no samples
+	static BenchmarkStats Summarize(std::vector<double> samples);
+
+	Benchmark(const BenchmarkSettings& settings);
+
+	// Once per frame, with the profiler's newest frame, the
+	// thread whose scopes count as stages and the frame's stats
+	void RecordFrame(const ProfileFrame& frame, unsigned int thread, const RenderStatsFrame& renderStats);
+	bool IsFinished();
+
+	std::string GetReport();
+	bool WriteReport(const std::wstring& path);
+
+private:
+	BenchmarkSettings settings;
+	unsigned int framesSeen;
+	std::vector<double> frameMs;
+	std::map<std::string, std::vector<double>> stageMs;
+	std::vector<RenderStatsFrame> renderStats;
+};
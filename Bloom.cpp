@@ -0,0 +1,121 @@
+#include "Bloom.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	XMFLOAT3 Add(XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(a.x + b.x, a.y + b.y, a.z + b.z); }
+	XMFLOAT3 Scale(XMFLOAT3 a, float s) { return XMFLOAT3(a.x * s, a.y * s, a.z * s); }
+	XMFLOAT3 Lerp(XMFLOAT3 a, XMFLOAT3 b, float t) { return Add(Scale(a, 1.0f - t), Scale(b, t)); }
+}
+
+Bloom::Image::Image(unsigned int width, unsigned int height) :
+	Width(width), Height(height), Pixels((size_t)width * height, XMFLOAT3(0, 0, 0))
+{
+}
+
+// --------------------------------------------------------
+// Same math as D3D11_FILTER_MIN_MAG_MIP_LINEAR with clamp:
+// texel centers sit at half texel offsets
+// --------------------------------------------------------
+XMFLOAT3 Bloom::SampleBilinear(const Image& image, float u, float v)
+{
+	float x = u * image.Width - 0.5f;
+	float y = v * image.Height - 0.5f;
+	float fx = floorf(x);
+	float fy = floorf(y);
+	float tx = x - fx;
+	float ty = y - fy;
+
+	int maxX = (int)image.Width - 1;
+	int maxY = (int)image.Height - 1;
+	int x0 = std::clamp((int)fx, 0, maxX);
+	int x1 = std::clamp((int)fx + 1, 0, maxX);
+	int y0 = std::clamp((int)fy, 0, maxY);
+	int y1 = std::clamp((int)fy + 1, 0, maxY);
+
+	XMFLOAT3 top = Lerp(image.At(x0, y0), image.At(x1, y0), tx);
+	XMFLOAT3 bottom = Lerp(image.At(x0, y1), image.At(x1, y1), tx);
+	return Lerp(top, bottom, ty);
+}
+
+XMFLOAT3 Bloom::Prefilter(XMFLOAT3 color, float threshold, float knee)
+{
+	float brightness = std::max(color.x, std::max(color.y, color.z));
+	float soft = std::clamp(brightness - threshold + knee, 0.0f, 2.0f * knee);
+	soft = soft * soft / (4.0f * knee + 0.00001f);
+	float contribution = std::max(soft, brightness - threshold) / std::max(brightness, 0.00001f);
+	return Scale(color, contribution);
+}
+
+// --------------------------------------------------------
+// The 13 tap pattern from Jimenez's "Next Generation Post
+// Processing in Call of Duty: Advanced Warfare".  Five
+// overlapping 4x4 boxes, the center one weighted highest,
+// which avoids the flickering of a plain box filter
+// --------------------------------------------------------
+Bloom::Image Bloom::Downsample13(const Image& source, bool prefilter, float threshold, float knee)
+{
+	Image result(std::max(1u, source.Width / 2), std::max(1u, source.Height / 2));
+	float texelU = 1.0f / source.Width;
+	float texelV = 1.0f / source.Height;
+
+	for (unsigned int y = 0; y < result.Height; y++)
+	{
+		for (unsigned int x = 0; x < result.Width; x++)
+		{
+			float u = (x + 0.5f) / result.Width;
+			float v = (y + 0.5f) / result.Height;
+			auto tap = [&](float ox, float oy) { return SampleBilinear(source, u + ox * texelU, v + oy * texelV); };
+
+			XMFLOAT3 a = tap(-2, -2), b = tap(0, -2), c = tap(2, -2);
+			XMFLOAT3 d = tap(-1, -1), e = tap(1, -1);
+			XMFLOAT3 f = tap(-2, 0), g = tap(0, 0), h = tap(2, 0);
+			XMFLOAT3 i = tap(-1, 1), j = tap(1, 1);
+			XMFLOAT3 k = tap(-2, 2), l = tap(0, 2), m = tap(2, 2);
+
+			XMFLOAT3 color = Scale(Add(Add(d, e), Add(i, j)), 0.5f / 4);
+			color = Add(color, Scale(Add(Add(a, b), Add(f, g)), 0.125f / 4));
+			color = Add(color, Scale(Add(Add(b, c), Add(g, h)), 0.125f / 4));
+			color = Add(color, Scale(Add(Add(f, g), Add(k, l)), 0.125f / 4));
+			color = Add(color, Scale(Add(Add(g, h), Add(l, m)), 0.125f / 4));
+
+			if (prefilter)
+				color = Prefilter(color, threshold, knee);
+			result.At(x, y) = color;
+		}
+	}
+	return result;
+}
+
+Bloom::Image Bloom::UpsampleTent(const Image& low, const Image& high, float radius)
+{
+	Image result(high.Width, high.Height);
+	float texelU = radius / low.Width;
+	float texelV = radius / low.Height;
+	const float weights[3] = { 1, 2, 1 };
+
+	for (unsigned int y = 0; y < result.Height; y++)
+	{
+		for (unsigned int x = 0; x < result.Width; x++)
+		{
+			float u = (x + 0.5f) / result.Width;
+			float v = (y + 0.5f) / result.Height;
+
+			XMFLOAT3 tent(0, 0, 0);
+			for (int oy = -1; oy <= 1; oy++)
+			{
+				for (int ox = -1; ox <= 1; ox++)
+				{
+					float w = weights[ox + 1] * weights[oy + 1] / 16.0f;
+					tent = Add(tent, Scale(SampleBilinear(low, u + ox * texelU, v + oy * texelV), w));
+				}
+			}
+
+			result.At(x, y) = Add(high.At(x, y), tent);
+		}
+	}
+	return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// CPU versions of the bloom filters in BloomDownsamplePS.hlsl
+// and BloomUpsamplePS.hlsl, working on plain float images.
+// Sampling matches a D3D bilinear sampler with clamp
+// addressing, so results can be compared against a GPU
+// capture of the same input
+// --------------------------------------------------------
+namespace Bloom
+{
+	struct Image
+	{
+		unsigned int Width;
+		unsigned int Height;
+		std::vector<DirectX::XMFLOAT3> Pixels; // Row major
+
+		Image() : Width(0), Height(0) {}
+		Image(unsigned int width, unsigned int height);
+
+		DirectX::XMFLOAT3& At(unsigned int x, unsigned int y) { return Pixels[(size_t)y * Width + x]; }
+		const DirectX::XMFLOAT3& At(unsigned int x, unsigned int y) const { return Pixels[(size_t)y * Width + x]; }
+	};
+
+	// Bilinear sample with clamped addressing at a UV
+	DirectX::XMFLOAT3 SampleBilinear(const Image& image, float u, float v);
+
+	// Soft threshold that only lets bright colors through,
+	// with a quadratic knee so the cutoff isn't a hard edge
+	DirectX::XMFLOAT3 Prefilter(DirectX::XMFLOAT3 color, float threshold, float knee);
+
+	// Half resolution 13 tap downsample.  Optionally applies
+	// the prefilter, as the first step of the chain does
+	Image Downsample13(const Image& source, bool prefilter = false, float threshold = 1.0f, float knee = 0.5f);
+
+	// 3x3 tent upsample of the lower level, added to the higher
+	// level.  Radius is in texels of the lower level
+	Image UpsampleTent(const Image& low, const Image& high, float radius);
+}
@@ -0,0 +1,63 @@
+cbuffer ExternalData : register(b0)
+{
+    int prefilter;   // Only the first downsample thresholds
+    float threshold;
+    float knee;
+}
+
+// Defines the input to this pixel shader
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// Textures and such
+Texture2D Source : register(t0);
+SamplerState BasicSampler : register(s0);
+
+// Soft threshold with a quadratic knee
+float3 Prefilter(float3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - threshold + knee, 0, 2 * knee);
+    soft = soft * soft / (4 * knee + 0.00001f);
+    float contribution = max(soft, brightness - threshold) / max(brightness, 0.00001f);
+    return color * contribution;
+}
+
+// 13 tap downsample (Jimenez, "Next Generation Post Processing
+// in Call of Duty: Advanced Warfare").  Must match
+// Bloom::Downsample13() on the C++ side
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    float width, height;
+    Source.GetDimensions(width, height);
+    float2 texel = float2(1.0f / width, 1.0f / height);
+    float2 uv = input.uv;
+
+    float3 a = Source.SampleLevel(BasicSampler, uv + float2(-2, -2) * texel, 0).rgb;
+    float3 b = Source.SampleLevel(BasicSampler, uv + float2( 0, -2) * texel, 0).rgb;
+    float3 c = Source.SampleLevel(BasicSampler, uv + float2( 2, -2) * texel, 0).rgb;
+    float3 d = Source.SampleLevel(BasicSampler, uv + float2(-1, -1) * texel, 0).rgb;
+    float3 e = Source.SampleLevel(BasicSampler, uv + float2( 1, -1) * texel, 0).rgb;
+    float3 f = Source.SampleLevel(BasicSampler, uv + float2(-2,  0) * texel, 0).rgb;
+    float3 g = Source.SampleLevel(BasicSampler, uv, 0).rgb;
+    float3 h = Source.SampleLevel(BasicSampler, uv + float2( 2,  0) * texel, 0).rgb;
+    float3 i = Source.SampleLevel(BasicSampler, uv + float2(-1,  1) * texel, 0).rgb;
+    float3 j = Source.SampleLevel(BasicSampler, uv + float2( 1,  1) * texel, 0).rgb;
+    float3 k = Source.SampleLevel(BasicSampler, uv + float2(-2,  2) * texel, 0).rgb;
+    float3 l = Source.SampleLevel(BasicSampler, uv + float2( 0,  2) * texel, 0).rgb;
+    float3 m = Source.SampleLevel(BasicSampler, uv + float2( 2,  2) * texel, 0).rgb;
+
+    float3 color = (d + e + i + j) * (0.5f / 4);
+    color += (a + b + f + g) * (0.125f / 4);
+    color += (b + c + g + h) * (0.125f / 4);
+    color += (f + g + k + l) * (0.125f / 4);
+    color += (g + h + l + m) * (0.125f / 4);
+
+    if (prefilter)
+        color = Prefilter(color);
+
+    return float4(color, 1);
+}
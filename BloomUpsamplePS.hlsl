@@ -0,0 +1,39 @@
+cbuffer ExternalData : register(b0)
+{
+    float radius; // In texels of the lower level
+}
+
+// Defines the input to this pixel shader
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// Textures and such
+Texture2D Low : register(t0);  // Smaller level, already upsampled into
+Texture2D High : register(t1); // Same size level from the downsample chain
+SamplerState BasicSampler : register(s0);
+
+// 3x3 tent filter of the lower level added onto the higher
+// one.  Must match Bloom::UpsampleTent() on the C++ side
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    float width, height;
+    Low.GetDimensions(width, height);
+    float2 texel = float2(radius / width, radius / height);
+    float2 uv = input.uv;
+
+    float3 tent = Low.SampleLevel(BasicSampler, uv, 0).rgb * 4;
+    tent += Low.SampleLevel(BasicSampler, uv + float2(-1,  0) * texel, 0).rgb * 2;
+    tent += Low.SampleLevel(BasicSampler, uv + float2( 1,  0) * texel, 0).rgb * 2;
+    tent += Low.SampleLevel(BasicSampler, uv + float2( 0, -1) * texel, 0).rgb * 2;
+    tent += Low.SampleLevel(BasicSampler, uv + float2( 0,  1) * texel, 0).rgb * 2;
+    tent += Low.SampleLevel(BasicSampler, uv + float2(-1, -1) * texel, 0).rgb;
+    tent += Low.SampleLevel(BasicSampler, uv + float2( 1, -1) * texel, 0).rgb;
+    tent += Low.SampleLevel(BasicSampler, uv + float2(-1,  1) * texel, 0).rgb;
+    tent += Low.SampleLevel(BasicSampler, uv + float2( 1,  1) * texel, 0).rgb;
+
+    float3 high = High.SampleLevel(BasicSampler, uv, 0).rgb;
+    return float4(high + tent / 16, 1);
+}
@@ -10,4 +10,16 @@ struct constBuffer
 	XMFLOAT4X4 world;
 	XMFLOAT4X4 view;
 	XMFLOAT4X4 projection;
+};
+
+// Matches CameraData in VertexShader.hlsl.  Uploaded once a
+// frame and bound once per context, not set for every entity
+#define CAMERA_CONSTANTS_REGISTER 1
+struct CameraConstants
+{
+	XMFLOAT4X4 view;
+	XMFLOAT4X4 projection;
+	XMFLOAT4X4 viewProjection;
+	XMFLOAT3 cameraPosition;
+	float padding;
 };
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "Camera.h"
 #include "Input.h"
+#include "Meshlets.h"
+#include <cmath>
 using namespace std;
 using namespace DirectX;
 using namespace Input;
 Camera::Camera(DirectX::XMFLOAT3 pos, float fov, float aspectRatio, float nearClip, float farClip, float moveSpeed, float mouseLookSpeed, bool isActive)  :
-	fov(fov),aspectRatio(aspectRatio),nearClip(nearClip),farClip(farClip),moveSpeed(moveSpeed),mouseLookSpeed(mouseLookSpeed),isActive(isActive)
+	fov(fov),aspectRatio(aspectRatio),nearClip(nearClip),farClip(farClip),moveSpeed(moveSpeed),mouseLookSpeed(mouseLookSpeed),isActive(isActive),
+	viewVersion(0),viewBuilt(false),projDirty(true),viewProjDirty(true)
 {
 	transform = make_shared<Transform>();
 	transform->SetPosition(pos);
@@ -15,16 +18,55 @@ Camera::Camera(DirectX::XMFLOAT3 pos, float fov, float aspectRatio, float nearCl
 Camera::~Camera()
 {
 }
-XMFLOAT4X4 Camera::GetView()
+const XMFLOAT4X4& Camera::GetView()
 {
+	UpdateViewMatrix();
 	return viewMatrix;
 }
 
-XMFLOAT4X4 Camera::GetProjection()
+const XMFLOAT4X4& Camera::GetProjection()
 {
+	UpdateProjectionMatrix(aspectRatio);
 	return projMatrix;
 }
 
+const XMFLOAT4X4& Camera::GetViewProjection()
+{
+	UpdateViewProjection();
+	return viewProjMatrix;
+}
+
+const XMFLOAT4* Camera::GetFrustumPlanes()
+{
+	UpdateViewProjection();
+	return frustumPlanes;
+}
+
+// --------------------------------------------------------
+// Turning moves each side plane by at most the angle turned,
+// so the sides open up by the margin.  Anything in the turned
+// view is within its half diagonal of the forward direction,
+// so that bounds how far in front and behind the near and far
+// planes it can land along the old forward direction
+// --------------------------------------------------------
+void Camera::GetWidenedFrustumPlanes(float margin, XMFLOAT4 planes[6])
+{
+	const float limit = XM_PIDIV2 - 0.01f;
+	float tanY = tanf(fov * 0.5f);
+	float tanX = tanY * aspectRatio;
+	float halfDiagonal = atanf(sqrtf(tanX * tanX + tanY * tanY));
+
+	float halfY = fminf(fov * 0.5f + margin, limit);
+	float halfX = fminf(atanf(tanX) + margin, limit);
+	float nearDepth = nearClip * cosf(fminf(halfDiagonal + margin, limit));
+	float farDepth = farClip / cosf(halfDiagonal);
+
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(halfY * 2.0f, tanf(halfX) / tanf(halfY), nearDepth, farDepth);
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMLoadFloat4x4(&GetView()), proj));
+	Meshlets::ExtractFrustumPlanes(viewProj, planes);
+}
+
 shared_ptr<Transform> Camera::GetTransform()
 {
 	return transform;
@@ -36,18 +78,44 @@ float Camera::GetFOV()
 }
 void Camera::SetFOV(float fov)
 {
+	if (fov == this->fov)
+		return;
 	this->fov = fov;
+	projDirty = true;
+}
+float Camera::GetNearClip()
+{
+	return nearClip;
+}
+float Camera::GetFarClip()
+{
+	return farClip;
+}
+float Camera::GetAspectRatio()
+{
+	return aspectRatio;
 }
 void Camera::UpdateProjectionMatrix(float aspectRatio)
 {
+	if (!projDirty && aspectRatio == this->aspectRatio)
+		return;
 	this->aspectRatio = aspectRatio;
 
 	XMMATRIX pM=XMMatrixPerspectiveFovLH(fov, aspectRatio, nearClip, farClip);
 	XMStoreFloat4x4(&projMatrix, pM);
+	projDirty = false;
+	viewProjDirty = true;
 }
 
 void Camera::UpdateViewMatrix()
 {
+	// Anything that moves the camera goes through its transform
+	if (viewBuilt && transform->GetVersion() == viewVersion)
+		return;
+	viewVersion = transform->GetVersion();
+	viewBuilt = true;
+	viewProjDirty = true;
+
 	XMFLOAT3 foward = transform->GetFoward();
 	XMFLOAT3 pos = transform->GetPosition();
 	
@@ -76,22 +144,49 @@ void Camera::Update(float deltaTime)
 
 	//mouse input
 	if (MouseLeftDown())
-	{
-		float cursorX = GetMouseXDelta()*mouseLookSpeed;
-		float cursorY = GetMouseYDelta()*mouseLookSpeed;
-		transform->Rotate(cursorY, cursorX, 0);
-
-
-		XMFLOAT3 rot = transform->GetPitchYawRoll();
-		if (rot.x > XM_PIDIV2) rot.x = XM_PIDIV2; 
-		if (rot.x < -XM_PIDIV2) rot.x = -XM_PIDIV2; 
-		transform->SetRotation(rot);
+		MouseLook(GetMouseXDelta(), GetMouseYDelta());
+	UpdateViewMatrix();
+}
 
+float Camera::LateLatch()
+{
+	if (!isActive || !MouseLeftDown())
+		return 0.0f;
 
-	}
+	// Forward moves by no more than the pitch and yaw changes added up
+	XMFLOAT3 before = transform->GetPitchYawRoll();
+	MouseLook(GetLatchedMouseXDelta(), GetLatchedMouseYDelta());
 	UpdateViewMatrix();
+	XMFLOAT3 after = transform->GetPitchYawRoll();
+	return fabsf(after.x - before.x) + fabsf(after.y - before.y);
 }
 
+void Camera::MouseLook(int xDelta, int yDelta)
+{
+	// Rotating by nothing would still bump the transform's version
+	// and rebuild the view for no reason
+	if (xDelta == 0 && yDelta == 0)
+		return;
+
+	float cursorX = xDelta*mouseLookSpeed;
+	float cursorY = yDelta*mouseLookSpeed;
+	transform->Rotate(cursorY, cursorX, 0);
 
 
+	XMFLOAT3 rot = transform->GetPitchYawRoll();
+	if (rot.x > XM_PIDIV2) rot.x = XM_PIDIV2; 
+	if (rot.x < -XM_PIDIV2) rot.x = -XM_PIDIV2; 
+	transform->SetRotation(rot);
+}
 
+void Camera::UpdateViewProjection()
+{
+	UpdateViewMatrix();
+	UpdateProjectionMatrix(aspectRatio);
+	if (!viewProjDirty)
+		return;
+
+	XMStoreFloat4x4(&viewProjMatrix, XMMatrixMultiply(XMLoadFloat4x4(&viewMatrix), XMLoadFloat4x4(&projMatrix)));
+	Meshlets::ExtractFrustumPlanes(viewProjMatrix, frustumPlanes);
+	viewProjDirty = false;
+}
@@ -9,22 +9,50 @@ class Camera
 		~Camera();
 		bool isActive;
 
-		DirectX::XMFLOAT4X4 GetView();
-		DirectX::XMFLOAT4X4 GetProjection();
+		// Rebuilt on demand, only once the transform or lens has
+		// actually changed since they were last built
+		const DirectX::XMFLOAT4X4& GetView();
+		const DirectX::XMFLOAT4X4& GetProjection();
+		const DirectX::XMFLOAT4X4& GetViewProjection();
+
+		// World space, in the order Meshlets::ExtractFrustumPlanes()
+		// gives them: left, right, bottom, top, near, far
+		const DirectX::XMFLOAT4* GetFrustumPlanes();
+
+		// Same order, but wide enough to hold anything the view
+		// could see after turning up to margin radians in place
+		void GetWidenedFrustumPlanes(float margin, DirectX::XMFLOAT4 planes[6]);
 		std::shared_ptr<Transform>GetTransform();
 		float GetFOV();
 		void SetFOV(float fov);
+		float GetNearClip();
+		float GetFarClip();
+		float GetAspectRatio();
 
 		void UpdateProjectionMatrix(float aspectRatio);
 		void UpdateViewMatrix();
 		void Update(float deltaTime);
 
+		// Applies the mouse movement found by Input::LatchMouse().
+		// Returns an upper bound on how far the view turned, in radians
+		float LateLatch();
+
 		
 	private:
 		DirectX::XMFLOAT4X4 viewMatrix;
 		DirectX::XMFLOAT4X4 projMatrix;
+		DirectX::XMFLOAT4X4 viewProjMatrix;
+		DirectX::XMFLOAT4 frustumPlanes[6];
 		std::shared_ptr<Transform> transform;
 
+		unsigned long long viewVersion; // The transform's version when the view was built
+		bool viewBuilt;
+		bool projDirty;
+		bool viewProjDirty;
+		void UpdateViewProjection();
+
+		void MouseLook(int xDelta, int yDelta);
+
 
 		float fov;
 		float nearClip;
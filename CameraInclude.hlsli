@@ -0,0 +1,26 @@
+#ifndef _GGP_CAMERA_INCLUDES_
+#define _GGP_CAMERA_INCLUDES_
+
+// The same for every entity, so the game fills it once a frame
+// (see CameraConstants in BufferStructs.h)
+cbuffer CameraData : register(b1)
+{
+    matrix view;
+    matrix projection;
+    matrix viewProjection;
+    float3 cameraPosition;
+}
+
+// Local position to world and clip space.  The depth pre-pass and
+// the lit pass both go through this so their depths round the same
+// way, which the lit pass's EQUAL depth test relies on.  precise
+// keeps the compiler from fusing or reordering either multiply
+float4 LocalToClip(matrix world, float3 localPosition, out float3 worldPos)
+{
+    precise float4 world4 = mul(world, float4(localPosition, 1.0f));
+    worldPos = world4.xyz;
+    precise float4 clip = mul(viewProjection, float4(worldPos, 1.0f));
+    return clip;
+}
+
+#endif
@@ -0,0 +1,276 @@
+#include "CascadedShadowMap.h"
+#include "Graphics.h"
+#include "Hash.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Creates the cascade texture array, a depth view for each
+// slice and the state used to render and sample it
+// --------------------------------------------------------
+CascadedShadowMap::CascadedShadowMap(std::shared_ptr<SimpleVertexShader> shadowVS, unsigned int resolution) :
+	vs(shadowVS), resolution(resolution), active(false), cascades{},
+	staticCascadeFit{}, staticCascadeValid{}, cascadeMatchesStatic{}, staticCasterHash(0),
+	casterDraws(0), staticCascadeRenders(0), staticCascadeCopies(0)
+{
+	D3D11_TEXTURE2D_DESC shadowDesc = {};
+	{
+		shadowDesc.Width = resolution; // Ideally a power of 2 (like 1024)
+		shadowDesc.Height = resolution; // Ideally a power of 2 (like 1024)
+		shadowDesc.ArraySize = MAX_SHADOW_CASCADES;
+		shadowDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+		shadowDesc.CPUAccessFlags = 0;
+		shadowDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+		shadowDesc.MipLevels = 1;
+		shadowDesc.MiscFlags = 0;
+		shadowDesc.SampleDesc.Count = 1;
+		shadowDesc.SampleDesc.Quality = 0;
+		shadowDesc.Usage = D3D11_USAGE_DEFAULT;
+	}
+
+	Graphics::Api->CreateTexture2D(shadowDesc, 0, texture.GetAddressOf());
+
+	// Same layout again for the static caster cache, only ever
+	// rendered into and copied from (never sampled)
+	shadowDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	Graphics::Api->CreateTexture2D(shadowDesc, 0, staticTexture.GetAddressOf());
+
+	// Create a depth/stencil view for each cascade
+	for (int c = 0; c < MAX_SHADOW_CASCADES; c++)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
+		shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
+		shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+		shadowDSDesc.Texture2DArray.MipSlice = 0;
+		shadowDSDesc.Texture2DArray.FirstArraySlice = c;
+		shadowDSDesc.Texture2DArray.ArraySize = 1;
+		Graphics::Device->CreateDepthStencilView(texture.Get(), &shadowDSDesc, dsvs[c].GetAddressOf());
+		Graphics::Device->CreateDepthStencilView(staticTexture.Get(), &shadowDSDesc, staticDSVs[c].GetAddressOf());
+	}
+
+	// Create the SRV for the whole array
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	{
+		srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MipLevels = 1;
+		srvDesc.Texture2DArray.MostDetailedMip = 0;
+		srvDesc.Texture2DArray.FirstArraySlice = 0;
+		srvDesc.Texture2DArray.ArraySize = MAX_SHADOW_CASCADES;
+	}
+	Graphics::Device->CreateShaderResourceView(texture.Get(), &srvDesc, srv.GetAddressOf());
+
+	D3D11_RASTERIZER_DESC shadowRastDesc = {};
+	{
+		shadowRastDesc.FillMode = D3D11_FILL_SOLID;
+		shadowRastDesc.CullMode = D3D11_CULL_BACK;
+		shadowRastDesc.DepthClipEnable = false; // Casters in front of the near plane get flattened onto it
+		shadowRastDesc.DepthBias = 100; // Min. precision units, not world units!
+		shadowRastDesc.SlopeScaledDepthBias = 1.0f; // Bias more based on slope
+	}
+	Graphics::Device->CreateRasterizerState(&shadowRastDesc, rasterizer.GetAddressOf());
+
+	D3D11_SAMPLER_DESC shadowSampDesc = {};
+	{
+		shadowSampDesc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR;
+		shadowSampDesc.ComparisonFunc = D3D11_COMPARISON_LESS;
+		shadowSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_BORDER;
+		shadowSampDesc.AddressV = D3D11_TEXTURE_ADDRESS_BORDER;
+		shadowSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_BORDER;
+		shadowSampDesc.BorderColor[0] = 1.0f; // Only need the first component
+	}
+	Graphics::Device->CreateSamplerState(&shadowSampDesc, sampler.GetAddressOf());
+}
+
+// --------------------------------------------------------
+// Splits the camera's frustum (out to the shadow distance)
+// and fits a cascade around each slice
+// --------------------------------------------------------
+void CascadedShadowMap::Update(Camera* camera, const std::vector<Light>& lights)
+{
+	PROFILE_SCOPE("UpdateShadowCascades");
+	active = settings.Enabled && !lights.empty() && lights[0].Type == LIGHT_TYPE_DIRECTIONAL;
+	if (!active)
+		return;
+
+	std::shared_ptr<Transform> camTransform = camera->GetTransform();
+	float farDepth = min(settings.Distance, camera->GetFarClip());
+	float splits[MAX_SHADOW_CASCADES + 1];
+	ShadowCascades::ComputeSplits(camera->GetNearClip(), farDepth, settings.CascadeCount, settings.Lambda, splits);
+
+	for (int c = 0; c < settings.CascadeCount; c++)
+	{
+		XMFLOAT3 corners[8];
+		ShadowCascades::GetFrustumSliceCorners(
+			camTransform->GetPosition(),
+			camTransform->GetFoward(),
+			camTransform->GetUp(),
+			camTransform->GetRight(),
+			camera->GetFOV(),
+			camera->GetAspectRatio(),
+			splits[c],
+			splits[c + 1],
+			corners);
+
+		cascades[c] = ShadowCascades::FitCascade(corners, lights[0].Direction, resolution, settings.CasterDistance);
+		cascades[c].SplitNear = splits[c];
+		cascades[c].SplitFar = splits[c + 1];
+	}
+}
+
+// --------------------------------------------------------
+// Renders depth for each cascade.  With caching on, static
+// casters are drawn into a separate cache only when needed
+// and copied in, then the dynamic casters go on top
+// --------------------------------------------------------
+void CascadedShadowMap::Render(const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, unsigned int width, unsigned int height)
+{
+	casterDraws = 0;
+	staticCascadeRenders = 0;
+	staticCascadeCopies = 0;
+	if (!active)
+		return;
+
+	// Any static caster moving invalidates every cascade
+	unsigned long long hash = HashStaticCasters(entities);
+	if (!settings.Caching || hash != staticCasterHash)
+	{
+		for (auto& valid : staticCascadeValid)
+			valid = false;
+		staticCasterHash = hash;
+	}
+
+	Graphics::Context->RSSetState(rasterizer.Get());
+	Graphics::Context->PSSetShader(0, 0, 0);
+
+	D3D11_VIEWPORT viewport = {};
+	{
+		viewport.Width = (float)resolution;
+		viewport.Height = (float)resolution;
+		viewport.MaxDepth = 1.0f;
+	}
+	Graphics::Context->RSSetViewports(1, &viewport);
+
+	vs->SetShader();
+	ID3D11RenderTargetView* nullRTV{};
+	for (int c = 0; c < settings.CascadeCount; c++)
+	{
+		vs->SetMatrix4x4("view", cascades[c].View);
+		vs->SetMatrix4x4("projection", cascades[c].Projection);
+
+		if (!settings.Caching)
+		{
+			//Clear this cascade and render everything into it
+			Graphics::Context->ClearDepthStencilView(dsvs[c].Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+			Graphics::Context->OMSetRenderTargets(1, &nullRTV, dsvs[c].Get());
+			RenderCasters(entities, stream, c, true);
+			RenderCasters(entities, stream, c, false);
+			cascadeMatchesStatic[c] = false;
+			continue;
+		}
+
+		// The cache is only good while the cascade's snapped fit is the
+		// same.  That only changes once the slice moves a whole snap
+		// step (see FitCascade), so a moving camera can still reuse it
+		bool refreshed = false;
+		if (!staticCascadeValid[c] || !ShadowCascades::SameFit(staticCascadeFit[c], cascades[c]))
+		{
+			Graphics::Context->ClearDepthStencilView(staticDSVs[c].Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+			Graphics::Context->OMSetRenderTargets(1, &nullRTV, staticDSVs[c].Get());
+			RenderCasters(entities, stream, c, true);
+
+			staticCascadeFit[c] = cascades[c];
+			staticCascadeValid[c] = true;
+			staticCascadeRenders++;
+			refreshed = true;
+		}
+
+		// Depth resources can only be copied a whole subresource at a
+		// time, so there's no partial update.  If the live slice still
+		// holds exactly the cache (nothing dynamic was drawn over it)
+		// and nothing dynamic goes on top this frame, it's skipped
+		bool dynamicCasters = HasCasters(entities, c, false);
+		if (!refreshed && cascadeMatchesStatic[c] && !dynamicCasters)
+			continue;
+
+		Graphics::Context->OMSetRenderTargets(1, &nullRTV, 0);
+		Graphics::Context->CopySubresourceRegion(texture.Get(), c, 0, 0, 0, staticTexture.Get(), c, 0);
+		staticCascadeCopies++;
+
+		Graphics::Context->OMSetRenderTargets(1, &nullRTV, dsvs[c].Get());
+		RenderCasters(entities, stream, c, false);
+		cascadeMatchesStatic[c] = !dynamicCasters;
+	}
+
+	viewport.Width = (float)width;
+	viewport.Height = (float)height;
+	Graphics::Context->RSSetViewports(1, &viewport);
+	Graphics::Context->RSSetState(0);
+}
+
+// --------------------------------------------------------
+// Draws the static or dynamic entities that can cast into
+// a cascade, assuming its view and depth buffer are set
+// --------------------------------------------------------
+void CascadedShadowMap::RenderCasters(const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, int cascade, bool staticCasters)
+{
+	for (auto& e : entities)
+	{
+		if (e->IsStatic() != staticCasters)
+			continue;
+
+		XMFLOAT3 center;
+		float radius;
+		e->GetWorldBounds(center, radius);
+		if (!ShadowCascades::CasterVisible(cascades[cascade], center, radius))
+			continue;
+
+		vs->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
+		vs->CopyAllBufferData();
+		// Draw the mesh directly to avoid the entity's material
+		e->GetMesh()->Draw(stream, e->GetLod());
+		casterDraws++;
+	}
+}
+
+// --------------------------------------------------------
+// Would RenderCasters() draw anything?
+// --------------------------------------------------------
+bool CascadedShadowMap::HasCasters(const std::vector<std::shared_ptr<GameEntity>>& entities, int cascade, bool staticCasters)
+{
+	for (auto& e : entities)
+	{
+		if (e->IsStatic() != staticCasters)
+			continue;
+
+		XMFLOAT3 center;
+		float radius;
+		e->GetWorldBounds(center, radius);
+		if (ShadowCascades::CasterVisible(cascades[cascade], center, radius))
+			return true;
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// Hash of the static entities and their world matrices, so
+// any static caster moving (or being added) is noticed
+// --------------------------------------------------------
+unsigned long long CascadedShadowMap::HashStaticCasters(const std::vector<std::shared_ptr<GameEntity>>& entities)
+{
+	unsigned long long hash = Hash::Seed;
+	for (auto& e : entities)
+	{
+		if (!e->IsStatic())
+			continue;
+
+		GameEntity* entity = e.get();
+		XMFLOAT4X4 world = e->GetTransform()->GetWorldMatrix();
+		int lod = e->GetLod();
+		Hash::Bytes(hash, &entity, sizeof(entity));
+		Hash::Bytes(hash, &world, sizeof(world));
+		Hash::Bytes(hash, &lod, sizeof(lod));
+	}
+	return hash;
+}
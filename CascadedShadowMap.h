@@ -0,0 +1,88 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "Camera.h"
+#include "GameEntity.h"
+#include "Lights.h"
+#include "ShadowCascades.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Everything that can be changed from the UI
+// --------------------------------------------------------
+struct CascadedShadowSettings
+{
+	bool Enabled = true;
+	int CascadeCount = 4;
+	float Lambda = 0.75f;			// Log vs. uniform split blend
+	float Distance = 40.0f;			// No shadows past this view depth
+	float CasterDistance = 30.0f;	// Casters this far behind a cascade still count
+	bool Caching = true;			// Cache static casters per cascade
+};
+
+// --------------------------------------------------------
+// Cascaded shadow map for the first light, when it's
+// directional.  The cascades are fitted to the camera each
+// frame.  Static casters are cached per cascade and only
+// re-rendered when the cascade or a static caster moves;
+// dynamic casters are drawn on top
+// --------------------------------------------------------
+class CascadedShadowMap
+{
+public:
+	CascadedShadowMap(std::shared_ptr<SimpleVertexShader> shadowVS, unsigned int resolution);
+
+	// Fits a cascade around each slice of the camera's frustum.
+	// Shadows are only active while enabled and the first light
+	// is directional
+	void Update(Camera* camera, const std::vector<Light>& lights);
+
+	// Renders depth for each active cascade, then puts back a
+	// viewport of the given size
+	void Render(const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, unsigned int width, unsigned int height);
+
+	// Getters
+	CascadedShadowSettings& GetSettings() { return settings; }
+	int GetActiveCascadeCount() { return active ? settings.CascadeCount : 0; }
+	const ShadowCascades::Cascade& GetCascade(int cascade) { return cascades[cascade]; }
+	unsigned int GetResolution() { return resolution; }
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetShaderResource() { return srv; } // Whole Texture2DArray
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> GetSampler() { return sampler; }
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> GetRasterizer() { return rasterizer; }
+
+	// Stats from the last Render()
+	unsigned int GetCasterDraws() { return casterDraws; }
+	unsigned int GetStaticCascadeRenders() { return staticCascadeRenders; }
+	unsigned int GetStaticCascadeCopies() { return staticCascadeCopies; }
+
+private:
+	void RenderCasters(const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, int cascade, bool staticCasters);
+	bool HasCasters(const std::vector<std::shared_ptr<GameEntity>>& entities, int cascade, bool staticCasters);
+	unsigned long long HashStaticCasters(const std::vector<std::shared_ptr<GameEntity>>& entities);
+
+	std::shared_ptr<SimpleVertexShader> vs;
+	unsigned int resolution;
+	CascadedShadowSettings settings;
+	bool active;
+	ShadowCascades::Cascade cascades[MAX_SHADOW_CASCADES];
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> dsvs[MAX_SHADOW_CASCADES]; // One per array slice
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer;
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler;
+
+	// Same layout again for the static caster cache
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> staticTexture;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> staticDSVs[MAX_SHADOW_CASCADES];
+	ShadowCascades::Cascade staticCascadeFit[MAX_SHADOW_CASCADES]; // Fit each cache slice was rendered with
+	bool staticCascadeValid[MAX_SHADOW_CASCADES];
+	bool cascadeMatchesStatic[MAX_SHADOW_CASCADES]; // Live slice holds only the cached static casters
+	unsigned long long staticCasterHash;
+
+	unsigned int casterDraws;
+	unsigned int staticCascadeRenders;
+	unsigned int staticCascadeCopies;
+};
@@ -0,0 +1,87 @@
+#include "CommandRecorder.h"
+#include <algorithm>
+
+void NullCommandRecordingBackend::Reserve(unsigned int chunkCount)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	Events.push_back("Reserve " + std::to_string(chunkCount));
+}
+
+ID3D11DeviceContext* NullCommandRecordingBackend::BeginChunk(unsigned int chunk)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	Events.push_back("Begin " + std::to_string(chunk));
+
+	std::thread::id id = std::this_thread::get_id();
+	if (std::find(recordingThreads.begin(), recordingThreads.end(), id) == recordingThreads.end())
+		recordingThreads.push_back(id);
+	return 0;
+}
+
+void NullCommandRecordingBackend::EndChunk(unsigned int chunk)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	Events.push_back("End " + std::to_string(chunk));
+}
+
+void NullCommandRecordingBackend::ExecuteChunk(unsigned int chunk)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	Events.push_back("Execute " + std::to_string(chunk));
+}
+
+std::vector<unsigned int> NullCommandRecordingBackend::GetExecutionOrder()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	std::vector<unsigned int> order;
+	for (auto& e : Events)
+	{
+		if (e.rfind("Execute ", 0) == 0)
+			order.push_back((unsigned int)std::stoul(e.substr(8)));
+	}
+	return order;
+}
+
+unsigned int NullCommandRecordingBackend::GetRecordingThreadCount()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return (unsigned int)recordingThreads.size();
+}
+
+ParallelCommandRecorder::ParallelCommandRecorder(std::shared_ptr<JobSystem> jobs) :
+	jobs(jobs), chunkCount(0)
+{
+}
+
+// --------------------------------------------------------
+// Each chunk is one job, so a context is only ever used by
+// one thread at a time.  Playback waits for all of them
+// --------------------------------------------------------
+void ParallelCommandRecorder::Record(
+	ICommandRecordingBackend& backend,
+	unsigned int count,
+	unsigned int chunkSize,
+	const std::function<void(ID3D11DeviceContext*, unsigned int, unsigned int)>& record)
+{
+	if (chunkSize == 0)
+		chunkSize = 1;
+	chunkCount = (count + chunkSize - 1) / chunkSize;
+	if (chunkCount == 0)
+		return;
+
+	backend.Reserve(chunkCount);
+	jobs->ParallelFor(chunkCount, 1, [&](unsigned int first, unsigned int last)
+		{
+			for (unsigned int chunk = first; chunk < last; chunk++)
+			{
+				unsigned int begin = chunk * chunkSize;
+				unsigned int end = std::min(begin + chunkSize, count);
+				ID3D11DeviceContext* context = backend.BeginChunk(chunk);
+				record(context, begin, end);
+				backend.EndChunk(chunk);
+			}
+		});
+
+	for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+		backend.ExecuteChunk(chunk);
+}
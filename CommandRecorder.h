@@ -0,0 +1,88 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+
+// Only ever passed through, so this header stays API free
+struct ID3D11DeviceContext;
+
+// --------------------------------------------------------
+// What the parallel recorder needs from the graphics API.
+// Each chunk of a draw list gets its own context to record
+// into on a worker thread, and the results are played back
+// on the main thread in chunk order
+// --------------------------------------------------------
+class ICommandRecordingBackend
+{
+public:
+	virtual ~ICommandRecordingBackend() = default;
+
+	// Main thread, before recording: makes sure there are at
+	// least this many chunk contexts
+	virtual void Reserve(unsigned int chunkCount) = 0;
+
+	// Worker threads.  A chunk only ever touches its own context
+	virtual ID3D11DeviceContext* BeginChunk(unsigned int chunk) = 0;
+	virtual void EndChunk(unsigned int chunk) = 0;
+
+	// Main thread, once every chunk has ended
+	virtual void ExecuteChunk(unsigned int chunk) = 0;
+};
+
+// --------------------------------------------------------
+// Backend that records nothing but what it was asked to do,
+// so chunking and playback order can be checked without a
+// GPU.  Events look like "Begin 2", "End 2" or "Execute 2".
+// Contexts handed out are null
+// --------------------------------------------------------
+class NullCommandRecordingBackend : public ICommandRecordingBackend
+{
+public:
+	void Reserve(unsigned int chunkCount) override;
+	ID3D11DeviceContext* BeginChunk(unsigned int chunk) override;
+	void EndChunk(unsigned int chunk) override;
+	void ExecuteChunk(unsigned int chunk) override;
+
+	// Chunks in the order they were played back
+	std::vector<unsigned int> GetExecutionOrder();
+
+	// How many different threads recorded chunks
+	unsigned int GetRecordingThreadCount();
+
+	std::vector<std::string> Events;
+
+private:
+	std::mutex lock;
+	std::vector<std::thread::id> recordingThreads;
+};
+
+// --------------------------------------------------------
+// Splits a draw list into chunks, records the chunks in
+// parallel on the job system, then plays them back in order
+// so the result matches recording everything serially
+// --------------------------------------------------------
+class ParallelCommandRecorder
+{
+public:
+	ParallelCommandRecorder(std::shared_ptr<JobSystem> jobs);
+
+	// Calls record(context, begin, end) once per chunk of at most
+	// chunkSize items from [0, count).  Contexts start out with no
+	// state, so each chunk has to set everything it relies on
+	void Record(
+		ICommandRecordingBackend& backend,
+		unsigned int count,
+		unsigned int chunkSize,
+		const std::function<void(ID3D11DeviceContext*, unsigned int, unsigned int)>& record);
+
+	// Results of the last Record()
+	unsigned int GetChunkCount() { return chunkCount; }
+
+private:
+	std::shared_ptr<JobSystem> jobs;
+	unsigned int chunkCount;
+};
@@ -0,0 +1,49 @@
+#include "CommandRecordingBackendD3D11.h"
+#include "Graphics.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Deferred contexts are kept from frame to frame, so this
+// only creates them the first time a chunk count is seen.
+// Shader data on them is re-synced from the immediate
+// context for every recording, since whatever the last one
+// left behind is stale by now
+// --------------------------------------------------------
+void CommandRecordingBackendD3D11::Reserve(unsigned int chunkCount)
+{
+	ISimpleShader::BeginContextRecording();
+	while (contexts.size() < chunkCount)
+	{
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+		Graphics::Device->CreateDeferredContext(0, context.GetAddressOf());
+		contexts.push_back(context);
+	}
+	commandLists.resize(contexts.size());
+}
+
+ID3D11DeviceContext* CommandRecordingBackendD3D11::BeginChunk(unsigned int chunk)
+{
+	return contexts[chunk].Get();
+}
+
+void CommandRecordingBackendD3D11::EndChunk(unsigned int chunk)
+{
+	// FALSE: the deferred context starts the next chunk from scratch
+	contexts[chunk]->FinishCommandList(FALSE, commandLists[chunk].ReleaseAndGetAddressOf());
+}
+
+void CommandRecordingBackendD3D11::ExecuteChunk(unsigned int chunk)
+{
+	if (!commandLists[chunk])
+		return;
+
+	Graphics::Context->ExecuteCommandList(commandLists[chunk].Get(), FALSE);
+	commandLists[chunk].Reset();
+}
+
+bool CommandRecordingBackendD3D11::HasDriverCommandLists()
+{
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	Graphics::Device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading));
+	return threading.DriverCommandLists != FALSE;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <vector>
+#include "CommandRecorder.h"
+
+// --------------------------------------------------------
+// Command recording backend that records each chunk on a
+// D3D11 deferred context and plays the command lists back
+// on Graphics::Context.  Playback doesn't restore the
+// immediate context's state, so it comes back in its
+// default state and the caller re-binds what it needs
+// --------------------------------------------------------
+class CommandRecordingBackendD3D11 : public ICommandRecordingBackend
+{
+public:
+	void Reserve(unsigned int chunkCount) override;
+	ID3D11DeviceContext* BeginChunk(unsigned int chunk) override;
+	void EndChunk(unsigned int chunk) override;
+	void ExecuteChunk(unsigned int chunk) override;
+
+	// True if the driver builds command lists itself, rather than
+	// the runtime emulating them (which still works, but gains less)
+	bool HasDriverCommandLists();
+
+private:
+	std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceContext>> contexts;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>> commandLists;
+};
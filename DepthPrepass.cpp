@@ -0,0 +1,106 @@
+#include "DepthPrepass.h"
+#include "BufferStructs.h"
+#include "Graphics.h"
+#include "PathHelpers.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Creates the state and queries used by the depth pre-pass
+// --------------------------------------------------------
+DepthPrepass::DepthPrepass() :
+	enabled(false), draws(0), sceneStatsPending{}, sceneStatsFrame(0), measuring(false), scenePixelInvocations(0)
+{
+	vs = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"DepthPrepassVS.cso").c_str());
+
+	D3D11_DEPTH_STENCIL_DESC equalDesc = {};
+	equalDesc.DepthEnable = true;
+	equalDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	equalDesc.DepthFunc = D3D11_COMPARISON_EQUAL;
+	Graphics::Device->CreateDepthStencilState(&equalDesc, equalState.GetAddressOf());
+
+	D3D11_QUERY_DESC statsDesc = {};
+	statsDesc.Query = D3D11_QUERY_PIPELINE_STATISTICS;
+	for (int i = 0; i < 3; i++)
+		Graphics::Device->CreateQuery(&statsDesc, sceneStatsQueries[i].GetAddressOf());
+}
+
+// --------------------------------------------------------
+// Fills the depth buffer only.  DepthPrepassVS.hlsl shares
+// its position math and camera constants with the lit pass's
+// VertexShader.hlsl (LocalToClip() in CameraInclude.hlsli),
+// so the EQUAL test in the main pass sees the same depths
+// --------------------------------------------------------
+void DepthPrepass::Render(Camera* camera, const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, Microsoft::WRL::ComPtr<ID3D11Buffer> cameraConstants)
+{
+	Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	ID3D11RenderTargetView* nullRTV{};
+	Graphics::Context->OMSetRenderTargets(1, &nullRTV, Graphics::DepthBufferDSV.Get());
+
+	// Front to back, so hidden surfaces fail the depth test early
+	XMFLOAT3 camPos = camera->GetTransform()->GetPosition();
+	std::vector<std::pair<float, GameEntity*>> sorted;
+	for (auto& e : entities)
+	{
+		if (e->IsOcclusionCulled())
+			continue;
+
+		XMFLOAT3 pos = e->GetTransform()->GetPosition();
+		float dist = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&pos), XMLoadFloat3(&camPos))));
+		sorted.push_back({ dist, e.get() });
+	}
+	std::sort(sorted.begin(), sorted.end(),
+		[](const std::pair<float, GameEntity*>& a, const std::pair<float, GameEntity*>& b) { return a.first < b.first; });
+
+	vs->SetShader();
+	Graphics::Context->PSSetShader(0, 0, 0);
+	Graphics::Api->SetConstantBuffers(Graphics::Context.Get(), ShaderStage::Vertex, CAMERA_CONSTANTS_REGISTER, 1, cameraConstants.GetAddressOf());
+
+	draws = 0;
+	for (auto& pair : sorted)
+	{
+		vs->SetMatrix4x4("world", pair.second->GetTransform()->GetWorldMatrix());
+		vs->CopyAllBufferData();
+		pair.second->DrawMesh(stream);
+		draws++;
+	}
+}
+
+void DepthPrepass::BeginSceneStats(ID3D11DeviceContext* context)
+{
+	measuring = !sceneStatsPending[sceneStatsFrame];
+	if (measuring)
+		context->Begin(sceneStatsQueries[sceneStatsFrame].Get());
+}
+
+void DepthPrepass::EndSceneStats(ID3D11DeviceContext* context)
+{
+	if (measuring)
+	{
+		context->End(sceneStatsQueries[sceneStatsFrame].Get());
+		sceneStatsPending[sceneStatsFrame] = true;
+		sceneStatsFrame = (sceneStatsFrame + 1) % 3;
+	}
+	ReadSceneStats(context);
+}
+
+// --------------------------------------------------------
+// Picks up finished pipeline statistics for the lit pass
+// without waiting on the GPU
+// --------------------------------------------------------
+void DepthPrepass::ReadSceneStats(ID3D11DeviceContext* context)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (!sceneStatsPending[i])
+			continue;
+
+		D3D11_QUERY_DATA_PIPELINE_STATISTICS stats = {};
+		if (context->GetData(sceneStatsQueries[i].Get(), &stats, sizeof(stats), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			continue;
+
+		scenePixelInvocations = stats.PSInvocations;
+		sceneStatsPending[i] = false;
+	}
+}
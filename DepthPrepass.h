@@ -0,0 +1,51 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "Camera.h"
+#include "GameEntity.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Optional depth only pass ahead of the lit pass, which then
+// tests EQUAL against it and so only shades what ends up
+// visible.  Also counts the lit pass's pixel shader
+// invocations, to compare overdraw with and without it
+// --------------------------------------------------------
+class DepthPrepass
+{
+public:
+	DepthPrepass();
+
+	bool IsEnabled() { return enabled; }
+	void SetEnabled(bool prepass) { enabled = prepass; }
+
+	// Clears the depth buffer and fills it, front to back
+	void Render(Camera* camera, const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, Microsoft::WRL::ComPtr<ID3D11Buffer> cameraConstants);
+
+	// For the lit pass after a pre-pass: test for the exact depth, never write
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> GetEqualState() { return equalState; }
+
+	// Around the lit pass's draws.  A query only starts once the
+	// last one in its slot has been read back
+	void BeginSceneStats(ID3D11DeviceContext* context);
+	void EndSceneStats(ID3D11DeviceContext* context);
+
+	unsigned int GetDraws() { return enabled ? draws : 0; }
+	unsigned long long GetScenePixelInvocations() { return scenePixelInvocations; }
+
+private:
+	void ReadSceneStats(ID3D11DeviceContext* context);
+
+	bool enabled;
+	std::shared_ptr<SimpleVertexShader> vs;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> equalState;
+	unsigned int draws;
+
+	Microsoft::WRL::ComPtr<ID3D11Query> sceneStatsQueries[3];
+	bool sceneStatsPending[3];
+	int sceneStatsFrame;
+	bool measuring;
+	unsigned long long scenePixelInvocations;
+};
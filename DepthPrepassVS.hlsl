@@ -0,0 +1,16 @@
+#include "ShaderInclude.hlsli"
+#include "CameraInclude.hlsli"
+
+// Only world is needed, but it sits at the same register as
+// VertexShader.hlsl's so the same value feeds the same math
+cbuffer ExternalData : register(b0)
+{
+    matrix world;
+}
+
+// Depth only version of VertexShader.hlsl for the pre-pass
+float4 main(VertexShaderPositionInput input) : SV_POSITION
+{
+    float3 worldPos;
+    return LocalToClip(world, input.localPosition, worldPos);
+}
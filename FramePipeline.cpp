@@ -0,0 +1,63 @@
+#include "FramePipeline.h"
+#include <utility>
+
+FramePipeline::FramePipeline() :
+	packets(),
+	writeIndex(0),
+	readyIndex(1),
+	readIndex(2),
+	readyFresh(false),
+	anyPublished(false),
+	published(0),
+	dropped(0)
+{
+}
+
+FramePacket& FramePipeline::BeginWrite()
+{
+	// Only the writer ever changes writeIndex, so no lock needed
+	return packets[writeIndex];
+}
+
+// --------------------------------------------------------
+// Swaps the finished packet into the ready slot.  Whatever
+// was there becomes the next one to write
+// --------------------------------------------------------
+void FramePipeline::Publish()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (readyFresh)
+		dropped++;
+
+	std::swap(writeIndex, readyIndex);
+	readyFresh = true;
+	anyPublished = true;
+	published++;
+}
+
+const FramePacket* FramePipeline::AcquireLatest()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (readyFresh)
+	{
+		std::swap(readIndex, readyIndex);
+		readyFresh = false;
+	}
+	else if (!anyPublished)
+	{
+		return 0;
+	}
+	return &packets[readIndex];
+}
+
+unsigned long long FramePipeline::GetPublishedCount()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return published;
+}
+
+unsigned long long FramePipeline::GetDroppedCount()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return dropped;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <DirectXMath.h>
+#include <mutex>
+#include <vector>
+
+// One entity's simulated transform
+struct EntitySnapshot
+{
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT3 PitchYawRoll;
+	DirectX::XMFLOAT3 Scale;
+};
+
+// --------------------------------------------------------
+// Everything the simulation produced for one frame.  Once
+// published, the simulation doesn't touch it again until
+// the renderer has moved on to a newer one.  The simulation
+// runs in fixed steps, so the renderer blends from the state
+// before the latest step to the state after it
+// --------------------------------------------------------
+struct FramePacket
+{
+	unsigned long long Frame;
+	float DeltaTime;	// Simulated this frame: steps times the step size
+	float TotalTime;	// As of the latest step
+	float SimulationMs;
+	unsigned int Steps;	// Possibly zero, if the frame was shorter than a step
+	float Alpha;		// 0 renders Previous, 1 renders Entities
+	std::vector<EntitySnapshot> Previous; // One step before Entities
+	std::vector<EntitySnapshot> Entities; // Same order as the entity list
+};
+
+// --------------------------------------------------------
+// Triple buffered hand off from the simulation to the
+// renderer.  One packet is being written, one is the newest
+// finished frame and one is being rendered, so neither side
+// ever waits on the other here.  If the simulation publishes
+// twice before the renderer picks one up, the older packet
+// is dropped.
+//
+// BeginWrite()/Publish() belong to the simulation and
+// AcquireLatest() to the renderer; each side is one thread
+// at a time
+// --------------------------------------------------------
+class FramePipeline
+{
+public:
+	FramePipeline();
+
+	// The packet to fill in.  Stays the same until Publish()
+	FramePacket& BeginWrite();
+	void Publish();
+
+	// The newest published packet, which stays valid until the next
+	// call.  Null until something has been published
+	const FramePacket* AcquireLatest();
+
+	// Stats
+	unsigned long long GetPublishedCount();
+	unsigned long long GetDroppedCount();
+
+private:
+	FramePacket packets[3];
+	int writeIndex;
+	int readyIndex;
+	int readIndex;
+	bool readyFresh;	// Ready packet hasn't been acquired yet
+	bool anyPublished;
+
+	std::mutex lock;
+	unsigned long long published;
+	unsigned long long dropped;
+};
@@ -0,0 +1,151 @@
+#include "FrameTiming.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+double SteadyFrameClock::Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SteadyFrameClock::Sleep(double seconds)
+{
+	if (seconds <= 0.0)
+		std::this_thread::yield();
+	else
+		std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+FixedTimestep::FixedTimestep(double step, unsigned int maxSteps) :
+	step(step > 0.0 ? step : 1.0 / 60.0),
+	maxSteps(maxSteps > 0 ? maxSteps : 1),
+	accumulator(0.0),
+	stepCount(0),
+	droppedTime(0.0)
+{
+}
+
+// --------------------------------------------------------
+// Steps already taken keep their time; only what's waiting
+// in the accumulator is measured in the new step size.  A
+// smaller step can leave several steps waiting, which the
+// next Advance() runs
+// --------------------------------------------------------
+void FixedTimestep::SetStep(double newStep)
+{
+	if (newStep <= 0.0)
+		return;
+
+	double time = GetTime();
+	step = newStep;
+	stepCount = (unsigned long long)(time / step);
+	accumulator += time - stepCount * step;
+}
+
+unsigned int FixedTimestep::Advance(double elapsed)
+{
+	if (elapsed > 0.0)
+		accumulator += elapsed;
+
+	unsigned int steps = 0;
+	while (accumulator >= step && steps < maxSteps)
+	{
+		accumulator -= step;
+		steps++;
+	}
+
+	// Still behind after the limit: skip the whole steps, keep the remainder
+	if (accumulator >= step)
+	{
+		double remainder = std::fmod(accumulator, step);
+		droppedTime += accumulator - remainder;
+		accumulator = remainder;
+	}
+
+	stepCount += steps;
+	return steps;
+}
+
+FramePacer::FramePacer(std::shared_ptr<IFrameClock> clock) :
+	clock(clock),
+	targetFrameRate(0.0),
+	spinTime(0.002),
+	nextFrame(0.0),
+	scheduled(false),
+	lastWait(0.0)
+{
+}
+
+void FramePacer::SetTargetFrameRate(double framesPerSecond)
+{
+	targetFrameRate = framesPerSecond > 0.0 ? framesPerSecond : 0.0;
+	scheduled = false;
+}
+
+double FramePacer::WaitForNextFrame()
+{
+	double start = clock->Now();
+	if (targetFrameRate <= 0.0)
+	{
+		lastWait = 0.0;
+		return start;
+	}
+
+	double interval = 1.0 / targetFrameRate;
+	if (!scheduled)
+	{
+		nextFrame = start;
+		scheduled = true;
+	}
+
+	double now = start;
+	if (nextFrame - now > spinTime)
+	{
+		clock->Sleep(nextFrame - now - spinTime);
+		now = clock->Now();
+	}
+	while (now < nextFrame)
+	{
+		clock->Sleep(0.0);
+		now = clock->Now();
+	}
+
+	// A whole interval late means this frame ran long, so start a
+	// new grid here rather than rushing to catch up
+	nextFrame += interval;
+	if (now >= nextFrame)
+		nextFrame = now + interval;
+
+	lastWait = now - start;
+	return now;
+}
+
+InputLatencyTracker::InputLatencyTracker() :
+	newestMs(0.0f), oldestMs(0.0f), latchMs(0.0f), averageMs(0.0f), maxMs(0.0f),
+	windowSum(0.0), windowSamples(0), windowMax(0.0f), windowStart(0)
+{
+}
+
+void InputLatencyTracker::Record(long long presented, long long newestEvent, long long oldestEvent, long long latch)
+{
+	if (newestEvent != 0)
+	{
+		newestMs = (presented - newestEvent) / 1000000.0f;
+		oldestMs = (presented - oldestEvent) / 1000000.0f;
+		windowSum += oldestMs;
+		windowSamples++;
+		if (oldestMs > windowMax)
+			windowMax = oldestMs;
+	}
+	latchMs = latch != 0 ? (presented - latch) / 1000000.0f : 0.0f;
+
+	if (presented - windowStart >= 1000000000LL)
+	{
+		averageMs = windowSamples > 0 ? (float)(windowSum / windowSamples) : 0.0f;
+		maxMs = windowMax;
+		windowSum = 0.0;
+		windowSamples = 0;
+		windowMax = 0.0f;
+		windowStart = presented;
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <memory>
+
+// --------------------------------------------------------
+// Where frame timing gets the time from.  Seconds, from any
+// starting point.  Tests swap in a clock they control
+// --------------------------------------------------------
+class IFrameClock
+{
+public:
+	virtual ~IFrameClock() = default;
+	virtual double Now() = 0;
+
+	// May wake up late; zero just gives up the rest of the time slice
+	virtual void Sleep(double seconds) = 0;
+};
+
+// The real clock, from std::chrono::steady_clock
+class SteadyFrameClock : public IFrameClock
+{
+public:
+	double Now() override;
+	void Sleep(double seconds) override;
+};
+
+// --------------------------------------------------------
+// Turns variable frame times into a whole number of fixed
+// simulation steps.  Leftover time carries into the next
+// frame, and how far it is into the next step (the alpha)
+// says how far to blend from the previous step's state to
+// the latest one when rendering.  A long stall (breakpoint,
+// window drag) would otherwise demand a burst of catch-up
+// steps, so anything past maxSteps a frame is dropped
+// --------------------------------------------------------
+class FixedTimestep
+{
+public:
+	FixedTimestep(double step = 1.0 / 60.0, unsigned int maxSteps = 8);
+
+	void SetStep(double step);
+	double GetStep() { return step; }
+
+	// Adds one frame's elapsed time and returns how many steps
+	// to simulate for it, possibly zero
+	unsigned int Advance(double elapsed);
+
+	// 0 to 1 after Advance(): how far the leftover time is into
+	// the next step
+	double GetAlpha() { return accumulator / step; }
+
+	// Simulated time as of the latest step
+	double GetTime() { return stepCount * step; }
+	unsigned long long GetStepCount() { return stepCount; }
+
+	// Total time thrown away by the step limit
+	double GetDroppedTime() { return droppedTime; }
+
+private:
+	double step;
+	unsigned int maxSteps;
+	double accumulator;
+	unsigned long long stepCount;
+	double droppedTime;
+};
+
+// --------------------------------------------------------
+// Optional frame rate limit.  Sleeps most of the way to the
+// next frame and spins the rest, since sleeps can overshoot
+// by a millisecond or more.  Frames are scheduled on a fixed
+// grid so small wake up errors don't build up, but a frame
+// that runs long moves the grid instead of being followed by
+// a burst of short ones
+// --------------------------------------------------------
+class FramePacer
+{
+public:
+	FramePacer(std::shared_ptr<IFrameClock> clock);
+
+	// Zero for no limit
+	void SetTargetFrameRate(double framesPerSecond);
+	double GetTargetFrameRate() { return targetFrameRate; }
+
+	// How early to wake up and start spinning
+	void SetSpinTime(double seconds) { spinTime = seconds; }
+
+	// Blocks until the next frame is due and returns the time it
+	// started.  Without a limit, returns right away
+	double WaitForNextFrame();
+
+	// Time spent in the last WaitForNextFrame()
+	double GetLastWait() { return lastWait; }
+
+private:
+	std::shared_ptr<IFrameClock> clock;
+	double targetFrameRate;
+	double spinTime;
+	double nextFrame;
+	bool scheduled;
+	double lastWait;
+};
+
+// --------------------------------------------------------
+// Input to present, for the newest and oldest event a frame
+// picked up, plus a once a second average and max of the
+// oldest (the worst case).  Times are in Profiler::Now()
+// nanoseconds, with zero meaning there wasn't one
+// --------------------------------------------------------
+class InputLatencyTracker
+{
+public:
+	InputLatencyTracker();
+
+	// Call right after Present() returns
+	void Record(long long presented, long long newestEvent, long long oldestEvent, long long latch);
+
+	float GetNewestMs() { return newestMs; }
+	float GetOldestMs() { return oldestMs; }
+	float GetLatchMs() { return latchMs; }
+
+	// Of the oldest, over the last full second
+	float GetAverageMs() { return averageMs; }
+	float GetMaxMs() { return maxMs; }
+
+private:
+	float newestMs;
+	float oldestMs;
+	float latchMs;
+	float averageMs;
+	float maxMs;
+	double windowSum;
+	unsigned int windowSamples;
+	float windowMax;
+	long long windowStart;
+};
@@ -16,21 +16,56 @@
 #include "imgui_impl_win32.h"
 #include <iostream>
 #include <format> 
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <random>
+#include <filesystem>
 #include "SimpleShader.h"
 #include"Material.h"
+#include "RenderStats.h"
 #include "WICTextureLoader.h"
 
 // For the DirectX Math library
 using namespace DirectX;
 
 
+
+Game::Game(const BenchmarkSettings& benchmarkSettings) :
+	benchmarkSettings(benchmarkSettings)
+{
+}
+
 // --------------------------------------------------------
 // Called once per program, after the window and graphics API
 // are initialized but before the game loop begins
 // --------------------------------------------------------
 void Game::Initialize()
 {
-	
+	// One worker per hardware thread, this one included
+	Profiler::SetThreadName("Main");
+	jobs = std::make_shared<JobSystem>();
+	simulation = std::make_shared<SceneSimulation>(jobs);
+	if (benchmarkSettings.Enabled)
+	{
+		// One step per benchmark frame, exactly
+		benchmark = std::make_shared<Benchmark>(benchmarkSettings);
+		simulation->GetTimestep().SetStep(benchmarkSettings.TimeStep);
+	}
+	else
+		simulation->GetTimestep().SetStep(1.0 / simulationRate);
+	commandRecorder = std::make_shared<ParallelCommandRecorder>(jobs);
+	commandBackend = std::make_shared<CommandRecordingBackendD3D11>();
+
+	// Camera constants are shared by every entity, so they're
+	// made here rather than by each shader that uses them
+	ISimpleShader::SharedConstantBuffers.insert("CameraData");
+	D3D11_BUFFER_DESC cameraDesc = {};
+	cameraDesc.Usage = D3D11_USAGE_DEFAULT;
+	cameraDesc.ByteWidth = sizeof(CameraConstants);
+	cameraDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	Graphics::Api->CreateBuffer(cameraDesc, 0, cameraConstants.GetAddressOf());
+
 	//set up cameras
 	std::shared_ptr<Camera>cam1 = std::make_shared<Camera>(
 		XMFLOAT3(-3, 2, -20.0f), //pos
@@ -69,6 +104,10 @@ void Game::Initialize()
 
 	activeCam = cam1;
 	blurRadius = 0;
+	CreateShadowMap();
+	CreateShadowAtlas();
+	depthPrepass = std::make_shared<DepthPrepass>();
+	occlusion = std::make_shared<OcclusionCuller>(Window::Width(), Window::Height());
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
@@ -93,9 +132,6 @@ void Game::Initialize()
 		//ImGui::StyleColorsLight();
 		//ImGui::StyleColorsClassic();
 	}
-	/*shadowRes = 2048;
-	shadowProjSize = 28.f;
-	CreateShadowMap();*/
 
 
 
@@ -117,6 +153,12 @@ Game::~Game()
 
 }
 
+void Game::SetFramePacer(std::shared_ptr<FramePacer> pacer)
+{
+	framePacer = pacer;
+	frameRateLimit = pacer ? (int)pacer->GetTargetFrameRate() : 0;
+}
+
 
 
 
@@ -213,7 +255,6 @@ void Game::CreateGeometry()
 	std::shared_ptr<SimplePixelShader> envReflexPS = std::make_shared<SimplePixelShader>(
 		Graphics::Device, Graphics::Context, FixPath(L"ReflectSkyPS.cso").c_str());
 
-	shadowVS = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"ShadowVS.cso").c_str());
 	
 	
 
@@ -222,13 +263,16 @@ void Game::CreateGeometry()
 
 	
 	
-	std::shared_ptr<Mesh> cube=std::make_shared<Mesh>("Cube",FixPath("../../Assets/Models/cube.obj").c_str());
-	std::shared_ptr<Mesh> cyl = std::make_shared<Mesh>("Cylinder", FixPath("../../Assets/Models/cylinder.obj").c_str());
-	std::shared_ptr<Mesh> helix = std::make_shared<Mesh>("Helix", FixPath("../../Assets/Models/helix.obj").c_str());
-	std::shared_ptr<Mesh> quad = std::make_shared<Mesh>("Quad", FixPath("../../Assets/Models/quad.obj").c_str());
-	std::shared_ptr<Mesh> quadDS= std::make_shared<Mesh>("Double Sided Quad", FixPath("../../Assets/Models/quad_double_sided.obj").c_str());
-	std::shared_ptr<Mesh> sphere = std::make_shared<Mesh>("Sphere", FixPath("../../Assets/Models/sphere.obj").c_str());
-	std::shared_ptr<Mesh> torus = std::make_shared<Mesh>("Torus", FixPath("../../Assets/Models/torus.obj").c_str());
+	// Every static mesh goes in one set of shared buffers
+	geometryArena = std::make_shared<GeometryArena>(65536, 256 * 1024);
+
+	std::shared_ptr<Mesh> cube=std::make_shared<Mesh>("Cube",FixPath("../../Assets/Models/cube.obj").c_str(), true, geometryArena);
+	std::shared_ptr<Mesh> cyl = std::make_shared<Mesh>("Cylinder", FixPath("../../Assets/Models/cylinder.obj").c_str(), true, geometryArena);
+	std::shared_ptr<Mesh> helix = std::make_shared<Mesh>("Helix", FixPath("../../Assets/Models/helix.obj").c_str(), true, geometryArena);
+	std::shared_ptr<Mesh> quad = std::make_shared<Mesh>("Quad", FixPath("../../Assets/Models/quad.obj").c_str(), true, geometryArena);
+	std::shared_ptr<Mesh> quadDS= std::make_shared<Mesh>("Double Sided Quad", FixPath("../../Assets/Models/quad_double_sided.obj").c_str(), true, geometryArena);
+	std::shared_ptr<Mesh> sphere = std::make_shared<Mesh>("Sphere", FixPath("../../Assets/Models/sphere.obj").c_str(), true, geometryArena);
+	std::shared_ptr<Mesh> torus = std::make_shared<Mesh>("Torus", FixPath("../../Assets/Models/torus.obj").c_str(), true, geometryArena);
 	meshList.insert(meshList.begin(), { cube,cyl,helix,quad,quadDS,sphere, torus });
 
 	
@@ -295,19 +339,22 @@ void Game::CreateGeometry()
 	for (auto& e : entityList)
 	{
 		e->GetTransform()->MoveAbsolute(x, 0, 0);
+		e->SetAnimation(ENTITY_ANIMATE_SPIN);
 		x += 3;
 	}
-	ResizePPRs();
-	ppPS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PostProcessPS.cso").c_str());
-	ppVS = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"FullscreenVS.cso").c_str());
-	// Sampler state for post processing
-	D3D11_SAMPLER_DESC ppSampDesc = {};
-	ppSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-	ppSampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-	ppSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-	ppSampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	ppSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
-	Graphics::Device->CreateSamplerState(&ppSampDesc, ppSampler.GetAddressOf());
+	entityList[1]->SetAnimation(ENTITY_ANIMATE_SPIN | ENTITY_ANIMATE_BOB);
+	entityList[2]->SetAnimation(ENTITY_ANIMATE_SPIN | ENTITY_ANIMATE_SWAY);
+
+	// The last entity is never animated, so its shadow can be cached
+	entityList.back()->SetAnimation(0);
+	entityList.back()->SetStatic(true);
+	entityList.back()->SetOccluder(true);
+	simulation->Reset(entityList);
+	CreatePostProcessChain();
+	graphBackend = std::make_shared<RenderGraphBackendD3D11>();
+	gpuProfiler = std::make_shared<GpuProfiler>();
+	graphBackend->SetGpuProfiler(gpuProfiler);
+	BuildRenderGraph();
 	
 	//lights
 	Light light1 = {};
@@ -358,10 +405,66 @@ void Game::CreateGeometry()
 				XMVector3Normalize(XMLoadFloat3(&lights[i].Direction))
 			);
 
+	if (benchmarkSettings.Enabled)
+		CreateBenchmarkScene();
+}
 
+// --------------------------------------------------------
+// Swaps the hand built scene for a generated one: a grid of
+// entities cycling through the meshes, materials tinted and
+// lights placed from the seed.  The same settings always
+// build the same scene
+// --------------------------------------------------------
+void Game::CreateBenchmarkScene()
+{
+	std::mt19937 rng(benchmarkSettings.Seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
 
+	std::vector<std::shared_ptr<Material>> materials;
+	for (unsigned int i = 0; i < benchmarkSettings.Materials; i++)
+	{
+		std::shared_ptr<Material> mat = std::make_shared<Material>(*matList[i % matList.size()]);
+		mat->SetColorTint(XMFLOAT4(0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng), 1.0f));
+		materials.push_back(mat);
+	}
+	matList = materials;
 
-	
+	entityList.clear();
+	unsigned int side = (unsigned int)ceil(sqrt((float)benchmarkSettings.Entities));
+	for (unsigned int i = 0; i < benchmarkSettings.Entities; i++)
+	{
+		std::shared_ptr<GameEntity> e = std::make_shared<GameEntity>(meshList[i % meshList.size()], materials[i % materials.size()]);
+		e->GetTransform()->SetPosition(((int)(i % side) - (int)side / 2) * 3.0f, 0, (i / side) * 3.0f);
+		e->GetTransform()->SetRotation(0, unit(rng) * XM_2PI, 0);
+		e->SetAnimation(ENTITY_ANIMATE_SPIN);
+		entityList.push_back(e);
+	}
+	entityList.back()->SetAnimation(0);
+	entityList.back()->SetStatic(true);
+	entityList.back()->SetOccluder(true);
+	simulation->Reset(entityList);
+
+	// A shadowed sun, then point lights scattered over the grid
+	float extent = side * 3.0f;
+	lights.clear();
+	for (unsigned int i = 0; i < benchmarkSettings.Lights; i++)
+	{
+		Light l = {};
+		l.Intensity = 1.0f;
+		l.Color = XMFLOAT3(0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng));
+		if (i == 0)
+		{
+			l.Type = LIGHT_TYPE_DIRECTIONAL;
+			XMStoreFloat3(&l.Direction, XMVector3Normalize(XMVectorSet(0.3f, -1.0f, 0.2f, 0)));
+		}
+		else
+		{
+			l.Type = LIGHT_TYPE_POINT;
+			l.Position = XMFLOAT3((unit(rng) - 0.5f) * extent, 1.0f + 2.0f * unit(rng), unit(rng) * extent);
+			l.Range = 10.0f;
+		}
+		lights.push_back(l);
+	}
 }
 
 
@@ -376,7 +479,8 @@ void Game::OnResize()
 		c->UpdateProjectionMatrix(Window::AspectRatio());
 	}
 
-	if (Graphics::Device)ResizePPRs();
+	if (postProcess)postProcess->Resize(Window::Width(), Window::Height());
+	if (occlusion) occlusion->Resize(Window::Width(), Window::Height());
 	
 }
 /// <summary>
@@ -385,6 +489,7 @@ void Game::OnResize()
 /// </summary>
 void Game::UpdateImGui(float deltaTime,float totalTime)
 {
+	PROFILE_SCOPE("UpdateImGui");
 	ImGuiIO& io = ImGui::GetIO();
 	io.DeltaTime = deltaTime;
 	io.DisplaySize.x = (float)Window::Width();
@@ -402,9 +507,44 @@ void Game::UpdateImGui(float deltaTime,float totalTime)
 	ImGui::Begin("Assignment Window");
 	ImGui::Text("Framrate: %f fps", ImGui::GetIO().Framerate);
 	ImGui::Text("Window Resolution: %dx%d", Window::Width(), Window::Height());
+	ImGui::Text("Post Process Textures: %u (%.2f MB)", postProcess->GetPooledTextureCount(), postProcess->GetPooledMemory() / (1024.0f * 1024.0f));
 	ImGui::ColorEdit4("Background Color", &color.x);
 	ImGui::ColorEdit4("cb colorTint", &colorTint.x);
 
+	if (ImGui::TreeNode("Render Stats"))
+	{
+		if (!Graphics::Api->IsSubmitting())
+			ImGui::Text("Submission off: counted, not submitted");
+		ImGui::Text("Buffers and Textures: %.2f MB live", Graphics::Api->GetStats().ResourceBytes / (1024.0f * 1024.0f));
+
+		// Last few seconds of each counter, newest on the right
+		const std::deque<RenderStatsFrame>& history = RenderStats::GetHistory();
+		auto plot = [&](const char* label, unsigned long long RenderStatsFrame::* counter, float scale)
+			{
+				float values[RENDER_STATS_HISTORY_FRAMES] = {};
+				float peak = 0.0f;
+				for (size_t i = 0; i < history.size(); i++)
+				{
+					values[i] = (history[i].*counter) * scale;
+					peak = max(peak, values[i]);
+				}
+				float current = history.empty() ? 0.0f : values[history.size() - 1];
+				char overlay[64];
+				snprintf(overlay, sizeof(overlay), "%.0f (peak %.0f)", current, peak);
+				ImGui::PlotLines(label, values, (int)history.size(), 0, overlay, 0.0f, max(peak * 1.1f, 1.0f), ImVec2(0, 40));
+			};
+		plot("Draw Calls", &RenderStatsFrame::DrawCalls, 1.0f);
+		plot("Triangles", &RenderStatsFrame::Triangles, 1.0f);
+		plot("SetShader Calls", &RenderStatsFrame::ShaderSets, 1.0f);
+		plot("SRV Binds", &RenderStatsFrame::ShaderResourceBinds, 1.0f);
+		plot("Sampler Binds", &RenderStatsFrame::SamplerBinds, 1.0f);
+		plot("CB Uploads (KB)", &RenderStatsFrame::ConstantBufferBytes, 1.0f / 1024.0f);
+		plot("Material Binds", &RenderStatsFrame::MaterialBinds, 1.0f);
+		plot("Resources Created", &RenderStatsFrame::ResourcesCreated, 1.0f);
+
+		ImGui::TreePop();
+	}
+
 	if (ImGui::TreeNode("Lights"))
 	{
 		int count = 1;
@@ -457,10 +597,371 @@ void Game::UpdateImGui(float deltaTime,float totalTime)
 		ImGui::TreePop();
 	}
 
-	//ImGui::Image((ImTextureID)shadowSRV.Get(), ImVec2(512, 512));
+	if (ImGui::TreeNode("Shadows"))
+	{
+		CascadedShadowSettings& shadowSettings = shadowMap->GetSettings();
+		ImGui::Checkbox("Enabled", &shadowSettings.Enabled);
+		ImGui::SliderInt("Cascades", &shadowSettings.CascadeCount, 1, MAX_SHADOW_CASCADES);
+		ImGui::SliderFloat("Split Lambda", &shadowSettings.Lambda, 0.0f, 1.0f);
+		ImGui::SliderFloat("Distance", &shadowSettings.Distance, 5.0f, 100.0f);
+		ImGui::Checkbox("Cache Static Casters", &shadowSettings.Caching);
+		ImGui::Checkbox("Animate Entities", &animateEntities);
+		ImGui::Text("Caster Draws: %u", shadowMap->GetCasterDraws() + shadowAtlas->GetCasterDraws());
+		ImGui::Text("Static Cascades Re-rendered: %u", shadowMap->GetStaticCascadeRenders());
+		ImGui::Text("Static Cascades Copied: %u", shadowMap->GetStaticCascadeCopies());
+
+		ImGui::Separator();
+		LocalShadowSettings& localSettings = shadowAtlas->GetSettings();
+		ImGui::Checkbox("Point/Spot Shadows", &localSettings.Enabled);
+		int tileSizeIndex = 0;
+		while ((128 << tileSizeIndex) < localSettings.MaxTileSize)
+			tileSizeIndex++;
+		if (ImGui::Combo("Max Tile Size", &tileSizeIndex, "128\0" "256\0" "512\0" "1024\0" "2048\0"))
+			localSettings.MaxTileSize = 128 << tileSizeIndex;
+		ImGui::Text("Atlas Tiles: %u (%.0f%% used)", shadowAtlas->GetAtlas().GetTileCount(), shadowAtlas->GetAtlas().GetUsage() * 100.0f);
+		ImGui::Text("Atlas Tiles Re-rendered: %u", shadowAtlas->GetRenderedTiles());
+		ImGui::Image((ImTextureID)shadowAtlas->GetShaderResource().Get(), ImVec2(256, 256));
+		for (int c = 0; c < shadowMap->GetActiveCascadeCount(); c++)
+		{
+			const ShadowCascades::Cascade& cascade = shadowMap->GetCascade(c);
+			ImGui::Text("Cascade %d: %.1f - %.1f (%.3f units/texel)", c, cascade.SplitNear, cascade.SplitFar, cascade.TexelSize);
+		}
+		ImGui::TreePop();
+	}
 		
-	ImGui::SliderInt("Blur Disance", &blurRadius, 0, 50);
+	if (ImGui::SliderInt("Blur Disance", &blurRadius, 0, 50))
+		postProcess->SetPassEnabled("Blur", blurRadius > 0);
+
+	if (ImGui::TreeNode("Tonemapping"))
+	{
+		ImGui::Combo("Operator", &tonemapOperator, "None\0Reinhard\0ACES\0");
+		ImGui::Checkbox("Auto Exposure", &autoExposure);
+		if (autoExposure)
+		{
+			ImGui::SliderFloat("Key", &exposureKey, 0.01f, 1.0f);
+			ImGui::DragFloatRange2("Exposure Range", &minExposure, &maxExposure, 0.01f, 0.001f, 64.0f);
+		}
+		else
+		{
+			ImGui::SliderFloat("Exposure", &manualExposure, 0.01f, 16.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
+		}
+		ImGui::SliderFloat("Compensation (EV)", &exposureCompensation, -5.0f, 5.0f);
+
+		// Display value for scene luminance 0 to 8 (before exposure)
+		float curve[64];
+		for (int i = 0; i < 64; i++)
+			curve[i] = Tonemap::LinearToSRGB(Tonemap::Apply((Tonemap::Operator)tonemapOperator, i / 8.0f));
+		ImGui::PlotLines("Curve", curve, 64, 0, 0, 0.0f, 1.0f, ImVec2(0, 60));
+
+		ImGui::TreePop();
+	}
+	if (ImGui::TreeNode("Depth Pre-pass"))
+	{
+		bool prepass = depthPrepass->IsEnabled();
+		if (ImGui::Checkbox("Enabled", &prepass))
+		{
+			depthPrepass->SetEnabled(prepass);
+			BuildRenderGraph();
+		}
+		bool positionOnly = depthStream == MeshStream::Position;
+		if (ImGui::Checkbox("Position-only Stream (Shadows + Pre-pass)", &positionOnly))
+			depthStream = positionOnly ? MeshStream::Position : MeshStream::Full;
+		ImGui::Text("Depth Pass Vertex Fetch: %u bytes", positionOnly ? (unsigned int)sizeof(XMFLOAT3) : (unsigned int)sizeof(PackedVertex));
+		ImGui::Text("Pre-pass Draws: %u", depthPrepass->GetDraws());
+		ImGui::Text("Lit Draws: %u", sceneDraws);
+		ImGui::Text("Lit Pixel Shader Invocations: %llu", depthPrepass->GetScenePixelInvocations());
+		float pixels = (float)Window::Width() * Window::Height();
+		ImGui::Text("Lit Pixels per Screen Pixel: %.2f", pixels > 0 ? depthPrepass->GetScenePixelInvocations() / pixels : 0.0f);
+
+		std::string order;
+		for (int index : renderGraph.GetExecutionOrder())
+			order += renderGraph.GetPass(index).Name + " ";
+		ImGui::TextWrapped("Pass Order: %s", order.c_str());
+		ImGui::TreePop();
+	}
 	ImGui::Checkbox("Emssive Map", &useEmissive);
+	ImGui::SliderFloat("Emissive Intensity", &emissiveIntensity, 0.0f, 16.0f);
+
+	if (ImGui::TreeNode("Level of Detail"))
+	{
+		ImGui::SliderInt("Force LOD (-1 = auto)", &forcedLod, -1, MAX_MESH_LODS - 1);
+		ImGui::SliderFloat("LOD 1 Below", &lodThresholds[0], 0.01f, 1.0f);
+		ImGui::SliderFloat("LOD 2 Below", &lodThresholds[1], 0.01f, lodThresholds[0]);
+		ImGui::SliderFloat("LOD 3 Below", &lodThresholds[2], 0.01f, lodThresholds[1]);
+		ImGui::SliderFloat("Hysteresis", &lodHysteresis, 0.0f, 0.5f);
+
+		int triangles = 0;
+		for (auto& e : entityList)
+		{
+			std::shared_ptr<Mesh> m = e->GetMesh();
+			triangles += m->GetLodIndexCount(min(e->GetLod(), m->GetLodCount() - 1)) / 3;
+			ImGui::Text("%s: LOD %d of %d (%d tris, error %.4f)", m->GetName(), e->GetLod(), m->GetLodCount(),
+				m->GetLodIndexCount(min(e->GetLod(), m->GetLodCount() - 1)) / 3,
+				m->GetLodError(min(e->GetLod(), m->GetLodCount() - 1)));
+		}
+		ImGui::Text("Scene Triangles: %d", triangles);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Meshlet Culling"))
+	{
+		ImGui::Checkbox("Enabled", &meshletCulling);
+		ImGui::Text("Meshlets: %u (%u off screen, %u back facing)",
+			meshletTotal, meshletStats.FrustumCulled, meshletStats.BackFaceCulled);
+		ImGui::Text("Triangles Submitted: %u of %u", meshletStats.TrianglesKept, meshletTrianglesTotal);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Frame Pacing"))
+	{
+		if (ImGui::SliderInt("Simulation Rate (Hz)", &simulationRate, 10, 240))
+			simulation->GetTimestep().SetStep(1.0 / simulationRate);
+		ImGui::Checkbox("Interpolate Between Steps", &simulation->GetSettings().Interpolate);
+		ImGui::Text("Steps This Frame: %u, Blend: %.2f", simulation->GetDisplayedSteps(), simulation->GetDisplayedAlpha());
+		ImGui::Text("Time Dropped (too far behind): %.3f s", simulation->GetTimestep().GetDroppedTime());
+
+		ImGui::Text("Waitable Swap Chain: %s", Graphics::HasFrameLatencyWaitable() ? "Yes" : "No");
+		if (framePacer)
+		{
+			if (ImGui::SliderInt("Frame Rate Limit", &frameRateLimit, 0, 480, frameRateLimit == 0 ? "Off" : "%d fps"))
+				framePacer->SetTargetFrameRate(frameRateLimit);
+			ImGui::Text("Waited for Limit: %.3f ms", framePacer->GetLastWait() * 1000.0);
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Input Latency"))
+	{
+		ImGui::Checkbox("Late Latch Mouse Look", &lateLatchInput);
+		if (lateLatchInput)
+		{
+			ImGui::SliderFloat("Culling Margin", &lateLatchMarginDegrees, 0.0f, 30.0f, "%.1f degrees");
+			ImGui::Text("Culling Redone: %s", lateLatchRecull ? "Yes" : "No");
+		}
+		ImGui::Text("Newest Input to Present: %.3f ms", inputLatency.GetNewestMs());
+		ImGui::Text("Oldest Input to Present: %.3f ms", inputLatency.GetOldestMs());
+		ImGui::Text("Last Second: %.3f ms average, %.3f ms max", inputLatency.GetAverageMs(), inputLatency.GetMaxMs());
+		if (lateLatchInput)
+			ImGui::Text("Latch to Present: %.3f ms", inputLatency.GetLatchMs());
+		ImGui::Text("Events Dropped: %llu", Input::GetDroppedEventCount());
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Job System"))
+	{
+		ImGui::Checkbox("Parallel Update", &parallelUpdate);
+		ImGui::SliderInt("Entities per Job", &jobGrainSize, 1, 16);
+		ImGui::Text("Workers: %u (including the main thread)", jobs->GetWorkerCount());
+		for (size_t w = 0; w < jobStats.size(); w++)
+		{
+			ImGui::Text("Worker %d: %5.1f%% busy, %llu jobs, %llu stolen", (int)w,
+				jobStats[w].Utilization * 100.0f, jobStats[w].JobsRun, jobStats[w].Steals);
+		}
+
+		ImGui::Checkbox("Pipelined Simulation", &simulation->GetSettings().Pipelined);
+		ImGui::Text("Rendering Simulation Frame %llu (%.3f ms to simulate)", simulation->GetDisplayedFrame(), simulation->GetDisplayedSimulationMs());
+		ImGui::Text("Frames Published: %llu, Dropped: %llu", simulation->GetPipeline().GetPublishedCount(), simulation->GetPipeline().GetDroppedCount());
+
+		ImGui::Checkbox("Parallel Scene Recording", &parallelRecording);
+		ImGui::SliderInt("Draws per Chunk", &drawsPerChunk, 1, 16);
+		ImGui::Text("Scene Recording: %.3f ms, %u deferred command lists", sceneRecordMs,
+			parallelRecording && sceneDraws > (unsigned int)drawsPerChunk ? commandRecorder->GetChunkCount() : 0);
+		ImGui::Text("Driver Command Lists: %s", commandBackend->HasDriverCommandLists() ? "Yes" : "No (emulated by the runtime)");
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Profiler"))
+	{
+		if (ImGui::Checkbox("Pause", &profilerPaused) && profilerPaused)
+		{
+			profilerSnapshot = Profiler::GetHistory();
+			profilerFramesBack = 0;
+		}
+		const std::deque<ProfileFrame>& history = profilerPaused ? profilerSnapshot : Profiler::GetHistory();
+		if (profilerPaused)
+			ImGui::SliderInt("Frames Back", &profilerFramesBack, 0, max((int)history.size() - 1, 0));
+
+		// GPU results come back late, so the live view shows the
+		// newest frame that has them
+		int back = profilerPaused ? profilerFramesBack : (int)gpuProfiler->GetLatency();
+		if (back < (int)history.size())
+		{
+			const ProfileFrame& frame = history[history.size() - 1 - back];
+			std::vector<std::string> threadNames = Profiler::GetThreadNames();
+			unsigned int rows = (unsigned int)threadNames.size() + 1; // Last row is the GPU
+
+			double gpuMs = 0.0;
+			long long frameEnd = frame.EndNs;
+			std::vector<unsigned int> rowDepth(rows, 1);
+			for (auto& e : frame.Events)
+			{
+				if (e.Thread < rows - 1)
+					rowDepth[e.Thread] = max(rowDepth[e.Thread], e.Depth + 1);
+			}
+			for (auto& e : frame.GpuEvents)
+			{
+				rowDepth[rows - 1] = max(rowDepth[rows - 1], e.Depth + 1);
+				frameEnd = max(frameEnd, e.EndNs);
+				if (e.Depth == 0)
+					gpuMs += (e.EndNs - e.StartNs) / 1e6;
+			}
+			ImGui::Text("Frame %llu: %.3f ms CPU, %.3f ms GPU in passes (%u frames behind)",
+				frame.Index, (frame.EndNs - frame.StartNs) / 1e6, gpuMs, gpuProfiler->GetLatency());
+
+			// Timeline: a row per thread, nested scopes stacked under
+			// their parents, then the GPU
+			const float labelWidth = 80.0f;
+			const float barHeight = ImGui::GetTextLineHeight() + 2.0f;
+			ImDrawList* drawList = ImGui::GetWindowDrawList();
+			ImVec2 origin = ImGui::GetCursorScreenPos();
+			float width = max(ImGui::GetContentRegionAvail().x - labelWidth, 50.0f);
+			double scale = width / (double)max(frameEnd - frame.StartNs, 1LL);
+
+			std::vector<float> rowTop(rows);
+			float y = origin.y;
+			for (unsigned int r = 0; r < rows; r++)
+			{
+				rowTop[r] = y;
+				const char* label = r < rows - 1 ? threadNames[r].c_str() : "GPU";
+				drawList->AddText(ImVec2(origin.x, y), ImGui::GetColorU32(ImGuiCol_Text), label);
+				y += rowDepth[r] * barHeight + 4.0f;
+			}
+
+			auto drawEvent = [&](const ProfileEvent& e, float top)
+				{
+					float x0 = origin.x + labelWidth + (float)((e.StartNs - frame.StartNs) * scale);
+					float x1 = max(origin.x + labelWidth + (float)((e.EndNs - frame.StartNs) * scale), x0 + 1.0f);
+					float y0 = top + e.Depth * barHeight;
+					ImVec2 a(x0, y0);
+					ImVec2 b(x1, y0 + barHeight - 1.0f);
+					float hue = (float)(std::hash<std::string_view>()(e.Name) % 360) / 360.0f;
+					drawList->AddRectFilled(a, b, ImColor::HSV(hue, 0.5f, 0.85f));
+					if (ImGui::CalcTextSize(e.Name).x < x1 - x0 - 4.0f)
+						drawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32(0, 0, 0, 255), e.Name);
+					if (ImGui::IsMouseHoveringRect(a, b))
+						ImGui::SetTooltip("%s: %.3f ms", e.Name, (e.EndNs - e.StartNs) / 1e6);
+				};
+			for (auto& e : frame.Events)
+			{
+				if (e.Thread < rows - 1)
+					drawEvent(e, rowTop[e.Thread]);
+			}
+			for (auto& e : frame.GpuEvents)
+				drawEvent(e, rowTop[rows - 1]);
+			ImGui::Dummy(ImVec2(labelWidth + width, y - origin.y));
+		}
+
+		ImGui::Text("Dropped Events: %llu", Profiler::GetDroppedEvents());
+		if (ImGui::Button("Save Chrome Trace"))
+		{
+			std::wstring path = FixPath(L"profile.json");
+			profilerStatus = Profiler::WriteChromeTrace(path, PROFILER_HISTORY_FRAMES) ?
+				"Saved " + WideToNarrow(path) :
+				"Couldn't write " + WideToNarrow(path);
+		}
+		if (!profilerStatus.empty())
+			ImGui::TextUnformatted(profilerStatus.c_str());
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Occlusion Culling"))
+	{
+		int occlusionMode = occlusion->GetMode();
+		if (ImGui::Combo("Depth Source", &occlusionMode, "Off\0Hi-Z Readback\0Software Occluders\0Both\0"))
+		{
+			occlusion->SetMode(occlusionMode);
+			BuildRenderGraph();
+		}
+		ImGui::Text("Culled: %u of %u tested", occlusion->GetCulledCount(), occlusion->GetTestedCount());
+		if (occlusionMode & Occlusion::OCCLUSION_HIZ)
+		{
+			if (occlusion->IsHiZValid())
+			{
+				const Occlusion::DepthBuffer& hiz = occlusion->GetHiZPyramid().Levels[0];
+				ImGui::Text("Hi-Z Readback: %ux%u, %u frames old", hiz.Width, hiz.Height, occlusion->GetHiZLatency());
+			}
+			else
+				ImGui::Text("Hi-Z Readback: waiting on the GPU");
+		}
+		if (occlusionMode & Occlusion::OCCLUSION_SOFTWARE)
+		{
+			const Occlusion::DepthBuffer& software = occlusion->GetSoftwareDepth();
+			ImGui::Text("Software Buffer: %ux%u, %u occluder tris", software.Width, software.Height, occlusion->GetOccluderTriangles());
+		}
+
+		ImGui::Text("Occluders:");
+		for (size_t i = 0; i < entityList.size(); i++)
+		{
+			GameEntity* e = entityList[i].get();
+			bool occluder = e->IsOccluder();
+			std::string label = std::to_string(i) + ": " + e->GetMesh()->GetName() + (e->IsOcclusionCulled() ? " (hidden)" : "");
+			if (ImGui::Checkbox(label.c_str(), &occluder))
+				e->SetOccluder(occluder);
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Vertex Compression"))
+	{
+		ImGui::Text("Vertex Size: %u bytes (uncompressed %u)", (unsigned int)sizeof(PackedVertex), (unsigned int)sizeof(Vertex));
+		ImGui::Text("Geometry Arena: %u / %u verts, %.1f / %.1f KB indices, %u free ranges",
+			geometryArena->GetVerticesUsed(), geometryArena->GetVertexCapacity(),
+			geometryArena->GetIndexBytesUsed() / 1024.0f, geometryArena->GetIndexCapacityBytes() / 1024.0f,
+			geometryArena->GetFreeRangeCount());
+		ImGui::Text("Input Assembler Binds Last Frame: %u", arenaBindCount);
+		std::vector<Mesh*> shown;
+		for (auto& e : entityList)
+		{
+			Mesh* m = e->GetMesh().get();
+			if (std::find(shown.begin(), shown.end(), m) != shown.end())
+				continue;
+			shown.push_back(m);
+
+			VertexCompression::RoundTripError err = m->GetCompressionError();
+			ImGui::Text("%s: %d verts, %.1f KB (was %.1f KB)", m->GetName(), m->GetVertexCount(),
+				m->GetVertexCount() * sizeof(PackedVertex) / 1024.0f, m->GetVertexCount() * sizeof(Vertex) / 1024.0f);
+			ImGui::Text("  %d indices, %u-bit, %.1f KB", m->GetIndexCount(), m->GetIndexSize() * 8,
+				m->GetIndexCount() * m->GetIndexSize() / 1024.0f);
+			ImGui::Text("  Max Error - Normal: %.3f deg, Tangent: %.3f deg, UV: %.5f, 16-bit Pos: %.5f",
+				err.MaxNormalDegrees, err.MaxTangentDegrees, err.MaxUV, err.MaxPosition16);
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Bloom"))
+	{
+		if (ImGui::Checkbox("Enabled", &bloomEnabled))
+		{
+			for (auto& p : postProcess->GetPasses())
+			{
+				if (p.Name.rfind("Bloom", 0) == 0)
+					postProcess->SetPassEnabled(p.Name, bloomEnabled);
+			}
+		}
+		ImGui::SliderFloat("Threshold", &bloomThreshold, 0.0f, 8.0f);
+		ImGui::SliderFloat("Knee", &bloomKnee, 0.01f, 2.0f);
+		ImGui::SliderFloat("Radius", &bloomRadius, 0.5f, 4.0f);
+		ImGui::SliderFloat("Bloom Intensity", &bloomIntensity, 0.0f, 1.0f);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Post Process Timing"))
+	{
+		bool timing = postProcess->IsTimingEnabled();
+		if (ImGui::Checkbox("Measure GPU Time", &timing))
+			postProcess->SetTimingEnabled(timing);
+
+		float total = 0.0f;
+		for (auto& p : postProcess->GetPasses())
+		{
+			if (!p.Enabled)
+				continue;
+			ImGui::Text("%-16s %.3f ms", p.Name.c_str(), p.GpuTime);
+			total += p.GpuTime;
+		}
+		ImGui::Text("%-16s %.3f ms", "Total", total);
+		ImGui::TreePop();
+	}
 	
 	//set the info up and let it be changed by ui
 	XMFLOAT3 pos = activeCam->GetTransform()->GetPosition();
@@ -497,21 +998,47 @@ void Game::UpdateImGui(float deltaTime,float totalTime)
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
+	PROFILE_SCOPE("Update");
 	// Example input checking: Quit if the escape key is pressed
 	if (Input::KeyDown(VK_ESCAPE))
 		Window::Quit();
 	
 	// Feed fresh data to ImGui
 	UpdateImGui(deltaTime, totalTime);
-	//check to see if camera changed
-	for (int i=0;i<entityList.size()-1;i++)
-	{
-		entityList[i]->GetTransform()->Rotate(0, deltaTime, 0);
-	}
+	// The camera follows input, so it stays on this thread
+	// rather than picking up the pipeline's extra frame
 	activeCam->Update(deltaTime);
-	entityList[2]->GetTransform()->SetPosition((float)sin(totalTime)*2, 0, -6);
 
-	entityList[1]->GetTransform()->SetPosition(entityList[1]->GetTransform()->GetPosition().x, (float)sin(totalTime), 0);
+	// Settings are copied now since the UI can change them while
+	// the simulation job is running
+	bool animate = animateEntities;
+	unsigned int grainSize = parallelUpdate ? (unsigned int)jobGrainSize : (unsigned int)entityList.size();
+
+	// Fixed steps for the time that's passed, then the newest
+	// finished frame is what gets rendered
+	simulation->Update(deltaTime, entityList, animate, grainSize);
+
+	// The view can still turn before it's drawn (see Draw()), so
+	// meshlets are culled against a frustum opened up by the
+	// margin and nothing reaching past the screen edge is
+	// occlusion culled.  LODs only depend on distance
+	float margin = lateLatchInput ? XMConvertToRadians(lateLatchMarginDegrees) : 0.0f;
+	UpdateLods();
+	UpdateMeshletCulling(margin);
+	occlusion->Update(activeCam.get(), entityList, *jobs, grainSize, lateLatchInput);
+	shadowMap->Update(activeCam.get(), lights);
+	shadowAtlas->Update(activeCam.get(), lights);
+
+	// Worker utilization over the last second
+	jobStatsTimer += deltaTime;
+	if (jobStatsTimer >= 1.0f)
+	{
+		jobStats.clear();
+		for (unsigned int w = 0; w < jobs->GetWorkerCount(); w++)
+			jobStats.push_back(jobs->GetWorkerStats(w));
+		jobs->ResetStats();
+		jobStatsTimer = 0.0f;
+	}
 	
 
 
@@ -525,70 +1052,57 @@ void Game::Update(float deltaTime, float totalTime)
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
-	// Frame START
-	// - These things should happen ONCE PER FRAME
-	// - At the beginning of Game::Draw() before drawing *anything*
-	// - At the beginning of Game::Draw() before drawing *anything*
+	// The UI and anything else may have touched the input assembler
+	arenaBindCount = geometryArena->GetBindCount();
+	geometryArena->ResetBindings();
+
+	// Last chance for mouse look to catch up, right before the
+	// camera constants go up.  Culling in Update() allowed for
+	// turning up to the margin; past that it's redone against the
+	// exact frustum.  The cascades follow the camera's direction,
+	// so they're refit after any turn
+	lateLatchRecull = false;
+	if (lateLatchInput)
 	{
-		// Clear the back buffer (erase what's on screen) and depth buffer
-		Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(),	&color.x);
-		Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+		PROFILE_SCOPE("Late Latch");
+		Input::LatchMouse();
+		float turned = activeCam->LateLatch();
+		if (turned > 0.0f)
+			shadowMap->Update(activeCam.get(), lights);
+		if (turned > XMConvertToRadians(lateLatchMarginDegrees))
+		{
+			UpdateMeshletCulling(0.0f);
+			lateLatchRecull = true;
+		}
 	}
-	//post process pre render
-	const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-	Graphics::Context->ClearRenderTargetView(ppRTV.Get(), clearColor);
-
-	Graphics::Context->OMSetRenderTargets(1, ppRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
 
-	//enable raster
-	/*Graphics::Context->RSSetState(shadowRasterizer.Get());
-
-	RenderShadowMap();
-	Graphics::Context->RSSetState(0);*/
-	
-
-	for (auto& s : entityList)
-	{
-		std::shared_ptr<SimpleVertexShader> vs = s->GetMaterial()->GetVertexShader();
-		vs->SetMatrix4x4("lightView", lightViewMatrix);
-		vs->SetMatrix4x4("lightProjection", lightProjectionMatrix);
-
-		std::shared_ptr<SimplePixelShader> ps = s->GetMaterial()->GetPixelShader();
-		ps->SetFloat3("ambient", ambientColor);
-		ps->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
-		ps->SetInt("useEmissive", useEmissive);
-		/*ps->SetShaderResourceView("ShadowMap", shadowSRV);
-		ps->SetSamplerState("ShadowSampler", shadowSampler);*/
-		s->Draw(activeCam);
-	}
-	sky->Draw(activeCam);
-
-	//post process post render
-	Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
-	// Activate shaders and bind resources
-// Also set any required cbuffer data (not shown)
-	ppVS->SetShader();
-	ppPS->SetShader();
-	ppPS->SetShaderResourceView("PixelColors", ppSRV.Get());
-	ppPS->SetSamplerState("BasicSampler", ppSampler.Get());
-
-	ppPS->SetFloat("pixelWidth", 1.0f / Window::Width());
-	ppPS->SetFloat("pixelHeight", 1.0f / Window::Height());
-	ppPS->SetInt("blurRadius", blurRadius);
-	ppPS->CopyAllBufferData();
-	Graphics::Context->Draw(3, 0); // Draw exactly 3 vertices (one triangle)
+	// Camera constants go up once for the whole frame, ahead of
+	// every pass that reads them.  This is also where the camera's
+	// matrices get rebuilt if they need it, before any worker
+	// thread reads them
+	CameraConstants camera = {};
+	camera.view = activeCam->GetView();
+	camera.projection = activeCam->GetProjection();
+	camera.viewProjection = activeCam->GetViewProjection();
+	camera.cameraPosition = activeCam->GetTransform()->GetPosition();
+	Graphics::Api->UpdateSubresource(Graphics::Context.Get(), cameraConstants.Get(), 0, &camera, sizeof(camera));
+	RenderStats::CountConstantBufferBytes(sizeof(camera));
+
+	// Everything up to the UI is a pass in the render graph, and
+	// each pass gets its own CPU and GPU profiler scope
+	gpuProfiler->BeginFrame();
 	{
-		
-
-		ImGui::Render(); // Turns this frames UI into renderable triangles
-		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws it to the screen
+		PROFILE_SCOPE("Render Graph");
+		renderGraph.Execute(*graphBackend);
 	}
-
+	gpuProfiler->EndFrame();
 
 	// Frame END
 	// - These should happen exactly ONCE PER FRAME
 	// - At the very end of the frame (after drawing *everything*)
 	{
+		PROFILE_SCOPE("Present");
+
 		// Present at the end of the frame
 		bool vsync = Graphics::VsyncState();
 		Graphics::SwapChain->Present(
@@ -600,174 +1114,506 @@ void Game::Draw(float deltaTime, float totalTime)
 			1,
 			Graphics::BackBufferRTV.GetAddressOf(),
 			Graphics::DepthBufferDSV.Get());
+	}
 
-		ID3D11ShaderResourceView* nullSRVs[128] = {};
-		Graphics::Context->PSSetShaderResources(0, 128, nullSRVs);
+	// Input to present.  The GPU and display add more on top, but
+	// this is the part the frame loop controls
+	inputLatency.Record(Profiler::Now(), Input::GetNewestEventTime(), Input::GetOldestEventTime(), Input::GetLatchTime());
+
+	// Everything since the last present belongs to this frame
+	Profiler::EndFrame();
+	RenderStats::EndFrame(Graphics::Api->GetStats());
+
+	// Benchmark runs end themselves once enough frames are measured
+	if (benchmark)
+	{
+		benchmark->RecordFrame(Profiler::GetHistory().back(), Profiler::GetThreadIndex(), RenderStats::GetLastFrame());
+		if (benchmark->IsFinished())
+		{
+			std::wstring output = NarrowToWide(benchmarkSettings.Output);
+			if (!std::filesystem::path(output).is_absolute())
+				output = FixPath(output);
+			if (!benchmark->WriteReport(output))
+				printf("Couldn't write benchmark report to %s\n", WideToNarrow(output).c_str());
+			printf("%s", benchmark->GetReport().c_str());
+
+			benchmark.reset();
+			Window::Quit();
+		}
 	}
 }
 
-void Game::CreateShadowMap()
+// --------------------------------------------------------
+// Declares the passes that make up a frame.  The graph
+// culls anything whose output isn't used and only unbinds
+// shader resources that are actually about to be written,
+// so there's no need to clear every SRV slot each frame
+// --------------------------------------------------------
+void Game::BuildRenderGraph()
 {
-	D3D11_TEXTURE2D_DESC shadowDesc = {};
-	{
-		shadowDesc.Width = shadowRes; // Ideally a power of 2 (like 1024)
-		shadowDesc.Height = shadowRes; // Ideally a power of 2 (like 1024)
-		shadowDesc.ArraySize = 1;
-		shadowDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
-		shadowDesc.CPUAccessFlags = 0;
-		shadowDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-		shadowDesc.MipLevels = 1;
-		shadowDesc.MiscFlags = 0;
-		shadowDesc.SampleDesc.Count = 1;
-		shadowDesc.SampleDesc.Quality = 0;
-		shadowDesc.Usage = D3D11_USAGE_DEFAULT;
-	}
+	renderGraph.Reset();
+
+	RenderGraphResource backBuffer = renderGraph.ImportTexture("BackBuffer");
+	RenderGraphResource depth = renderGraph.ImportTexture("Depth");
+	RenderGraphResource scene = renderGraph.ImportTexture("Scene");
+	renderGraph.MarkOutput(backBuffer);
+
+	// Cascaded shadow map for the first light.  It stays bound to
+	// the pixel shader after the scene pass, so it's a tracked read
+	// that gets unbound before the next frame renders into it
+	RenderGraphResource shadowMapTexture = renderGraph.ImportTexture("ShadowMap");
+	renderGraph.AddPass("Shadows",
+		[shadowMapTexture](RenderGraphPassBuilder& builder)
+		{
+			builder.Write(shadowMapTexture);
+		},
+		[this]()
+		{
+			shadowMap->Render(entityList, depthStream, Window::Width(), Window::Height());
+		});
 
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
-	Graphics::Device->CreateTexture2D(&shadowDesc, 0, shadowTexture.GetAddressOf());
+	// Point and spot light shadow atlas, same story as the cascades
+	RenderGraphResource shadowAtlasTexture = renderGraph.ImportTexture("ShadowAtlas");
+	renderGraph.AddPass("LocalShadows",
+		[shadowAtlasTexture](RenderGraphPassBuilder& builder)
+		{
+			builder.Write(shadowAtlasTexture);
+		},
+		[this]()
+		{
+			shadowAtlas->Render(lights, entityList, depthStream, Window::Width(), Window::Height());
+		});
+
+	// Optional depth only pass, front to back, so the lit pass
+	// below only shades the pixels that end up visible.  When
+	// it's off the scene pass clears depth instead, which culls
+	// this one
+	renderGraph.AddPass("DepthPrepass",
+		[depth](RenderGraphPassBuilder& builder)
+		{
+			builder.Write(depth);
+		},
+		[this]()
+		{
+			depthPrepass->Render(activeCam.get(), entityList, depthStream, cameraConstants);
+		});
 
-	// Create the depth/stencil view
-	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
-	{
-		shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
-		shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-		shadowDSDesc.Texture2D.MipSlice = 0;
+	// Opaque entities into the post process chain's scene target
+	renderGraph.AddPass("Scene",
+		[this, scene, depth, shadowMapTexture, shadowAtlasTexture](RenderGraphPassBuilder& builder)
+		{
+			builder.Read(shadowMapTexture, RenderGraphStage::Pixel, 4); // register(t4) in PixelShader.hlsl
+			builder.Read(shadowAtlasTexture, RenderGraphStage::Pixel, 6); // register(t6)
+			builder.Write(scene);
+			if (depthPrepass->IsEnabled())
+			{
+				builder.Read(depth); // Tested with EQUAL against the pre-pass
+				builder.Write(depth);
+			}
+			else
+				builder.Overwrite(depth);
+		},
+		[this]()
+		{
+			// Shadow data is the same for every entity
+			int activeCascades = shadowMap->GetActiveCascadeCount();
+			XMFLOAT4X4 cascadeViewProj[MAX_SHADOW_CASCADES] = {};
+			float cascadeSplits[MAX_SHADOW_CASCADES] = {};
+			for (int c = 0; c < activeCascades; c++)
+			{
+				cascadeViewProj[c] = shadowMap->GetCascade(c).ViewProjection;
+				cascadeSplits[c] = shadowMap->GetCascade(c).SplitFar;
+			}
+			float shadowTexelSize = 1.0f / shadowMap->GetResolution();
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowSRV = shadowMap->GetShaderResource();
+			Microsoft::WRL::ComPtr<ID3D11SamplerState> shadowSampler = shadowMap->GetSampler();
+			XMFLOAT3 cameraForward = activeCam->GetTransform()->GetFoward();
+
+			XMFLOAT4X4 localViewProj[MAX_LOCAL_SHADOW_TILES] = {};
+			XMFLOAT4 localRects[MAX_LOCAL_SHADOW_TILES] = {};
+			shadowAtlas->GetShaderData(localViewProj, localRects);
+			float atlasTexelSize = 1.0f / shadowAtlas->GetAtlas().GetAtlasSize();
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowAtlasSRV = shadowAtlas->GetShaderResource();
+
+			Microsoft::WRL::ComPtr<ID3D11RenderTargetView> sceneRTV = postProcess->GetRenderTarget("Scene");
+			bool prepassRan = !renderGraph.IsPassCulled("DepthPrepass");
+			Graphics::Context->ClearRenderTargetView(sceneRTV.Get(), &color.x);
+			if (!prepassRan)
+				Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+			Graphics::Context->OMSetRenderTargets(1, sceneRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+
+			// Depth is already final after a pre-pass, so only shade what matches it
+			if (prepassRan)
+				Graphics::Context->OMSetDepthStencilState(depthPrepass->GetEqualState().Get(), 0);
+
+			std::vector<GameEntity*> drawList;
+			for (auto& s : entityList)
+			{
+				if (!s->IsOcclusionCulled())
+					drawList.push_back(s.get());
+			}
 
-	}
-	Graphics::Device->CreateDepthStencilView(shadowTexture.Get(), &shadowDSDesc, shadowDSV.GetAddressOf());
+			// Everything here goes through the given context, so the
+			// same code records serially or on a worker thread
+			auto drawEntities = [&](ID3D11DeviceContext* context, unsigned int begin, unsigned int end)
+				{
+					Graphics::Api->SetConstantBuffers(context, ShaderStage::Vertex, CAMERA_CONSTANTS_REGISTER, 1, cameraConstants.GetAddressOf());
+					Graphics::Api->SetConstantBuffers(context, ShaderStage::Pixel, CAMERA_CONSTANTS_REGISTER, 1, cameraConstants.GetAddressOf());
+					for (unsigned int i = begin; i < end; i++)
+					{
+						GameEntity* s = drawList[i];
+						std::shared_ptr<SimplePixelShader> ps = s->GetMaterial()->GetPixelShader();
+						ps->SetFloat3("ambient", ambientColor, context);
+						ps->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size(), context);
+						ps->SetInt("useEmissive", useEmissive, context);
+						ps->SetFloat("emissiveIntensity", emissiveIntensity, context);
+
+						ps->SetData("cascadeViewProj", cascadeViewProj, sizeof(cascadeViewProj), context);
+						ps->SetData("cascadeSplits", cascadeSplits, sizeof(cascadeSplits), context);
+						ps->SetFloat3("cameraForward", cameraForward, context);
+						ps->SetInt("cascadeCount", activeCascades, context);
+						ps->SetFloat("shadowTexelSize", shadowTexelSize, context);
+						ps->SetShaderResourceView("ShadowMap", shadowSRV, context);
+						ps->SetSamplerState("ShadowSampler", shadowSampler, context);
+						ps->SetData("localShadowViewProj", localViewProj, sizeof(localViewProj), context);
+						ps->SetData("localShadowRects", localRects, sizeof(localRects), context);
+						ps->SetFloat("shadowAtlasTexelSize", atlasTexelSize, context);
+						ps->SetShaderResourceView("ShadowAtlas", shadowAtlasSRV, context);
+						s->Draw(context);
+					}
+				};
+
+			// Count pixel shader invocations to compare overdraw with and without the pre-pass
+			depthPrepass->BeginSceneStats(Graphics::Context.Get());
+
+			auto recordStart = std::chrono::steady_clock::now();
+			if (parallelRecording && drawList.size() > (size_t)drawsPerChunk)
+			{
+				D3D11_VIEWPORT viewport = {};
+				UINT viewportCount = 1;
+				Graphics::Context->RSGetViewports(&viewportCount, &viewport);
+
+				// Deferred contexts start out empty, so each chunk
+				// sets up the output merger and pipeline itself.  Shader
+				// data on them starts as a copy of the immediate context's
+				// (see ISimpleShader::BeginContextRecording()), which is
+				// why drawEntities sets every variable for every draw
+				commandRecorder->Record(*commandBackend, (unsigned int)drawList.size(), drawsPerChunk,
+					[&](ID3D11DeviceContext* context, unsigned int begin, unsigned int end)
+					{
+						PROFILE_SCOPE("Record Chunk");
+						context->OMSetRenderTargets(1, sceneRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+						if (prepassRan)
+							context->OMSetDepthStencilState(depthPrepass->GetEqualState().Get(), 0);
+						context->RSSetViewports(1, &viewport);
+						context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+						drawEntities(context, begin, end);
+					});
+
+				// Playback leaves the immediate context in its default
+				// state, so put back what the sky pass draws with
+				Graphics::Context->OMSetRenderTargets(1, sceneRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+				Graphics::Context->RSSetViewports(1, &viewport);
+				Graphics::Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+				geometryArena->InvalidateBindings();
+			}
+			else
+			{
+				drawEntities(Graphics::Context.Get(), 0, (unsigned int)drawList.size());
+			}
+			sceneRecordMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+			sceneDraws = (unsigned int)drawList.size();
 
-	// Create the SRV for the shadow map
-	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	{
-		srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
-		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MipLevels = 1;
-		srvDesc.Texture2D.MostDetailedMip = 0;
-	}
-	Graphics::Device->CreateShaderResourceView(shadowTexture.Get(), &srvDesc, shadowSRV.GetAddressOf());
+			depthPrepass->EndSceneStats(Graphics::Context.Get());
+			Graphics::Context->OMSetDepthStencilState(0, 0);
+		});
 
-	D3D11_RASTERIZER_DESC shadowRastDesc = {};
-	{
-		shadowRastDesc.FillMode = D3D11_FILL_SOLID;
-		shadowRastDesc.CullMode = D3D11_CULL_BACK;
-		shadowRastDesc.DepthClipEnable = true;
-		shadowRastDesc.DepthBias = 100; // Min. precision units, not world units!
-		shadowRastDesc.SlopeScaledDepthBias = 1.0f; // Bias more based on slope
-	}
-	Graphics::Device->CreateRasterizerState(&shadowRastDesc, &shadowRasterizer);
+	// Sky fills in wherever the depth buffer is still clear
+	renderGraph.AddPass("Sky",
+		[scene, depth](RenderGraphPassBuilder& builder)
+		{
+			builder.Write(scene);
+			builder.Write(depth);
+		},
+		[this]()
+		{
+			sky->Draw(activeCam);
+		});
 
-	D3D11_SAMPLER_DESC shadowSampDesc = {};
+	// Reduce the finished depth buffer for next frames' occlusion
+	// tests.  Nothing on the GPU reads the result, the CPU picks
+	// it up a few frames from now
+	if (occlusion->GetMode() & Occlusion::OCCLUSION_HIZ)
 	{
-		shadowSampDesc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR;
-		shadowSampDesc.ComparisonFunc = D3D11_COMPARISON_LESS;
-		shadowSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_BORDER;
-		shadowSampDesc.AddressV = D3D11_TEXTURE_ADDRESS_BORDER;
-		shadowSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_BORDER;
-		shadowSampDesc.BorderColor[0] = 1.0f; // Only need the first component
+		renderGraph.AddPass("HiZ",
+			[depth](RenderGraphPassBuilder& builder)
+			{
+				builder.Read(depth, RenderGraphStage::Pixel, 0); // register(t0) in HiZDownsamplePS.hlsl
+				builder.SetSideEffects();
+			},
+			[this]()
+			{
+				occlusion->RenderHiZ(activeCam.get());
+			});
 	}
-	Graphics::Device->CreateSamplerState(&shadowSampDesc, &shadowSampler);
 
+	// Post process chain ends in the back buffer
+	renderGraph.AddPass("PostProcess",
+		[scene, backBuffer](RenderGraphPassBuilder& builder)
+		{
+			builder.Read(scene);
+			builder.Write(backBuffer);
+		},
+		[this]()
+		{
+			postProcess->Execute(Graphics::BackBufferRTV.Get());
+		});
 
-	XMMATRIX lightView = XMMatrixLookAtLH(
-		XMVectorSet(0, 20, -20, 0),
-		XMVectorSet(0, 0, 0, 0),
-		XMVectorSet(0, 1, 0, 0));
-	XMStoreFloat4x4(&lightViewMatrix, lightView);
+	// UI on top of everything
+	renderGraph.AddPass("UI",
+		[backBuffer](RenderGraphPassBuilder& builder)
+		{
+			builder.Write(backBuffer);
+		},
+		[]()
+		{
+			Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
+			ImGui::Render(); // Turns this frame's UI into renderable triangles
+			ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws it to the screen
+		});
 
-	XMMATRIX lightProjection = XMMatrixOrthographicLH(
-		shadowProjSize,
-		shadowProjSize,
-		1.0f,
-		100.0f);
-	XMStoreFloat4x4(&lightProjectionMatrix, lightProjection);
+	renderGraph.Compile();
 }
 
-void Game::RenderShadowMap()
+// --------------------------------------------------------
+// Sets up the cascaded shadow map for the first light
+// --------------------------------------------------------
+void Game::CreateShadowMap()
 {
-	//Clear ShadowMap
-	Graphics::Context->ClearDepthStencilView(shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	shadowVS = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"ShadowVS.cso").c_str());
+	shadowMap = std::make_shared<CascadedShadowMap>(shadowVS, 2048);
+}
 
-	//output merger
-	ID3D11RenderTargetView* nullRTV{};
-	Graphics::Context->OMSetRenderTargets(1, &nullRTV, shadowDSV.Get());
+// --------------------------------------------------------
+// Sets up the point/spot light shadow atlas.  It draws with
+// the same shader and rasterizer state as the cascades
+// --------------------------------------------------------
+void Game::CreateShadowAtlas()
+{
+	shadowAtlas = std::make_shared<LocalShadowAtlas>(shadowVS, shadowMap->GetRasterizer());
+}
 
-	Graphics::Context->PSSetShader(0, 0, 0);
-	//deactivate viewport
-	D3D11_VIEWPORT viewport = {};
-	{
-		viewport.Width = (float)shadowRes;
-		viewport.Height = (float)shadowRes;
-		viewport.MaxDepth = 1.0f;
-	}
-	Graphics::Context->RSSetViewports(1, & viewport);
+// --------------------------------------------------------
+// Picks each entity's LOD from how big it is on screen.
+// Done once per frame so every pass (shadows, pre-pass,
+// scene) draws the same triangles
+// --------------------------------------------------------
+void Game::UpdateLods()
+{
+	PROFILE_SCOPE("UpdateLods");
+	XMFLOAT3 camPos = activeCam->GetTransform()->GetPosition();
+	float fov = activeCam->GetFOV();
+	ParallelForEntities([&](unsigned int i)
+		{
+			GameEntity* e = entityList[i].get();
+			int lodCount = e->GetMesh()->GetLodCount();
+			if (forcedLod >= 0)
+			{
+				e->SetLod(min(forcedLod, lodCount - 1));
+				return;
+			}
 
-	//Ent render loop
-	shadowVS->SetShader();
-	shadowVS->SetMatrix4x4("view", lightViewMatrix);
-	shadowVS->SetMatrix4x4("projection", lightProjectionMatrix);
+			XMFLOAT3 center;
+			float radius;
+			e->GetWorldBounds(center, radius);
+			float dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&center), XMLoadFloat3(&camPos))));
+			float size = MeshLod::ProjectedSize(radius, dist, fov);
+			e->SetLod(MeshLod::SelectLod(e->GetLod(), size, lodThresholds, lodCount, lodHysteresis));
+		});
+}
 
-	// Loop and draw all entities
-	for (auto& e : entityList)
+// --------------------------------------------------------
+// Runs body(index) for every entity, split across the job
+// system when parallel updates are on.  Each call should
+// only touch its own entity
+// --------------------------------------------------------
+void Game::ParallelForEntities(const std::function<void(unsigned int)>& body)
+{
+	unsigned int count = (unsigned int)entityList.size();
+	if (!parallelUpdate)
 	{
-		shadowVS->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-		shadowVS->CopyAllBufferData();
-		// Draw the mesh directly to avoid the entity's material
-		// Note: Your code may differ significantly here!
-		e->GetMesh()->Draw();
+		for (unsigned int i = 0; i < count; i++)
+			body(i);
+		return;
 	}
 
-	viewport.Width = (float)Window::Width();
-	viewport.Height = (float)Window::Height();
-	Graphics::Context->RSSetViewports(1, &viewport);
-	Graphics::Context->OMSetRenderTargets(
-		1,
-		Graphics::BackBufferRTV.GetAddressOf(),
-		Graphics::DepthBufferDSV.Get());
+	jobs->ParallelFor(count, (unsigned int)jobGrainSize, [&body](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				body(i);
+		});
 }
 
-void Game::ResizePPRs()
+// --------------------------------------------------------
+// Culls the meshlets of big meshes against the camera, in
+// each mesh's local space.  The pre-pass and scene pass draw
+// what's left; shadows still draw whole meshes since parts
+// the camera can't see can still cast into view.  A margin
+// keeps anything the view could turn toward, in radians
+// --------------------------------------------------------
+void Game::UpdateMeshletCulling(float margin)
 {
-	ppSRV.Reset();
-	ppRTV.Reset();
-
-	// Describe the texture we're creating
-	D3D11_TEXTURE2D_DESC textureDesc = {};
-	textureDesc.Width = Window::Width();
-	textureDesc.Height = Window::Height();
-	textureDesc.ArraySize = 1;
-	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	textureDesc.CPUAccessFlags = 0;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.MipLevels = 1;
-	textureDesc.MiscFlags = 0;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Usage = D3D11_USAGE_DEFAULT;
-
-	// Create the resource (no need to track it after the views are created below)
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> ppTexture;
-	Graphics::Device->CreateTexture2D(&textureDesc, 0, ppTexture.GetAddressOf());
-
-	//Create the Render Target View
-	D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-	rtvDesc.Format = textureDesc.Format;
-	rtvDesc.Texture2D.MipSlice = 0;
-	rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-	Graphics::Device->CreateRenderTargetView(
-		ppTexture.Get(),
-		&rtvDesc,
-		ppRTV.ReleaseAndGetAddressOf());
-
-		//Create the Shader Resource View
-		// By passing it a null description for the SRV, we
-		// get a "default" SRV that has access to the entire resource
-		Graphics::Device->CreateShaderResourceView(
-			ppTexture.Get(),
-			0,
-			ppSRV.ReleaseAndGetAddressOf());
-
+	PROFILE_SCOPE("UpdateMeshletCulling");
+	XMFLOAT4 cameraPlanes[6];
+	if (margin > 0.0f)
+		activeCam->GetWidenedFrustumPlanes(margin, cameraPlanes);
+	else
+		std::copy_n(activeCam->GetFrustumPlanes(), 6, cameraPlanes);
+	XMFLOAT3 camPos = activeCam->GetTransform()->GetPosition();
+
+	// Each entity's results go in its own slot, then get added up
+	std::vector<Meshlets::CullStats> entityStats(entityList.size());
+	std::vector<char> culled(entityList.size()); // Not vector<bool>, its bits can't be written from different threads
+	ParallelForEntities([&](unsigned int i)
+		{
+			GameEntity* e = entityList[i].get();
+			const std::vector<Meshlets::Meshlet>& meshlets = e->GetMesh()->GetMeshlets();
+			culled[i] = meshletCulling && !meshlets.empty() && e->GetLod() == 0;
+			if (!culled[i])
+			{
+				e->ClearMeshletRanges();
+				return;
+			}
 
+			// Camera and frustum in the mesh's local space
+			// A world space plane p becomes p * transpose(world) in local space
+			XMFLOAT4X4 worldMatrix = e->GetTransform()->GetWorldMatrix();
+			XMMATRIX world = XMLoadFloat4x4(&worldMatrix);
+			XMMATRIX worldTranspose = XMMatrixTranspose(world);
+			XMFLOAT4 planes[6];
+			for (int p = 0; p < 6; p++)
+				XMStoreFloat4(&planes[p], XMPlaneNormalize(XMPlaneTransform(XMLoadFloat4(&cameraPlanes[p]), worldTranspose)));
+
+			XMFLOAT3 localCam;
+			XMStoreFloat3(&localCam, XMVector3Transform(XMLoadFloat3(&camPos), XMMatrixInverse(0, world)));
+
+			std::vector<Meshlets::Range> ranges;
+			entityStats[i] = Meshlets::Cull(meshlets, localCam, planes, ranges);
+			e->SetMeshletRanges(ranges);
+		});
+
+	meshletStats = {};
+	meshletTotal = 0;
+	meshletTrianglesTotal = 0;
+	for (size_t i = 0; i < entityList.size(); i++)
+	{
+		if (!culled[i])
+			continue;
+
+		meshletStats.FrustumCulled += entityStats[i].FrustumCulled;
+		meshletStats.BackFaceCulled += entityStats[i].BackFaceCulled;
+		meshletStats.TrianglesKept += entityStats[i].TrianglesKept;
+		meshletTotal += (unsigned int)entityList[i]->GetMesh()->GetMeshlets().size();
+		meshletTrianglesTotal += entityList[i]->GetMesh()->GetIndexCount() / 3;
+	}
 }
 
+// --------------------------------------------------------
+// Sets up the post process chain.  The scene is drawn into
+// the chain's "Scene" target and each pass after that gets
+// its output from the chain's texture pool
+// --------------------------------------------------------
+void Game::CreatePostProcessChain()
+{
+	ppPS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PostProcessPS.cso").c_str());
+	ppVS = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"FullscreenVS.cso").c_str());
+	// Sampler state for post processing
+	D3D11_SAMPLER_DESC ppSampDesc = {};
+	ppSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	ppSampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	ppSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	ppSampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	ppSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	Graphics::Device->CreateSamplerState(&ppSampDesc, ppSampler.GetAddressOf());
 
+	luminancePS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"LuminancePS.cso").c_str());
+	luminanceDownsamplePS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"LuminanceDownsamplePS.cso").c_str());
+	tonemapPS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"TonemapPS.cso").c_str());
+	bloomDownsamplePS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"BloomDownsamplePS.cso").c_str());
+	bloomUpsamplePS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"BloomUpsamplePS.cso").c_str());
+
+	// The scene is linear HDR, only the tonemap pass writes display colors
+	postProcess = std::make_shared<PostProcessChain>(ppVS, ppSampler);
+	postProcess->AddTarget("Scene", DXGI_FORMAT_R11G11B10_FLOAT, 1.0f, true);
+	postProcess->AddTarget("Blurred", DXGI_FORMAT_R11G11B10_FLOAT);
+	postProcess->AddTarget("Luminance4", DXGI_FORMAT_R16_FLOAT, 1.0f / 4);
+	postProcess->AddTarget("Luminance16", DXGI_FORMAT_R16_FLOAT, 1.0f / 16);
+	postProcess->AddTarget("Luminance64", DXGI_FORMAT_R16_FLOAT, 1.0f / 64);
+
+	// Bloom levels (2 = half res, 4 = quarter res, ...)
+	const int bloomLevels[] = { 2, 4, 8, 16, 32 };
+	for (int level : bloomLevels)
+	{
+		postProcess->AddTarget("BloomDown" + std::to_string(level), DXGI_FORMAT_R11G11B10_FLOAT, 1.0f / level);
+		postProcess->AddTarget("BloomUp" + std::to_string(level), DXGI_FORMAT_R11G11B10_FLOAT, 1.0f / level);
+	}
+
+	// Blur in HDR (skipped entirely when the radius is 0)
+	postProcess->AddPass("Blur", ppPS, { {"PixelColors", "Scene"} }, "Blurred",
+		[this](SimplePixelShader* ps, unsigned int width, unsigned int height)
+		{
+			ps->SetFloat("pixelWidth", 1.0f / width);
+			ps->SetFloat("pixelHeight", 1.0f / height);
+			ps->SetInt("blurRadius", blurRadius);
+		});
+	postProcess->SetPassEnabled("Blur", blurRadius > 0);
+
+	// Reduce the scene to a handful of average log luminance texels
+	postProcess->AddPass("Luminance", luminancePS, { {"PixelColors", "Blurred"} }, "Luminance4");
+	postProcess->AddPass("LuminanceDown16", luminanceDownsamplePS, { {"Luminance", "Luminance4"} }, "Luminance16");
+	postProcess->AddPass("LuminanceDown64", luminanceDownsamplePS, { {"Luminance", "Luminance16"} }, "Luminance64");
+
+	// Bloom: bright pass on the way into the first downsample, then
+	// each level is tent upsampled and added to the one above it
+	std::string source = "Blurred";
+	for (int level : bloomLevels)
+	{
+		std::string target = "BloomDown" + std::to_string(level);
+		bool first = level == bloomLevels[0];
+		postProcess->AddPass(target, bloomDownsamplePS, { {"Source", source} }, target,
+			[this, first](SimplePixelShader* ps, unsigned int, unsigned int)
+			{
+				ps->SetInt("prefilter", first);
+				ps->SetFloat("threshold", bloomThreshold);
+				ps->SetFloat("knee", bloomKnee);
+			});
+		source = target;
+	}
+	for (int i = (int)std::size(bloomLevels) - 2; i >= 0; i--)
+	{
+		std::string target = "BloomUp" + std::to_string(bloomLevels[i]);
+		postProcess->AddPass(target, bloomUpsamplePS, { {"Low", source}, {"High", "BloomDown" + std::to_string(bloomLevels[i])} }, target,
+			[this](SimplePixelShader* ps, unsigned int, unsigned int)
+			{
+				ps->SetFloat("radius", bloomRadius);
+			});
+		source = target;
+	}
 
+	// Exposure, tonemap and sRGB encode straight to the back buffer
+	postProcess->AddPass("Tonemap", tonemapPS, { {"PixelColors", "Blurred"}, {"Luminance", "Luminance64"}, {"Bloom", source} }, "",
+		[this](SimplePixelShader* ps, unsigned int, unsigned int)
+		{
+			ps->SetInt("tonemapOperator", tonemapOperator);
+			ps->SetInt("autoExposure", autoExposure);
+			ps->SetFloat("manualExposure", manualExposure);
+			ps->SetFloat("exposureKey", exposureKey);
+			ps->SetFloat("minExposure", minExposure);
+			ps->SetFloat("maxExposure", maxExposure);
+			ps->SetFloat("exposureCompensation", exposureCompensation);
+			ps->SetFloat("bloomIntensity", bloomEnabled ? bloomIntensity : 0.0f);
+		});
+
+	postProcess->Compile();
+	postProcess->Resize(Window::Width(), Window::Height());
+}
@@ -10,12 +10,28 @@
 #include "SimpleShader.h"
 #include "Lights.h"
 #include "Sky.h"
+#include "PostProcessChain.h"
+#include "Tonemap.h"
+#include "CascadedShadowMap.h"
+#include "LocalShadowAtlas.h"
+#include "RenderGraph.h"
+#include "OcclusionCuller.h"
+#include "DepthPrepass.h"
+#include "JobSystem.h"
+#include "RenderGraphBackendD3D11.h"
+#include "CommandRecorder.h"
+#include "CommandRecordingBackendD3D11.h"
+#include "SceneSimulation.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "Benchmark.h"
+#include "FrameTiming.h"
 class Game
 {
 	
 public:
 	// Basic OOP setup
-	Game() = default;
+	Game(const BenchmarkSettings& benchmarkSettings = BenchmarkSettings());
 	~Game();
 	Game(const Game&) = delete; // Remove copy constructor
 	Game& operator=(const Game&) = delete; // Remove copy-assignment operator
@@ -25,14 +41,22 @@ public:
 	void Update(float deltaTime, float totalTime);
 	void Draw(float deltaTime, float totalTime);
 	void OnResize();
+
+	// Optional, for the frame rate limit in the UI
+	void SetFramePacer(std::shared_ptr<FramePacer> pacer);
 	
 private:
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void CreateGeometry();
+	void CreateBenchmarkScene();
 	void UpdateImGui(float deltaTime, float totalTime);
 	void CreateShadowMap();
-	void RenderShadowMap();
-	void ResizePPRs();
+	void UpdateLods();
+	void UpdateMeshletCulling(float margin);
+	void ParallelForEntities(const std::function<void(unsigned int)>& body);
+	void CreateShadowAtlas();
+	void CreatePostProcessChain();
+	void BuildRenderGraph();
 	//some varaibles needed for ImGui
 	DirectX::XMFLOAT4 color = { 0.0f, 0.0f, 0.0f, 0.0f };
 	std::unique_ptr<int>slider= std::make_unique<int>(50);
@@ -49,26 +73,124 @@ private:
 	std::vector<Light>lights;
 	std::shared_ptr<Sky> sky;
 
-	//shadow
+	//shadow (cascaded, for the first light when it's directional)
 	std::shared_ptr<SimpleVertexShader> shadowVS;
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowSRV;
-	DirectX::XMFLOAT4X4 lightViewMatrix;
-	DirectX::XMFLOAT4X4 lightProjectionMatrix;
-	Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizer;
-	Microsoft::WRL::ComPtr<ID3D11SamplerState> shadowSampler;
-	int shadowRes;
-	float shadowProjSize;
+	std::shared_ptr<CascadedShadowMap> shadowMap;
+
+	// CameraData for the entity vertex shader, filled once a frame
+	Microsoft::WRL::ComPtr<ID3D11Buffer> cameraConstants;
+	bool animateEntities = true;
+
+	// Point and spot light shadows share one atlas
+	std::shared_ptr<LocalShadowAtlas> shadowAtlas;
+
+	// Depth only pass ahead of the lit pass, which then tests EQUAL
+	std::shared_ptr<DepthPrepass> depthPrepass;
+	unsigned int sceneDraws = 0;
+
+	// Per frame CPU work (animation, LODs, culling) is split
+	// across a work stealing job system
+	std::shared_ptr<JobSystem> jobs;
+	bool parallelUpdate = true;
+	int jobGrainSize = 1; // Entities per job
+	std::vector<JobWorkerStats> jobStats; // Refreshed once a second
+	float jobStatsTimer = 0.0f;
+
+	// Entity animation, in fixed steps and pipelined with rendering
+	std::shared_ptr<SceneSimulation> simulation;
+	int simulationRate = 60; // Steps per second
+
+	// Owned by the main loop; when each frame may start
+	std::shared_ptr<FramePacer> framePacer;
+	int frameRateLimit = 0;
+
+	// Mouse look is read again just before rendering, and input is
+	// timed from when the window saw it to when Present() returns.
+	// The worst case is the oldest event a frame picked up.  The
+	// margin is how far the view can turn in that time before
+	// culling has to be redone
+	bool lateLatchInput = true;
+	float lateLatchMarginDegrees = 5.0f;
+	bool lateLatchRecull = false;
+	InputLatencyTracker inputLatency;
+
+	// Set when started with -benchmark: a generated scene, and
+	// a report once enough frames have been measured
+	BenchmarkSettings benchmarkSettings;
+	std::shared_ptr<Benchmark> benchmark;
+
+	// CPU scopes come from PROFILE_SCOPE, GPU scopes from each
+	// render graph pass.  Pausing keeps a copy of the history
+	std::shared_ptr<GpuProfiler> gpuProfiler;
+	bool profilerPaused = false;
+	int profilerFramesBack = 0;
+	std::deque<ProfileFrame> profilerSnapshot;
+	std::string profilerStatus;
+
+	// The scene pass can record its draws in chunks on deferred
+	// contexts across the job system, played back in order
+	std::shared_ptr<ParallelCommandRecorder> commandRecorder;
+	std::shared_ptr<CommandRecordingBackendD3D11> commandBackend;
+	bool parallelRecording = true;
+	int drawsPerChunk = 4;
+	float sceneRecordMs = 0.0f; // CPU time to record (and play back) the scene draws
+
+	// Shared vertex/index buffers for every static mesh
+	std::shared_ptr<GeometryArena> geometryArena;
+	unsigned int arenaBindCount = 0;
+
+	// Level of detail selection by projected size (fraction of screen height)
+	float lodThresholds[MAX_MESH_LODS - 1] = { 0.5f, 0.25f, 0.12f };
+	float lodHysteresis = 0.1f;
+	int forcedLod = -1;
+
+	// CPU meshlet culling for big meshes
+	bool meshletCulling = true;
+	Meshlets::CullStats meshletStats = {};
+	unsigned int meshletTotal = 0;
+	unsigned int meshletTrianglesTotal = 0;
+
+	// Occlusion culling against a Hi-Z readback and/or occluders
+	// rasterized on the CPU
+	std::shared_ptr<OcclusionCuller> occlusion;
+
+	// Vertex buffer used by depth only passes (shadows, pre-pass)
+	MeshStream depthStream = MeshStream::Position;
 
 	// Resources that are shared among all post processes
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> ppSampler;
 	std::shared_ptr<SimpleVertexShader> ppVS;
-	// Resources that are tied to a particular post process
+	// Passes and pooled render targets, scene renders into its "Scene" target
+	std::shared_ptr<PostProcessChain> postProcess;
 	std::shared_ptr<SimplePixelShader> ppPS;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> ppRTV; // For rendering
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ppSRV; // For samplin
 	int blurRadius;
+
+	// HDR resolve: log luminance reduction then tonemap + sRGB
+	std::shared_ptr<SimplePixelShader> luminancePS;
+	std::shared_ptr<SimplePixelShader> luminanceDownsamplePS;
+	std::shared_ptr<SimplePixelShader> tonemapPS;
+	int tonemapOperator = Tonemap::TONEMAP_ACES;
+	bool autoExposure = true;
+	float manualExposure = 1.0f;
+	float exposureKey = 0.18f;
+	float minExposure = 0.05f;
+	float maxExposure = 8.0f;
+	float exposureCompensation = 0.0f;
+
+	// Bloom: 13 tap downsample chain, then tent upsample back up
+	std::shared_ptr<SimplePixelShader> bloomDownsamplePS;
+	std::shared_ptr<SimplePixelShader> bloomUpsamplePS;
+	bool bloomEnabled = true;
+	float bloomThreshold = 1.0f;
+	float bloomKnee = 0.5f;
+	float bloomRadius = 1.0f;
+	float bloomIntensity = 0.05f;
+	float emissiveIntensity = 4.0f;
 	bool useEmissive = false;
+
+	// Passes making up a frame, rebuilt by BuildRenderGraph()
+	RenderGraph renderGraph;
+	std::shared_ptr<RenderGraphBackendD3D11> graphBackend;
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
 	//     Component Object Model, which DirectX objects do
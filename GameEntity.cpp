@@ -7,6 +7,12 @@ GameEntity::GameEntity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> mat
     this->mesh = mesh;
     this->mat = mat;
     transform = make_shared<Transform>();
+    isStatic = false;
+    animation = 0;
+    lod = 0;
+    useMeshletRanges = false;
+    isOccluder = false;
+    occlusionCulled = false;
 }
 
 std::shared_ptr<Mesh> GameEntity::GetMesh()
@@ -33,27 +39,107 @@ void GameEntity::SetMaterial(std::shared_ptr<Material> mat)
 {
     this->mat = mat;
 }
-void GameEntity::Draw(std::shared_ptr<Camera> camera)
+void GameEntity::GetWorldBounds(XMFLOAT3& center, float& radius)
+{
+    XMFLOAT3 localCenter = mesh->GetBoundsCenter();
+    XMFLOAT4X4 world = transform->GetWorldMatrix();
+    XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&localCenter), XMLoadFloat4x4(&world)));
+
+    // Non-uniform scale stretches the sphere by its largest axis
+    XMFLOAT3 scale = transform->GetScale();
+    radius = mesh->GetBoundsRadius() * fmaxf(fabsf(scale.x), fmaxf(fabsf(scale.y), fabsf(scale.z)));
+}
+
+bool GameEntity::IsStatic()
+{
+    return isStatic;
+}
+
+void GameEntity::SetStatic(bool isStatic)
+{
+    this->isStatic = isStatic;
+}
+
+unsigned int GameEntity::GetAnimation()
+{
+    return animation;
+}
+
+void GameEntity::SetAnimation(unsigned int animation)
+{
+    this->animation = animation;
+}
+
+int GameEntity::GetLod()
+{
+    return lod;
+}
+
+void GameEntity::SetLod(int lod)
+{
+    this->lod = lod;
+}
+
+void GameEntity::SetMeshletRanges(const std::vector<Meshlets::Range>& ranges)
+{
+    meshletRanges = ranges;
+    useMeshletRanges = true;
+}
+
+void GameEntity::ClearMeshletRanges()
+{
+    meshletRanges.clear();
+    useMeshletRanges = false;
+}
+
+bool GameEntity::IsOccluder()
+{
+    return isOccluder;
+}
+
+void GameEntity::SetOccluder(bool isOccluder)
+{
+    this->isOccluder = isOccluder;
+}
+
+bool GameEntity::IsOcclusionCulled()
+{
+    return occlusionCulled;
+}
+
+void GameEntity::SetOcclusionCulled(bool culled)
+{
+    occlusionCulled = culled;
+}
+
+void GameEntity::DrawMesh(MeshStream stream, ID3D11DeviceContext* context)
+{
+    if (useMeshletRanges && lod == 0)
+        mesh->DrawRanges(stream, meshletRanges, context);
+    else
+        mesh->Draw(stream, lod, context);
+}
+
+void GameEntity::Draw(ID3D11DeviceContext* context)
 {
     
     std::shared_ptr<SimpleVertexShader> vs = mat->GetVertexShader();
     std::shared_ptr<SimplePixelShader> ps = mat->GetPixelShader();
-    vs->SetShader();
-    ps->SetShader();
+    vs->SetShader(context);
+    ps->SetShader(context);
     XMFLOAT4 color = mat->GetColorTint();
 
-    vs->SetMatrix4x4("world", transform->GetWorldMatrix());
-    vs->SetMatrix4x4("view", camera->GetView());
-    vs->SetMatrix4x4("projection", camera->GetProjection());
-    vs->SetMatrix4x4("worldInvTranspose", transform->GetWorldInverseTransposeMatrix());
-    vs->CopyAllBufferData();
+    // View, projection and the camera's position come from the
+    // per-frame camera constants
+    vs->SetMatrix4x4("world", transform->GetWorldMatrix(), context);
+    vs->SetMatrix4x4("worldInvTranspose", transform->GetWorldInverseTransposeMatrix(), context);
+    vs->CopyAllBufferData(context);
 
-    ps->SetFloat3("colorTint", &color.x);
-    ps->SetFloat3("cameraPosition", camera->GetTransform()->GetPosition());
-    mat->PrepareMaterials();
+    ps->SetFloat3("colorTint", &color.x, context);
+    mat->PrepareMaterials(context);
 
-    ps->CopyAllBufferData();
-    mesh->Draw();
+    ps->CopyAllBufferData(context);
+    DrawMesh(MeshStream::Full, context);
 }
 
 
@@ -9,6 +9,13 @@
 #include "Camera.h"
 #include "Material.h"
 
+// How the simulation animates an entity (see Game::Simulate).
+// Movement is about where the entity was when the simulation
+// started, and the flags can be combined
+#define ENTITY_ANIMATE_SPIN 0x1 // Turns about the y axis
+#define ENTITY_ANIMATE_BOB  0x2 // Up and down
+#define ENTITY_ANIMATE_SWAY 0x4 // Side to side along x
+
 class GameEntity
 {
 	public:
@@ -19,12 +26,55 @@ class GameEntity
 		std::shared_ptr<Material> GetMaterial();
 		
 		void SetMesh(std::shared_ptr<Mesh>mesh);
-		void Draw(std::shared_ptr<Camera> camera);
+		//context defaults to the immediate context
+		void Draw(ID3D11DeviceContext* context = 0);
 		void SetMaterial(std::shared_ptr<Material> mat);
 
+		//mesh's bounding sphere moved into world space
+		void GetWorldBounds(DirectX::XMFLOAT3& center, float& radius);
+
+		//static entities aren't expected to move, so things like
+		//shadow maps can cache them
+		bool IsStatic();
+		void SetStatic(bool isStatic);
+
+		//how the simulation moves this entity, any ENTITY_ANIMATE_ flags
+		unsigned int GetAnimation();
+		void SetAnimation(unsigned int animation);
+
+		//level of detail to draw the mesh at, picked once per frame
+		int GetLod();
+		void SetLod(int lod);
+
+		//meshlets left after culling against the camera.  Only used
+		//at LOD 0, and only when set for this frame
+		void SetMeshletRanges(const std::vector<Meshlets::Range>& ranges);
+		void ClearMeshletRanges();
+
+		//occluders are rasterized into the CPU occlusion buffer and
+		//are never culled themselves
+		bool IsOccluder();
+		void SetOccluder(bool isOccluder);
+
+		//hidden behind something this frame, so the camera's passes
+		//skip it (shadows still draw it)
+		bool IsOcclusionCulled();
+		void SetOcclusionCulled(bool culled);
+
+		//draws just the geometry (no material) with the current LOD
+		//and meshlet ranges, for the main camera's passes
+		void DrawMesh(MeshStream stream, ID3D11DeviceContext* context = 0);
+
 	private:
 		std::shared_ptr<Mesh> mesh;
 		std::shared_ptr<Transform> transform;
 		std::shared_ptr<Material> mat;
+		bool isStatic;
+		unsigned int animation;
+		int lod;
+		std::vector<Meshlets::Range> meshletRanges;
+		bool useMeshletRanges;
+		bool isOccluder;
+		bool occlusionCulled;
 };
 
@@ -0,0 +1,154 @@
+#include "GeometryArena.h"
+#include "Graphics.h"
+
+using namespace DirectX;
+
+GeometryArena::GeometryArena(unsigned int vertexCapacity, unsigned int indexCapacityBytes) :
+	vertexAllocator(vertexCapacity),
+	indexAllocator((indexCapacityBytes + 3) / 4),
+	bound(false),
+	boundStream(MeshStream::Full),
+	boundIndexFormat(DXGI_FORMAT_R32_UINT),
+	bindCount(0)
+{
+	vertexBuffer = CreateBuffer(vertexAllocator.GetCapacity() * sizeof(PackedVertex), D3D11_BIND_VERTEX_BUFFER);
+	positionBuffer = CreateBuffer(vertexAllocator.GetCapacity() * sizeof(XMFLOAT3), D3D11_BIND_VERTEX_BUFFER);
+	indexBuffer = CreateBuffer(indexAllocator.GetCapacity() * 4, D3D11_BIND_INDEX_BUFFER);
+}
+
+// --------------------------------------------------------
+// Finds space for the mesh in each buffer and copies it in.
+// If a buffer is full it's doubled (or more), copying the
+// old contents over so existing allocations stay put
+// --------------------------------------------------------
+GeometryAllocation GeometryArena::Allocate(
+	const PackedVertex* verts,
+	const XMFLOAT3* positions,
+	unsigned int vertexCount,
+	const void* indices,
+	unsigned int indexSize,
+	unsigned int indexCount)
+{
+	GeometryAllocation a = {};
+	a.VertexCount = vertexCount;
+	a.IndexDwords = (indexCount * indexSize + 3) / 4;
+
+	a.BaseVertex = vertexAllocator.Allocate(vertexCount);
+	if (a.BaseVertex == GeometryRangeAllocator::Invalid)
+	{
+		unsigned int oldCapacity = vertexAllocator.GetCapacity();
+		unsigned int newCapacity = max(oldCapacity * 2, oldCapacity + vertexCount);
+		GrowBuffer(vertexBuffer, oldCapacity * sizeof(PackedVertex), newCapacity * sizeof(PackedVertex), D3D11_BIND_VERTEX_BUFFER);
+		GrowBuffer(positionBuffer, oldCapacity * sizeof(XMFLOAT3), newCapacity * sizeof(XMFLOAT3), D3D11_BIND_VERTEX_BUFFER);
+		vertexAllocator.Grow(newCapacity);
+		a.BaseVertex = vertexAllocator.Allocate(vertexCount);
+	}
+
+	a.IndexOffset = indexAllocator.Allocate(a.IndexDwords);
+	if (a.IndexOffset == GeometryRangeAllocator::Invalid)
+	{
+		unsigned int oldCapacity = indexAllocator.GetCapacity();
+		unsigned int newCapacity = max(oldCapacity * 2, oldCapacity + a.IndexDwords);
+		GrowBuffer(indexBuffer, oldCapacity * 4, newCapacity * 4, D3D11_BIND_INDEX_BUFFER);
+		indexAllocator.Grow(newCapacity);
+		a.IndexOffset = indexAllocator.Allocate(a.IndexDwords);
+	}
+
+	Upload(vertexBuffer.Get(), a.BaseVertex * sizeof(PackedVertex), vertexCount * sizeof(PackedVertex), verts);
+	Upload(positionBuffer.Get(), a.BaseVertex * sizeof(XMFLOAT3), vertexCount * sizeof(XMFLOAT3), positions);
+	Upload(indexBuffer.Get(), a.IndexOffset * 4, indexCount * indexSize, indices);
+	return a;
+}
+
+void GeometryArena::Free(const GeometryAllocation& allocation)
+{
+	vertexAllocator.Free(allocation.BaseVertex, allocation.VertexCount);
+	indexAllocator.Free(allocation.IndexOffset, allocation.IndexDwords);
+}
+
+void GeometryArena::Bind(MeshStream stream, DXGI_FORMAT indexFormat, ID3D11DeviceContext* context)
+{
+	if (context && context != Graphics::Context.Get())
+	{
+		UINT offset = 0;
+		UINT stride = stream == MeshStream::Position ? sizeof(XMFLOAT3) : sizeof(PackedVertex);
+		ID3D11Buffer* buffer = stream == MeshStream::Position ? positionBuffer.Get() : vertexBuffer.Get();
+		Graphics::Api->SetVertexBuffer(context, buffer, stride, offset);
+		Graphics::Api->SetIndexBuffer(context, indexBuffer.Get(), indexFormat, 0);
+		return;
+	}
+
+	if (!bound || stream != boundStream)
+	{
+		UINT offset = 0;
+		UINT stride = stream == MeshStream::Position ? sizeof(XMFLOAT3) : sizeof(PackedVertex);
+		ID3D11Buffer* buffer = stream == MeshStream::Position ? positionBuffer.Get() : vertexBuffer.Get();
+		Graphics::Api->SetVertexBuffer(Graphics::Context.Get(), buffer, stride, offset);
+		bindCount++;
+	}
+
+	if (!bound || indexFormat != boundIndexFormat)
+	{
+		Graphics::Api->SetIndexBuffer(Graphics::Context.Get(), indexBuffer.Get(), indexFormat, 0);
+		bindCount++;
+	}
+
+	bound = true;
+	boundStream = stream;
+	boundIndexFormat = indexFormat;
+}
+
+void GeometryArena::ResetBindings()
+{
+	bound = false;
+	bindCount = 0;
+}
+
+void GeometryArena::InvalidateBindings()
+{
+	bound = false;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> GeometryArena::CreateBuffer(unsigned int bytes, UINT bindFlags)
+{
+	// Default usage (not immutable) so meshes can be added and removed later
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = bytes;
+	desc.BindFlags = bindFlags;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	Graphics::Api->CreateBuffer(desc, 0, buffer.GetAddressOf());
+	return buffer;
+}
+
+void GeometryArena::GrowBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, unsigned int oldBytes, unsigned int newBytes, UINT bindFlags)
+{
+	Microsoft::WRL::ComPtr<ID3D11Buffer> bigger = CreateBuffer(newBytes, bindFlags);
+	if (oldBytes > 0)
+	{
+		D3D11_BOX box = {};
+		box.left = 0;
+		box.right = oldBytes;
+		box.bottom = 1;
+		box.back = 1;
+		Graphics::Context->CopySubresourceRegion(bigger.Get(), 0, 0, 0, 0, buffer.Get(), 0, &box);
+	}
+	buffer = bigger;
+
+	// The old buffer might still be bound
+	bound = false;
+}
+
+void GeometryArena::Upload(ID3D11Buffer* buffer, unsigned int byteOffset, unsigned int bytes, const void* data)
+{
+	if (bytes == 0 || !data)
+		return;
+
+	D3D11_BOX box = {};
+	box.left = byteOffset;
+	box.right = byteOffset + bytes;
+	box.bottom = 1;
+	box.back = 1;
+	Graphics::Api->UpdateSubresource(Graphics::Context.Get(), buffer, &box, data, bytes);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include "GeometryRangeAllocator.h"
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Where a mesh lives inside the arena
+// --------------------------------------------------------
+struct GeometryAllocation
+{
+	unsigned int BaseVertex;	// Same in both vertex streams
+	unsigned int VertexCount;
+	unsigned int IndexOffset;	// In 4 byte units, so it works for either index size
+	unsigned int IndexDwords;
+
+	// First index for DrawIndexed, given the mesh's index size
+	unsigned int StartIndex(unsigned int indexSize) const { return IndexOffset * 4 / indexSize; }
+};
+
+// --------------------------------------------------------
+// A few large buffers that every static mesh is packed into:
+// one for PackedVertex, a parallel one for positions only,
+// and one for indices of either size.  Since all meshes share
+// the buffers, drawing a different mesh is just a different
+// DrawIndexed, and the input assembler only gets rebound when
+// the stream or index format actually changes
+// --------------------------------------------------------
+class GeometryArena
+{
+public:
+	GeometryArena(unsigned int vertexCapacity, unsigned int indexCapacityBytes);
+
+	// Copies a mesh into the arena, growing the buffers if needed
+	GeometryAllocation Allocate(
+		const PackedVertex* verts,
+		const DirectX::XMFLOAT3* positions,
+		unsigned int vertexCount,
+		const void* indices,
+		unsigned int indexSize,
+		unsigned int indexCount);
+	void Free(const GeometryAllocation& allocation);
+
+	// Binds the arena's buffers unless they're already bound.  The
+	// cache is for the immediate context only; any other context
+	// (like a deferred one on a worker thread) always binds
+	void Bind(MeshStream stream, DXGI_FORMAT indexFormat, ID3D11DeviceContext* context = 0);
+
+	// Forgets what's bound.  Call once per frame, since anything
+	// else (like the UI) may have changed the input assembler
+	void ResetBindings();
+
+	// Forgets what's bound but keeps the count, for when the
+	// immediate context's state was cleared mid frame
+	void InvalidateBindings();
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer() { return vertexBuffer; }
+	Microsoft::WRL::ComPtr<ID3D11Buffer> GetPositionBuffer() { return positionBuffer; }
+	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer() { return indexBuffer; }
+
+	// Stats
+	unsigned int GetBindCount() { return bindCount; }
+	unsigned int GetVertexCapacity() { return vertexAllocator.GetCapacity(); }
+	unsigned int GetVerticesUsed() { return vertexAllocator.GetUsed(); }
+	unsigned int GetIndexCapacityBytes() { return indexAllocator.GetCapacity() * 4; }
+	unsigned int GetIndexBytesUsed() { return indexAllocator.GetUsed() * 4; }
+	unsigned int GetFreeRangeCount() { return vertexAllocator.GetFreeRangeCount() + indexAllocator.GetFreeRangeCount(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> positionBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+	GeometryRangeAllocator vertexAllocator;
+	GeometryRangeAllocator indexAllocator; // In 4 byte units
+
+	// What's currently bound, to skip redundant IA calls
+	bool bound;
+	MeshStream boundStream;
+	DXGI_FORMAT boundIndexFormat;
+	unsigned int bindCount;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> CreateBuffer(unsigned int bytes, UINT bindFlags);
+	void GrowBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, unsigned int oldBytes, unsigned int newBytes, UINT bindFlags);
+	void Upload(ID3D11Buffer* buffer, unsigned int byteOffset, unsigned int bytes, const void* data);
+};
@@ -0,0 +1,82 @@
+#include "GeometryRangeAllocator.h"
+#include <iterator>
+
+GeometryRangeAllocator::GeometryRangeAllocator(unsigned int capacity) :
+	capacity(capacity), used(0)
+{
+	if (capacity > 0)
+		freeRanges[0] = capacity;
+}
+
+unsigned int GeometryRangeAllocator::Allocate(unsigned int size)
+{
+	if (size == 0)
+		return Invalid;
+
+	for (auto it = freeRanges.begin(); it != freeRanges.end(); it++)
+	{
+		if (it->second < size)
+			continue;
+
+		// Take the front of the range, leaving the rest free
+		unsigned int offset = it->first;
+		unsigned int remaining = it->second - size;
+		freeRanges.erase(it);
+		if (remaining > 0)
+			freeRanges[offset + size] = remaining;
+
+		used += size;
+		return offset;
+	}
+	return Invalid;
+}
+
+// --------------------------------------------------------
+// Returns a range to the free list, merging it with the
+// free ranges directly before and after it
+// --------------------------------------------------------
+void GeometryRangeAllocator::Free(unsigned int offset, unsigned int size)
+{
+	if (size == 0)
+		return;
+	used -= size;
+
+	auto next = freeRanges.lower_bound(offset);
+	if (next != freeRanges.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = freeRanges.erase(next);
+	}
+
+	if (next != freeRanges.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset)
+		{
+			prev->second += size;
+			return;
+		}
+	}
+	freeRanges[offset] = size;
+}
+
+void GeometryRangeAllocator::Grow(unsigned int newCapacity)
+{
+	if (newCapacity <= capacity)
+		return;
+
+	unsigned int oldCapacity = capacity;
+	capacity = newCapacity;
+
+	// Adding the new space as a "freed" range merges it with a free tail
+	used += newCapacity - oldCapacity;
+	Free(oldCapacity, newCapacity - oldCapacity);
+}
+
+unsigned int GeometryRangeAllocator::GetLargestFreeRange()
+{
+	unsigned int largest = 0;
+	for (auto& r : freeRanges)
+		largest = largest > r.second ? largest : r.second;
+	return largest;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <map>
+
+// --------------------------------------------------------
+// First fit free list over a range of elements.  Freed
+// ranges are merged with their neighbors so meshes can be
+// streamed in and out without the space fragmenting away
+// --------------------------------------------------------
+class GeometryRangeAllocator
+{
+public:
+	static const unsigned int Invalid = 0xFFFFFFFF;
+
+	GeometryRangeAllocator(unsigned int capacity = 0);
+
+	// Returns the offset of the new range, or Invalid if no free range is big enough
+	unsigned int Allocate(unsigned int size);
+	void Free(unsigned int offset, unsigned int size);
+
+	// Adds space at the end (existing offsets stay valid)
+	void Grow(unsigned int newCapacity);
+
+	unsigned int GetCapacity() { return capacity; }
+	unsigned int GetUsed() { return used; }
+	unsigned int GetLargestFreeRange();
+	unsigned int GetFreeRangeCount() { return (unsigned int)freeRanges.size(); }
+
+private:
+	unsigned int capacity;
+	unsigned int used;
+	std::map<unsigned int, unsigned int> freeRanges; // Offset -> size
+};
@@ -0,0 +1,149 @@
+#include "GpuProfiler.h"
+#include "Graphics.h"
+
+GpuProfiler::GpuProfiler() :
+	frameIndex(0),
+	current(0),
+	frameMs(0.0f),
+	latency(0)
+{
+	D3D11_QUERY_DESC disjointDesc = {};
+	disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	for (auto& frame : frames)
+	{
+		Graphics::Device->CreateQuery(&disjointDesc, frame.Disjoint.GetAddressOf());
+		frame.QueryCount = 0;
+		frame.FrameIndex = 0;
+		frame.CpuStartNs = 0;
+		frame.Pending = false;
+	}
+}
+
+// --------------------------------------------------------
+// Only times this frame if its queries have been read back;
+// otherwise scopes are ignored until the next frame
+// --------------------------------------------------------
+void GpuProfiler::BeginFrame()
+{
+	ReadResults();
+
+	GpuProfilerFrame& frame = frames[frameIndex];
+	current = frame.Pending ? 0 : &frame;
+	openScopes.clear();
+	if (!current)
+		return;
+
+	current->QueryCount = 0;
+	current->Scopes.clear();
+	current->FrameIndex = Profiler::GetFrameIndex();
+	current->CpuStartNs = Profiler::Now();
+	Graphics::Context->Begin(current->Disjoint.Get());
+	Graphics::Context->End(current->Timestamps[NextQuery()].Get());
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (!current)
+		return;
+
+	// Close anything left open so every scope has an end
+	while (!openScopes.empty())
+		EndScope();
+
+	Graphics::Context->End(current->Timestamps[NextQuery()].Get());
+	Graphics::Context->End(current->Disjoint.Get());
+	current->Pending = true;
+	current = 0;
+	frameIndex = (frameIndex + 1) % GPU_PROFILER_FRAMES;
+}
+
+void GpuProfiler::BeginScope(const char* name)
+{
+	if (!current)
+		return;
+
+	GpuProfilerScope scope = {};
+	scope.Name = name;
+	scope.Depth = (unsigned int)openScopes.size();
+	scope.BeginQuery = NextQuery();
+	Graphics::Context->End(current->Timestamps[scope.BeginQuery].Get());
+
+	openScopes.push_back((unsigned int)current->Scopes.size());
+	current->Scopes.push_back(scope);
+}
+
+void GpuProfiler::EndScope()
+{
+	if (!current || openScopes.empty())
+		return;
+
+	GpuProfilerScope& scope = current->Scopes[openScopes.back()];
+	scope.EndQuery = NextQuery();
+	Graphics::Context->End(current->Timestamps[scope.EndQuery].Get());
+	openScopes.pop_back();
+}
+
+// --------------------------------------------------------
+// Grows the current frame's query list as scopes are added
+// --------------------------------------------------------
+unsigned int GpuProfiler::NextQuery()
+{
+	if (current->QueryCount >= current->Timestamps.size())
+	{
+		D3D11_QUERY_DESC timestampDesc = {};
+		timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+		current->Timestamps.emplace_back();
+		Graphics::Device->CreateQuery(&timestampDesc, current->Timestamps.back().GetAddressOf());
+	}
+	return current->QueryCount++;
+}
+
+// --------------------------------------------------------
+// Picks up any frames the GPU has finished, without waiting
+// on ones that aren't ready yet.  Scopes are placed on the
+// CPU timeline relative to when their frame began, which is
+// as close as the two clocks can be lined up here
+// --------------------------------------------------------
+void GpuProfiler::ReadResults()
+{
+	for (auto& frame : frames)
+	{
+		if (!frame.Pending)
+			continue;
+
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+		if (Graphics::Context->GetData(frame.Disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			continue;
+
+		std::vector<UINT64> stamps(frame.QueryCount);
+		bool ready = true;
+		for (unsigned int i = 0; i < stamps.size() && ready; i++)
+			ready = Graphics::Context->GetData(frame.Timestamps[i].Get(), &stamps[i], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+		if (!ready)
+			continue;
+
+		frame.Pending = false;
+		if (disjoint.Disjoint || stamps.size() < 2)
+			continue;
+
+		auto toNs = [&](UINT64 stamp)
+			{
+				return frame.CpuStartNs + (long long)((double)(stamp - stamps[0]) / disjoint.Frequency * 1e9);
+			};
+
+		std::vector<ProfileEvent> events;
+		for (auto& s : frame.Scopes)
+		{
+			ProfileEvent e = {};
+			e.Name = s.Name;
+			e.StartNs = toNs(stamps[s.BeginQuery]);
+			e.EndNs = toNs(stamps[s.EndQuery]);
+			e.Depth = s.Depth;
+			events.push_back(e);
+		}
+		Profiler::AddGpuEvents(frame.FrameIndex, events);
+
+		frameMs = (float)((double)(stamps.back() - stamps[0]) / disjoint.Frequency * 1000.0);
+		latency = (unsigned int)(Profiler::GetFrameIndex() - frame.FrameIndex);
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <vector>
+#include "Profiler.h"
+
+#define GPU_PROFILER_FRAMES 4 // Frames of queries in flight before timing skips a frame
+
+// One timed GPU scope within a frame
+struct GpuProfilerScope
+{
+	const char* Name;
+	unsigned int Depth;
+	unsigned int BeginQuery;
+	unsigned int EndQuery;
+};
+
+// --------------------------------------------------------
+// Timestamp queries for one frame.  Several of these are
+// cycled so results are read a few frames late instead of
+// stalling on the GPU
+// --------------------------------------------------------
+struct GpuProfilerFrame
+{
+	Microsoft::WRL::ComPtr<ID3D11Query> Disjoint;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> Timestamps;
+	unsigned int QueryCount;
+	std::vector<GpuProfilerScope> Scopes;
+	unsigned long long FrameIndex;	// Profiler frame that submitted it
+	long long CpuStartNs;			// Where its scopes start on the CPU timeline
+	bool Pending;
+};
+
+// --------------------------------------------------------
+// Hierarchical GPU timing through Graphics::Context.  Scopes
+// are bracketed with timestamp queries inside a disjoint
+// query per frame, and finished frames are handed to the
+// CPU profiler's history.  Main thread only
+// --------------------------------------------------------
+class GpuProfiler
+{
+public:
+	GpuProfiler();
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Names must outlive the profiler, like CPU scope names
+	void BeginScope(const char* name);
+	void EndScope();
+
+	// From the most recent frame that came back
+	float GetFrameMs() { return frameMs; }
+	unsigned int GetLatency() { return latency; } // Frames between submitting and reading
+
+private:
+	void ReadResults();
+	unsigned int NextQuery();
+
+	GpuProfilerFrame frames[GPU_PROFILER_FRAMES];
+	int frameIndex;
+	GpuProfilerFrame* current; // Null when this frame isn't being timed
+	std::vector<unsigned int> openScopes;
+
+	float frameMs;
+	unsigned int latency;
+};
+
+// Times the enclosing block on the GPU
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler* profiler, const char* name) : profiler(profiler) { if (profiler) profiler->BeginScope(name); }
+	~GpuProfileScope() { if (profiler) profiler->EndScope(); }
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+	GpuProfiler* profiler;
+};
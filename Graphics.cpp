@@ -1,4 +1,5 @@
 #include "Graphics.h"
+#include "GraphicsDeviceD3D11.h"
 #include <dxgi1_6.h>
 
 // Tell the drivers to use high-performance GPU in multi-GPU systems (like laptops)
@@ -22,11 +23,21 @@ namespace Graphics
 		D3D_FEATURE_LEVEL featureLevel;
 
 		Microsoft::WRL::ComPtr<ID3D11InfoQueue> InfoQueue;
+
+		// Signaled when the swap chain can take another frame
+		HANDLE frameLatencyWaitable = 0;
+
+		UINT SwapChainFlags()
+		{
+			return DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT |
+				(supportsTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0);
+		}
 	}
 }
 
 // Getters
 bool Graphics::VsyncState() { return vsyncDesired || !supportsTearing || isFullscreen; }
+bool Graphics::HasFrameLatencyWaitable() { return frameLatencyWaitable != 0; }
 std::wstring Graphics::APIName() 
 { 
 	switch (featureLevel)
@@ -46,8 +57,10 @@ std::wstring Graphics::APIName()
 // windowHeight    - Height of the window (and our viewport)
 // windowHandle    - OS-level handle of the window
 // vsyncIfPossible - Sync to the monitor's refresh rate if available?
+// driver          - GPU, WARP (the CPU rasterizer), or WARP with
+//                   everything sent through Api counted and dropped
 // --------------------------------------------------------
-HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight, HWND windowHandle, bool vsyncIfPossible)
+HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight, HWND windowHandle, bool vsyncIfPossible, Driver driver)
 {
 	// Only initialize once
 	if (apiInitialized)
@@ -96,7 +109,7 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 	swapDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
 	swapDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
 	swapDesc.BufferUsage		= DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	swapDesc.Flags				= supportsTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+	swapDesc.Flags				= SwapChainFlags();
 	swapDesc.OutputWindow		= windowHandle;
 	swapDesc.SampleDesc.Count	= 1;
 	swapDesc.SampleDesc.Quality = 0;
@@ -109,7 +122,7 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 	// Attempt to initialize DirectX
 	hr = D3D11CreateDeviceAndSwapChain(
 		0,							// Video adapter (physical GPU) to use, or null for default
-		D3D_DRIVER_TYPE_HARDWARE,	// We want to use the hardware (GPU)
+		driver == Driver::Hardware ? D3D_DRIVER_TYPE_HARDWARE : D3D_DRIVER_TYPE_WARP,	// Hardware (GPU) unless asked otherwise
 		0,							// Used when doing software rendering
 		deviceFlags,				// Any special options
 		0,							// Optional array of possible versions we want as fallbacks
@@ -122,6 +135,20 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 		Context.GetAddressOf());	// Pointer to our Device Context pointer
 	if (FAILED(hr)) return hr;
 
+	// Only queue one frame ahead, and let the game loop wait until
+	// the swap chain is ready for it rather than blocking in Present()
+	Microsoft::WRL::ComPtr<IDXGISwapChain2> swapChain2;
+	if (SUCCEEDED(SwapChain.As(&swapChain2)))
+	{
+		swapChain2->SetMaximumFrameLatency(1);
+		frameLatencyWaitable = swapChain2->GetFrameLatencyWaitableObject();
+	}
+
+	// Always counting, but only passing submissions on for a real driver
+	Api = std::make_shared<RecordingGraphicsDevice>(
+		std::make_shared<GraphicsDeviceD3D11>(Device),
+		driver != Driver::NoSubmit);
+
 	// We're set up
 	apiInitialized = true;
 
@@ -152,6 +179,9 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 // --------------------------------------------------------
 void Graphics::ShutDown()
 {
+	if (frameLatencyWaitable)
+		CloseHandle(frameLatencyWaitable);
+	frameLatencyWaitable = 0;
 }
 
 
@@ -174,6 +204,7 @@ void Graphics::ResizeBuffers(unsigned int width, unsigned int height)
 
 	BackBufferRTV.Reset();
 	DepthBufferDSV.Reset();
+	DepthBufferSRV.Reset();
 
 	// Resize the swap chain buffers
 	SwapChain->ResizeBuffers(
@@ -181,7 +212,7 @@ void Graphics::ResizeBuffers(unsigned int width, unsigned int height)
 		width, 
 		height, 
 		DXGI_FORMAT_R8G8B8A8_UNORM, 
-		supportsTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0);
+		SwapChainFlags()); // Must match the flags the swap chain was made with
 
 	// Grab the references to the first buffer
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> backBufferTexture;
@@ -203,23 +234,38 @@ void Graphics::ResizeBuffers(unsigned int width, unsigned int height)
 	depthStencilDesc.Height = height;
 	depthStencilDesc.MipLevels = 1;
 	depthStencilDesc.ArraySize = 1;
-	depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthStencilDesc.Format = DXGI_FORMAT_R24G8_TYPELESS; // Typeless so it can also be read as a texture
 	depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
-	depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
 	depthStencilDesc.CPUAccessFlags = 0;
 	depthStencilDesc.MiscFlags = 0;
 	depthStencilDesc.SampleDesc.Count = 1;
 	depthStencilDesc.SampleDesc.Quality = 0;
 
-	// Create the depth buffer and its view, then 
+	// Create the depth buffer and its views, then 
 	// release our reference to the texture
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> depthBufferTexture;
-	Device->CreateTexture2D(&depthStencilDesc, 0, &depthBufferTexture);
+	Api->CreateTexture2D(depthStencilDesc, 0, &depthBufferTexture);
+
+	D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+	dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	dsvDesc.Texture2D.MipSlice = 0;
 	Device->CreateDepthStencilView(
 		depthBufferTexture.Get(),
-		0,
+		&dsvDesc,
 		DepthBufferDSV.GetAddressOf()); 
 
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	Device->CreateShaderResourceView(
+		depthBufferTexture.Get(),
+		&srvDesc,
+		DepthBufferSRV.GetAddressOf());
+
 	// Bind the views to the pipeline, so rendering properly 
 	// uses their underlying textures
 	Context->OMSetRenderTargets(
@@ -243,6 +289,19 @@ void Graphics::ResizeBuffers(unsigned int width, unsigned int height)
 }
 
 
+// --------------------------------------------------------
+// Blocks until the swap chain is ready for another frame, so
+// input is read and the frame built as late as possible
+// instead of sitting in a queue.  Waits up to a second, in
+// case something has gone wrong with presentation
+// --------------------------------------------------------
+void Graphics::WaitForFrameLatency()
+{
+	if (frameLatencyWaitable)
+		WaitForSingleObjectEx(frameLatencyWaitable, 1000, TRUE);
+}
+
+
 // --------------------------------------------------------
 // Prints graphics debug messages waiting in the queue
 // --------------------------------------------------------
@@ -2,14 +2,26 @@
 
 #include <Windows.h>
 #include <d3d11.h>
+#include <memory>
 #include <string>
 #include <wrl/client.h>
+#include "GraphicsDevice.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
 
 namespace Graphics
 {
+	// Where rendering happens.  NoSubmit still makes a (WARP)
+	// device so resources exist, but nothing sent through Api
+	// reaches it
+	enum class Driver
+	{
+		Hardware,
+		Software,
+		NoSubmit
+	};
+
 	// --- GLOBAL VARS ---
 
 	// Primary D3D11 API objects
@@ -17,21 +29,30 @@ namespace Graphics
 	inline Microsoft::WRL::ComPtr<ID3D11DeviceContext> Context;
 	inline Microsoft::WRL::ComPtr<IDXGISwapChain> SwapChain;
 
+	// Draws, uploads, shader and geometry binds, and buffer and
+	// texture creation go through here so they can be counted
+	inline std::shared_ptr<RecordingGraphicsDevice> Api;
+
 	// Rendering buffers
 	inline Microsoft::WRL::ComPtr<ID3D11RenderTargetView> BackBufferRTV;
 	inline Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DepthBufferDSV;
+	inline Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> DepthBufferSRV; // Depth only, for building the Hi-Z pyramid
 
 	// --- FUNCTIONS ---
 
 	// Getters
 	bool VsyncState();
+	bool HasFrameLatencyWaitable();
 	std::wstring APIName();
 
 	// General functions
-	HRESULT Initialize(unsigned int windowWidth, unsigned int windowHeight, HWND windowHandle, bool vsyncIfPossible);
+	HRESULT Initialize(unsigned int windowWidth, unsigned int windowHeight, HWND windowHandle, bool vsyncIfPossible, Driver driver = Driver::Hardware);
 	void ShutDown();
 	void ResizeBuffers(unsigned int width, unsigned int height);
 
+	// Frame pacing: waits on the swap chain's frame latency object
+	void WaitForFrameLatency();
+
 	// Debug Layer
 	void PrintDebugMessages();
 }
\ No newline at end of file
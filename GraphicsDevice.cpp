@@ -0,0 +1,292 @@
+#include "GraphicsDevice.h"
+#include "GraphicsDeviceNull.h"
+#include <algorithm>
+
+namespace
+{
+	// Bytes per pixel, or per 4x4 block for compressed formats
+	unsigned int GetFormatBytes(DXGI_FORMAT format, bool& blockCompressed)
+	{
+		blockCompressed = false;
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		case DXGI_FORMAT_R32G32B32A32_UINT:
+			return 16;
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			return 12;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+		case DXGI_FORMAT_R16G16B16A16_SNORM:
+		case DXGI_FORMAT_R32G32_FLOAT:
+		case DXGI_FORMAT_R32G32_UINT:
+		case DXGI_FORMAT_R32G8X24_TYPELESS:
+		case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+			return 8;
+		case DXGI_FORMAT_R16_FLOAT:
+		case DXGI_FORMAT_R16_UINT:
+		case DXGI_FORMAT_R16_UNORM:
+		case DXGI_FORMAT_R16_TYPELESS:
+		case DXGI_FORMAT_D16_UNORM:
+		case DXGI_FORMAT_R8G8_UNORM:
+			return 2;
+		case DXGI_FORMAT_R8_UNORM:
+			return 1;
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+			blockCompressed = true;
+			return 8;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			blockCompressed = true;
+			return 16;
+		default:
+			// Everything else this engine uses is 32 bits
+			return 4;
+		}
+	}
+
+	// {7D3C5A1E-4B2F-4E91-9A6D-2C81F053B74E}
+	const GUID ReleaseTrackerGuid = { 0x7d3c5a1e, 0x4b2f, 0x4e91, { 0x9a, 0x6d, 0x2c, 0x81, 0xf0, 0x53, 0xb7, 0x4e } };
+
+	// --------------------------------------------------------
+	// Hung on a resource as private data, which the resource
+	// releases when it's destroyed.  Counts its bytes in for
+	// as long as it's alive
+	// --------------------------------------------------------
+	class ReleaseTracker : public IUnknown
+	{
+	public:
+		ReleaseTracker(std::shared_ptr<std::atomic<unsigned long long>> liveBytes, unsigned long long bytes) :
+			refCount(1), liveBytes(liveBytes), bytes(bytes)
+		{
+			liveBytes->fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		~ReleaseTracker()
+		{
+			liveBytes->fetch_sub(bytes, std::memory_order_relaxed);
+		}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID id, void** object) override
+		{
+			if (!object)
+				return E_POINTER;
+			if (id == __uuidof(IUnknown))
+			{
+				AddRef();
+				*object = static_cast<IUnknown*>(this);
+				return S_OK;
+			}
+			*object = 0;
+			return E_NOINTERFACE;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef() override
+		{
+			return refCount.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			ULONG count = refCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+			if (count == 0)
+				delete this;
+			return count;
+		}
+
+	private:
+		std::atomic<ULONG> refCount;
+		std::shared_ptr<std::atomic<unsigned long long>> liveBytes;
+		unsigned long long bytes;
+	};
+}
+
+RecordingGraphicsDevice::RecordingGraphicsDevice(std::shared_ptr<IGraphicsDevice> inner, bool submit) :
+	inner(inner ? inner : std::make_shared<NullGraphicsDevice>()),
+	submit(submit),
+	drawCalls(0),
+	triangles(0),
+	bytesUploaded(0),
+	shaderBinds(0),
+	constantBufferBinds(0),
+	shaderResourceBinds(0),
+	samplerBinds(0),
+	inputBinds(0),
+	resourcesCreated(0),
+	resourceBytes(std::make_shared<std::atomic<unsigned long long>>(0))
+{
+}
+
+// --------------------------------------------------------
+// Only what was actually created is counted.  A null out
+// pointer just validates the description, as in D3D11
+// --------------------------------------------------------
+HRESULT RecordingGraphicsDevice::CreateBuffer(const D3D11_BUFFER_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer)
+{
+	HRESULT hr = inner->CreateBuffer(desc, initialData, buffer);
+	if (FAILED(hr) || !buffer || !*buffer)
+		return hr;
+
+	resourcesCreated.fetch_add(1, std::memory_order_relaxed);
+	if (initialData)
+		bytesUploaded.fetch_add(desc.ByteWidth, std::memory_order_relaxed);
+	TrackRelease(*buffer, desc.ByteWidth);
+	return hr;
+}
+
+HRESULT RecordingGraphicsDevice::CreateTexture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture)
+{
+	HRESULT hr = inner->CreateTexture2D(desc, initialData, texture);
+	if (FAILED(hr) || !texture || !*texture)
+		return hr;
+
+	unsigned long long bytes = GetTextureBytes(desc);
+	resourcesCreated.fetch_add(1, std::memory_order_relaxed);
+	if (initialData)
+		bytesUploaded.fetch_add(bytes, std::memory_order_relaxed);
+	TrackRelease(*texture, bytes);
+	return hr;
+}
+
+// --------------------------------------------------------
+// The resource holds the tracker from here on and releases
+// it when it's destroyed, taking the bytes back off.  If it
+// won't take it, the bytes come straight back off
+// --------------------------------------------------------
+void RecordingGraphicsDevice::TrackRelease(ID3D11Resource* resource, unsigned long long bytes)
+{
+	ReleaseTracker* tracker = new ReleaseTracker(resourceBytes, bytes);
+	resource->SetPrivateDataInterface(ReleaseTrackerGuid, tracker);
+	tracker->Release();
+}
+
+void RecordingGraphicsDevice::UpdateSubresource(ID3D11DeviceContext* context, ID3D11Resource* resource, const D3D11_BOX* box, const void* data, unsigned int bytes)
+{
+	bytesUploaded.fetch_add(bytes, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->UpdateSubresource(context, resource, box, data, bytes);
+}
+
+void RecordingGraphicsDevice::SetShader(ID3D11DeviceContext* context, ShaderStage stage, ID3D11DeviceChild* shader)
+{
+	shaderBinds.fetch_add(1, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->SetShader(context, stage, shader);
+}
+
+void RecordingGraphicsDevice::SetConstantBuffers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	constantBufferBinds.fetch_add(count, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->SetConstantBuffers(context, stage, slot, count, buffers);
+}
+
+void RecordingGraphicsDevice::SetShaderResources(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs)
+{
+	shaderResourceBinds.fetch_add(count, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->SetShaderResources(context, stage, slot, count, srvs);
+}
+
+void RecordingGraphicsDevice::SetSamplers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	samplerBinds.fetch_add(count, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->SetSamplers(context, stage, slot, count, samplers);
+}
+
+void RecordingGraphicsDevice::SetInputLayout(ID3D11DeviceContext* context, ID3D11InputLayout* layout)
+{
+	inputBinds.fetch_add(1, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->SetInputLayout(context, layout);
+}
+
+void RecordingGraphicsDevice::SetVertexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	inputBinds.fetch_add(1, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->SetVertexBuffer(context, buffer, stride, offset);
+}
+
+void RecordingGraphicsDevice::SetIndexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	inputBinds.fetch_add(1, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->SetIndexBuffer(context, buffer, format, offset);
+}
+
+void RecordingGraphicsDevice::Draw(ID3D11DeviceContext* context, unsigned int vertexCount, unsigned int startVertex)
+{
+	drawCalls.fetch_add(1, std::memory_order_relaxed);
+	triangles.fetch_add(vertexCount / 3, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->Draw(context, vertexCount, startVertex);
+}
+
+void RecordingGraphicsDevice::DrawIndexed(ID3D11DeviceContext* context, unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	drawCalls.fetch_add(1, std::memory_order_relaxed);
+	triangles.fetch_add(indexCount / 3, std::memory_order_relaxed);
+	if (IsSubmitting())
+		inner->DrawIndexed(context, indexCount, startIndex, baseVertex);
+}
+
+GraphicsDeviceStats RecordingGraphicsDevice::GetStats()
+{
+	GraphicsDeviceStats stats = {};
+	stats.DrawCalls = drawCalls.load(std::memory_order_relaxed);
+	stats.Triangles = triangles.load(std::memory_order_relaxed);
+	stats.BytesUploaded = bytesUploaded.load(std::memory_order_relaxed);
+	stats.ShaderBinds = shaderBinds.load(std::memory_order_relaxed);
+	stats.ConstantBufferBinds = constantBufferBinds.load(std::memory_order_relaxed);
+	stats.ShaderResourceBinds = shaderResourceBinds.load(std::memory_order_relaxed);
+	stats.SamplerBinds = samplerBinds.load(std::memory_order_relaxed);
+	stats.InputBinds = inputBinds.load(std::memory_order_relaxed);
+	stats.ResourcesCreated = resourcesCreated.load(std::memory_order_relaxed);
+	stats.ResourceBytes = resourceBytes->load(std::memory_order_relaxed);
+	return stats;
+}
+
+// --------------------------------------------------------
+// Every mip of every array slice.  Zero mip levels means a
+// full chain, down to 1x1
+// --------------------------------------------------------
+unsigned long long GetTextureBytes(const D3D11_TEXTURE2D_DESC& desc)
+{
+	bool blockCompressed = false;
+	unsigned int formatBytes = GetFormatBytes(desc.Format, blockCompressed);
+
+	unsigned int mips = desc.MipLevels;
+	if (mips == 0)
+	{
+		unsigned int size = std::max(desc.Width, desc.Height);
+		while (size > 0)
+		{
+			mips++;
+			size >>= 1;
+		}
+	}
+
+	unsigned long long bytes = 0;
+	unsigned int width = desc.Width;
+	unsigned int height = desc.Height;
+	for (unsigned int m = 0; m < mips; m++)
+	{
+		if (blockCompressed)
+			bytes += (unsigned long long)((width + 3) / 4) * ((height + 3) / 4) * formatBytes;
+		else
+			bytes += (unsigned long long)width * height * formatBytes;
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+
+	unsigned int samples = desc.SampleDesc.Count > 1 ? desc.SampleDesc.Count : 1;
+	return bytes * std::max(desc.ArraySize, 1u) * samples;
+}
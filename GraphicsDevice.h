@@ -0,0 +1,124 @@
+#pragma once
+#include <d3d11.h>
+#include <atomic>
+#include <memory>
+
+enum class ShaderStage
+{
+	Vertex,
+	Hull,
+	Domain,
+	Geometry,
+	Pixel,
+	Compute
+};
+
+// Totals since the device was created.  Take the difference
+// of two snapshots for a single frame
+struct GraphicsDeviceStats
+{
+	unsigned long long DrawCalls;
+	unsigned long long Triangles;			// Assumes triangle lists
+	unsigned long long BytesUploaded;
+	unsigned long long ShaderBinds;
+	unsigned long long ConstantBufferBinds;
+	unsigned long long ShaderResourceBinds;
+	unsigned long long SamplerBinds;
+	unsigned long long InputBinds;			// Input layouts, vertex and index buffers
+	unsigned long long ResourcesCreated;
+	unsigned long long ResourceBytes;		// Created and not yet released, so not a running total
+
+	unsigned long long StateChanges() const
+	{
+		return ShaderBinds + ConstantBufferBinds + ShaderResourceBinds + SamplerBinds + InputBinds;
+	}
+};
+
+// --------------------------------------------------------
+// The calls the engine makes often enough to be worth
+// counting: draws, uploads, shader state and geometry
+// binds, plus buffer and texture creation.  Submission calls
+// take the context to record into, which may be deferred.
+// Less frequent setup (render targets, viewports, blend and
+// depth states, queries) still goes straight to the context
+// --------------------------------------------------------
+class IGraphicsDevice
+{
+public:
+	virtual ~IGraphicsDevice() = default;
+
+	virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer) = 0;
+	virtual HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) = 0;
+
+	// Box may be null for the whole resource.  Bytes is only used for counting
+	virtual void UpdateSubresource(ID3D11DeviceContext* context, ID3D11Resource* resource, const D3D11_BOX* box, const void* data, unsigned int bytes) = 0;
+
+	// Shader must match the stage (an ID3D11PixelShader for Pixel...)
+	virtual void SetShader(ID3D11DeviceContext* context, ShaderStage stage, ID3D11DeviceChild* shader) = 0;
+	virtual void SetConstantBuffers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) = 0;
+	virtual void SetShaderResources(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) = 0;
+	virtual void SetSamplers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) = 0;
+
+	virtual void SetInputLayout(ID3D11DeviceContext* context, ID3D11InputLayout* layout) = 0;
+	virtual void SetVertexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) = 0;
+	virtual void SetIndexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset) = 0;
+
+	virtual void Draw(ID3D11DeviceContext* context, unsigned int vertexCount, unsigned int startVertex) = 0;
+	virtual void DrawIndexed(ID3D11DeviceContext* context, unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+};
+
+// Approximate size in memory, ignoring padding and alignment
+unsigned long long GetTextureBytes(const D3D11_TEXTURE2D_DESC& desc);
+
+// --------------------------------------------------------
+// Counts everything asked of it, then optionally passes it
+// on.  With submission turned off, draws, uploads and binds
+// are counted but go nowhere, so the frame's CPU side and
+// call counts can be measured without GPU work behind them.
+// Creation is still passed on, since the rest of the engine
+// expects resources back.  Without an inner device it wraps
+// a NullGraphicsDevice.  Each resource it creates carries a
+// tracker that takes its bytes back off when it's released.
+// Safe to call from several threads at once, as parallel
+// recording does
+// --------------------------------------------------------
+class RecordingGraphicsDevice : public IGraphicsDevice
+{
+public:
+	RecordingGraphicsDevice(std::shared_ptr<IGraphicsDevice> inner = 0, bool submit = true);
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer) override;
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) override;
+	void UpdateSubresource(ID3D11DeviceContext* context, ID3D11Resource* resource, const D3D11_BOX* box, const void* data, unsigned int bytes) override;
+	void SetShader(ID3D11DeviceContext* context, ShaderStage stage, ID3D11DeviceChild* shader) override;
+	void SetConstantBuffers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) override;
+	void SetShaderResources(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void SetSamplers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) override;
+	void SetInputLayout(ID3D11DeviceContext* context, ID3D11InputLayout* layout) override;
+	void SetVertexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) override;
+	void SetIndexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset) override;
+	void Draw(ID3D11DeviceContext* context, unsigned int vertexCount, unsigned int startVertex) override;
+	void DrawIndexed(ID3D11DeviceContext* context, unsigned int indexCount, unsigned int startIndex, int baseVertex) override;
+
+	GraphicsDeviceStats GetStats();
+	bool IsSubmitting() { return submit; }
+
+private:
+	void TrackRelease(ID3D11Resource* resource, unsigned long long bytes);
+
+	std::shared_ptr<IGraphicsDevice> inner;
+	bool submit;
+
+	std::atomic<unsigned long long> drawCalls;
+	std::atomic<unsigned long long> triangles;
+	std::atomic<unsigned long long> bytesUploaded;
+	std::atomic<unsigned long long> shaderBinds;
+	std::atomic<unsigned long long> constantBufferBinds;
+	std::atomic<unsigned long long> shaderResourceBinds;
+	std::atomic<unsigned long long> samplerBinds;
+	std::atomic<unsigned long long> inputBinds;
+	std::atomic<unsigned long long> resourcesCreated;
+
+	// Shared with the trackers, which can outlive this
+	std::shared_ptr<std::atomic<unsigned long long>> resourceBytes;
+};
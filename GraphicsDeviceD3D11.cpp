@@ -0,0 +1,100 @@
+#include "GraphicsDeviceD3D11.h"
+
+GraphicsDeviceD3D11::GraphicsDeviceD3D11(Microsoft::WRL::ComPtr<ID3D11Device> device) :
+	device(device)
+{
+}
+
+HRESULT GraphicsDeviceD3D11::CreateBuffer(const D3D11_BUFFER_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer)
+{
+	return device->CreateBuffer(&desc, initialData, buffer);
+}
+
+HRESULT GraphicsDeviceD3D11::CreateTexture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture)
+{
+	return device->CreateTexture2D(&desc, initialData, texture);
+}
+
+void GraphicsDeviceD3D11::UpdateSubresource(ID3D11DeviceContext* context, ID3D11Resource* resource, const D3D11_BOX* box, const void* data, unsigned int bytes)
+{
+	context->UpdateSubresource(resource, 0, box, data, 0, 0);
+}
+
+void GraphicsDeviceD3D11::SetShader(ID3D11DeviceContext* context, ShaderStage stage, ID3D11DeviceChild* shader)
+{
+	switch (stage)
+	{
+	case ShaderStage::Vertex: context->VSSetShader(static_cast<ID3D11VertexShader*>(shader), 0, 0); break;
+	case ShaderStage::Hull: context->HSSetShader(static_cast<ID3D11HullShader*>(shader), 0, 0); break;
+	case ShaderStage::Domain: context->DSSetShader(static_cast<ID3D11DomainShader*>(shader), 0, 0); break;
+	case ShaderStage::Geometry: context->GSSetShader(static_cast<ID3D11GeometryShader*>(shader), 0, 0); break;
+	case ShaderStage::Pixel: context->PSSetShader(static_cast<ID3D11PixelShader*>(shader), 0, 0); break;
+	case ShaderStage::Compute: context->CSSetShader(static_cast<ID3D11ComputeShader*>(shader), 0, 0); break;
+	}
+}
+
+void GraphicsDeviceD3D11::SetConstantBuffers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	switch (stage)
+	{
+	case ShaderStage::Vertex: context->VSSetConstantBuffers(slot, count, buffers); break;
+	case ShaderStage::Hull: context->HSSetConstantBuffers(slot, count, buffers); break;
+	case ShaderStage::Domain: context->DSSetConstantBuffers(slot, count, buffers); break;
+	case ShaderStage::Geometry: context->GSSetConstantBuffers(slot, count, buffers); break;
+	case ShaderStage::Pixel: context->PSSetConstantBuffers(slot, count, buffers); break;
+	case ShaderStage::Compute: context->CSSetConstantBuffers(slot, count, buffers); break;
+	}
+}
+
+void GraphicsDeviceD3D11::SetShaderResources(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs)
+{
+	switch (stage)
+	{
+	case ShaderStage::Vertex: context->VSSetShaderResources(slot, count, srvs); break;
+	case ShaderStage::Hull: context->HSSetShaderResources(slot, count, srvs); break;
+	case ShaderStage::Domain: context->DSSetShaderResources(slot, count, srvs); break;
+	case ShaderStage::Geometry: context->GSSetShaderResources(slot, count, srvs); break;
+	case ShaderStage::Pixel: context->PSSetShaderResources(slot, count, srvs); break;
+	case ShaderStage::Compute: context->CSSetShaderResources(slot, count, srvs); break;
+	}
+}
+
+void GraphicsDeviceD3D11::SetSamplers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	switch (stage)
+	{
+	case ShaderStage::Vertex: context->VSSetSamplers(slot, count, samplers); break;
+	case ShaderStage::Hull: context->HSSetSamplers(slot, count, samplers); break;
+	case ShaderStage::Domain: context->DSSetSamplers(slot, count, samplers); break;
+	case ShaderStage::Geometry: context->GSSetSamplers(slot, count, samplers); break;
+	case ShaderStage::Pixel: context->PSSetSamplers(slot, count, samplers); break;
+	case ShaderStage::Compute: context->CSSetSamplers(slot, count, samplers); break;
+	}
+}
+
+void GraphicsDeviceD3D11::SetInputLayout(ID3D11DeviceContext* context, ID3D11InputLayout* layout)
+{
+	context->IASetInputLayout(layout);
+}
+
+void GraphicsDeviceD3D11::SetVertexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	UINT strides[] = { stride };
+	UINT offsets[] = { offset };
+	context->IASetVertexBuffers(0, 1, &buffer, strides, offsets);
+}
+
+void GraphicsDeviceD3D11::SetIndexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	context->IASetIndexBuffer(buffer, format, offset);
+}
+
+void GraphicsDeviceD3D11::Draw(ID3D11DeviceContext* context, unsigned int vertexCount, unsigned int startVertex)
+{
+	context->Draw(vertexCount, startVertex);
+}
+
+void GraphicsDeviceD3D11::DrawIndexed(ID3D11DeviceContext* context, unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include "GraphicsDevice.h"
+
+// --------------------------------------------------------
+// Passes each call straight on to D3D11: creation goes to
+// the device given here, submission to whichever context
+// the caller hands in
+// --------------------------------------------------------
+class GraphicsDeviceD3D11 : public IGraphicsDevice
+{
+public:
+	GraphicsDeviceD3D11(Microsoft::WRL::ComPtr<ID3D11Device> device);
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer) override;
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) override;
+	void UpdateSubresource(ID3D11DeviceContext* context, ID3D11Resource* resource, const D3D11_BOX* box, const void* data, unsigned int bytes) override;
+	void SetShader(ID3D11DeviceContext* context, ShaderStage stage, ID3D11DeviceChild* shader) override;
+	void SetConstantBuffers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) override;
+	void SetShaderResources(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void SetSamplers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) override;
+	void SetInputLayout(ID3D11DeviceContext* context, ID3D11InputLayout* layout) override;
+	void SetVertexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) override;
+	void SetIndexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset) override;
+	void Draw(ID3D11DeviceContext* context, unsigned int vertexCount, unsigned int startVertex) override;
+	void DrawIndexed(ID3D11DeviceContext* context, unsigned int indexCount, unsigned int startIndex, int baseVertex) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+};
@@ -0,0 +1,173 @@
+#include "GraphicsDeviceNull.h"
+#include <cstring>
+#include <vector>
+#include <wrl/client.h>
+
+namespace
+{
+	// --------------------------------------------------------
+	// Just enough of an ID3D11Buffer or ID3D11Texture2D for the
+	// engine to hold, describe and hang private data on.  Owns
+	// nothing but its description
+	// --------------------------------------------------------
+	template<class Interface, class Desc, D3D11_RESOURCE_DIMENSION Dimension>
+	class NullResource : public Interface
+	{
+	public:
+		NullResource(const Desc& desc, unsigned long long bytes, std::shared_ptr<NullResourceTotals> totals) :
+			refCount(1), desc(desc), bytes(bytes), evictionPriority(0), totals(totals)
+		{
+			totals->Count.fetch_add(1, std::memory_order_relaxed);
+			totals->Bytes.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		~NullResource()
+		{
+			totals->Count.fetch_sub(1, std::memory_order_relaxed);
+			totals->Bytes.fetch_sub(bytes, std::memory_order_relaxed);
+		}
+
+		// IUnknown
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID id, void** object) override
+		{
+			if (!object)
+				return E_POINTER;
+			if (id == __uuidof(IUnknown) || id == __uuidof(ID3D11DeviceChild) ||
+				id == __uuidof(ID3D11Resource) || id == __uuidof(Interface))
+			{
+				AddRef();
+				*object = static_cast<Interface*>(this);
+				return S_OK;
+			}
+			*object = 0;
+			return E_NOINTERFACE;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef() override
+		{
+			return refCount.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			ULONG count = refCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+			if (count == 0)
+				delete this;
+			return count;
+		}
+
+		// ID3D11DeviceChild
+		void STDMETHODCALLTYPE GetDevice(ID3D11Device** device) override
+		{
+			*device = 0;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* size, void* data) override
+		{
+			if (!size)
+				return E_INVALIDARG;
+			for (PrivateData& p : privateData)
+			{
+				if (p.Guid != guid)
+					continue;
+				if (p.Object)
+				{
+					if (data && *size < sizeof(IUnknown*))
+						return DXGI_ERROR_MORE_DATA;
+					*size = sizeof(IUnknown*);
+					if (data)
+					{
+						p.Object.Get()->AddRef();
+						*(IUnknown**)data = p.Object.Get();
+					}
+					return S_OK;
+				}
+				if (data && *size < p.Bytes.size())
+					return DXGI_ERROR_MORE_DATA;
+				*size = (UINT)p.Bytes.size();
+				if (data)
+					memcpy(data, p.Bytes.data(), p.Bytes.size());
+				return S_OK;
+			}
+			*size = 0;
+			return DXGI_ERROR_NOT_FOUND;
+		}
+
+		HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT size, const void* data) override
+		{
+			PrivateData& p = FindPrivateData(guid);
+			p.Object.Reset();
+			p.Bytes.assign((const char*)data, (const char*)data + (data ? size : 0));
+			return S_OK;
+		}
+
+		// Held until it's replaced or this resource goes, like D3D11
+		HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* data) override
+		{
+			PrivateData& p = FindPrivateData(guid);
+			p.Bytes.clear();
+			p.Object = const_cast<IUnknown*>(data);
+			return S_OK;
+		}
+
+		// ID3D11Resource
+		void STDMETHODCALLTYPE GetType(D3D11_RESOURCE_DIMENSION* dimension) override { *dimension = Dimension; }
+		void STDMETHODCALLTYPE SetEvictionPriority(UINT priority) override { evictionPriority = priority; }
+		UINT STDMETHODCALLTYPE GetEvictionPriority() override { return evictionPriority; }
+
+		// ID3D11Buffer or ID3D11Texture2D
+		void STDMETHODCALLTYPE GetDesc(Desc* out) override { *out = desc; }
+
+	private:
+		struct PrivateData
+		{
+			GUID Guid;
+			std::vector<char> Bytes;
+			Microsoft::WRL::ComPtr<IUnknown> Object;
+		};
+
+		PrivateData& FindPrivateData(REFGUID guid)
+		{
+			for (PrivateData& p : privateData)
+				if (p.Guid == guid)
+					return p;
+			privateData.emplace_back();
+			privateData.back().Guid = guid;
+			return privateData.back();
+		}
+
+		std::atomic<ULONG> refCount;
+		Desc desc;
+		unsigned long long bytes;
+		UINT evictionPriority;
+		std::vector<PrivateData> privateData;
+		std::shared_ptr<NullResourceTotals> totals;
+	};
+
+	typedef NullResource<ID3D11Buffer, D3D11_BUFFER_DESC, D3D11_RESOURCE_DIMENSION_BUFFER> NullBuffer;
+	typedef NullResource<ID3D11Texture2D, D3D11_TEXTURE2D_DESC, D3D11_RESOURCE_DIMENSION_TEXTURE2D> NullTexture2D;
+}
+
+NullGraphicsDevice::NullGraphicsDevice() :
+	totals(std::make_shared<NullResourceTotals>())
+{
+}
+
+// --------------------------------------------------------
+// Initial data is ignored: nothing ever reads the contents
+// --------------------------------------------------------
+HRESULT NullGraphicsDevice::CreateBuffer(const D3D11_BUFFER_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer)
+{
+	if (!buffer)
+		return S_FALSE;
+	*buffer = new NullBuffer(desc, desc.ByteWidth, totals);
+	return S_OK;
+}
+
+HRESULT NullGraphicsDevice::CreateTexture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture)
+{
+	if (!texture)
+		return S_FALSE;
+	*texture = new NullTexture2D(desc, GetTextureBytes(desc), totals);
+	return S_OK;
+}
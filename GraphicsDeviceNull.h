@@ -0,0 +1,49 @@
+#pragma once
+#include <d3d11.h>
+#include <atomic>
+#include <memory>
+#include "GraphicsDevice.h"
+
+// Resources a NullGraphicsDevice has handed out and not yet
+// had released.  Shared with each resource, since they can
+// outlive the device that made them
+struct NullResourceTotals
+{
+	std::atomic<unsigned long long> Count = 0;
+	std::atomic<unsigned long long> Bytes = 0;
+};
+
+// --------------------------------------------------------
+// Creates no D3D objects and submits nothing.  Buffers and
+// textures come back as small stand-ins that remember their
+// description and private data, and take themselves off the
+// live totals when their last reference goes.  Submission
+// calls are dropped.  Only what goes through IGraphicsDevice
+// is covered: views, shaders and states are still made on
+// a real device elsewhere in the engine
+// --------------------------------------------------------
+class NullGraphicsDevice : public IGraphicsDevice
+{
+public:
+	NullGraphicsDevice();
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer) override;
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) override;
+	void UpdateSubresource(ID3D11DeviceContext* context, ID3D11Resource* resource, const D3D11_BOX* box, const void* data, unsigned int bytes) override {}
+	void SetShader(ID3D11DeviceContext* context, ShaderStage stage, ID3D11DeviceChild* shader) override {}
+	void SetConstantBuffers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) override {}
+	void SetShaderResources(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override {}
+	void SetSamplers(ID3D11DeviceContext* context, ShaderStage stage, unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) override {}
+	void SetInputLayout(ID3D11DeviceContext* context, ID3D11InputLayout* layout) override {}
+	void SetVertexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) override {}
+	void SetIndexBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset) override {}
+	void Draw(ID3D11DeviceContext* context, unsigned int vertexCount, unsigned int startVertex) override {}
+	void DrawIndexed(ID3D11DeviceContext* context, unsigned int indexCount, unsigned int startIndex, int baseVertex) override {}
+
+	// Created and not yet released
+	unsigned long long GetLiveResources() { return totals->Count.load(std::memory_order_relaxed); }
+	unsigned long long GetLiveBytes() { return totals->Bytes.load(std::memory_order_relaxed); }
+
+private:
+	std::shared_ptr<NullResourceTotals> totals;
+};
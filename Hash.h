@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+
+// --------------------------------------------------------
+// FNV-1a, used by the shadow caches to notice when anything
+// a cached cascade or atlas tile depends on has changed
+// --------------------------------------------------------
+namespace Hash
+{
+	const unsigned long long Seed = 14695981039346656037ull;
+
+	inline void Bytes(unsigned long long& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+}
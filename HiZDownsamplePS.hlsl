@@ -0,0 +1,37 @@
+cbuffer ExternalData : register(b0)
+{
+    int2 sourceSize; // Size of the level being reduced
+}
+
+// Defines the input to this pixel shader
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// Textures and such
+Texture2D Source : register(t0);
+
+// Farthest depth of the 2x2 block under this pixel.  When the
+// source has an odd size, the last row/column also takes in the
+// leftover texel so nothing is skipped.  Must match
+// Occlusion::DepthPyramid::Build() on the C++ side
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    int2 dest = int2(input.position.xy);
+    int2 start = dest * 2;
+    int2 end = start + 1;
+
+    int2 destSize = max(sourceSize / 2, int2(1, 1));
+    if (dest.x == destSize.x - 1) end.x = sourceSize.x - 1;
+    if (dest.y == destSize.y - 1) end.y = sourceSize.y - 1;
+
+    float farthest = 0;
+    for (int y = start.y; y <= end.y; y++)
+    {
+        for (int x = start.x; x <= end.x; x++)
+            farthest = max(farthest, Source.Load(int3(x, y, 0)).r);
+    }
+    return float4(farthest, 0, 0, 1);
+}
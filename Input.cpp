@@ -1,5 +1,8 @@
 #include "Input.h"
+#include "InputEvents.h"
+#include "Profiler.h"
 #include <hidusage.h>
+#include <windowsx.h>
 
 // --------------- Basic usage -----------------
 // 
@@ -97,6 +100,28 @@ namespace Input
 		// The window's handle (id) from the OS, so
 		// we can get the cursor's position
 		HWND hWnd = 0;
+
+		// Filled in by the window procedure, emptied once a frame
+		InputEventQueue events;
+		long long oldestEventTime = 0;
+		long long newestEventTime = 0;
+
+		// Mouse movement found by the late latch
+		int latchedMouseXDelta = 0;
+		int latchedMouseYDelta = 0;
+		long long latchTime = 0;
+
+		void QueueEvent(InputEventType type, int code = 0, int x = 0, int y = 0, float wheel = 0.0f)
+		{
+			InputEvent e = {};
+			e.Type = type;
+			e.Code = code;
+			e.X = x;
+			e.Y = y;
+			e.Wheel = wheel;
+			e.TimeNs = Profiler::Now();
+			events.Push(e);
+		}
 	}
 }
 
@@ -150,6 +175,25 @@ void Input::ShutDown()
 // ----------------------------------------------------------
 void Input::Update()
 {
+	// Everything the window has seen since last frame.  Keys and
+	// buttons are read below as a whole, so here they only count
+	// towards when this frame's input happened
+	InputEvent e = {};
+	while (events.Pop(e))
+	{
+		if (e.Type == InputEventType::RawMouseMove)
+		{
+			rawMouseXDelta += e.X;
+			rawMouseYDelta += e.Y;
+		}
+		else if (e.Type == InputEventType::MouseWheel)
+			wheelDelta += e.Wheel;
+
+		if (oldestEventTime == 0)
+			oldestEventTime = e.TimeNs;
+		newestEventTime = e.TimeNs;
+	}
+
 	// Copy the old keys so we have last frame's data
 	memcpy(prevKbState, kbState, sizeof(unsigned char) * 256);
 
@@ -185,8 +229,75 @@ void Input::EndOfFrame()
 	wheelDelta = 0;
 	rawMouseXDelta = 0;
 	rawMouseYDelta = 0;
+
+	// And the frame's late latch and event times
+	latchedMouseXDelta = 0;
+	latchedMouseYDelta = 0;
+	latchTime = 0;
+	oldestEventTime = 0;
+	newestEventTime = 0;
+}
+
+// ----------------------------------------------------------
+//  Turns window messages into input events.  Keys and mouse
+//  buttons are queued for their timestamps; raw movement and
+//  the wheel are also added up from the queue
+// ----------------------------------------------------------
+void Input::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+	switch (message)
+	{
+	case WM_KEYDOWN:
+	case WM_SYSKEYDOWN:	QueueEvent(InputEventType::KeyDown, (int)wParam); break;
+	case WM_KEYUP:
+	case WM_SYSKEYUP:	QueueEvent(InputEventType::KeyUp, (int)wParam); break;
+
+	case WM_LBUTTONDOWN:	QueueEvent(InputEventType::MouseButtonDown, VK_LBUTTON); break;
+	case WM_RBUTTONDOWN:	QueueEvent(InputEventType::MouseButtonDown, VK_RBUTTON); break;
+	case WM_MBUTTONDOWN:	QueueEvent(InputEventType::MouseButtonDown, VK_MBUTTON); break;
+	case WM_LBUTTONUP:		QueueEvent(InputEventType::MouseButtonUp, VK_LBUTTON); break;
+	case WM_RBUTTONUP:		QueueEvent(InputEventType::MouseButtonUp, VK_RBUTTON); break;
+	case WM_MBUTTONUP:		QueueEvent(InputEventType::MouseButtonUp, VK_MBUTTON); break;
+
+	case WM_MOUSEMOVE:
+		QueueEvent(InputEventType::MouseMove, 0, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		break;
+
+	case WM_MOUSEWHEEL:
+		QueueEvent(InputEventType::MouseWheel, 0, 0, 0, GET_WHEEL_DELTA_WPARAM(wParam) / (float)WHEEL_DELTA);
+		break;
+
+	case WM_INPUT:
+		ProcessRawMouseInput(lParam);
+		break;
+	}
 }
 
+// ----------------------------------------------------------
+//  The late latch.  The cursor moves whether or not messages
+//  are being handled, so reading it again this late catches
+//  movement from while the frame was being built
+// ----------------------------------------------------------
+void Input::LatchMouse()
+{
+	POINT mousePos = {};
+	GetCursorPos(&mousePos);
+	ScreenToClient(hWnd, &mousePos);
+
+	latchedMouseXDelta = mousePos.x - mouseX;
+	latchedMouseYDelta = mousePos.y - mouseY;
+	mouseX = mousePos.x;
+	mouseY = mousePos.y;
+	latchTime = Profiler::Now();
+}
+
+int Input::GetLatchedMouseXDelta() { return latchedMouseXDelta; }
+int Input::GetLatchedMouseYDelta() { return latchedMouseYDelta; }
+long long Input::GetOldestEventTime() { return oldestEventTime; }
+long long Input::GetNewestEventTime() { return newestEventTime; }
+long long Input::GetLatchTime() { return latchTime; }
+unsigned long long Input::GetDroppedEventCount() { return events.GetDroppedCount(); }
+
 // ----------------------------------------------------------
 //  Get the mouse's current position in pixels relative
 //  to the top left corner of the window.
@@ -226,9 +337,9 @@ void Input::ProcessRawMouseInput(LPARAM lParam)
 	RAWINPUT* raw = (RAWINPUT*)rawInputBytes;
 	if (raw->header.dwType == RIM_TYPEMOUSE)
 	{
-		// This is mouse data, so grab the movement values
-		rawMouseXDelta = raw->data.mouse.lLastX;
-		rawMouseYDelta = raw->data.mouse.lLastY;
+		// This is mouse data, so queue the movement values.  There
+		// can be several of these a frame, so Update() adds them up
+		QueueEvent(InputEventType::RawMouseMove, 0, raw->data.mouse.lLastX, raw->data.mouse.lLastY);
 	}
 }
 
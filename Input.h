@@ -11,6 +11,25 @@ namespace Input
 	void Update();
 	void EndOfFrame();
 
+	// Called by the window for every message.  Input messages are
+	// timestamped and queued, then picked up by the next Update()
+	void ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam);
+
+	// Late latch: reads the cursor again just before the camera's
+	// matrices are used.  Movement since Update() is reported here
+	// and left out of the next frame's mouse delta
+	void LatchMouse();
+	int GetLatchedMouseXDelta();
+	int GetLatchedMouseYDelta();
+
+	// When this frame's input happened, as Profiler::Now() times:
+	// the oldest and newest events Update() picked up (zero if there
+	// were none), and the last LatchMouse() (zero if it didn't run)
+	long long GetOldestEventTime();
+	long long GetNewestEventTime();
+	long long GetLatchTime();
+	unsigned long long GetDroppedEventCount();
+
 	int GetMouseX();
 	int GetMouseY();
 	int GetMouseXDelta();
@@ -0,0 +1,34 @@
+#include "InputEvents.h"
+
+InputEventQueue::InputEventQueue() :
+	events(),
+	head(0),
+	tail(0),
+	dropped(0)
+{
+}
+
+bool InputEventQueue::Push(const InputEvent& e)
+{
+	unsigned int h = head.load(std::memory_order_relaxed);
+	if (h - tail.load(std::memory_order_acquire) >= INPUT_EVENT_QUEUE_SIZE)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	events[h % INPUT_EVENT_QUEUE_SIZE] = e;
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputEventQueue::Pop(InputEvent& e)
+{
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	if (t == head.load(std::memory_order_acquire))
+		return false;
+
+	e = events[t % INPUT_EVENT_QUEUE_SIZE];
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+
+#define INPUT_EVENT_QUEUE_SIZE 1024
+
+enum class InputEventType
+{
+	KeyDown,
+	KeyUp,
+	MouseButtonDown,
+	MouseButtonUp,
+	MouseMove,		// X and Y are the cursor position in the window
+	RawMouseMove,	// X and Y are how far the mouse itself moved
+	MouseWheel
+};
+
+// One message from the window.  The time is Profiler::Now()
+// when the message was handled, so it lines up with the
+// profiler's frames
+struct InputEvent
+{
+	InputEventType Type;
+	int Code;		// Virtual key, or VK_LBUTTON/VK_RBUTTON/VK_MBUTTON
+	int X;
+	int Y;
+	float Wheel;	// In notches
+	long long TimeNs;
+};
+
+// --------------------------------------------------------
+// Fixed size, single producer, single consumer queue.  The
+// window procedure pushes and the frame pops, without a lock
+// between them, so the two can live on different threads.
+// A full queue drops new events rather than block the
+// window procedure
+// --------------------------------------------------------
+class InputEventQueue
+{
+public:
+	InputEventQueue();
+
+	// Producer only.  False if the queue was full
+	bool Push(const InputEvent& e);
+
+	// Consumer only.  False if the queue was empty
+	bool Pop(InputEvent& e);
+
+	unsigned long long GetDroppedCount() { return dropped; }
+
+private:
+	InputEvent events[INPUT_EVENT_QUEUE_SIZE];
+	std::atomic<unsigned int> head;
+	std::atomic<unsigned int> tail;
+	std::atomic<unsigned long long> dropped;
+};
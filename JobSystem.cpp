@@ -0,0 +1,252 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace
+{
+	// Which worker of which system the current thread is
+	thread_local JobSystem* threadSystem = 0;
+	thread_local unsigned int threadWorker = 0;
+
+	// Jobs run while waiting inside another job are already
+	// part of that job's busy time
+	thread_local int threadJobDepth = 0;
+}
+
+JobSystem::JobSystem(unsigned int threadCount) :
+	quit(false), queued(0)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		workers.push_back(std::make_unique<Worker>());
+		workers.back()->JobsRun = 0;
+		workers.back()->Steals = 0;
+		workers.back()->BusyNanoseconds = 0;
+	}
+
+	threadSystem = this;
+	threadWorker = 0;
+	statsStart = std::chrono::steady_clock::now();
+
+	for (unsigned int i = 1; i < threadCount; i++)
+		threads.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto& t : threads)
+		t.join();
+
+	if (threadSystem == this)
+		threadSystem = 0;
+}
+
+// --------------------------------------------------------
+// Threads that aren't one of our workers (or belong to a
+// different system) queue onto worker 0
+// --------------------------------------------------------
+unsigned int JobSystem::CurrentWorker()
+{
+	return threadSystem == this ? threadWorker : 0;
+}
+
+void JobSystem::Run(std::function<void()> job, JobCounter& counter)
+{
+	counter.Pending++;
+	queued++;
+
+	Worker& w = *workers[CurrentWorker()];
+	{
+		std::lock_guard<std::mutex> lock(w.Lock);
+		w.Jobs.push_back({ std::move(job), &counter });
+	}
+
+	// Taking the lock means a thread that just saw nothing queued
+	// is already waiting, so it can't miss this notify
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+	}
+	wake.notify_one();
+}
+
+void JobSystem::RunBackground(std::function<void()> job, JobCounter& counter)
+{
+	counter.Pending++;
+	queued++;
+
+	{
+		std::lock_guard<std::mutex> lock(backgroundLock);
+		background.push_back({ std::move(job), &counter });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+	}
+	wake.notify_one();
+}
+
+// --------------------------------------------------------
+// Takes a background job if allowed, then pops the newest
+// job off our own deque, or steals the oldest one from
+// another worker.  Returns false if there was nothing to do
+// --------------------------------------------------------
+bool JobSystem::TryRunOne(unsigned int self, bool allowBackground)
+{
+	Job job = {};
+	bool found = false;
+	bool stolen = false;
+
+	if (allowBackground)
+	{
+		std::lock_guard<std::mutex> lock(backgroundLock);
+		if (!background.empty())
+		{
+			job = std::move(background.front());
+			background.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		Worker& w = *workers[self];
+		std::lock_guard<std::mutex> lock(w.Lock);
+		if (!w.Jobs.empty())
+		{
+			job = std::move(w.Jobs.back());
+			w.Jobs.pop_back();
+			found = true;
+		}
+	}
+
+	for (unsigned int i = 1; !found && i < workers.size(); i++)
+	{
+		Worker& victim = *workers[(self + i) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.Lock);
+		if (!victim.Jobs.empty())
+		{
+			job = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			found = stolen = true;
+		}
+	}
+
+	if (!found)
+		return false;
+	queued--;
+
+	auto start = std::chrono::steady_clock::now();
+	threadJobDepth++;
+	{
+		PROFILE_SCOPE(stolen ? "Job (stolen)" : "Job");
+		job.Work();
+	}
+	threadJobDepth--;
+	auto end = std::chrono::steady_clock::now();
+
+	Worker& w = *workers[self];
+	if (threadJobDepth == 0)
+		w.BusyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	w.JobsRun++;
+	if (stolen)
+		w.Steals++;
+
+	job.Counter->Pending--;
+	return true;
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	// Background jobs are left to the worker threads, so waiting
+	// here can't get stuck behind one.  With no worker threads
+	// there's nobody else to run them
+	unsigned int self = CurrentWorker();
+	bool allowBackground = workers.size() == 1;
+	while (counter.Pending > 0)
+	{
+		// Whatever's left is running on another thread
+		if (!TryRunOne(self, allowBackground))
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+	threadSystem = this;
+	threadWorker = index;
+	Profiler::SetThreadName("Worker " + std::to_string(index));
+
+	while (!quit)
+	{
+		if (TryRunOne(index, true))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepLock);
+		wake.wait(lock, [this]() { return quit || queued > 0; });
+	}
+}
+
+// --------------------------------------------------------
+// Splits the range into chunks of grainSize and runs them as
+// jobs.  The caller helps out until they're all done
+// --------------------------------------------------------
+void JobSystem::ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& body)
+{
+	if (count == 0)
+		return;
+	if (grainSize == 0)
+		grainSize = 1;
+
+	// Not worth the trip through the queues
+	if (count <= grainSize || workers.size() == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (unsigned int begin = 0; begin < count; begin += grainSize)
+	{
+		unsigned int end = begin + grainSize < count ? begin + grainSize : count;
+		Run([&body, begin, end]() { body(begin, end); }, counter);
+	}
+	Wait(counter);
+}
+
+unsigned int JobSystem::GetWorkerCount()
+{
+	return (unsigned int)workers.size();
+}
+
+JobWorkerStats JobSystem::GetWorkerStats(unsigned int worker)
+{
+	Worker& w = *workers[worker];
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - statsStart).count();
+
+	JobWorkerStats stats = {};
+	stats.JobsRun = w.JobsRun;
+	stats.Steals = w.Steals;
+	stats.BusySeconds = w.BusyNanoseconds / 1e9;
+	stats.Utilization = elapsed > 0.0 ? (float)(stats.BusySeconds / elapsed) : 0.0f;
+	return stats;
+}
+
+void JobSystem::ResetStats()
+{
+	for (auto& w : workers)
+	{
+		w->JobsRun = 0;
+		w->Steals = 0;
+		w->BusyNanoseconds = 0;
+	}
+	statsStart = std::chrono::steady_clock::now();
+}
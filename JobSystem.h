@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Counts jobs that haven't finished yet.  Hand the same one
+// to every job in a batch, then Wait() on it
+// --------------------------------------------------------
+struct JobCounter
+{
+	std::atomic<int> Pending;
+	JobCounter() : Pending(0) {}
+};
+
+// What one worker has done since the last ResetStats()
+struct JobWorkerStats
+{
+	unsigned long long JobsRun;
+	unsigned long long Steals;	// Jobs taken from another worker's deque
+	double BusySeconds;
+	float Utilization;			// Busy time / time since the reset
+};
+
+// --------------------------------------------------------
+// A small work stealing scheduler.  Each worker owns a deque
+// and pushes/pops its own jobs at the back (newest first, so
+// the work is still in cache), while idle workers steal from
+// the front of someone else's (oldest first, usually the
+// biggest chunks).
+//
+// The thread that creates the system is worker 0.  It doesn't
+// get a thread of its own; instead it runs jobs while it
+// waits on a counter, so a frame never just blocks
+// --------------------------------------------------------
+class JobSystem
+{
+public:
+	// 0 threads means one per hardware thread, counting the caller
+	JobSystem(unsigned int threadCount = 0);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Queues a job on the calling worker's deque
+	void Run(std::function<void()> job, JobCounter& counter);
+
+	// Queues a long running job that should overlap with the
+	// caller rather than hold it up.  Only worker threads with
+	// nothing else on the go pick these up; Wait() never runs one
+	// inline unless there are no worker threads at all
+	void RunBackground(std::function<void()> job, JobCounter& counter);
+
+	// Runs (or steals) other jobs until the counter hits zero
+	void Wait(JobCounter& counter);
+
+	// Calls body(begin, end) over [0, count) in chunks of at most
+	// grainSize items, returning once every chunk is done
+	void ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& body);
+
+	// Workers, including the calling thread (worker 0)
+	unsigned int GetWorkerCount();
+	JobWorkerStats GetWorkerStats(unsigned int worker);
+	void ResetStats();
+
+private:
+	struct Job
+	{
+		std::function<void()> Work;
+		JobCounter* Counter;
+	};
+
+	struct Worker
+	{
+		std::mutex Lock;
+		std::deque<Job> Jobs;
+		std::atomic<unsigned long long> JobsRun;
+		std::atomic<unsigned long long> Steals;
+		std::atomic<long long> BusyNanoseconds;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+
+	// Shared by every worker, oldest first
+	std::mutex backgroundLock;
+	std::deque<Job> background;
+
+	// Idle threads sleep until something is queued
+	std::atomic<bool> quit;
+	std::atomic<int> queued;
+	std::mutex sleepLock;
+	std::condition_variable wake;
+
+	std::chrono::steady_clock::time_point statsStart;
+
+	unsigned int CurrentWorker();
+	bool TryRunOne(unsigned int self, bool allowBackground);
+	void WorkerLoop(unsigned int index);
+};
@@ -2,6 +2,7 @@
 #define LIGHT_TYPE_DIRECTIONAL 0
 #define LIGHT_TYPE_POINT 1
 #define LIGHT_TYPE_SPOT 2 
+#define MAX_LIGHTS 5 // Size of lights[] in PixelShader.hlsl
 #include <DirectXMath.h>
 struct Light
 {
@@ -21,7 +22,9 @@ struct Light
 
 	float SpotOuterAngle; //outer cone angle(rads)
 
-	DirectX::XMFLOAT2 Padding; //padding to hit 16 bit boundry
+	int ShadowTile; //first shadow atlas tile (-1 for none), point lights use 6 in a row
+
+	float Padding; //padding to hit 16 bit boundry
 
 };
 
@@ -28,7 +28,8 @@ struct Light
 
     float SpotInnerAngle; //inner cone angle(rads)
     float SpotOuterAngle; //outer cone angle(rads)
-    float2 Padding; //padding to hit 16 bit boundry
+    int ShadowTile; //first shadow atlas tile (-1 for none), point lights use 6 in a row
+    float Padding; //padding to hit 16 bit boundry
 
 };
 float Diffuse(float3 normal, float3 direction)
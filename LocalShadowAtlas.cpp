@@ -0,0 +1,247 @@
+#include "LocalShadowAtlas.h"
+#include "Graphics.h"
+#include "Hash.h"
+#include "PathHelpers.h"
+#include "Profiler.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Creates the atlas and what's needed to clear a single
+// tile of it
+// --------------------------------------------------------
+LocalShadowAtlas::LocalShadowAtlas(std::shared_ptr<SimpleVertexShader> shadowVS, Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer) :
+	vs(shadowVS), rasterizer(rasterizer), atlas(4096, 128), casterDraws(0), renderedTiles(0)
+{
+	unsigned int size = atlas.GetAtlasSize();
+
+	D3D11_TEXTURE2D_DESC atlasDesc = {};
+	atlasDesc.Width = size;
+	atlasDesc.Height = size;
+	atlasDesc.ArraySize = 1;
+	atlasDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+	atlasDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	atlasDesc.MipLevels = 1;
+	atlasDesc.SampleDesc.Count = 1;
+	atlasDesc.Usage = D3D11_USAGE_DEFAULT;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> atlasTexture;
+	Graphics::Api->CreateTexture2D(atlasDesc, 0, atlasTexture.GetAddressOf());
+
+	D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+	dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
+	dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	Graphics::Device->CreateDepthStencilView(atlasTexture.Get(), &dsvDesc, dsv.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	Graphics::Device->CreateShaderResourceView(atlasTexture.Get(), &srvDesc, srv.GetAddressOf());
+
+	// Start fully cleared, since tiles only clear themselves
+	Graphics::Context->ClearDepthStencilView(dsv.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+	// Clearing a tile means drawing over it with depth forced to 1
+	D3D11_DEPTH_STENCIL_DESC clearDesc = {};
+	clearDesc.DepthEnable = true;
+	clearDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	clearDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+	Graphics::Device->CreateDepthStencilState(&clearDesc, clearState.GetAddressOf());
+
+	fullscreenVS = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"FullscreenVS.cso").c_str());
+	clearPS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"ShadowAtlasClearPS.cso").c_str());
+}
+
+bool LocalShadowAtlas::CastsShadows(const Light& light)
+{
+	return settings.Enabled && light.Intensity > 0.0f &&
+		(light.Type == LIGHT_TYPE_POINT || light.Type == LIGHT_TYPE_SPOT);
+}
+
+// --------------------------------------------------------
+// Works out which point and spot lights get shadows this
+// frame, how big their tiles are and where each view looks
+// --------------------------------------------------------
+void LocalShadowAtlas::Update(Camera* camera, std::vector<Light>& lights)
+{
+	PROFILE_SCOPE("UpdateLocalShadows");
+	XMFLOAT3 camPos = camera->GetTransform()->GetPosition();
+	float tanHalfFov = tanf(camera->GetFOV() * 0.5f);
+
+	// Fraction of the screen height each light's range covers
+	std::vector<std::pair<float, int>> candidates;
+	for (int i = 0; i < (int)lights.size(); i++)
+	{
+		Light& l = lights[i];
+		l.ShadowTile = -1;
+		if (!CastsShadows(l))
+			continue;
+
+		float dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&l.Position), XMLoadFloat3(&camPos))));
+		candidates.push_back({ dist <= l.Range ? 1.0f : l.Range / (dist * tanHalfFov), i });
+	}
+
+	// Only as many faces as the shader can index, most important
+	// lights first, so nothing holds atlas space it can't use.
+	// Each light is a group, so a point light gets all six faces
+	// or none
+	std::stable_sort(candidates.begin(), candidates.end(),
+		[](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; });
+	std::vector<ShadowAtlasRequest> requests;
+	for (auto& c : candidates)
+	{
+		int i = c.second;
+		int faces = lights[i].Type == LIGHT_TYPE_POINT ? 6 : 1;
+		if (requests.size() + faces > MAX_LOCAL_SHADOW_TILES)
+			continue;
+
+		unsigned int size = ShadowAtlas::SizeForImportance(c.first, 128, settings.MaxTileSize);
+		for (int f = 0; f < faces; f++)
+			requests.push_back({ (unsigned int)(i * 8 + f), (unsigned int)i, size, c.first });
+	}
+	atlas.Update(requests);
+
+	// Build the views, in the order the shader will index them
+	const XMFLOAT3 faceDirs[6] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+	const XMFLOAT3 faceUps[6] = { {0,1,0}, {0,1,0}, {0,0,-1}, {0,0,1}, {0,1,0}, {0,1,0} };
+	views.clear();
+	for (int i = 0; i < (int)lights.size(); i++)
+	{
+		Light& l = lights[i];
+		if (!CastsShadows(l))
+			continue;
+
+		// The atlas gives a point light every face or none
+		int faces = l.Type == LIGHT_TYPE_POINT ? 6 : 1;
+		ShadowAtlasTile tiles[6];
+		bool allocated = true;
+		for (int f = 0; f < faces; f++)
+			allocated = allocated && atlas.GetTile(i * 8 + f, tiles[f]);
+		if (!allocated)
+			continue;
+
+		l.ShadowTile = (int)views.size();
+		for (int f = 0; f < faces; f++)
+		{
+			LocalShadowView view = {};
+			view.Key = i * 8 + f;
+			view.LightIndex = i;
+			view.Tile = tiles[f];
+
+			XMVECTOR pos = XMLoadFloat3(&l.Position);
+			if (l.Type == LIGHT_TYPE_POINT)
+			{
+				XMStoreFloat4x4(&view.View, XMMatrixLookToLH(pos, XMLoadFloat3(&faceDirs[f]), XMLoadFloat3(&faceUps[f])));
+				XMStoreFloat4x4(&view.Projection, XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 0.05f, l.Range));
+			}
+			else
+			{
+				XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&l.Direction));
+				XMVECTOR up = fabsf(XMVectorGetY(dir)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+				float cone = min(2.0f * max(l.SpotInnerAngle, l.SpotOuterAngle), XMConvertToRadians(170.0f));
+				XMStoreFloat4x4(&view.View, XMMatrixLookToLH(pos, dir, up));
+				XMStoreFloat4x4(&view.Projection, XMMatrixPerspectiveFovLH(cone, 1.0f, 0.05f, l.Range));
+			}
+			views.push_back(view);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Renders the atlas tiles whose contents could have changed:
+// new tiles, and ones whose light or nearby casters moved
+// --------------------------------------------------------
+void LocalShadowAtlas::Render(const std::vector<Light>& lights, const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, unsigned int width, unsigned int height)
+{
+	renderedTiles = 0;
+	casterDraws = 0;
+	if (views.empty())
+		return;
+
+	ID3D11RenderTargetView* nullRTV{};
+	Graphics::Context->OMSetRenderTargets(1, &nullRTV, dsv.Get());
+	Graphics::Context->RSSetState(rasterizer.Get());
+
+	for (auto& view : views)
+	{
+		const Light& l = lights[view.LightIndex];
+
+		// Everything the tile's contents depend on
+		unsigned long long hash = Hash::Seed;
+		Hash::Bytes(hash, &view.View, sizeof(view.View));
+		Hash::Bytes(hash, &view.Projection, sizeof(view.Projection));
+		Hash::Bytes(hash, &view.Tile, sizeof(view.Tile));
+		std::vector<std::shared_ptr<GameEntity>> casters;
+		for (auto& e : entities)
+		{
+			XMFLOAT3 center;
+			float radius;
+			e->GetWorldBounds(center, radius);
+			float dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&center), XMLoadFloat3(&l.Position))));
+			if (dist > l.Range + radius)
+				continue;
+
+			GameEntity* entity = e.get();
+			XMFLOAT4X4 world = e->GetTransform()->GetWorldMatrix();
+			int lod = e->GetLod();
+			Hash::Bytes(hash, &entity, sizeof(entity));
+			Hash::Bytes(hash, &world, sizeof(world));
+			Hash::Bytes(hash, &lod, sizeof(lod));
+			casters.push_back(e);
+		}
+
+		auto cached = tileHashes.find(view.Key);
+		if (!atlas.IsTileNew(view.Key) && cached != tileHashes.end() && cached->second == hash)
+			continue;
+		tileHashes[view.Key] = hash;
+		renderedTiles++;
+
+		D3D11_VIEWPORT viewport = {};
+		viewport.TopLeftX = (float)view.Tile.X;
+		viewport.TopLeftY = (float)view.Tile.Y;
+		viewport.Width = (float)view.Tile.Size;
+		viewport.Height = (float)view.Tile.Size;
+		viewport.MaxDepth = 1.0f;
+		Graphics::Context->RSSetViewports(1, &viewport);
+
+		// Clear just this tile
+		Graphics::Context->OMSetDepthStencilState(clearState.Get(), 0);
+		fullscreenVS->SetShader();
+		clearPS->SetShader();
+		Graphics::Api->Draw(Graphics::Context.Get(), 3, 0);
+		Graphics::Context->OMSetDepthStencilState(0, 0);
+
+		// Depth only from the light's point of view
+		Graphics::Context->PSSetShader(0, 0, 0);
+		vs->SetShader();
+		vs->SetMatrix4x4("view", view.View);
+		vs->SetMatrix4x4("projection", view.Projection);
+		for (auto& e : casters)
+		{
+			vs->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
+			vs->CopyAllBufferData();
+			e->GetMesh()->Draw(stream, e->GetLod());
+			casterDraws++;
+		}
+	}
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)width;
+	viewport.Height = (float)height;
+	viewport.MaxDepth = 1.0f;
+	Graphics::Context->RSSetViewports(1, &viewport);
+	Graphics::Context->RSSetState(0);
+}
+
+void LocalShadowAtlas::GetShaderData(XMFLOAT4X4 viewProjections[MAX_LOCAL_SHADOW_TILES], XMFLOAT4 rects[MAX_LOCAL_SHADOW_TILES])
+{
+	float atlasSize = (float)atlas.GetAtlasSize();
+	for (size_t t = 0; t < views.size(); t++)
+	{
+		LocalShadowView& v = views[t];
+		XMStoreFloat4x4(&viewProjections[t], XMMatrixMultiply(XMLoadFloat4x4(&v.View), XMLoadFloat4x4(&v.Projection)));
+		rects[t] = XMFLOAT4(v.Tile.X / atlasSize, v.Tile.Y / atlasSize, v.Tile.Size / atlasSize, v.Tile.Size / atlasSize);
+	}
+}
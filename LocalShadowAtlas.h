@@ -0,0 +1,86 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <map>
+#include <memory>
+#include <vector>
+#include "Camera.h"
+#include "GameEntity.h"
+#include "Lights.h"
+#include "ShadowAtlas.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// One view rendered into the shadow atlas (a spot light, or
+// one cube face of a point light)
+// --------------------------------------------------------
+struct LocalShadowView
+{
+	unsigned int Key;	// Light index * 8 + face
+	int LightIndex;
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	ShadowAtlasTile Tile;
+};
+
+// --------------------------------------------------------
+// Everything that can be changed from the UI
+// --------------------------------------------------------
+struct LocalShadowSettings
+{
+	bool Enabled = true;
+	int MaxTileSize = 1024;
+};
+
+// --------------------------------------------------------
+// Point and spot light shadows, sharing one atlas.  Tiles
+// are sized by how much of the screen the light covers and
+// are only re-rendered when their contents could have
+// changed
+// --------------------------------------------------------
+class LocalShadowAtlas
+{
+public:
+	LocalShadowAtlas(std::shared_ptr<SimpleVertexShader> shadowVS, Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer);
+
+	// Picks the lights that get shadows this frame and sets
+	// each light's ShadowTile (-1 for none)
+	void Update(Camera* camera, std::vector<Light>& lights);
+
+	// Renders the tiles that need it, then puts back a viewport
+	// of the given size
+	void Render(const std::vector<Light>& lights, const std::vector<std::shared_ptr<GameEntity>>& entities, MeshStream stream, unsigned int width, unsigned int height);
+
+	// View projection and atlas rectangle (in UVs) per tile, in
+	// the order the shader indexes them
+	void GetShaderData(DirectX::XMFLOAT4X4 viewProjections[MAX_LOCAL_SHADOW_TILES], DirectX::XMFLOAT4 rects[MAX_LOCAL_SHADOW_TILES]);
+
+	// Getters
+	LocalShadowSettings& GetSettings() { return settings; }
+	ShadowAtlas& GetAtlas() { return atlas; }
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetShaderResource() { return srv; }
+
+	// Stats from the last Render()
+	unsigned int GetCasterDraws() { return casterDraws; }
+	unsigned int GetRenderedTiles() { return renderedTiles; }
+
+private:
+	bool CastsShadows(const Light& light);
+
+	std::shared_ptr<SimpleVertexShader> vs;
+	std::shared_ptr<SimpleVertexShader> fullscreenVS;
+	std::shared_ptr<SimplePixelShader> clearPS;
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer;
+	LocalShadowSettings settings;
+
+	ShadowAtlas atlas;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> dsv;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> clearState;
+
+	std::vector<LocalShadowView> views; // Same order as the shader's tiles
+	std::map<unsigned int, unsigned long long> tileHashes; // What each tile was last rendered with
+
+	unsigned int casterDraws;
+	unsigned int renderedTiles;
+};
@@ -0,0 +1,26 @@
+// Defines the input to this pixel shader
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// Textures and such
+Texture2D Luminance : register(t0);
+SamplerState BasicSampler : register(s0);
+
+// Averages a 4x4 block of log luminance with 4 bilinear taps
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    float width, height;
+    Luminance.GetDimensions(width, height);
+    float2 texel = float2(1.0f / width, 1.0f / height);
+
+    float total =
+        Luminance.SampleLevel(BasicSampler, input.uv + float2(-1, -1) * texel, 0).r +
+        Luminance.SampleLevel(BasicSampler, input.uv + float2( 1, -1) * texel, 0).r +
+        Luminance.SampleLevel(BasicSampler, input.uv + float2(-1,  1) * texel, 0).r +
+        Luminance.SampleLevel(BasicSampler, input.uv + float2( 1,  1) * texel, 0).r;
+
+    return float4(total / 4, 0, 0, 1);
+}
@@ -0,0 +1,31 @@
+// Defines the input to this pixel shader
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// Textures and such
+Texture2D PixelColors : register(t0);
+SamplerState BasicSampler : register(s0);
+
+// First step of the auto exposure reduction: converts the
+// HDR scene to log luminance at a quarter of its size.  Each
+// bilinear tap averages 2x2 texels, so 4 taps cover 4x4
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    float width, height;
+    PixelColors.GetDimensions(width, height);
+    float2 texel = float2(1.0f / width, 1.0f / height);
+
+    float2 offsets[4] = { float2(-1, -1), float2(1, -1), float2(-1, 1), float2(1, 1) };
+    float logLum = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        float3 color = PixelColors.SampleLevel(BasicSampler, input.uv + offsets[i] * texel, 0).rgb;
+        float lum = dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+        logLum += log(max(lum, 0.0001f));
+    }
+
+    return float4(logLum / 4, 0, 0, 1);
+}
@@ -56,9 +56,15 @@ int WINAPI WinMain(
 	const wchar_t* windowTitle = L"Direct3D11 Game";
 	bool statsInTitleBar = true;
 	bool vsync = false;
+	double frameRateLimit = 240.0; // Without vsync; zero for no limit
+
+	// Benchmark runs (see Benchmark.h) build a generated scene and
+	// step it at a fixed rate, so results compare between runs
+	BenchmarkSettings benchmark = Benchmark::ParseCommandLine(lpCmdLine);
+	unsigned int benchmarkFrame = 0;
 
 	// The main application object
-	game = new Game();
+	game = new Game(benchmark);
 
 	// Create the window and verify
 	HRESULT windowResult = Window::Create(
@@ -72,11 +78,15 @@ int WINAPI WinMain(
 		return windowResult;
 
 	// Initialize the graphics API and verify
+	Graphics::Driver driver = Graphics::Driver::Hardware;
+	if (benchmark.NoSubmit) driver = Graphics::Driver::NoSubmit;
+	else if (benchmark.Warp) driver = Graphics::Driver::Software;
 	HRESULT graphicsResult = Graphics::Initialize(
 		Window::Width(), 
 		Window::Height(), 
 		Window::Handle(),
-		vsync);
+		vsync,
+		driver);
 	if (FAILED(graphicsResult))
 		return graphicsResult;
 
@@ -86,6 +96,12 @@ int WINAPI WinMain(
 	// Now the game itself can be initialzied
 	game->Initialize();
 
+	// Frames start when the swap chain can take one and, without
+	// vsync, no faster than the limit.  Benchmarks run unlimited
+	std::shared_ptr<FramePacer> pacer = std::make_shared<FramePacer>(std::make_shared<SteadyFrameClock>());
+	pacer->SetTargetFrameRate(vsync || benchmark.Enabled ? 0.0 : frameRateLimit);
+	game->SetFramePacer(pacer);
+
 	// Time tracking
 	LARGE_INTEGER perfFreq{};
 	double perfSeconds = 0;
@@ -116,6 +132,11 @@ int WINAPI WinMain(
 		}
 		else
 		{
+			// Wait here, not in Present(), so input and timing are
+			// as fresh as possible when the frame is built
+			Graphics::WaitForFrameLatency();
+			pacer->WaitForNextFrame();
+
 			// Calculate up-to-date timing info
 			QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
 			float deltaTime = max((float)((currentTime - previousTime) * perfSeconds), 0.0f);
@@ -125,6 +146,13 @@ int WINAPI WinMain(
 			// Calculate basic fps
 			Window::UpdateStats(totalTime);
 
+			// Simulated time ignores the wall clock when benchmarking
+			if (benchmark.Enabled)
+			{
+				deltaTime = benchmark.TimeStep;
+				totalTime = benchmarkFrame++ * benchmark.TimeStep;
+			}
+
 			// Input updating
 			Input::Update();
 
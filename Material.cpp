@@ -1,4 +1,5 @@
 #include "Material.h"
+#include "RenderStats.h"
 
 
 Material::Material(std::shared_ptr<SimplePixelShader> ps, std::shared_ptr<SimpleVertexShader> vs, DirectX::XMFLOAT4 colorTint, float roughness, DirectX::XMFLOAT2 uvOffset, DirectX::XMFLOAT2 uvScale) :
@@ -95,17 +96,18 @@ void Material::SetRoughness(float roughness)
     this->roughness = roughness;
 }
 
-void Material::PrepareMaterials()
+void Material::PrepareMaterials(ID3D11DeviceContext* context)
 {
-    ps->SetFloat2("uvOffset", uvOffset);
-    ps->SetFloat2("uvScale", uvScale);
-    ps->SetFloat("roughness", roughness);
+    RenderStats::CountMaterialBind();
+    ps->SetFloat2("uvOffset", uvOffset, context);
+    ps->SetFloat2("uvScale", uvScale, context);
+    ps->SetFloat("roughness", roughness, context);
     for (auto& t : textureSRVs)
     {
-        ps->SetShaderResourceView(t.first.c_str(), t.second);
+        ps->SetShaderResourceView(t.first.c_str(), t.second, context);
     }
     for (auto& s : samplers)
     {
-        ps->SetSamplerState(s.first.c_str(), s.second);
+        ps->SetSamplerState(s.first.c_str(), s.second, context);
     }
 }
@@ -33,7 +33,7 @@ public:
 	void SetUVOffset(DirectX::XMFLOAT2 offset);
 	void SetUVScale(DirectX::XMFLOAT2 scale);
 	void SetRoughness(float roughness);
-	void PrepareMaterials();
+	void PrepareMaterials(ID3D11DeviceContext* context = 0); // Null for the immediate context
 private:
 	std::shared_ptr<SimplePixelShader> ps;
 	std::shared_ptr<SimpleVertexShader> vs;
@@ -2,13 +2,14 @@
 
 using namespace DirectX;
 
-Mesh::Mesh(int vertNum, int indNum, Vertex* vertexList, unsigned int* indexList)
+Mesh::Mesh(int vertNum, int indNum, Vertex* vertexList, unsigned int* indexList, bool positionStream, std::shared_ptr<GeometryArena> arena) :
+	name("Mesh"), arena(arena)
 {
-	CreateBuffers(vertexList, vertNum, indexList, indNum);
+	CreateBuffers(vertexList, vertNum, indexList, indNum, positionStream);
 }
 //Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
-Mesh::Mesh(const char* name, const char* file) :
-	name(name)
+Mesh::Mesh(const char* name, const char* file, bool positionStream, std::shared_ptr<GeometryArena> arena) :
+	name(name), arena(arena)
 {
 	// Author: Chris Cascioli
 	// File input object
@@ -28,6 +29,23 @@ Mesh::Mesh(const char* name, const char* file) :
 	int indexCounter = 0;			// Count of indices
 	char chars[100];			// String for line reading
 
+	// Corners that use the same position/uv/normal from the file
+	// become one vertex, so neighboring faces share vertices
+	std::unordered_map<unsigned long long, UINT> weldLookup;
+	auto addVertex = [&](const Vertex& v, unsigned int p, unsigned int t, unsigned int n)
+	{
+		unsigned long long key = ((unsigned long long)p << 42) | ((unsigned long long)t << 21) | n;
+		auto found = weldLookup.find(key);
+		if (found == weldLookup.end())
+		{
+			found = weldLookup.insert({ key, (UINT)vertCounter }).first;
+			verts.push_back(v);
+			vertCounter++;
+		}
+		indices.push_back(found->second);
+		indexCounter++;
+	};
+
 	// Still have data left?
 	while (obj.good())
 	{
@@ -159,16 +177,11 @@ Mesh::Mesh(const char* name, const char* file) :
 			v2.Normal.z *= -1.0f;
 			v3.Normal.z *= -1.0f;
 
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-			vertCounter += 3;
-
-			// Add three more indices
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
+			// Add the verts (flipping the winding order), reusing
+			// any that an earlier face already added
+			addVertex(v1, i[0], i[1], i[2]);
+			addVertex(v3, i[6], i[7], i[8]);
+			addVertex(v2, i[3], i[4], i[5]);
 
 			// Was there a 4th face?
 			// - 12 numbers read means 4 faces WITH uv's
@@ -187,15 +200,9 @@ Mesh::Mesh(const char* name, const char* file) :
 				v4.Normal.z *= -1.0f;
 
 				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-				vertCounter += 3;
-
-				// Add three more indices
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
+				addVertex(v1, i[0], i[1], i[2]);
+				addVertex(v4, i[9], i[10], i[11]);
+				addVertex(v3, i[6], i[7], i[8]);
 			}
 		}
 	}
@@ -203,22 +210,60 @@ Mesh::Mesh(const char* name, const char* file) :
 	// Close the file and create the actual buffers
 	obj.close();
 	
-	CreateBuffers(&verts[0], vertCounter, &indices[0], indexCounter);
+	CreateBuffers(&verts[0], vertCounter, &indices[0], indexCounter, positionStream);
 
 }
 
 Mesh::~Mesh()
 {
+	// Give the space back so other meshes can stream into it
+	if (arena)
+		arena->Free(allocation);
+}
+
+const char* Mesh::GetName()
+{
+    return name;
+}
+
+bool Mesh::IsInArena()
+{
+    return arena != 0;
+}
+
+const GeometryAllocation& Mesh::GetArenaAllocation()
+{
+    return allocation;
 }
 
 Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer()
 {
-    return vertexBuffer;
+    return arena ? arena->GetVertexBuffer() : vertexBuffer;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetPositionBuffer()
+{
+    return arena ? arena->GetPositionBuffer() : positionBuffer;
+}
+
+bool Mesh::HasPositionStream()
+{
+    return arena || positionBuffer.Get() != 0;
 }
 
 Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer()
 {
-    return indexBuffer;
+    return arena ? arena->GetIndexBuffer() : indexBuffer;
+}
+
+DXGI_FORMAT Mesh::GetIndexFormat()
+{
+    return indexFormat;
+}
+
+unsigned int Mesh::GetIndexSize()
+{
+    return indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
 }
 
 int Mesh::GetIndexCount()
@@ -231,24 +276,200 @@ int Mesh::GetVertexCount()
     return vertices;
 }
 
-void Mesh::Draw()
+XMFLOAT3 Mesh::GetBoundsCenter()
+{
+    return boundsCenter;
+}
+
+float Mesh::GetBoundsRadius()
+{
+    return boundsRadius;
+}
+
+VertexCompression::RoundTripError Mesh::GetCompressionError()
+{
+    return compressionError;
+}
+
+int Mesh::GetLodCount()
+{
+    return (int)lods.size();
+}
+
+int Mesh::GetLodIndexCount(int lod)
+{
+    return lods[lod].IndexCount;
+}
+
+float Mesh::GetLodError(int lod)
+{
+    return lods[lod].Error;
+}
+
+const std::vector<Meshlets::Meshlet>& Mesh::GetMeshlets()
+{
+    return meshlets;
+}
+
+const std::vector<XMFLOAT3>& Mesh::GetCpuPositions()
+{
+    return cpuPositions;
+}
+
+const std::vector<unsigned int>& Mesh::GetCpuIndices()
+{
+    return cpuIndices;
+}
+
+// --------------------------------------------------------
+// Draws only some parts of LOD 0, usually the meshlets that
+// survived culling.  Ranges are relative to the start of
+// LOD 0's indices
+// --------------------------------------------------------
+void Mesh::DrawRanges(MeshStream stream, const std::vector<Meshlets::Range>& ranges, ID3D11DeviceContext* context)
+{
+	if (!context)
+		context = Graphics::Context.Get();
+
+	if (arena)
+	{
+		arena->Bind(stream, indexFormat, context);
+		unsigned int start = allocation.StartIndex(GetIndexSize());
+		for (auto& r : ranges)
+			Graphics::Api->DrawIndexed(context, r.IndexCount, start + r.StartIndex, allocation.BaseVertex);
+		return;
+	}
+
+	UINT offset = 0;
+	if (stream == MeshStream::Position && positionBuffer)
+	{
+		UINT stride = sizeof(XMFLOAT3);
+		Graphics::Api->SetVertexBuffer(context, positionBuffer.Get(), stride, offset);
+	}
+	else
+	{
+		UINT stride = sizeof(PackedVertex);
+		Graphics::Api->SetVertexBuffer(context, vertexBuffer.Get(), stride, offset);
+	}
+	Graphics::Api->SetIndexBuffer(context, indexBuffer.Get(), indexFormat, 0);
+	for (auto& r : ranges)
+		Graphics::Api->DrawIndexed(context, r.IndexCount, r.StartIndex, 0);
+}
+
+void Mesh::Draw(MeshStream stream, int lod, ID3D11DeviceContext* context)
 {
+	if (!context)
+		context = Graphics::Context.Get();
+
+	lod = lod < 0 ? 0 : (lod >= (int)lods.size() ? (int)lods.size() - 1 : lod);
+	const MeshLodLevel& level = lods[lod];
+
+	// Arena meshes share buffers, so usually only the offsets change
+	if (arena)
+	{
+		arena->Bind(stream, indexFormat, context);
+		Graphics::Api->DrawIndexed(context, level.IndexCount, allocation.StartIndex(GetIndexSize()) + level.StartIndex, allocation.BaseVertex);
+		return;
+	}
+
 	// Set buffers in the input assembler
-	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
-	Graphics::Context->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
-	Graphics::Context->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	if (stream == MeshStream::Position && positionBuffer)
+	{
+		UINT stride = sizeof(XMFLOAT3);
+		Graphics::Api->SetVertexBuffer(context, positionBuffer.Get(), stride, offset);
+	}
+	else
+	{
+		UINT stride = sizeof(PackedVertex);
+		Graphics::Api->SetVertexBuffer(context, vertexBuffer.Get(), stride, offset);
+	}
+	Graphics::Api->SetIndexBuffer(context, indexBuffer.Get(), indexFormat, 0);
 
 	// Draw this mesh
-	Graphics::Context->DrawIndexed(this->indices, 0, 0);
+	Graphics::Api->DrawIndexed(context, level.IndexCount, level.StartIndex, 0);
 }
 
-void Mesh::CreateBuffers(Vertex* vertList, int vertNum, unsigned int* indList, int indNum)
+void Mesh::CreateBuffers(Vertex* vertList, int vertNum, unsigned int* indList, int indNum, bool positionStream)
 {
 	CalculateTangents(&vertList[0], vertNum, &indList[0], indNum);
 	this->indices = indNum;
 	this->vertices = vertNum;
 
+	// Bounding sphere from the center of the vertices' box
+	XMFLOAT3 minPos = vertList[0].Position;
+	XMFLOAT3 maxPos = vertList[0].Position;
+	for (int i = 1; i < vertNum; i++)
+	{
+		XMStoreFloat3(&minPos, XMVectorMin(XMLoadFloat3(&minPos), XMLoadFloat3(&vertList[i].Position)));
+		XMStoreFloat3(&maxPos, XMVectorMax(XMLoadFloat3(&maxPos), XMLoadFloat3(&vertList[i].Position)));
+	}
+	XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&minPos), XMLoadFloat3(&maxPos)), 0.5f);
+	XMStoreFloat3(&boundsCenter, center);
+	boundsRadius = 0.0f;
+	for (int i = 0; i < vertNum; i++)
+	{
+		float dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&vertList[i].Position), center)));
+		boundsRadius = max(boundsRadius, dist);
+	}
+
+	// Lower detail index lists that reuse these vertices.  Every
+	// LOD's indices go in the same index buffer, one after another
+	std::vector<unsigned int> allIndices(indList, indList + indNum);
+
+	// Big meshes get split into meshlets so parts of them can be
+	// culled.  This reorders LOD 0's triangles, nothing else changes
+	meshlets.clear();
+	if (indNum / 3 >= MESH_MESHLET_MIN_TRIANGLES)
+		meshlets = Meshlets::Build(vertList, indList, indNum, allIndices);
+
+	lods.clear();
+	lods.push_back({ indNum, 0, 0.0f });
+	if (indNum / 3 >= MESH_LOD_MIN_TRIANGLES)
+	{
+		for (int l = 1; l < MAX_MESH_LODS; l++)
+		{
+			int target = (indNum >> l) / 3 * 3;
+			MeshLod::SimplifyResult lod = MeshLod::Simplify(vertList, vertNum, allIndices.data(), indNum, target, boundsRadius * 0.05f);
+
+			// Stop once simplifying isn't buying much (seams, flat spots)
+			if (lod.Indices.size() > lods.back().IndexCount * 0.8f)
+				break;
+
+			lods.push_back({ (int)lod.Indices.size(), (int)allIndices.size(), lod.Error });
+			allIndices.insert(allIndices.end(), lod.Indices.begin(), lod.Indices.end());
+		}
+	}
+
+	// Compress the vertices for the GPU and remember how much
+	// precision that cost
+	std::vector<PackedVertex> packed(vertNum);
+	for (int i = 0; i < vertNum; i++)
+		packed[i] = VertexCompression::Pack(vertList[i]);
+	compressionError = VertexCompression::MeasureRoundTrip(vertList, vertNum);
+
+	// Positions on their own, for depth only passes.  The CPU
+	// keeps them (and LOD 0) in case this mesh is an occluder
+	cpuPositions.resize(vertNum);
+	for (int i = 0; i < vertNum; i++)
+		cpuPositions[i] = vertList[i].Position;
+	cpuIndices.assign(allIndices.begin(), allIndices.begin() + indNum);
+
+	// Use 16 bit indices whenever every vertex can be reached
+	// with them, which halves the size of the index data
+	std::vector<unsigned short> shortIndices;
+	indexFormat = vertNum <= 65536 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	if (indexFormat == DXGI_FORMAT_R16_UINT)
+		shortIndices.assign(allIndices.begin(), allIndices.end());
+	const void* indexData = shortIndices.empty() ? (const void*)&allIndices[0] : (const void*)&shortIndices[0];
+
+	// Shared buffers: just copy into the arena
+	if (arena)
+	{
+		allocation = arena->Allocate(&packed[0], &cpuPositions[0], vertNum, indexData, GetIndexSize(), (unsigned int)allIndices.size());
+		return;
+	}
+
 	// Create a VERTEX BUFFER
 	// - This holds the vertex data of triangles for a single object
 	// - This buffer is created on the GPU, which is where the data needs to
@@ -256,7 +477,7 @@ void Mesh::CreateBuffers(Vertex* vertList, int vertNum, unsigned int* indList, i
 	{
 		D3D11_BUFFER_DESC vtb = {};
 		vtb.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
-		vtb.ByteWidth = sizeof(Vertex) * vertices;       //* number of vertices in the buffer
+		vtb.ByteWidth = sizeof(PackedVertex) * vertices;       //* number of vertices in the buffer
 		vtb.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells Direct3D this is a vertex buffer
 		vtb.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
 		vtb.MiscFlags = 0;
@@ -265,11 +486,26 @@ void Mesh::CreateBuffers(Vertex* vertList, int vertNum, unsigned int* indList, i
 		// - This is how we initially fill the buffer with data
 		// - Essentially, we're specifying a pointer to the data to copy
 		D3D11_SUBRESOURCE_DATA initialVertexData = {};
-		initialVertexData.pSysMem = vertList; // pSysMem = Pointer to System Memory
+		initialVertexData.pSysMem = &packed[0]; // pSysMem = Pointer to System Memory
 
 		// Actually create the buffer on the GPU with the initial data
 		// - Once we do this, we'll NEVER CHANGE DATA IN THE BUFFER AGAIN
-		Graphics::Device->CreateBuffer(&vtb, &initialVertexData, this->vertexBuffer.GetAddressOf());
+		Graphics::Api->CreateBuffer(vtb, &initialVertexData, this->vertexBuffer.GetAddressOf());
+	}
+
+	// Create a second VERTEX BUFFER with only positions
+	// - Depth only passes (shadows, the pre-pass) read 12 bytes
+	//    per vertex from this instead of the full vertex
+	if (positionStream)
+	{
+		D3D11_BUFFER_DESC pbd = {};
+		pbd.Usage = D3D11_USAGE_IMMUTABLE;
+		pbd.ByteWidth = sizeof(XMFLOAT3) * vertices;
+		pbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA initialPositionData = {};
+		initialPositionData.pSysMem = &cpuPositions[0];
+		Graphics::Api->CreateBuffer(pbd, &initialPositionData, this->positionBuffer.GetAddressOf());
 	}
 
 	// Create an INDEX BUFFER
@@ -280,7 +516,7 @@ void Mesh::CreateBuffers(Vertex* vertList, int vertNum, unsigned int* indList, i
 	{
 		D3D11_BUFFER_DESC ibd = {};
 		ibd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
-		ibd.ByteWidth = sizeof(unsigned int) * indices;	// * number of indices in the buffer
+		ibd.ByteWidth = GetIndexSize() * (unsigned int)allIndices.size();	// * number of indices in the buffer (all LODs)
 		ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;	// Tells Direct3D this is an index buffer
 		ibd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
 		ibd.MiscFlags = 0;
@@ -288,11 +524,11 @@ void Mesh::CreateBuffers(Vertex* vertList, int vertNum, unsigned int* indList, i
 
 		// Specify the initial data for this buffer, similar to above
 		D3D11_SUBRESOURCE_DATA initialIndexData = {};
-		initialIndexData.pSysMem = indList; // pSysMem = Pointer to System Memory
+		initialIndexData.pSysMem = indexData; // pSysMem = Pointer to System Memory
 
 		// Actually create the buffer with the initial data
 		// - Once we do this, we'll NEVER CHANGE THE BUFFER AGAIN
-		Graphics::Device->CreateBuffer(&ibd, &initialIndexData, indexBuffer.GetAddressOf());
+		Graphics::Api->CreateBuffer(ibd, &initialIndexData, indexBuffer.GetAddressOf());
 	}
 }
 // --------------------------------------------------------
@@ -3,45 +3,117 @@
 #include <wrl/client.h>
 #include "Graphics.h"
 #include "Vertex.h"
+#include "VertexCompression.h"
+#include "GeometryArena.h"
+#include "MeshLod.h"
+#include "Meshlets.h"
+
+#define MAX_MESH_LODS 4
+#define MESH_LOD_MIN_TRIANGLES 256 // Smaller meshes only get LOD 0
+#define MESH_MESHLET_MIN_TRIANGLES 2048 // Smaller meshes aren't worth culling in pieces
+
+// One level of detail: a range of the mesh's index buffer
+struct MeshLodLevel
+{
+	int IndexCount;
+	int StartIndex;
+	float Error; // From the simplifier, in local space units
+};
 #include "fstream"
 #include <stdexcept>
 #include <memory> 
 #include <DirectXMath.h>
 #include <vector>
+#include <unordered_map>
+
 class Mesh
 {
 	private:
 		Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+		DXGI_FORMAT indexFormat; // R16_UINT when there are few enough vertices
+		Microsoft::WRL::ComPtr<ID3D11Buffer> positionBuffer; // Optional, null if not created
+
+		// When set, the buffers above are unused and the mesh lives in the arena instead
+		std::shared_ptr<GeometryArena> arena;
+		GeometryAllocation allocation;
 		const char* name;
 		int indices;
 		int vertices;
+		DirectX::XMFLOAT3 boundsCenter; // Local space bounding sphere
+		float boundsRadius;
+		VertexCompression::RoundTripError compressionError;
+		std::vector<MeshLodLevel> lods; // LOD 0 is the full mesh
+		std::vector<Meshlets::Meshlet> meshlets; // Of LOD 0, empty for small meshes
+		std::vector<DirectX::XMFLOAT3> cpuPositions; // Copies kept for software occlusion
+		std::vector<unsigned int> cpuIndices; // LOD 0 only
 
 	public:
 		//OOP
-		Mesh(int vertNum,int indNum, Vertex* vertexList, unsigned int* indexList);
-		Mesh(const char* name, const char* file);
+		Mesh(int vertNum,int indNum, Vertex* vertexList, unsigned int* indexList, bool positionStream = true, std::shared_ptr<GeometryArena> arena = 0);
+		Mesh(const char* name, const char* file, bool positionStream = true, std::shared_ptr<GeometryArena> arena = 0);
 		~Mesh();
 		Mesh(const Mesh&) = delete; // Remove copy constructor
 		Mesh& operator=(const Mesh&) = delete; // Remove copy-assignment operator
 
 
+		//returns the name given when loaded
+		const char* GetName();
+
+		//true if the mesh was packed into a shared GeometryArena
+		bool IsInArena();
+		const GeometryAllocation& GetArenaAllocation();
+
 		//returns vertex buffer comptr
 		Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
 
+		//returns the position only vertex buffer comptr (may be null)
+		Microsoft::WRL::ComPtr<ID3D11Buffer> GetPositionBuffer();
+		bool HasPositionStream();
+
 		//returns indes buffer comptr
 		Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
 
-		//returns # of indices this mesh contains
+		//returns the format of the index buffer and bytes per index
+		DXGI_FORMAT GetIndexFormat();
+		unsigned int GetIndexSize();
+
+		//levels of detail, generated on load
+		int GetLodCount();
+		int GetLodIndexCount(int lod);
+		float GetLodError(int lod);
+
+		//clusters of LOD 0's triangles, for culling parts of the mesh
+		const std::vector<Meshlets::Meshlet>& GetMeshlets();
+
+		//CPU copies of the positions and LOD 0's indices, for
+		//rasterizing the mesh as an occluder
+		const std::vector<DirectX::XMFLOAT3>& GetCpuPositions();
+		const std::vector<unsigned int>& GetCpuIndices();
+
+		//returns # of indices this mesh contains (LOD 0)
 		int GetIndexCount();
 
 		//returns # of vertices this mesh contains
 		int GetVertexCount();
 
-		//sets buffers and draws using the correct number of indices
-		void Draw();
+		//local space bounding sphere around every vertex
+		DirectX::XMFLOAT3 GetBoundsCenter();
+		float GetBoundsRadius();
+
+		//worst case error from compressing the vertices
+		VertexCompression::RoundTripError GetCompressionError();
+
+		//sets buffers and draws using the correct number of indices.
+		//falls back to the full stream if there's no position stream,
+		//which still works for shaders that only read POSITION.
+		//context defaults to the immediate context
+		void Draw(MeshStream stream = MeshStream::Full, int lod = 0, ID3D11DeviceContext* context = 0);
+
+		//draws ranges of LOD 0's indices, like the meshlets that weren't culled
+		void DrawRanges(MeshStream stream, const std::vector<Meshlets::Range>& ranges, ID3D11DeviceContext* context = 0);
 
-		void CreateBuffers(Vertex* vertList,int vertNum,unsigned int* indList,int indNum);
+		void CreateBuffers(Vertex* vertList,int vertNum,unsigned int* indList,int indNum, bool positionStream = true);
 		void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
 
 };
@@ -0,0 +1,357 @@
+#include "MeshLod.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+	// Symmetric 4x4 matrix for the sum of squared plane distances
+	struct Quadric
+	{
+		float a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+		void AddPlane(float a, float b, float c, float d)
+		{
+			a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+			b2 += b * b; bc += b * c; bd += b * d;
+			c2 += c * c; cd += c * d;
+			d2 += d * d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+		}
+
+		float Evaluate(XMFLOAT3 p) const
+		{
+			float x = p.x, y = p.y, z = p.z;
+			float e =
+				a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+				b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+				c2 * z * z + 2 * cd * z +
+				d2;
+			return fmaxf(e, 0.0f);
+		}
+	};
+
+	XMFLOAT3 Sub(XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+	XMFLOAT3 Cross(XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+	float Dot(XMFLOAT3 a, XMFLOAT3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	XMFLOAT3 TriangleNormal(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c)
+	{
+		return Cross(Sub(b, a), Sub(c, a));
+	}
+
+	// Distance from a point to a triangle (closest point method from
+	// Ericson, Real-Time Collision Detection 5.1.5)
+	float PointTriangleDistance(XMFLOAT3 p, XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c)
+	{
+		XMFLOAT3 ab = Sub(b, a), ac = Sub(c, a), ap = Sub(p, a);
+		float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+		XMFLOAT3 closest;
+		if (d1 <= 0 && d2 <= 0)
+			closest = a;
+		else
+		{
+			XMFLOAT3 bp = Sub(p, b);
+			float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+			XMFLOAT3 cp = Sub(p, c);
+			float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+			float vc = d1 * d4 - d3 * d2;
+			float vb = d5 * d2 - d1 * d6;
+			float va = d3 * d6 - d5 * d4;
+			if (d3 >= 0 && d4 <= d3)
+				closest = b;
+			else if (d6 >= 0 && d5 <= d6)
+				closest = c;
+			else if (vc <= 0 && d1 >= 0 && d3 <= 0)
+			{
+				float v = d1 / (d1 - d3);
+				closest = XMFLOAT3(a.x + ab.x * v, a.y + ab.y * v, a.z + ab.z * v);
+			}
+			else if (vb <= 0 && d2 >= 0 && d6 <= 0)
+			{
+				float w = d2 / (d2 - d6);
+				closest = XMFLOAT3(a.x + ac.x * w, a.y + ac.y * w, a.z + ac.z * w);
+			}
+			else if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+			{
+				float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+				closest = XMFLOAT3(b.x + (c.x - b.x) * w, b.y + (c.y - b.y) * w, b.z + (c.z - b.z) * w);
+			}
+			else
+			{
+				float denom = 1.0f / (va + vb + vc);
+				float v = vb * denom, w = vc * denom;
+				closest = XMFLOAT3(a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w);
+			}
+		}
+		XMFLOAT3 d = Sub(p, closest);
+		return sqrtf(Dot(d, d));
+	}
+
+	struct Collapse
+	{
+		unsigned int From;
+		unsigned int To;
+		float Cost;
+	};
+}
+
+MeshLod::SimplifyResult MeshLod::Simplify(
+	const Vertex* verts, int vertCount,
+	const unsigned int* indices, int indexCount,
+	int targetIndexCount, float maxError)
+{
+	SimplifyResult result;
+	result.Indices.assign(indices, indices + indexCount);
+	result.Error = 0.0f;
+
+	// Group vertices that share a position.  Each group gets the
+	// index of its first vertex
+	std::vector<unsigned int> positionGroup(vertCount);
+	std::vector<int> groupSize(vertCount, 0);
+	{
+		std::unordered_map<unsigned long long, unsigned int> lookup;
+		for (int i = 0; i < vertCount; i++)
+		{
+			unsigned int bits[3];
+			memcpy(bits, &verts[i].Position, sizeof(bits));
+			unsigned long long key = bits[0] * 73856093ull ^ bits[1] * 19349663ull ^ bits[2] * 83492791ull;
+
+			// Walk the (rare) hash collisions until an exact match
+			unsigned int group = i;
+			for (auto found = lookup.find(key); found != lookup.end(); found = lookup.find(++key))
+			{
+				if (memcmp(&verts[found->second].Position, &verts[i].Position, sizeof(XMFLOAT3)) == 0)
+				{
+					group = found->second;
+					break;
+				}
+			}
+			if (group == (unsigned int)i)
+				lookup[key] = i;
+
+			positionGroup[i] = group;
+			groupSize[group]++;
+		}
+	}
+
+	// Seams and open borders never move.  A border edge is one that
+	// only a single triangle uses, comparing by position
+	std::vector<bool> locked(vertCount, false);
+	{
+		std::unordered_map<unsigned long long, int> edgeCount;
+		for (int t = 0; t + 2 < indexCount; t += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				unsigned int a = positionGroup[indices[t + e]];
+				unsigned int b = positionGroup[indices[t + (e + 1) % 3]];
+				if (a > b) std::swap(a, b);
+				edgeCount[((unsigned long long)a << 32) | b]++;
+			}
+		}
+		for (auto& edge : edgeCount)
+		{
+			if (edge.second != 1)
+				continue;
+			unsigned int a = (unsigned int)(edge.first >> 32);
+			unsigned int b = (unsigned int)(edge.first & 0xFFFFFFFF);
+			locked[a] = locked[b] = true;
+		}
+		for (int i = 0; i < vertCount; i++)
+		{
+			if (groupSize[positionGroup[i]] > 1 || locked[positionGroup[i]])
+				locked[i] = true;
+		}
+	}
+
+	// Plane quadrics, summed per position group
+	std::vector<Quadric> quadrics(vertCount, Quadric{});
+	for (int t = 0; t + 2 < indexCount; t += 3)
+	{
+		XMFLOAT3 a = verts[indices[t]].Position;
+		XMFLOAT3 n = TriangleNormal(a, verts[indices[t + 1]].Position, verts[indices[t + 2]].Position);
+		float len = sqrtf(Dot(n, n));
+		if (len == 0.0f)
+			continue;
+		n = XMFLOAT3(n.x / len, n.y / len, n.z / len);
+		float d = -Dot(n, a);
+		for (int c = 0; c < 3; c++)
+			quadrics[positionGroup[indices[t + c]]].AddPlane(n.x, n.y, n.z, d);
+	}
+
+	std::vector<unsigned int>& current = result.Indices;
+	float maxCost = maxError * maxError;
+
+	// Each pass collapses a batch of edges that don't touch each
+	// other, then rebuilds the index list
+	while ((int)current.size() > targetIndexCount)
+	{
+		int triCount = (int)current.size() / 3;
+
+		// Triangles around each vertex
+		std::vector<std::vector<int>> vertexTris(vertCount);
+		for (int t = 0; t < triCount; t++)
+		{
+			for (int c = 0; c < 3; c++)
+				vertexTris[current[t * 3 + c]].push_back(t);
+		}
+
+		// Every possible half edge collapse
+		std::vector<Collapse> candidates;
+		for (int t = 0; t < triCount; t++)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				unsigned int from = current[t * 3 + e];
+				unsigned int to = current[t * 3 + (e + 1) % 3];
+				for (int dir = 0; dir < 2; dir++)
+				{
+					if (!locked[from])
+					{
+						Quadric q = quadrics[positionGroup[from]];
+						q.Add(quadrics[positionGroup[to]]);
+						candidates.push_back({ from, to, q.Evaluate(verts[to].Position) });
+					}
+					std::swap(from, to);
+				}
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(),
+			[](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost; });
+
+		std::vector<unsigned int> remap(vertCount);
+		for (int i = 0; i < vertCount; i++)
+			remap[i] = i;
+		std::vector<bool> touched(vertCount, false);
+
+		int trianglesLeft = triCount;
+		int collapses = 0;
+		for (auto& c : candidates)
+		{
+			if (c.Cost > maxCost || trianglesLeft * 3 <= targetIndexCount)
+				break;
+			if (touched[c.From] || touched[c.To])
+				continue;
+
+			// Reject collapses that would flip a triangle over
+			bool flips = false;
+			int removed = 0;
+			for (int t : vertexTris[c.From])
+			{
+				unsigned int* tri = &current[t * 3];
+				if (tri[0] == c.To || tri[1] == c.To || tri[2] == c.To)
+				{
+					removed++;
+					continue;
+				}
+
+				XMFLOAT3 p[3];
+				XMFLOAT3 moved[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = verts[tri[k]].Position;
+					moved[k] = tri[k] == c.From ? verts[c.To].Position : p[k];
+				}
+				XMFLOAT3 before = TriangleNormal(p[0], p[1], p[2]);
+				XMFLOAT3 after = TriangleNormal(moved[0], moved[1], moved[2]);
+				if (Dot(before, after) <= 0.0f)
+				{
+					flips = true;
+					break;
+				}
+			}
+			if (flips)
+				continue;
+
+			// Nothing else around either vertex may change this pass,
+			// since the flip test above assumed they stay put
+			for (int t : vertexTris[c.From])
+				for (int k = 0; k < 3; k++)
+					touched[current[t * 3 + k]] = true;
+			for (int t : vertexTris[c.To])
+				for (int k = 0; k < 3; k++)
+					touched[current[t * 3 + k]] = true;
+
+			remap[c.From] = c.To;
+			quadrics[positionGroup[c.To]].Add(quadrics[positionGroup[c.From]]);
+			result.Error = fmaxf(result.Error, sqrtf(c.Cost));
+			trianglesLeft -= removed;
+			collapses++;
+		}
+
+		if (collapses == 0)
+			break;
+
+		// Apply the collapses and drop triangles that became degenerate
+		std::vector<unsigned int> next;
+		next.reserve(current.size());
+		for (int t = 0; t < triCount; t++)
+		{
+			unsigned int a = remap[current[t * 3]];
+			unsigned int b = remap[current[t * 3 + 1]];
+			unsigned int c = remap[current[t * 3 + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+			next.push_back(a);
+			next.push_back(b);
+			next.push_back(c);
+		}
+		current.swap(next);
+	}
+
+	return result;
+}
+
+float MeshLod::MeasureDeviation(
+	const Vertex* verts,
+	const unsigned int* original, int originalCount,
+	const unsigned int* simplified, int simplifiedCount)
+{
+	float deviation = 0.0f;
+	for (int i = 0; i < originalCount; i++)
+	{
+		XMFLOAT3 p = verts[original[i]].Position;
+		float closest = INFINITY;
+		for (int t = 0; t + 2 < simplifiedCount && closest > 0.0f; t += 3)
+		{
+			closest = fminf(closest, PointTriangleDistance(p,
+				verts[simplified[t]].Position,
+				verts[simplified[t + 1]].Position,
+				verts[simplified[t + 2]].Position));
+		}
+		if (simplifiedCount > 0)
+			deviation = fmaxf(deviation, closest);
+	}
+	return deviation;
+}
+
+float MeshLod::ProjectedSize(float radius, float distance, float fovY)
+{
+	if (distance <= radius)
+		return 1.0f;
+	return fminf(radius / (distance * tanf(fovY * 0.5f)), 1.0f);
+}
+
+int MeshLod::SelectLod(int currentLod, float screenSize, const float* thresholds, int lodCount, float hysteresis)
+{
+	int lod = std::min(std::max(currentLod, 0), lodCount - 1);
+
+	// Coarser only once clearly below the threshold, finer only
+	// once clearly above it
+	while (lod + 1 < lodCount && screenSize < thresholds[lod] * (1.0f - hysteresis))
+		lod++;
+	while (lod > 0 && screenSize > thresholds[lod - 1] * (1.0f + hysteresis))
+		lod--;
+	return lod;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Level of detail helpers.  Simplify() builds lower detail
+// index lists for a mesh by collapsing edges in order of
+// quadric error (Garland & Heckbert).  Collapses only ever
+// move a vertex onto one of its neighbors, so every LOD can
+// share the original vertex buffer.
+//
+// Vertices on a UV/normal seam (several vertices at one
+// position) or on an open border are never moved, which
+// keeps seams and silhouettes of open meshes intact
+// --------------------------------------------------------
+namespace MeshLod
+{
+	struct SimplifyResult
+	{
+		std::vector<unsigned int> Indices;
+		float Error;	// Largest quadric error of any collapse, in distance units
+	};
+
+	// Collapses edges until the index count reaches the target or
+	// the next collapse would cost more than maxError
+	SimplifyResult Simplify(
+		const Vertex* verts, int vertCount,
+		const unsigned int* indices, int indexCount,
+		int targetIndexCount, float maxError);
+
+	// Largest distance from any vertex of the original mesh to the
+	// surface of the simplified mesh.  Brute force, meant for checks
+	float MeasureDeviation(
+		const Vertex* verts,
+		const unsigned int* original, int originalCount,
+		const unsigned int* simplified, int simplifiedCount);
+
+	// Height of a bounding sphere on screen, as a fraction of the
+	// screen's height (1 = fills it, capped at 1)
+	float ProjectedSize(float radius, float distance, float fovY);
+
+	// Picks a LOD from the projected size.  thresholds[i] is the size
+	// below which LOD i+1 is used, so there are lodCount - 1 of them,
+	// largest first.  Hysteresis (a fraction like 0.1) widens each
+	// threshold around the current LOD so it doesn't flicker back and
+	// forth when the size sits right on a boundary
+	int SelectLod(int currentLod, float screenSize, const float* thresholds, int lodCount, float hysteresis);
+}
@@ -0,0 +1,243 @@
+#include "Meshlets.h"
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	XMFLOAT3 Sub(XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+	float Dot(XMFLOAT3 a, XMFLOAT3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	float Length(XMFLOAT3 v) { return sqrtf(Dot(v, v)); }
+
+	// Bounds and normal cone for one finished meshlet
+	void ComputeBounds(Meshlets::Meshlet& m, const Vertex* verts, const unsigned int* indices)
+	{
+		unsigned int indexCount = m.TriangleCount * 3;
+
+		// Sphere around the center of the box
+		XMFLOAT3 lo = verts[indices[0]].Position;
+		XMFLOAT3 hi = lo;
+		for (unsigned int i = 1; i < indexCount; i++)
+		{
+			XMFLOAT3 p = verts[indices[i]].Position;
+			lo = XMFLOAT3(fminf(lo.x, p.x), fminf(lo.y, p.y), fminf(lo.z, p.z));
+			hi = XMFLOAT3(fmaxf(hi.x, p.x), fmaxf(hi.y, p.y), fmaxf(hi.z, p.z));
+		}
+		m.Center = XMFLOAT3((lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f);
+		m.Radius = 0.0f;
+		for (unsigned int i = 0; i < indexCount; i++)
+			m.Radius = fmaxf(m.Radius, Length(Sub(verts[indices[i]].Position, m.Center)));
+
+		// Cone: average the face normals, then find the widest one
+		std::vector<XMFLOAT3> normals;
+		XMFLOAT3 axis(0, 0, 0);
+		for (unsigned int t = 0; t < m.TriangleCount; t++)
+		{
+			XMFLOAT3 a = verts[indices[t * 3]].Position;
+			XMFLOAT3 e1 = Sub(verts[indices[t * 3 + 1]].Position, a);
+			XMFLOAT3 e2 = Sub(verts[indices[t * 3 + 2]].Position, a);
+			XMFLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+			float len = Length(n);
+			if (len == 0.0f)
+				continue;
+			n = XMFLOAT3(n.x / len, n.y / len, n.z / len);
+			normals.push_back(n);
+			axis = XMFLOAT3(axis.x + n.x, axis.y + n.y, axis.z + n.z);
+		}
+
+		m.ConeAxis = XMFLOAT3(0, 0, 0);
+		m.ConeCutoff = 1.0f;
+		float axisLength = Length(axis);
+		if (axisLength == 0.0f)
+			return;
+		axis = XMFLOAT3(axis.x / axisLength, axis.y / axisLength, axis.z / axisLength);
+
+		float minDot = 1.0f;
+		for (auto& n : normals)
+			minDot = fminf(minDot, Dot(n, axis));
+
+		// Normals spread over more than a hemisphere, never back facing
+		if (minDot <= 0.0f)
+			return;
+
+		m.ConeAxis = axis;
+		m.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+}
+
+// --------------------------------------------------------
+// Greedy clustering.  Each meshlet starts at the first
+// unused triangle, then keeps adding whichever neighboring
+// triangle brings in the fewest new vertices until it's full
+// or runs out of neighbors
+// --------------------------------------------------------
+std::vector<Meshlets::Meshlet> Meshlets::Build(
+	const Vertex* verts,
+	const unsigned int* indices, int indexCount,
+	std::vector<unsigned int>& reorderedIndices,
+	unsigned int maxVertices,
+	unsigned int maxTriangles)
+{
+	std::vector<Meshlet> meshlets;
+	reorderedIndices.clear();
+	reorderedIndices.reserve(indexCount);
+
+	int triCount = indexCount / 3;
+	unsigned int vertCount = 0;
+	for (int i = 0; i < indexCount; i++)
+		vertCount = indices[i] + 1 > vertCount ? indices[i] + 1 : vertCount;
+
+	// Triangles that use each vertex
+	std::vector<std::vector<int>> vertexTris(vertCount);
+	for (int t = 0; t < triCount; t++)
+		for (int c = 0; c < 3; c++)
+			vertexTris[indices[t * 3 + c]].push_back(t);
+
+	std::vector<bool> used(triCount, false);
+	std::vector<int> vertexMeshlet(vertCount, -1); // Which meshlet last took each vertex
+	int nextSeed = 0;
+
+	while (true)
+	{
+		while (nextSeed < triCount && used[nextSeed])
+			nextSeed++;
+		if (nextSeed == triCount)
+			break;
+
+		int id = (int)meshlets.size();
+		Meshlet m = {};
+		m.StartIndex = (unsigned int)reorderedIndices.size();
+		std::vector<int> candidates;
+
+		auto newVertices = [&](int t)
+		{
+			unsigned int count = 0;
+			for (int c = 0; c < 3; c++)
+				count += vertexMeshlet[indices[t * 3 + c]] != id;
+			return count;
+		};
+
+		auto addTriangle = [&](int t)
+		{
+			used[t] = true;
+			m.TriangleCount++;
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int v = indices[t * 3 + c];
+				reorderedIndices.push_back(v);
+				if (vertexMeshlet[v] == id)
+					continue;
+				vertexMeshlet[v] = id;
+				m.VertexCount++;
+				candidates.insert(candidates.end(), vertexTris[v].begin(), vertexTris[v].end());
+			}
+		};
+
+		addTriangle(nextSeed);
+		while (m.TriangleCount < maxTriangles)
+		{
+			int best = -1;
+			unsigned int bestNew = 4;
+			for (int t : candidates)
+			{
+				if (used[t])
+					continue;
+				unsigned int added = newVertices(t);
+				if (m.VertexCount + added <= maxVertices && added < bestNew)
+				{
+					best = t;
+					bestNew = added;
+					if (added == 0)
+						break;
+				}
+			}
+			if (best == -1)
+				break;
+			addTriangle(best);
+		}
+
+		ComputeBounds(m, verts, &reorderedIndices[m.StartIndex]);
+		meshlets.push_back(m);
+	}
+
+	return meshlets;
+}
+
+void Meshlets::ExtractFrustumPlanes(const XMFLOAT4X4& m, XMFLOAT4 planes[6])
+{
+	// Row vectors: clip = p * M, so each clip component is a column
+	XMFLOAT4 c0(m._11, m._21, m._31, m._41);
+	XMFLOAT4 c1(m._12, m._22, m._32, m._42);
+	XMFLOAT4 c2(m._13, m._23, m._33, m._43);
+	XMFLOAT4 c3(m._14, m._24, m._34, m._44);
+
+	planes[0] = XMFLOAT4(c3.x + c0.x, c3.y + c0.y, c3.z + c0.z, c3.w + c0.w); // Left
+	planes[1] = XMFLOAT4(c3.x - c0.x, c3.y - c0.y, c3.z - c0.z, c3.w - c0.w); // Right
+	planes[2] = XMFLOAT4(c3.x + c1.x, c3.y + c1.y, c3.z + c1.z, c3.w + c1.w); // Bottom
+	planes[3] = XMFLOAT4(c3.x - c1.x, c3.y - c1.y, c3.z - c1.z, c3.w - c1.w); // Top
+	planes[4] = c2;                                                          // Near (z >= 0)
+	planes[5] = XMFLOAT4(c3.x - c2.x, c3.y - c2.y, c3.z - c2.z, c3.w - c2.w); // Far
+
+	for (int i = 0; i < 6; i++)
+	{
+		float len = sqrtf(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+		if (len > 0.0f)
+			planes[i] = XMFLOAT4(planes[i].x / len, planes[i].y / len, planes[i].z / len, planes[i].w / len);
+	}
+}
+
+// --------------------------------------------------------
+// Cone test from meshoptimizer's meshopt_computeClusterBounds,
+// using the bounding sphere instead of a cone apex
+// --------------------------------------------------------
+bool Meshlets::IsBackFacing(const Meshlet& m, XMFLOAT3 cameraPosition)
+{
+	if (m.ConeCutoff >= 1.0f)
+		return false;
+
+	XMFLOAT3 toMeshlet = Sub(m.Center, cameraPosition);
+	return Dot(toMeshlet, m.ConeAxis) >= m.ConeCutoff * Length(toMeshlet) + m.Radius;
+}
+
+bool Meshlets::IsOutsideFrustum(const Meshlet& m, const XMFLOAT4 planes[6])
+{
+	for (int i = 0; i < 6; i++)
+	{
+		float d = planes[i].x * m.Center.x + planes[i].y * m.Center.y + planes[i].z * m.Center.z + planes[i].w;
+		if (d < -m.Radius)
+			return true;
+	}
+	return false;
+}
+
+Meshlets::CullStats Meshlets::Cull(
+	const std::vector<Meshlet>& meshlets,
+	XMFLOAT3 cameraPosition,
+	const XMFLOAT4 planes[6],
+	std::vector<Range>& ranges)
+{
+	CullStats stats = {};
+	ranges.clear();
+	for (auto& m : meshlets)
+	{
+		if (IsOutsideFrustum(m, planes))
+		{
+			stats.FrustumCulled++;
+			continue;
+		}
+		if (IsBackFacing(m, cameraPosition))
+		{
+			stats.BackFaceCulled++;
+			continue;
+		}
+
+		stats.TrianglesKept += m.TriangleCount;
+
+		// Extend the last range if this meshlet directly follows it
+		if (!ranges.empty() && ranges.back().StartIndex + ranges.back().IndexCount == m.StartIndex)
+			ranges.back().IndexCount += m.TriangleCount * 3;
+		else
+			ranges.push_back({ m.StartIndex, m.TriangleCount * 3 });
+	}
+	return stats;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "Vertex.h"
+
+// Meshlet size limits (the usual mesh shader friendly sizes)
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// --------------------------------------------------------
+// Splits a mesh into small clusters of triangles, each with
+// a bounding sphere and a cone around its normals, so whole
+// clusters can be culled on the CPU when they're off screen
+// or facing away from the camera.  There are no mesh shaders
+// here, so what survives is drawn as ranges of the regular
+// index buffer (the builder reorders triangles so each
+// meshlet's triangles are contiguous)
+//
+// Culling works in the mesh's local space; plane and back
+// face tests don't change under an affine transform, so
+// that's exact even with non-uniform scale
+// --------------------------------------------------------
+namespace Meshlets
+{
+	struct Meshlet
+	{
+		unsigned int StartIndex;	// Into the reordered index list
+		unsigned int TriangleCount;
+		unsigned int VertexCount;	// Unique vertices used
+		DirectX::XMFLOAT3 Center;	// Bounding sphere
+		float Radius;
+		DirectX::XMFLOAT3 ConeAxis;	// Average facing direction
+		float ConeCutoff;		// Sine of the cone's half angle, 1 if it can't be culled
+	};
+
+	// A run of contiguous indices to draw
+	struct Range
+	{
+		unsigned int StartIndex;
+		unsigned int IndexCount;
+	};
+
+	// Groups triangles into meshlets, growing each one through
+	// neighboring triangles so they stay spatially tight.  Writes
+	// the triangles back out in meshlet order
+	std::vector<Meshlet> Build(
+		const Vertex* verts,
+		const unsigned int* indices, int indexCount,
+		std::vector<unsigned int>& reorderedIndices,
+		unsigned int maxVertices = MESHLET_MAX_VERTICES,
+		unsigned int maxTriangles = MESHLET_MAX_TRIANGLES);
+
+	// Six planes (xyz = inward normal, w = distance) from a
+	// row-vector matrix like world * view * projection, with
+	// D3D's 0 to 1 depth range.  Planes end up in the space the
+	// matrix takes points from
+	void ExtractFrustumPlanes(const DirectX::XMFLOAT4X4& matrix, DirectX::XMFLOAT4 planes[6]);
+
+	// True if every triangle in the meshlet faces away from the camera
+	bool IsBackFacing(const Meshlet& m, DirectX::XMFLOAT3 cameraPosition);
+
+	// True if the bounding sphere is entirely outside a plane
+	bool IsOutsideFrustum(const Meshlet& m, const DirectX::XMFLOAT4 planes[6]);
+
+	struct CullStats
+	{
+		unsigned int FrustumCulled;
+		unsigned int BackFaceCulled;
+		unsigned int TrianglesKept;
+	};
+
+	// Culls every meshlet, merging the survivors into as few
+	// index ranges as possible
+	CullStats Cull(
+		const std::vector<Meshlet>& meshlets,
+		DirectX::XMFLOAT3 cameraPosition,
+		const DirectX::XMFLOAT4 planes[6],
+		std::vector<Range>& ranges);
+}
@@ -0,0 +1,232 @@
+#include "Occlusion.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	XMFLOAT4 Transform(XMFLOAT3 p, const XMFLOAT4X4& m)
+	{
+		return XMFLOAT4(
+			p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+			p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+			p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43,
+			p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44);
+	}
+
+	XMFLOAT4 Lerp(XMFLOAT4 a, XMFLOAT4 b, float t)
+	{
+		return XMFLOAT4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t);
+	}
+
+	// Fills one triangle that's already in pixel space (z = depth)
+	void RasterizeTriangle(Occlusion::DepthBuffer& buffer, XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c)
+	{
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (area == 0.0f)
+			return;
+
+		int minX = std::max(0, (int)floorf(std::min({ a.x, b.x, c.x })));
+		int maxX = std::min((int)buffer.Width - 1, (int)ceilf(std::max({ a.x, b.x, c.x })));
+		int minY = std::max(0, (int)floorf(std::min({ a.y, b.y, c.y })));
+		int maxY = std::min((int)buffer.Height - 1, (int)ceilf(std::max({ a.y, b.y, c.y })));
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float py = y + 0.5f;
+			for (int x = minX; x <= maxX; x++)
+			{
+				// Barycentrics at the pixel center, either winding
+				float px = x + 0.5f;
+				float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) / area;
+				float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) / area;
+				float w2 = 1.0f - w0 - w1;
+				if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+					continue;
+
+				// Depth is linear in screen space after the divide
+				float z = w0 * a.z + w1 * b.z + w2 * c.z;
+				float& d = buffer.At(x, y);
+				if (z < d)
+					d = z;
+			}
+		}
+	}
+}
+
+void Occlusion::DepthBuffer::Resize(unsigned int width, unsigned int height, float clearDepth)
+{
+	Width = width;
+	Height = height;
+	Depth.assign((size_t)width * height, clearDepth);
+}
+
+void Occlusion::DepthPyramid::Build(const DepthBuffer& base)
+{
+	Levels.clear();
+	Levels.push_back(base);
+	while (Levels.back().Width > 1 || Levels.back().Height > 1)
+	{
+		const DepthBuffer& src = Levels.back();
+		DepthBuffer dst;
+		dst.Resize(std::max(1u, src.Width / 2), std::max(1u, src.Height / 2), 0.0f);
+
+		for (unsigned int y = 0; y < dst.Height; y++)
+		{
+			// The last row/column also takes in the leftover odd one
+			unsigned int y0 = y * 2;
+			unsigned int y1 = y == dst.Height - 1 ? src.Height - 1 : std::min(y0 + 1, src.Height - 1);
+			for (unsigned int x = 0; x < dst.Width; x++)
+			{
+				unsigned int x0 = x * 2;
+				unsigned int x1 = x == dst.Width - 1 ? src.Width - 1 : std::min(x0 + 1, src.Width - 1);
+
+				float depth = 0.0f;
+				for (unsigned int sy = y0; sy <= y1; sy++)
+					for (unsigned int sx = x0; sx <= x1; sx++)
+						depth = std::max(depth, src.At(sx, sy));
+				dst.At(x, y) = depth;
+			}
+		}
+		Levels.push_back(dst);
+	}
+}
+
+// --------------------------------------------------------
+// Transforms to clip space, clips against the near plane
+// (z >= 0) so nothing behind the camera gets projected,
+// then rasterizes the resulting triangle fan
+// --------------------------------------------------------
+void Occlusion::RasterizeOccluder(
+	DepthBuffer& buffer,
+	const XMFLOAT3* positions,
+	const unsigned int* indices,
+	int indexCount,
+	const XMFLOAT4X4& worldViewProj)
+{
+	for (int t = 0; t + 2 < indexCount; t += 3)
+	{
+		XMFLOAT4 in[3] =
+		{
+			Transform(positions[indices[t]], worldViewProj),
+			Transform(positions[indices[t + 1]], worldViewProj),
+			Transform(positions[indices[t + 2]], worldViewProj)
+		};
+
+		// Sutherland-Hodgman against z >= 0 (at most 4 verts come out)
+		XMFLOAT4 clipped[4];
+		int count = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			XMFLOAT4 a = in[i];
+			XMFLOAT4 b = in[(i + 1) % 3];
+			bool aIn = a.z >= 0.0f;
+			bool bIn = b.z >= 0.0f;
+			if (aIn)
+				clipped[count++] = a;
+			if (aIn != bIn)
+				clipped[count++] = Lerp(a, b, a.z / (a.z - b.z));
+		}
+		if (count < 3)
+			continue;
+
+		// To pixels, with y going down like D3D's viewport
+		XMFLOAT3 screen[4];
+		for (int i = 0; i < count; i++)
+		{
+			float invW = 1.0f / clipped[i].w;
+			screen[i] = XMFLOAT3(
+				(clipped[i].x * invW * 0.5f + 0.5f) * buffer.Width,
+				(0.5f - clipped[i].y * invW * 0.5f) * buffer.Height,
+				clipped[i].z * invW);
+		}
+
+		for (int i = 1; i + 1 < count; i++)
+			RasterizeTriangle(buffer, screen[0], screen[i], screen[i + 1]);
+	}
+}
+
+// --------------------------------------------------------
+// Projects the corners of the box around the sphere.  Loose,
+// but it's always at least as big as the real footprint
+// --------------------------------------------------------
+Occlusion::ScreenBounds Occlusion::ProjectSphere(
+	XMFLOAT3 center,
+	float radius,
+	const XMFLOAT4X4& viewProj,
+	unsigned int width,
+	unsigned int height)
+{
+	ScreenBounds bounds = {};
+	bounds.MinX = bounds.MinY = bounds.MinDepth = INFINITY;
+	bounds.MaxX = bounds.MaxY = -INFINITY;
+
+	for (int i = 0; i < 8; i++)
+	{
+		XMFLOAT3 corner(
+			center.x + (i & 1 ? radius : -radius),
+			center.y + (i & 2 ? radius : -radius),
+			center.z + (i & 4 ? radius : -radius));
+		XMFLOAT4 clip = Transform(corner, viewProj);
+
+		// Crossing the near plane, so it's right in front of the camera
+		if (clip.z < 0.0f || clip.w <= 0.0f)
+			return bounds;
+
+		float x = (clip.x / clip.w * 0.5f + 0.5f) * width;
+		float y = (0.5f - clip.y / clip.w * 0.5f) * height;
+		bounds.MinX = std::min(bounds.MinX, x);
+		bounds.MaxX = std::max(bounds.MaxX, x);
+		bounds.MinY = std::min(bounds.MinY, y);
+		bounds.MaxY = std::max(bounds.MaxY, y);
+		bounds.MinDepth = std::min(bounds.MinDepth, clip.z / clip.w);
+	}
+
+	bounds.Valid = true;
+	return bounds;
+}
+
+bool Occlusion::IsOccluded(const DepthPyramid& pyramid, const ScreenBounds& bounds)
+{
+	if (!bounds.Valid || pyramid.Levels.empty())
+		return false;
+
+	const DepthBuffer& base = pyramid.Levels[0];
+	float minX = std::max(bounds.MinX, 0.0f);
+	float minY = std::max(bounds.MinY, 0.0f);
+	float maxX = std::min(bounds.MaxX, (float)base.Width);
+	float maxY = std::min(bounds.MaxY, (float)base.Height);
+
+	// Entirely off screen is the frustum's job, not ours
+	if (minX >= maxX || minY >= maxY)
+		return false;
+
+	// Level where the rectangle spans at most 4-5 texels a side.
+	// Going coarser (2 texels) is cheaper but the bigger texels
+	// drag in depth from well outside the object
+	float size = std::max(maxX - minX, maxY - minY);
+	int level = std::max(0, (int)ceilf(log2f(std::max(size, 1.0f))) - 2);
+	level = std::min(level, (int)pyramid.Levels.size() - 1);
+
+	// Base pixels the rectangle touches, then the level texels
+	// holding them.  Each level halves (rounding down) and its last
+	// texel takes in any leftover, so a shift and a clamp finds them
+	const DepthBuffer& l = pyramid.Levels[level];
+	unsigned int x0 = std::min(l.Width - 1, (unsigned int)minX >> level);
+	unsigned int y0 = std::min(l.Height - 1, (unsigned int)minY >> level);
+	unsigned int x1 = std::min(l.Width - 1, ((unsigned int)ceilf(maxX) - 1) >> level);
+	unsigned int y1 = std::min(l.Height - 1, ((unsigned int)ceilf(maxY) - 1) >> level);
+
+	float farthest = 0.0f;
+	for (unsigned int y = y0; y <= y1; y++)
+		for (unsigned int x = x0; x <= x1; x++)
+			farthest = std::max(farthest, l.At(x, y));
+
+	return bounds.MinDepth > farthest;
+}
+
+bool Occlusion::CrossesEdge(const ScreenBounds& bounds, unsigned int width, unsigned int height)
+{
+	return bounds.MinX < 0.0f || bounds.MinY < 0.0f || bounds.MaxX > (float)width || bounds.MaxY > (float)height;
+}
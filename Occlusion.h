@@ -0,0 +1,83 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+
+// Size of the CPU occlusion buffers (height follows the aspect ratio)
+#define OCCLUSION_BUFFER_WIDTH 256
+
+// --------------------------------------------------------
+// Occlusion culling against a small depth buffer on the CPU.
+// The depth can come from two places:
+//  - The GPU's Hi-Z pyramid, read back a few frames late
+//  - Rasterizing a handful of occluder meshes right here
+// Either way it's reduced to a max-depth pyramid, and an
+// object is hidden when the nearest point of its bounds is
+// behind the farthest depth under its screen rectangle
+// --------------------------------------------------------
+namespace Occlusion
+{
+	// Where the depth to test against comes from
+	enum Mode
+	{
+		OCCLUSION_OFF = 0,
+		OCCLUSION_HIZ = 1,
+		OCCLUSION_SOFTWARE = 2,
+		OCCLUSION_BOTH = 3
+	};
+
+	// Row major depths, 0 near to 1 far like D3D
+	struct DepthBuffer
+	{
+		unsigned int Width;
+		unsigned int Height;
+		std::vector<float> Depth;
+
+		DepthBuffer() : Width(0), Height(0) {}
+		void Resize(unsigned int width, unsigned int height, float clearDepth = 1.0f);
+		float& At(unsigned int x, unsigned int y) { return Depth[(size_t)y * Width + x]; }
+		float At(unsigned int x, unsigned int y) const { return Depth[(size_t)y * Width + x]; }
+	};
+
+	// Each level holds the max of the (up to 3x3, for odd sizes)
+	// texels it covers in the level above, so it's conservative
+	struct DepthPyramid
+	{
+		std::vector<DepthBuffer> Levels;
+		void Build(const DepthBuffer& base);
+	};
+
+	// Software rasterizes triangles into the buffer with a less
+	// depth test.  Triangles are clipped against the near plane;
+	// both sides are drawn
+	void RasterizeOccluder(
+		DepthBuffer& buffer,
+		const DirectX::XMFLOAT3* positions,
+		const unsigned int* indices,
+		int indexCount,
+		const DirectX::XMFLOAT4X4& worldViewProj);
+
+	// Screen rectangle (in pixels of a buffer) and nearest depth of
+	// a bounding sphere.  Not Valid if it crosses the near plane,
+	// which means it can't be culled
+	struct ScreenBounds
+	{
+		float MinX, MinY, MaxX, MaxY;
+		float MinDepth;
+		bool Valid;
+	};
+	ScreenBounds ProjectSphere(
+		DirectX::XMFLOAT3 center,
+		float radius,
+		const DirectX::XMFLOAT4X4& viewProj,
+		unsigned int width,
+		unsigned int height);
+
+	// Tests the bounds against the coarsest level where the
+	// rectangle covers at most a few texels
+	bool IsOccluded(const DepthPyramid& pyramid, const ScreenBounds& bounds);
+
+	// True if the rectangle reaches past any edge of a buffer
+	// this size, where only part of it can be tested
+	bool CrossesEdge(const ScreenBounds& bounds, unsigned int width, unsigned int height);
+}
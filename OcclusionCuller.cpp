@@ -0,0 +1,257 @@
+#include "OcclusionCuller.h"
+#include "Graphics.h"
+#include "PathHelpers.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height) :
+	mode(Occlusion::OCCLUSION_BOTH), width(0), height(0),
+	hizStagingViewProj{}, hizStagingFrameNumber{}, hizStagingPending{}, hizStagingFrame(0), hizFrame(0),
+	hizViewProj{}, hizValid(false), hizLatency(0),
+	culled(0), tested(0), occluderTriangles(0)
+{
+	fullscreenVS = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"FullscreenVS.cso").c_str());
+	downsamplePS = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"HiZDownsamplePS.cso").c_str());
+	Resize(width, height);
+}
+
+// --------------------------------------------------------
+// Creates the Hi-Z texture (half the depth buffer, mipped
+// down until a level fits the CPU occlusion buffer) and the
+// staging textures that level is read back through
+// --------------------------------------------------------
+void OcclusionCuller::Resize(unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+
+	unsigned int hizWidth = max(1u, width / 2);
+	unsigned int hizHeight = max(1u, height / 2);
+	unsigned int mips = 1;
+	while ((hizWidth >> (mips - 1)) > OCCLUSION_BUFFER_WIDTH)
+		mips++;
+
+	D3D11_TEXTURE2D_DESC hizDesc = {};
+	hizDesc.Width = hizWidth;
+	hizDesc.Height = hizHeight;
+	hizDesc.MipLevels = mips;
+	hizDesc.ArraySize = 1;
+	hizDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	hizDesc.SampleDesc.Count = 1;
+	hizDesc.Usage = D3D11_USAGE_DEFAULT;
+	hizDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	Graphics::Api->CreateTexture2D(hizDesc, 0, hizTexture.ReleaseAndGetAddressOf());
+
+	hizRTVs.assign(mips, 0);
+	hizSRVs.assign(mips, 0);
+	for (unsigned int m = 0; m < mips; m++)
+	{
+		D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+		rtvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+		rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+		rtvDesc.Texture2D.MipSlice = m;
+		Graphics::Device->CreateRenderTargetView(hizTexture.Get(), &rtvDesc, hizRTVs[m].GetAddressOf());
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = m;
+		srvDesc.Texture2D.MipLevels = 1;
+		Graphics::Device->CreateShaderResourceView(hizTexture.Get(), &srvDesc, hizSRVs[m].GetAddressOf());
+	}
+
+	// Only the smallest level comes back to the CPU
+	D3D11_TEXTURE2D_DESC stagingDesc = hizDesc;
+	stagingDesc.Width = max(1u, hizWidth >> (mips - 1));
+	stagingDesc.Height = max(1u, hizHeight >> (mips - 1));
+	stagingDesc.MipLevels = 1;
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.BindFlags = 0;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	for (int i = 0; i < 3; i++)
+	{
+		Graphics::Api->CreateTexture2D(stagingDesc, 0, hizStaging[i].ReleaseAndGetAddressOf());
+		hizStagingPending[i] = false;
+	}
+	hizValid = false;
+}
+
+// --------------------------------------------------------
+// The software buffer is exact for this frame's view but
+// only holds the occluders; the Hi-Z readback holds
+// everything that was drawn, but is a few frames old, so
+// it's tested with the view it came from
+// --------------------------------------------------------
+void OcclusionCuller::Update(Camera* camera, const std::vector<std::shared_ptr<GameEntity>>& entities, JobSystem& jobs, unsigned int grainSize, bool viewMayTurn)
+{
+	PROFILE_SCOPE("UpdateOcclusion");
+	culled = 0;
+	tested = 0;
+	occluderTriangles = 0;
+
+	XMFLOAT4X4 viewProj = camera->GetViewProjection();
+	XMMATRIX viewProjMatrix = XMLoadFloat4x4(&viewProj);
+
+	bool useHiZ = (mode & Occlusion::OCCLUSION_HIZ) && hizValid;
+	bool useSoftware = (mode & Occlusion::OCCLUSION_SOFTWARE) != 0;
+	if (useSoftware)
+	{
+		unsigned int bufferWidth = OCCLUSION_BUFFER_WIDTH;
+		unsigned int bufferHeight = max(1u, (unsigned int)(bufferWidth / camera->GetAspectRatio()));
+		softwareDepth.Resize(bufferWidth, bufferHeight);
+		for (auto& e : entities)
+		{
+			if (!e->IsOccluder())
+				continue;
+
+			std::shared_ptr<Mesh> mesh = e->GetMesh();
+			XMFLOAT4X4 world = e->GetTransform()->GetWorldMatrix();
+			XMFLOAT4X4 worldViewProj;
+			XMStoreFloat4x4(&worldViewProj, XMMatrixMultiply(XMLoadFloat4x4(&world), viewProjMatrix));
+			const std::vector<unsigned int>& indices = mesh->GetCpuIndices();
+			Occlusion::RasterizeOccluder(softwareDepth, mesh->GetCpuPositions().data(), indices.data(), (int)indices.size(), worldViewProj);
+			occluderTriangles += (unsigned int)indices.size() / 3;
+		}
+		softwarePyramid.Build(softwareDepth);
+	}
+
+	// Each entity only touches its own culled flag
+	jobs.ParallelFor((unsigned int)entities.size(), grainSize, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				GameEntity* e = entities[i].get();
+				e->SetOcclusionCulled(false);
+				if (mode == Occlusion::OCCLUSION_OFF || e->IsOccluder())
+					continue;
+
+				XMFLOAT3 center;
+				float radius;
+				e->GetWorldBounds(center, radius);
+
+				bool hidden = false;
+				if (useSoftware)
+				{
+					Occlusion::ScreenBounds bounds = Occlusion::ProjectSphere(center, radius, viewProj, softwareDepth.Width, softwareDepth.Height);
+					if (!viewMayTurn || !Occlusion::CrossesEdge(bounds, softwareDepth.Width, softwareDepth.Height))
+						hidden = Occlusion::IsOccluded(softwarePyramid, bounds);
+				}
+				if (!hidden && useHiZ)
+				{
+					const Occlusion::DepthBuffer& base = hizPyramid.Levels[0];
+					Occlusion::ScreenBounds bounds = Occlusion::ProjectSphere(center, radius, hizViewProj, base.Width, base.Height);
+					hidden = Occlusion::IsOccluded(hizPyramid, bounds);
+				}
+				e->SetOcclusionCulled(hidden);
+			}
+		});
+
+	for (auto& e : entities)
+	{
+		if (mode == Occlusion::OCCLUSION_OFF || e->IsOccluder())
+			continue;
+		tested++;
+		if (e->IsOcclusionCulled())
+			culled++;
+	}
+}
+
+// --------------------------------------------------------
+// Reduces the depth buffer into the Hi-Z mips, then queues
+// a copy of the smallest one for the CPU
+// --------------------------------------------------------
+void OcclusionCuller::RenderHiZ(Camera* camera)
+{
+	fullscreenVS->SetShader();
+	downsamplePS->SetShader();
+
+	unsigned int sourceWidth = width;
+	unsigned int sourceHeight = height;
+	for (size_t m = 0; m < hizRTVs.size(); m++)
+	{
+		unsigned int levelWidth = max(1u, sourceWidth / 2);
+		unsigned int levelHeight = max(1u, sourceHeight / 2);
+
+		// Target first, so binding the level above as input doesn't
+		// clash with it still being the render target
+		Graphics::Context->OMSetRenderTargets(1, hizRTVs[m].GetAddressOf(), 0);
+		D3D11_VIEWPORT viewport = {};
+		viewport.Width = (float)levelWidth;
+		viewport.Height = (float)levelHeight;
+		viewport.MaxDepth = 1.0f;
+		Graphics::Context->RSSetViewports(1, &viewport);
+
+		int sourceSize[2] = { (int)sourceWidth, (int)sourceHeight };
+		downsamplePS->SetShaderResourceView("Source", m == 0 ? Graphics::DepthBufferSRV : hizSRVs[m - 1]);
+		downsamplePS->SetData("sourceSize", sourceSize, sizeof(sourceSize));
+		downsamplePS->CopyAllBufferData();
+		Graphics::Api->Draw(Graphics::Context.Get(), 3, 0);
+
+		sourceWidth = levelWidth;
+		sourceHeight = levelHeight;
+	}
+
+	ID3D11ShaderResourceView* nullSRV = 0;
+	Graphics::Context->PSSetShaderResources(0, 1, &nullSRV);
+	Graphics::Context->OMSetRenderTargets(0, 0, 0);
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)width;
+	viewport.Height = (float)height;
+	viewport.MaxDepth = 1.0f;
+	Graphics::Context->RSSetViewports(1, &viewport);
+
+	// Remember which view this depth came from, since it'll be
+	// tested against a few frames from now
+	if (!hizStagingPending[hizStagingFrame])
+	{
+		Graphics::Context->CopySubresourceRegion(hizStaging[hizStagingFrame].Get(), 0, 0, 0, 0, hizTexture.Get(), (unsigned int)hizRTVs.size() - 1, 0);
+		hizStagingViewProj[hizStagingFrame] = camera->GetViewProjection();
+		hizStagingFrameNumber[hizStagingFrame] = hizFrame;
+		hizStagingPending[hizStagingFrame] = true;
+		hizStagingFrame = (hizStagingFrame + 1) % 3;
+	}
+	hizFrame++;
+
+	ReadHiZ();
+}
+
+// --------------------------------------------------------
+// Picks up the newest finished Hi-Z copy without waiting on
+// the GPU and builds the rest of the pyramid on the CPU
+// --------------------------------------------------------
+void OcclusionCuller::ReadHiZ()
+{
+	int newest = -1;
+	Occlusion::DepthBuffer base;
+	for (int i = 0; i < 3; i++)
+	{
+		if (!hizStagingPending[i])
+			continue;
+
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		if (Graphics::Context->Map(hizStaging[i].Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped) != S_OK)
+			continue;
+
+		if (newest == -1 || hizStagingFrameNumber[i] > hizStagingFrameNumber[newest])
+		{
+			D3D11_TEXTURE2D_DESC desc = {};
+			hizStaging[i]->GetDesc(&desc);
+			base.Resize(desc.Width, desc.Height);
+			for (unsigned int y = 0; y < desc.Height; y++)
+				memcpy(&base.At(0, y), (char*)mapped.pData + (size_t)y * mapped.RowPitch, desc.Width * sizeof(float));
+			newest = i;
+		}
+
+		Graphics::Context->Unmap(hizStaging[i].Get(), 0);
+		hizStagingPending[i] = false;
+	}
+
+	if (newest == -1)
+		return;
+
+	hizPyramid.Build(base);
+	hizViewProj = hizStagingViewProj[newest];
+	hizLatency = (unsigned int)(hizFrame - hizStagingFrameNumber[newest]);
+	hizValid = true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "Camera.h"
+#include "GameEntity.h"
+#include "JobSystem.h"
+#include "Occlusion.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Hides entities whose bounds are entirely behind the depth
+// we have for a frame.  The GPU reduces the depth buffer to
+// a small max-depth texture that's read back a few frames
+// late (with the view it was rendered from); occluder
+// entities can also be rasterized on the CPU for a
+// same-frame answer.  Occlusion.h has the CPU side of both
+// --------------------------------------------------------
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(unsigned int width, unsigned int height);
+
+	// Recreates the Hi-Z texture for a new depth buffer size
+	void Resize(unsigned int width, unsigned int height);
+
+	// Tests every entity that isn't an occluder itself and sets
+	// whether it's hidden, split across the job system.  If the
+	// view may still turn before it's drawn, anything reaching
+	// past the screen edge is kept: the occluders beyond the
+	// edge were never rasterized
+	void Update(Camera* camera, const std::vector<std::shared_ptr<GameEntity>>& entities, JobSystem& jobs, unsigned int grainSize, bool viewMayTurn = false);
+
+	// Reduces the finished depth buffer and queues it for the CPU
+	void RenderHiZ(Camera* camera);
+
+	// Which depth sources are used (Occlusion::OCCLUSION_ flags)
+	int GetMode() { return mode; }
+	void SetMode(int occlusionMode) { mode = occlusionMode; }
+
+	// Stats from the last Update()
+	unsigned int GetCulledCount() { return culled; }
+	unsigned int GetTestedCount() { return tested; }
+	unsigned int GetOccluderTriangles() { return occluderTriangles; }
+	const Occlusion::DepthBuffer& GetSoftwareDepth() { return softwareDepth; }
+
+	// Most recent readback
+	bool IsHiZValid() { return hizValid; }
+	const Occlusion::DepthPyramid& GetHiZPyramid() { return hizPyramid; }
+	unsigned int GetHiZLatency() { return hizLatency; } // Frames between rendering and reading back
+
+private:
+	void ReadHiZ();
+
+	int mode;
+	unsigned int width;
+	unsigned int height;
+
+	std::shared_ptr<SimpleVertexShader> fullscreenVS;
+	std::shared_ptr<SimplePixelShader> downsamplePS;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> hizTexture;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11RenderTargetView>> hizRTVs; // One per mip
+	std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> hizSRVs;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> hizStaging[3];
+	DirectX::XMFLOAT4X4 hizStagingViewProj[3];
+	unsigned long long hizStagingFrameNumber[3];
+	bool hizStagingPending[3];
+	int hizStagingFrame;
+	unsigned long long hizFrame;
+	Occlusion::DepthPyramid hizPyramid;
+	DirectX::XMFLOAT4X4 hizViewProj;
+	bool hizValid;
+	unsigned int hizLatency;
+
+	Occlusion::DepthBuffer softwareDepth;
+	Occlusion::DepthPyramid softwarePyramid;
+
+	unsigned int culled;
+	unsigned int tested;
+	unsigned int occluderTriangles;
+};
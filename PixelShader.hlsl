@@ -1,5 +1,11 @@
 #include "ShaderInclude.hlsli"
 #include "LightsInclude.hlsli"
+#include "CameraInclude.hlsli"
+
+// Must match MAX_SHADOW_CASCADES in ShadowCascades.h
+#define MAX_SHADOW_CASCADES 4
+// Must match MAX_LOCAL_SHADOW_TILES in ShadowAtlas.h
+#define MAX_LOCAL_SHADOW_TILES 16
 
 cbuffer ExternalData : register(b0)
 {
@@ -7,24 +13,117 @@ cbuffer ExternalData : register(b0)
     float roughness;
     float2 uvOffset;
     float2 uvScale;
-    float3 cameraPosition;
     float3 ambient;
     Light lights[5];
     bool useEmissive;
+    float emissiveIntensity;
+
+    // Cascaded shadows for lights[0] (when it's directional)
+    matrix cascadeViewProj[MAX_SHADOW_CASCADES];
+    float4 cascadeSplits; // Far view depth of each cascade
+    float3 cameraForward;
+    int cascadeCount;     // 0 turns shadows off
+    float shadowTexelSize; // 1 / shadow map resolution
+
+    // Point and spot light shadows, in tiles of the shadow atlas
+    matrix localShadowViewProj[MAX_LOCAL_SHADOW_TILES];
+    float4 localShadowRects[MAX_LOCAL_SHADOW_TILES]; // UV offset (xy) and scale (zw)
+    float shadowAtlasTexelSize; // 1 / atlas resolution
 }
 //textures and samplers
 Texture2D Albedo : register(t0);
 Texture2D NormalMap: register(t1);
 Texture2D RoughnessMap : register(t2);
 Texture2D MetalMap : register(t3);
-Texture2D ShadowMap : register(t4);
+Texture2DArray ShadowMap : register(t4); // One slice per cascade
 Texture2D EmissiveMap : register(t5);
+Texture2D ShadowAtlas : register(t6); // Point and spot light tiles
 
 SamplerState BasicSampler : register(s0); 
 SamplerComparisonState ShadowSampler : register(s1);
 
 
 
+// 3x3 PCF in the cascade covering this pixel, 1 is fully lit
+float ShadowAmount(float3 worldPos)
+{
+    if (cascadeCount == 0)
+        return 1.0f;
+
+    // Past the last cascade there's nothing to sample
+    float depth = dot(worldPos - cameraPosition, cameraForward);
+    if (depth > cascadeSplits[cascadeCount - 1])
+        return 1.0f;
+
+    int cascade = 0;
+    [unroll]
+    for (int c = 0; c < MAX_SHADOW_CASCADES - 1; c++)
+        cascade += (c < cascadeCount - 1 && depth > cascadeSplits[c]) ? 1 : 0;
+
+    float4 shadowPos = mul(cascadeViewProj[cascade], float4(worldPos, 1.0f));
+    shadowPos /= shadowPos.w;
+    float2 shadowUV = shadowPos.xy * 0.5f + 0.5f;
+    shadowUV.y = 1.0f - shadowUV.y;
+
+    float shadow = 0;
+    [unroll]
+    for (int y = -1; y <= 1; y++)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; x++)
+        {
+            float3 uv = float3(shadowUV + float2(x, y) * shadowTexelSize, cascade);
+            shadow += ShadowMap.SampleCmpLevelZero(ShadowSampler, uv, shadowPos.z).r;
+        }
+    }
+    return shadow / 9;
+}
+
+// 3x3 PCF in a light's atlas tile, 1 is fully lit.  Point
+// lights have 6 tiles in a row (+X, -X, +Y, -Y, +Z, -Z)
+float LocalShadowAmount(Light light, float3 worldPos)
+{
+    if (light.ShadowTile < 0)
+        return 1.0f;
+
+    int tile = light.ShadowTile;
+    if (light.Type == LIGHT_TYPE_POINT)
+    {
+        float3 dir = worldPos - light.Position;
+        float3 a = abs(dir);
+        if (a.x >= a.y && a.x >= a.z)
+            tile += dir.x > 0 ? 0 : 1;
+        else if (a.y >= a.z)
+            tile += dir.y > 0 ? 2 : 3;
+        else
+            tile += dir.z > 0 ? 4 : 5;
+    }
+
+    float4 shadowPos = mul(localShadowViewProj[tile], float4(worldPos, 1.0f));
+    shadowPos /= shadowPos.w;
+    float2 uv = shadowPos.xy * 0.5f + 0.5f;
+    uv.y = 1.0f - uv.y;
+
+    // Keep every tap inside this tile so neighbors don't bleed in
+    float4 rect = localShadowRects[tile];
+    float texel = shadowAtlasTexelSize / rect.z;
+    uv = clamp(uv, 1.5f * texel, 1.0f - 1.5f * texel);
+    float2 atlasUV = rect.xy + uv * rect.zw;
+
+    float shadow = 0;
+    [unroll]
+    for (int y = -1; y <= 1; y++)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; x++)
+        {
+            float2 offset = float2(x, y) * shadowAtlasTexelSize;
+            shadow += ShadowAtlas.SampleCmpLevelZero(ShadowSampler, atlasUV + offset, shadowPos.z).r;
+        }
+    }
+    return shadow / 9;
+}
+
 float4 main(VertexToPixel input) : SV_TARGET
 {
     input.normal = normalize(input.normal);
@@ -50,16 +149,7 @@ float4 main(VertexToPixel input) : SV_TARGET
     
     float3 totalLight = ambient * surfaceColor.xyz;
     
-        //shadows
-////perspective divide
-//    input.shadowMapPos /= input.shadowMapPos.w;
-//// Convert the normalized device coordinates to UVs for sampling
-//    float2 shadowUV = input.shadowMapPos.xy * 0.5f + 0.5f;
-//    shadowUV.y = 1.0f - shadowUV.y; // Flip the Y
-//// Grab the distances we need: light-to-pixel and closest-surface
-//    float distToLight = input.shadowMapPos.z;
-// // Get a ratio of comparison results using SampleCmpLevelZero()
-    //float shadowAmount = ShadowMap.SampleCmpLevelZero(ShadowSampler, shadowUV, distToLight).r;
+    float shadowAmount = ShadowAmount(input.worldPos);
     for (int i = 0; i < 5; i++)
     {
         Light light = lights[i];
@@ -67,13 +157,13 @@ float4 main(VertexToPixel input) : SV_TARGET
         switch (light.Type)
         {
             case LIGHT_TYPE_DIRECTIONAL:
-                totalLight += Directional(light, input.normal, input.worldPos, cameraPosition, surfaceColor.xyz, roughness, metal);
+                totalLight += Directional(light, input.normal, input.worldPos, cameraPosition, surfaceColor.xyz, roughness, metal) * (i == 0 ? shadowAmount : 1.0f);
                 break;
             case LIGHT_TYPE_POINT:
-                totalLight += Point(light, input.normal, input.worldPos, cameraPosition, surfaceColor.xyz, roughness,metal);
+                totalLight += Point(light, input.normal, input.worldPos, cameraPosition, surfaceColor.xyz, roughness,metal) * LocalShadowAmount(light, input.worldPos);
                 break;
             case LIGHT_TYPE_SPOT:
-                totalLight += Spot(light, input.normal, input.worldPos, cameraPosition, surfaceColor.xyz, roughness,metal);
+                totalLight += Spot(light, input.normal, input.worldPos, cameraPosition, surfaceColor.xyz, roughness,metal) * LocalShadowAmount(light, input.worldPos);
                 break;
 
         }
@@ -81,7 +171,7 @@ float4 main(VertexToPixel input) : SV_TARGET
     if (useEmissive)
     {
         float3 emissiveColor = EmissiveMap.Sample(BasicSampler, input.uv).rgb;
-        totalLight += pow(emissiveColor.rgb, 2.2);
+        totalLight += pow(emissiveColor.rgb, 2.2) * emissiveIntensity;
 
     }
     else
@@ -89,7 +179,7 @@ float4 main(VertexToPixel input) : SV_TARGET
         totalLight += float3(0, 0, 0);
 
     }
-    float3 final = pow(totalLight, 1 / 2.2f);
-    return float4(final,1);
+    // Linear HDR, tonemapping and gamma happen once in the post chain
+    return float4(totalLight, 1);
 
 }
\ No newline at end of file
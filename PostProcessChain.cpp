@@ -0,0 +1,545 @@
+#include "PostProcessChain.h"
+#include "Graphics.h"
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+	// Rough size of a single pixel, used for memory stats
+	unsigned int BytesPerPixel(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: return 8;
+		case DXGI_FORMAT_R16_FLOAT: return 2;
+		case DXGI_FORMAT_R8_UNORM: return 1;
+		default: return 4;
+		}
+	}
+
+	// How many frames of timestamp queries are in flight
+	const unsigned int TimerFrameCount = 4;
+}
+
+PostProcessChain::PostProcessChain(std::shared_ptr<SimpleVertexShader> fullscreenVS, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler) :
+	vs(fullscreenVS), sampler(sampler), width(0), height(0), dirty(true),
+	timingEnabled(false), timerFrameIndex(0)
+{
+}
+
+// --------------------------------------------------------
+// Declares a named target the passes can read and write
+//
+// name         - How passes refer to this target
+// format       - Texture format of the target
+// relativeSize - Size as a fraction of the window
+// external     - Is this target rendered into outside the chain?
+// --------------------------------------------------------
+void PostProcessChain::AddTarget(std::string name, DXGI_FORMAT format, float relativeSize, bool external)
+{
+	PostProcessTarget target = {};
+	target.Name = name;
+	target.Format = format;
+	target.RelativeSize = relativeSize;
+	target.External = external;
+	target.PoolIndex = -1;
+
+	targetLookup[name] = (int)targets.size();
+	targets.push_back(target);
+	dirty = true;
+}
+
+// --------------------------------------------------------
+// Adds a full screen pass to the end of the chain
+//
+// inputs    - Pairs of shader SRV name and target name
+// output    - Target to render into, or "" for the final output
+// setParams - Optional hook for setting extra shader data
+// --------------------------------------------------------
+void PostProcessChain::AddPass(
+	std::string name,
+	std::shared_ptr<SimplePixelShader> ps,
+	std::vector<std::pair<std::string, std::string>> inputs,
+	std::string output,
+	std::function<void(SimplePixelShader*, unsigned int, unsigned int)> setParams)
+{
+	PostProcessPass pass = {};
+	pass.Name = name;
+	pass.PS = ps;
+	pass.Inputs = inputs;
+	pass.Output = output;
+	pass.SetParams = setParams;
+	pass.Enabled = true;
+	pass.GpuTime = 0.0f;
+
+	passes.push_back(pass);
+	dirty = true;
+}
+
+// --------------------------------------------------------
+// Turns a pass on or off.  A disabled pass is skipped and
+// anything reading its output reads its first input instead,
+// so the last pass (which writes the final output) should
+// stay enabled
+// --------------------------------------------------------
+void PostProcessChain::SetPassEnabled(std::string name, bool enabled)
+{
+	for (auto& p : passes)
+	{
+		if (p.Name == name && p.Enabled != enabled)
+		{
+			p.Enabled = enabled;
+			dirty = true;
+		}
+	}
+}
+
+bool PostProcessChain::IsPassEnabled(std::string name)
+{
+	for (auto& p : passes)
+	{
+		if (p.Name == name)
+			return p.Enabled;
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// Figures out when each target is first written and last
+// read, then hands out pooled textures.  Targets with the
+// same format and relative size share a texture when their
+// lifetimes don't overlap.  Existing pooled textures are
+// reused where possible so toggling a pass doesn't thrash
+// --------------------------------------------------------
+void PostProcessChain::Compile()
+{
+	// Follow the outputs of disabled passes back to a real target
+	redirects.clear();
+	auto resolve = [&](std::string name)
+	{
+		while (redirects.count(name))
+			name = redirects[name];
+		return name;
+	};
+
+	for (auto& t : targets)
+	{
+		t.FirstUse = t.External ? -1 : INT_MAX;
+		t.LastUse = -1;
+		t.PoolIndex = -1;
+	}
+
+	// Lifetimes
+	for (int i = 0; i < (int)passes.size(); i++)
+	{
+		PostProcessPass& pass = passes[i];
+		if (!pass.Enabled)
+		{
+			if (!pass.Output.empty() && !pass.Inputs.empty())
+				redirects[pass.Output] = resolve(pass.Inputs[0].second);
+			continue;
+		}
+
+		for (auto& input : pass.Inputs)
+		{
+			PostProcessTarget* t = FindTarget(resolve(input.second));
+			if (t) t->LastUse = max(t->LastUse, i);
+		}
+
+		PostProcessTarget* out = FindTarget(pass.Output);
+		if (out) out->FirstUse = min(out->FirstUse, i);
+	}
+
+	// Only targets that are actually written need a texture
+	std::vector<PostProcessTarget*> live;
+	for (auto& t : targets)
+	{
+		if (t.FirstUse == INT_MAX)
+			continue;
+		t.LastUse = max(t.LastUse, t.FirstUse);
+		live.push_back(&t);
+	}
+	std::sort(live.begin(), live.end(),
+		[](PostProcessTarget* a, PostProcessTarget* b) { return a->FirstUse < b->FirstUse; });
+
+	// Hand out pooled textures, preferring ones that already exist
+	std::vector<bool> used(pool.size(), false);
+	for (auto& p : pool)
+		p.LastUse = INT_MIN;
+
+	for (auto* t : live)
+	{
+		int index = -1;
+		for (int i = 0; i < (int)pool.size(); i++)
+		{
+			PooledTexture& p = pool[i];
+			if (p.Format == t->Format &&
+				p.RelativeSize == t->RelativeSize &&
+				p.LastUse < t->FirstUse)
+			{
+				index = i;
+				break;
+			}
+		}
+
+		if (index == -1)
+		{
+			PooledTexture p = {};
+			p.Format = t->Format;
+			p.RelativeSize = t->RelativeSize;
+			index = (int)pool.size();
+			pool.push_back(p);
+			used.push_back(false);
+		}
+
+		pool[index].LastUse = t->LastUse;
+		used[index] = true;
+		t->PoolIndex = index;
+	}
+
+	// Release textures nothing maps to anymore
+	std::vector<int> remap(pool.size(), -1);
+	std::vector<PooledTexture> compacted;
+	for (int i = 0; i < (int)pool.size(); i++)
+	{
+		if (!used[i])
+			continue;
+		remap[i] = (int)compacted.size();
+		compacted.push_back(pool[i]);
+	}
+	pool = compacted;
+	for (auto& t : targets)
+	{
+		if (t.PoolIndex != -1)
+			t.PoolIndex = remap[t.PoolIndex];
+	}
+
+	dirty = false;
+
+	// Create anything new at the current size
+	if (width > 0 && height > 0)
+	{
+		for (auto& p : pool)
+		{
+			if (!p.RTV)
+				CreatePooledTexture(p);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Handles a window resize.  Only pooled textures whose
+// size actually changes are recreated
+// --------------------------------------------------------
+void PostProcessChain::Resize(unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+
+	if (dirty)
+		Compile();
+
+	for (auto& p : pool)
+	{
+		unsigned int w = max(1u, (unsigned int)(width * p.RelativeSize));
+		unsigned int h = max(1u, (unsigned int)(height * p.RelativeSize));
+		if (!p.RTV || w != p.Width || h != p.Height)
+			CreatePooledTexture(p);
+	}
+}
+
+// --------------------------------------------------------
+// Draws each enabled pass as a full screen triangle
+//
+// finalTarget - Where the pass with no output target draws
+// --------------------------------------------------------
+void PostProcessChain::Execute(ID3D11RenderTargetView* finalTarget)
+{
+	if (dirty)
+		Compile();
+
+	vs->SetShader();
+
+	// Only time this frame if its queries have been read back
+	PostProcessTimerFrame* timer = 0;
+	if (timingEnabled)
+	{
+		ReadTimers();
+		PostProcessTimerFrame& frame = timerFrames[timerFrameIndex];
+		if (!frame.Pending)
+		{
+			timer = &frame;
+			timer->PassIndices.clear();
+			Graphics::Context->Begin(timer->Disjoint.Get());
+			Graphics::Context->End(timer->Timestamps[0].Get());
+		}
+	}
+
+	unsigned int boundSRVs = 0;
+	for (int passIndex = 0; passIndex < (int)passes.size(); passIndex++)
+	{
+		PostProcessPass& pass = passes[passIndex];
+		if (!pass.Enabled)
+			continue;
+
+		// Unbind whatever the previous pass sampled so it can be written
+		if (boundSRVs > 0)
+		{
+			ID3D11ShaderResourceView* nullSRVs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+			Graphics::Context->PSSetShaderResources(0, boundSRVs, nullSRVs);
+			boundSRVs = 0;
+		}
+
+		// Where are we drawing?
+		ID3D11RenderTargetView* rtv = finalTarget;
+		unsigned int w = width;
+		unsigned int h = height;
+		PostProcessTarget* out = FindTarget(pass.Output);
+		if (out && out->PoolIndex != -1)
+		{
+			PooledTexture& p = pool[out->PoolIndex];
+			rtv = p.RTV.Get();
+			w = p.Width;
+			h = p.Height;
+		}
+		Graphics::Context->OMSetRenderTargets(1, &rtv, 0);
+
+		D3D11_VIEWPORT viewport = {};
+		viewport.Width = (float)w;
+		viewport.Height = (float)h;
+		viewport.MaxDepth = 1.0f;
+		Graphics::Context->RSSetViewports(1, &viewport);
+
+		// Shader and inputs
+		pass.PS->SetShader();
+		for (auto& input : pass.Inputs)
+		{
+			std::string name = input.second;
+			while (redirects.count(name))
+				name = redirects[name];
+
+			pass.PS->SetShaderResourceView(input.first, GetShaderResource(name));
+
+			const SimpleSRV* info = pass.PS->GetShaderResourceViewInfo(input.first);
+			if (info) boundSRVs = max(boundSRVs, info->BindIndex + 1);
+		}
+		pass.PS->SetSamplerState("BasicSampler", sampler);
+
+		if (pass.SetParams)
+			pass.SetParams(pass.PS.get(), w, h);
+
+		pass.PS->CopyAllBufferData();
+		Graphics::Api->Draw(Graphics::Context.Get(), 3, 0); // Draw exactly 3 vertices (one triangle)
+
+		if (timer)
+		{
+			// Grow the query list if passes were added since it was made
+			unsigned int slot = (unsigned int)timer->PassIndices.size() + 1;
+			if (slot >= timer->Timestamps.size())
+			{
+				D3D11_QUERY_DESC queryDesc = {};
+				queryDesc.Query = D3D11_QUERY_TIMESTAMP;
+				timer->Timestamps.emplace_back();
+				Graphics::Device->CreateQuery(&queryDesc, timer->Timestamps.back().GetAddressOf());
+			}
+			Graphics::Context->End(timer->Timestamps[slot].Get());
+			timer->PassIndices.push_back(passIndex);
+		}
+	}
+
+	if (timer)
+	{
+		Graphics::Context->End(timer->Disjoint.Get());
+		timer->Pending = true;
+		timerFrameIndex = (timerFrameIndex + 1) % TimerFrameCount;
+	}
+
+	// Leave nothing of ours bound, so our textures can be written next frame
+	if (boundSRVs > 0)
+	{
+		ID3D11ShaderResourceView* nullSRVs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+		Graphics::Context->PSSetShaderResources(0, boundSRVs, nullSRVs);
+	}
+
+	// Put the full size viewport back for anything drawn afterwards
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)width;
+	viewport.Height = (float)height;
+	viewport.MaxDepth = 1.0f;
+	Graphics::Context->RSSetViewports(1, &viewport);
+}
+
+Microsoft::WRL::ComPtr<ID3D11RenderTargetView> PostProcessChain::GetRenderTarget(std::string name)
+{
+	if (dirty) Compile();
+	PostProcessTarget* t = FindTarget(name);
+	if (!t || t->PoolIndex == -1)
+		return 0;
+	return pool[t->PoolIndex].RTV;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> PostProcessChain::GetShaderResource(std::string name)
+{
+	if (dirty) Compile();
+	PostProcessTarget* t = FindTarget(name);
+	if (!t || t->PoolIndex == -1)
+		return 0;
+	return pool[t->PoolIndex].SRV;
+}
+
+unsigned int PostProcessChain::GetTargetWidth(std::string name)
+{
+	PostProcessTarget* t = FindTarget(name);
+	return (t && t->PoolIndex != -1) ? pool[t->PoolIndex].Width : 0;
+}
+
+unsigned int PostProcessChain::GetTargetHeight(std::string name)
+{
+	PostProcessTarget* t = FindTarget(name);
+	return (t && t->PoolIndex != -1) ? pool[t->PoolIndex].Height : 0;
+}
+
+unsigned int PostProcessChain::GetPooledTextureCount()
+{
+	return (unsigned int)pool.size();
+}
+
+size_t PostProcessChain::GetPooledMemory()
+{
+	size_t total = 0;
+	for (auto& p : pool)
+		total += (size_t)p.Width * p.Height * BytesPerPixel(p.Format);
+	return total;
+}
+
+// --------------------------------------------------------
+// Turns per pass GPU timing on or off.  Queries are only
+// created while timing is on
+// --------------------------------------------------------
+void PostProcessChain::SetTimingEnabled(bool enabled)
+{
+	timingEnabled = enabled;
+	timerFrames.clear();
+	timerFrameIndex = 0;
+	if (!enabled)
+		return;
+
+	D3D11_QUERY_DESC disjointDesc = {};
+	disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	D3D11_QUERY_DESC timestampDesc = {};
+	timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+
+	timerFrames.resize(TimerFrameCount);
+	for (auto& frame : timerFrames)
+	{
+		Graphics::Device->CreateQuery(&disjointDesc, frame.Disjoint.GetAddressOf());
+		frame.Timestamps.resize(passes.size() + 1);
+		for (auto& t : frame.Timestamps)
+			Graphics::Device->CreateQuery(&timestampDesc, t.GetAddressOf());
+		frame.Pending = false;
+	}
+}
+
+bool PostProcessChain::IsTimingEnabled()
+{
+	return timingEnabled;
+}
+
+const std::vector<PostProcessPass>& PostProcessChain::GetPasses()
+{
+	return passes;
+}
+
+float PostProcessChain::GetPassTime(std::string name)
+{
+	for (auto& p : passes)
+	{
+		if (p.Name == name)
+			return p.Enabled ? p.GpuTime : 0.0f;
+	}
+	return 0.0f;
+}
+
+// --------------------------------------------------------
+// Picks up any timing results the GPU has finished, without
+// waiting on ones that aren't ready yet
+// --------------------------------------------------------
+void PostProcessChain::ReadTimers()
+{
+	for (auto& frame : timerFrames)
+	{
+		if (!frame.Pending)
+			continue;
+
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+		if (Graphics::Context->GetData(frame.Disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			continue;
+
+		std::vector<UINT64> stamps(frame.PassIndices.size() + 1);
+		bool ready = true;
+		for (unsigned int i = 0; i < stamps.size() && ready; i++)
+			ready = Graphics::Context->GetData(frame.Timestamps[i].Get(), &stamps[i], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+		if (!ready)
+			continue;
+
+		frame.Pending = false;
+		if (disjoint.Disjoint)
+			continue;
+
+		for (unsigned int i = 0; i < frame.PassIndices.size(); i++)
+		{
+			int index = frame.PassIndices[i];
+			if (index < (int)passes.size())
+				passes[index].GpuTime = (float)((double)(stamps[i + 1] - stamps[i]) / disjoint.Frequency * 1000.0);
+		}
+	}
+}
+
+PostProcessTarget* PostProcessChain::FindTarget(std::string name)
+{
+	auto it = targetLookup.find(name);
+	if (it == targetLookup.end())
+		return 0;
+	return &targets[it->second];
+}
+
+// --------------------------------------------------------
+// (Re)creates the texture and views for one pooled entry
+// at its size relative to the window
+// --------------------------------------------------------
+void PostProcessChain::CreatePooledTexture(PooledTexture& tex)
+{
+	tex.RTV.Reset();
+	tex.SRV.Reset();
+	tex.Width = max(1u, (unsigned int)(width * tex.RelativeSize));
+	tex.Height = max(1u, (unsigned int)(height * tex.RelativeSize));
+
+	// Describe the texture we're creating
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = tex.Width;
+	textureDesc.Height = tex.Height;
+	textureDesc.ArraySize = 1;
+	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.Format = tex.Format;
+	textureDesc.MipLevels = 1;
+	textureDesc.MiscFlags = 0;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+
+	// Create the resource (no need to track it after the views are created below)
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Graphics::Api->CreateTexture2D(textureDesc, 0, texture.GetAddressOf());
+
+	// Create the Render Target View
+	D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+	rtvDesc.Format = textureDesc.Format;
+	rtvDesc.Texture2D.MipSlice = 0;
+	rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+	Graphics::Device->CreateRenderTargetView(texture.Get(), &rtvDesc, tex.RTV.ReleaseAndGetAddressOf());
+
+	// A null description gives a "default" SRV of the whole resource
+	Graphics::Device->CreateShaderResourceView(texture.Get(), 0, tex.SRV.ReleaseAndGetAddressOf());
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// A named render target used by the post process chain.
+// Targets are sized relative to the window and are backed
+// by a pooled texture picked when the chain is compiled
+// --------------------------------------------------------
+struct PostProcessTarget
+{
+	std::string Name;
+	DXGI_FORMAT Format;
+	float RelativeSize;	// Fraction of the window size (1 = full res)
+	bool External;		// Written outside the chain (like the scene)
+	int FirstUse;		// Index of the pass that writes it (-1 for external)
+	int LastUse;		// Index of the last pass that reads it
+	int PoolIndex;		// Which pooled texture backs this target
+};
+
+// --------------------------------------------------------
+// A single full screen pass in the chain
+// --------------------------------------------------------
+struct PostProcessPass
+{
+	std::string Name;
+	std::shared_ptr<SimplePixelShader> PS;
+
+	// Shader SRV name -> target name, bound before the draw
+	std::vector<std::pair<std::string, std::string>> Inputs;
+
+	// Target to render into, empty for the final output (back buffer)
+	std::string Output;
+
+	// Optional hook for setting per-pass shader data.  Receives
+	// the size of the texture being rendered into
+	std::function<void(SimplePixelShader* ps, unsigned int width, unsigned int height)> SetParams;
+
+	bool Enabled;
+	float GpuTime; // Milliseconds, from the most recent timed frame
+};
+
+// --------------------------------------------------------
+// A texture owned by the pool.  Several targets can share
+// one of these as long as their lifetimes don't overlap
+// --------------------------------------------------------
+struct PooledTexture
+{
+	DXGI_FORMAT Format;
+	float RelativeSize;
+	unsigned int Width;
+	unsigned int Height;
+	int LastUse; // Only used while aliasing
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RTV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> SRV;
+};
+
+// --------------------------------------------------------
+// Timestamp queries for one frame of the chain.  Several of
+// these are cycled so results are read a few frames late
+// instead of stalling on the GPU
+// --------------------------------------------------------
+struct PostProcessTimerFrame
+{
+	Microsoft::WRL::ComPtr<ID3D11Query> Disjoint;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> Timestamps; // One before, then one after each pass
+	std::vector<int> PassIndices; // Which passes were timed
+	bool Pending;
+};
+
+class PostProcessChain
+{
+public:
+	PostProcessChain(std::shared_ptr<SimpleVertexShader> fullscreenVS, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
+
+	// Declaring the chain
+	void AddTarget(std::string name, DXGI_FORMAT format, float relativeSize = 1.0f, bool external = false);
+	void AddPass(
+		std::string name,
+		std::shared_ptr<SimplePixelShader> ps,
+		std::vector<std::pair<std::string, std::string>> inputs,
+		std::string output,
+		std::function<void(SimplePixelShader*, unsigned int, unsigned int)> setParams = nullptr);
+	void SetPassEnabled(std::string name, bool enabled);
+	bool IsPassEnabled(std::string name);
+
+	// Works out target lifetimes and which targets can share textures
+	void Compile();
+
+	// Recreates any pooled textures whose size changed
+	void Resize(unsigned int width, unsigned int height);
+
+	// Runs every enabled pass, ending in the given render target
+	void Execute(ID3D11RenderTargetView* finalTarget);
+
+	// Getters
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> GetRenderTarget(std::string name);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetShaderResource(std::string name);
+	unsigned int GetTargetWidth(std::string name);
+	unsigned int GetTargetHeight(std::string name);
+	unsigned int GetPooledTextureCount();
+	size_t GetPooledMemory();
+
+	// Per pass GPU timing
+	void SetTimingEnabled(bool enabled);
+	bool IsTimingEnabled();
+	const std::vector<PostProcessPass>& GetPasses();
+	float GetPassTime(std::string name);
+
+private:
+	std::shared_ptr<SimpleVertexShader> vs;
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler;
+
+	std::vector<PostProcessPass> passes;
+	std::vector<PostProcessTarget> targets;
+	std::unordered_map<std::string, int> targetLookup;
+	std::vector<PooledTexture> pool;
+
+	// Outputs of disabled passes are read from their first input instead
+	std::unordered_map<std::string, std::string> redirects;
+
+	unsigned int width;
+	unsigned int height;
+	bool dirty;
+
+	bool timingEnabled;
+	std::vector<PostProcessTimerFrame> timerFrames;
+	unsigned int timerFrameIndex;
+
+	PostProcessTarget* FindTarget(std::string name);
+	void CreatePooledTexture(PooledTexture& tex);
+	void ReadTimers();
+};
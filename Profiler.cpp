@@ -0,0 +1,254 @@
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace
+{
+	// One per thread that has ever profiled anything.  The owning
+	// thread is the only writer of Head and EndFrame() the only
+	// writer of Tail, so neither side needs a lock
+	struct ThreadBuffer
+	{
+		ProfileEvent Events[PROFILER_THREAD_EVENTS];
+		std::atomic<unsigned int> Head;
+		std::atomic<unsigned int> Tail;
+		std::string Name;
+	};
+
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	// Guards the thread list, thread names and interned strings.
+	// Only taken when a thread first profiles, and once a frame
+	std::mutex registryLock;
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
+	std::unordered_set<std::string> internedNames;
+	std::atomic<unsigned long long> droppedEvents(0);
+
+	// Main thread only
+	std::deque<ProfileFrame> history;
+	unsigned long long frameIndex = 0;
+	long long frameStart = 0;
+
+	// Open scopes on this thread
+	thread_local ThreadBuffer* threadBuffer = 0;
+	thread_local unsigned int threadIndex = 0;
+	thread_local const char* scopeNames[PROFILER_MAX_DEPTH];
+	thread_local long long scopeStarts[PROFILER_MAX_DEPTH];
+	thread_local unsigned int scopeDepth = 0;
+
+	ThreadBuffer* GetThreadBuffer()
+	{
+		if (!threadBuffer)
+		{
+			std::lock_guard<std::mutex> guard(registryLock);
+			threads.push_back(std::make_unique<ThreadBuffer>());
+			threadBuffer = threads.back().get();
+			threadBuffer->Head = 0;
+			threadBuffer->Tail = 0;
+			threadIndex = (unsigned int)threads.size() - 1;
+			threadBuffer->Name = "Thread " + std::to_string(threadIndex);
+		}
+		return threadBuffer;
+	}
+
+	std::string EscapeJson(const char* text)
+	{
+		std::string escaped;
+		for (const char* c = text; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				escaped += '\\';
+			if ((unsigned char)*c >= 0x20)
+				escaped += *c;
+		}
+		return escaped;
+	}
+}
+
+long long Profiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> guard(registryLock);
+	buffer->Name = name;
+}
+
+unsigned int Profiler::GetThreadIndex()
+{
+	GetThreadBuffer();
+	return threadIndex;
+}
+
+const char* Profiler::Intern(const std::string& name)
+{
+	std::lock_guard<std::mutex> guard(registryLock);
+	return internedNames.insert(name).first->c_str();
+}
+
+void Profiler::BeginScope(const char* name)
+{
+	// Scopes past the maximum depth are still counted so they
+	// pair up, they just aren't recorded
+	if (scopeDepth < PROFILER_MAX_DEPTH)
+	{
+		scopeNames[scopeDepth] = name;
+		scopeStarts[scopeDepth] = Now();
+	}
+	scopeDepth++;
+}
+
+// --------------------------------------------------------
+// Writes the finished scope into this thread's ring.  If
+// the main thread hasn't drained it in time the event is
+// dropped rather than overwriting one it might be reading
+// --------------------------------------------------------
+void Profiler::EndScope()
+{
+	if (scopeDepth == 0)
+		return;
+	scopeDepth--;
+	if (scopeDepth >= PROFILER_MAX_DEPTH)
+		return;
+
+	long long end = Now();
+	ThreadBuffer* buffer = GetThreadBuffer();
+	unsigned int head = buffer->Head.load(std::memory_order_relaxed);
+	if (head - buffer->Tail.load(std::memory_order_acquire) >= PROFILER_THREAD_EVENTS)
+	{
+		droppedEvents++;
+		return;
+	}
+
+	ProfileEvent& e = buffer->Events[head % PROFILER_THREAD_EVENTS];
+	e.Name = scopeNames[scopeDepth];
+	e.StartNs = scopeStarts[scopeDepth];
+	e.EndNs = end;
+	e.Depth = scopeDepth;
+	e.Thread = threadIndex;
+	buffer->Head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::EndFrame()
+{
+	long long now = Now();
+
+	ProfileFrame frame = {};
+	frame.Index = frameIndex;
+	frame.StartNs = frameStart;
+	frame.EndNs = now;
+	{
+		std::lock_guard<std::mutex> guard(registryLock);
+		for (auto& t : threads)
+		{
+			unsigned int head = t->Head.load(std::memory_order_acquire);
+			unsigned int tail = t->Tail.load(std::memory_order_relaxed);
+			for (unsigned int i = tail; i != head; i++)
+				frame.Events.push_back(t->Events[i % PROFILER_THREAD_EVENTS]);
+			t->Tail.store(head, std::memory_order_release);
+		}
+	}
+
+	history.push_back(std::move(frame));
+	while (history.size() > PROFILER_HISTORY_FRAMES)
+		history.pop_front();
+
+	frameIndex++;
+	frameStart = now;
+}
+
+unsigned long long Profiler::GetFrameIndex()
+{
+	return frameIndex;
+}
+
+void Profiler::AddGpuEvents(unsigned long long frame, const std::vector<ProfileEvent>& events)
+{
+	// Frames in the history are consecutive
+	if (history.empty() || frame < history.front().Index || frame > history.back().Index)
+		return;
+
+	ProfileFrame& f = history[(size_t)(frame - history.front().Index)];
+	f.GpuEvents.insert(f.GpuEvents.end(), events.begin(), events.end());
+}
+
+const std::deque<ProfileFrame>& Profiler::GetHistory()
+{
+	return history;
+}
+
+std::vector<std::string> Profiler::GetThreadNames()
+{
+	std::lock_guard<std::mutex> guard(registryLock);
+	std::vector<std::string> names;
+	for (auto& t : threads)
+		names.push_back(t->Name);
+	return names;
+}
+
+unsigned long long Profiler::GetDroppedEvents()
+{
+	return droppedEvents;
+}
+
+// --------------------------------------------------------
+// Complete ("X") events, one row per thread, then a row for
+// the GPU and one marking where each frame starts and ends
+// --------------------------------------------------------
+bool Profiler::WriteChromeTrace(const std::wstring& path, unsigned int frameCount)
+{
+	std::ofstream file{ std::filesystem::path(path) };
+	if (!file)
+		return false;
+
+	std::vector<std::string> names = GetThreadNames();
+	unsigned int gpuRow = (unsigned int)names.size();
+	unsigned int frameRow = gpuRow + 1;
+	names.push_back("GPU");
+	names.push_back("Frames");
+
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	auto writeEvent = [&](const char* name, const char* category, long long startNs, long long endNs, unsigned int row)
+		{
+			file << (first ? "" : ",\n");
+			file << "{\"name\":\"" << EscapeJson(name) << "\",\"cat\":\"" << category << "\",\"ph\":\"X\""
+				<< ",\"ts\":" << startNs / 1000.0 << ",\"dur\":" << (endNs - startNs) / 1000.0
+				<< ",\"pid\":1,\"tid\":" << row << "}";
+			first = false;
+		};
+
+	for (unsigned int i = 0; i < names.size(); i++)
+	{
+		file << (first ? "" : ",\n");
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+			<< ",\"args\":{\"name\":\"" << EscapeJson(names[i].c_str()) << "\"}}";
+		first = false;
+	}
+
+	size_t begin = history.size() > frameCount ? history.size() - frameCount : 0;
+	for (size_t f = begin; f < history.size(); f++)
+	{
+		const ProfileFrame& frame = history[f];
+		std::string frameName = "Frame " + std::to_string(frame.Index);
+		writeEvent(frameName.c_str(), "frame", frame.StartNs, frame.EndNs, frameRow);
+		for (auto& e : frame.Events)
+			writeEvent(e.Name, "cpu", e.StartNs, e.EndNs, e.Thread);
+		for (auto& e : frame.GpuEvents)
+			writeEvent(e.Name, "gpu", e.StartNs, e.EndNs, gpuRow);
+	}
+
+	file << "\n]}\n";
+	return (bool)file;
+}
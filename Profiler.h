@@ -0,0 +1,95 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <vector>
+
+#define PROFILER_THREAD_EVENTS 4096	// Per thread ring buffer, drained once a frame
+#define PROFILER_MAX_DEPTH 64
+#define PROFILER_HISTORY_FRAMES 120
+
+// One finished scope.  Times are nanoseconds since the
+// profiler started; names must outlive the profiler (string
+// literals, or something from Profiler::Intern())
+struct ProfileEvent
+{
+	const char* Name;
+	long long StartNs;
+	long long EndNs;
+	unsigned int Depth;
+	unsigned int Thread;	// Index into Profiler::GetThreadNames()
+};
+
+// --------------------------------------------------------
+// Everything recorded during one frame.  GPU scopes arrive a
+// few frames late and are lined up with the start of the
+// CPU work that submitted them
+// --------------------------------------------------------
+struct ProfileFrame
+{
+	unsigned long long Index;
+	long long StartNs;
+	long long EndNs;
+	std::vector<ProfileEvent> Events;
+	std::vector<ProfileEvent> GpuEvents;
+};
+
+// --------------------------------------------------------
+// Hierarchical CPU profiler.  Each thread writes finished
+// scopes into its own ring buffer without taking a lock, and
+// the main thread drains them all at the end of each frame.
+// Nothing here touches the graphics API; see GpuProfiler for
+// the GPU side
+// --------------------------------------------------------
+namespace Profiler
+{
+	// Nanoseconds since the profiler started
+	long long Now();
+
+	// Label for the calling thread's row in the timeline and trace
+	void SetThreadName(const std::string& name);
+
+	// The calling thread's row, as used by ProfileEvent::Thread
+	unsigned int GetThreadIndex();
+
+	// Returns a copy of the string that lives as long as the program,
+	// for scope names that aren't literals
+	const char* Intern(const std::string& name);
+
+	// Scopes nest per thread, so each BeginScope() needs an
+	// EndScope() on the same thread.  Prefer PROFILE_SCOPE()
+	void BeginScope(const char* name);
+	void EndScope();
+
+	// Main thread, once per frame: collects every thread's scopes
+	// and starts the next frame
+	void EndFrame();
+	unsigned long long GetFrameIndex();
+
+	// Called by the GPU profiler once a frame's results are back.
+	// Ignored if the frame has already left the history
+	void AddGpuEvents(unsigned long long frameIndex, const std::vector<ProfileEvent>& events);
+
+	// Most recent frames, oldest first
+	const std::deque<ProfileFrame>& GetHistory();
+	std::vector<std::string> GetThreadNames();
+	unsigned long long GetDroppedEvents();
+
+	// Writes the last frameCount frames of history as Chrome trace
+	// event JSON (chrome://tracing, Perfetto).  GPU scopes get their
+	// own row.  Returns false if the file couldn't be written
+	bool WriteChromeTrace(const std::wstring& path, unsigned int frameCount);
+}
+
+// Times the enclosing block
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name) { Profiler::BeginScope(name); }
+	~ProfileScope() { Profiler::EndScope(); }
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
@@ -1,12 +1,12 @@
 #include "ShaderInclude.hlsli"
 #include "LightsInclude.hlsli"
+#include "CameraInclude.hlsli"
 cbuffer ExternalData : register(b0)
 {
     float3 colorTint;
     float roughness;
     float2 uvOffset;
     float2 uvScale;
-    float3 cameraPosition;
     float3 ambient;
     Light lights[5];
 }
@@ -26,6 +26,6 @@ float4 main(VertexToPixel input):SV_TARGET
    
     float3 viewVector = normalize(cameraPosition - input.worldPos);
     float3 reflVector = reflect(-viewVector, input.normal);
-    float3 reflectionColor = CubeMap.Sample(BasicSampler, reflVector).rgb;
+    float3 reflectionColor = pow(CubeMap.Sample(BasicSampler, reflVector).rgb, 2.2);
     return float4(reflectionColor, 1);
 }
\ No newline at end of file
@@ -0,0 +1,358 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <set>
+
+void RenderGraphPassBuilder::Read(RenderGraphResource resource)
+{
+	pass.Reads.push_back({ resource, false, RenderGraphStage::Pixel, 0 });
+}
+
+void RenderGraphPassBuilder::Read(RenderGraphResource resource, RenderGraphStage stage, unsigned int slot)
+{
+	pass.Reads.push_back({ resource, true, stage, slot });
+}
+
+void RenderGraphPassBuilder::Write(RenderGraphResource resource)
+{
+	pass.Writes.push_back(resource);
+}
+
+void RenderGraphPassBuilder::Overwrite(RenderGraphResource resource)
+{
+	pass.Writes.push_back(resource);
+	pass.Overwrites.push_back(resource);
+}
+
+void RenderGraphPassBuilder::SetSideEffects()
+{
+	pass.SideEffects = true;
+}
+
+RenderGraph::RenderGraph() :
+	compiled(false), unbindCount(0)
+{
+}
+
+void RenderGraph::Reset()
+{
+	passes.clear();
+	resources.clear();
+	executionOrder.clear();
+	physicalDescs.clear();
+	compiled = false;
+}
+
+// --------------------------------------------------------
+// Imports a resource the graph doesn't own, like the back
+// buffer or a shadow map that lives across frames
+// --------------------------------------------------------
+RenderGraphResource RenderGraph::ImportTexture(std::string name)
+{
+	RenderGraphResourceNode node = {};
+	node.Name = name;
+	node.Imported = true;
+	node.PhysicalIndex = -1;
+	resources.push_back(node);
+
+	// Give each import a stable key so bindings can be tracked across frames
+	// (negative, and never -1, so they can't clash with transients)
+	if (!importKeys.count(name))
+		importKeys[name] = -(int)importKeys.size() - 2;
+
+	compiled = false;
+	return (RenderGraphResource)resources.size() - 1;
+}
+
+// --------------------------------------------------------
+// Declares a texture that only lives for part of the frame.
+// Its memory comes from a physical texture that may be
+// shared with other transients
+// --------------------------------------------------------
+RenderGraphResource RenderGraph::CreateTexture(std::string name, RenderGraphTextureDesc desc)
+{
+	RenderGraphResourceNode node = {};
+	node.Name = name;
+	node.Imported = false;
+	node.Desc = desc;
+	node.PhysicalIndex = -1;
+	resources.push_back(node);
+
+	compiled = false;
+	return (RenderGraphResource)resources.size() - 1;
+}
+
+// --------------------------------------------------------
+// Marks a resource as a final result of the frame (like the
+// back buffer).  Passes that feed it are never culled
+// --------------------------------------------------------
+void RenderGraph::MarkOutput(RenderGraphResource resource)
+{
+	resources[resource].IsOutput = true;
+	compiled = false;
+}
+
+void RenderGraph::AddPass(std::string name, std::function<void(RenderGraphPassBuilder&)> setup, std::function<void()> execute)
+{
+	RenderGraphPassNode pass = {};
+	pass.Name = name;
+	pass.Execute = execute;
+	passes.push_back(pass);
+
+	RenderGraphPassBuilder builder(passes.back());
+	if (setup)
+		setup(builder);
+
+	compiled = false;
+}
+
+// --------------------------------------------------------
+// Works out which passes run, in what order, and which
+// physical texture backs each transient
+// --------------------------------------------------------
+void RenderGraph::Compile()
+{
+	// Walk backwards from the outputs, keeping any pass that
+	// writes something a later (kept) pass needs.  Nothing
+	// before an overwrite is needed, unless the pass reads it
+	std::set<RenderGraphResource> needed;
+	for (int r = 0; r < (int)resources.size(); r++)
+	{
+		if (resources[r].IsOutput)
+			needed.insert(r);
+	}
+
+	for (int i = (int)passes.size() - 1; i >= 0; i--)
+	{
+		RenderGraphPassNode& pass = passes[i];
+		bool keep = pass.SideEffects;
+		for (auto w : pass.Writes)
+			keep = keep || needed.count(w) > 0;
+
+		pass.Culled = !keep;
+		if (pass.Culled)
+			continue;
+
+		for (auto w : pass.Overwrites)
+			needed.erase(w);
+		for (auto& r : pass.Reads)
+			needed.insert(r.Resource);
+	}
+
+	// Passes run in the order they were declared
+	executionOrder.clear();
+	for (int i = 0; i < (int)passes.size(); i++)
+	{
+		if (!passes[i].Culled)
+			executionOrder.push_back(i);
+	}
+
+	// Transient lifetimes, in execution order
+	for (auto& r : resources)
+	{
+		r.FirstUse = -1;
+		r.LastUse = -1;
+		r.PhysicalIndex = -1;
+	}
+	for (int order = 0; order < (int)executionOrder.size(); order++)
+	{
+		RenderGraphPassNode& pass = passes[executionOrder[order]];
+		auto touch = [&](RenderGraphResource id)
+		{
+			RenderGraphResourceNode& r = resources[id];
+			if (r.FirstUse == -1) r.FirstUse = order;
+			r.LastUse = order;
+		};
+		for (auto& r : pass.Reads) touch(r.Resource);
+		for (auto w : pass.Writes) touch(w);
+	}
+
+	// Greedily alias transients in the order they come alive
+	std::vector<RenderGraphResource> transients;
+	for (int r = 0; r < (int)resources.size(); r++)
+	{
+		if (!resources[r].Imported && resources[r].FirstUse != -1)
+			transients.push_back(r);
+	}
+	std::stable_sort(transients.begin(), transients.end(),
+		[&](RenderGraphResource a, RenderGraphResource b) { return resources[a].FirstUse < resources[b].FirstUse; });
+
+	physicalDescs.clear();
+	std::vector<int> physicalLastUse;
+	for (auto id : transients)
+	{
+		RenderGraphResourceNode& r = resources[id];
+		int index = -1;
+		for (int p = 0; p < (int)physicalDescs.size(); p++)
+		{
+			if (physicalDescs[p] == r.Desc && physicalLastUse[p] < r.FirstUse)
+			{
+				index = p;
+				break;
+			}
+		}
+
+		if (index == -1)
+		{
+			index = (int)physicalDescs.size();
+			physicalDescs.push_back(r.Desc);
+			physicalLastUse.push_back(-1);
+		}
+
+		physicalLastUse[index] = r.LastUse;
+		r.PhysicalIndex = index;
+	}
+
+	compiled = true;
+}
+
+// --------------------------------------------------------
+// Runs the compiled passes.  Before each pass, anything it
+// writes that's still bound as a shader input is unbound,
+// and if it reads something still bound as an output the
+// render targets are cleared.  Nothing else is touched
+// --------------------------------------------------------
+void RenderGraph::Execute(IRenderGraphBackend& backend)
+{
+	if (!compiled)
+		Compile();
+
+	// Only (re)create physical textures whose description changed
+	for (unsigned int p = 0; p < physicalDescs.size(); p++)
+	{
+		if (p < realizedDescs.size() && realizedDescs[p] == physicalDescs[p])
+			continue;
+
+		backend.CreateTexture(p, physicalDescs[p]);
+		if (p < realizedDescs.size())
+			realizedDescs[p] = physicalDescs[p];
+		else
+			realizedDescs.push_back(physicalDescs[p]);
+	}
+	while (realizedDescs.size() > physicalDescs.size())
+	{
+		backend.ReleaseTexture((unsigned int)realizedDescs.size() - 1);
+		realizedDescs.pop_back();
+	}
+
+	unbindCount = 0;
+	for (int index : executionOrder)
+	{
+		RenderGraphPassNode& pass = passes[index];
+
+		// Write-after-read: unbind inputs we're about to write
+		for (auto w : pass.Writes)
+		{
+			int key = BindingKey(w);
+			for (auto it = boundReads.begin(); it != boundReads.end();)
+			{
+				if (it->second == key)
+				{
+					backend.UnbindShaderResource(it->first.first, it->first.second);
+					unbindCount++;
+					it = boundReads.erase(it);
+				}
+				else
+				{
+					it++;
+				}
+			}
+		}
+
+		// Read-after-write: unbind outputs we're about to read
+		for (auto& r : pass.Reads)
+		{
+			int key = BindingKey(r.Resource);
+			if (std::find(boundOutputs.begin(), boundOutputs.end(), key) != boundOutputs.end())
+			{
+				backend.UnbindRenderTargets();
+				unbindCount++;
+				boundOutputs.clear();
+				break;
+			}
+		}
+
+		backend.BeginPass(pass.Name);
+		if (pass.Execute)
+			pass.Execute();
+		backend.EndPass(pass.Name);
+
+		// Remember what this pass left bound
+		boundOutputs.clear();
+		for (auto w : pass.Writes)
+			boundOutputs.push_back(BindingKey(w));
+		for (auto& r : pass.Reads)
+		{
+			if (r.Tracked)
+				boundReads[{ r.Stage, r.Slot }] = BindingKey(r.Resource);
+		}
+	}
+}
+
+bool RenderGraph::IsPassCulled(std::string name)
+{
+	for (auto& p : passes)
+	{
+		if (p.Name == name)
+			return p.Culled;
+	}
+	return true;
+}
+
+int RenderGraph::GetPhysicalIndex(RenderGraphResource resource)
+{
+	return resources[resource].PhysicalIndex;
+}
+
+unsigned int RenderGraph::GetCulledPassCount()
+{
+	return (unsigned int)(passes.size() - executionOrder.size());
+}
+
+// --------------------------------------------------------
+// Imports are keyed by name and transients by their physical
+// texture, so the same memory is recognized across frames
+// and across aliased transients
+// --------------------------------------------------------
+int RenderGraph::BindingKey(RenderGraphResource resource)
+{
+	RenderGraphResourceNode& r = resources[resource];
+	if (r.Imported)
+		return importKeys[r.Name];
+	return r.PhysicalIndex;
+}
+
+void RenderGraphRecordingBackend::CreateTexture(unsigned int physicalIndex, const RenderGraphTextureDesc& /*desc*/)
+{
+	Events.push_back("CreateTexture " + std::to_string(physicalIndex));
+}
+
+void RenderGraphRecordingBackend::ReleaseTexture(unsigned int physicalIndex)
+{
+	Events.push_back("ReleaseTexture " + std::to_string(physicalIndex));
+}
+
+void RenderGraphRecordingBackend::UnbindShaderResource(RenderGraphStage stage, unsigned int slot)
+{
+	Events.push_back("UnbindSRV " + std::to_string((int)stage) + " " + std::to_string(slot));
+}
+
+void RenderGraphRecordingBackend::UnbindRenderTargets()
+{
+	Events.push_back("UnbindRenderTargets");
+}
+
+void RenderGraphRecordingBackend::BeginPass(const std::string& name)
+{
+	Events.push_back("Pass " + name);
+}
+
+std::vector<std::string> RenderGraphRecordingBackend::GetPassOrder()
+{
+	std::vector<std::string> order;
+	for (auto& e : Events)
+	{
+		if (e.rfind("Pass ", 0) == 0)
+			order.push_back(e.substr(5));
+	}
+	return order;
+}
@@ -0,0 +1,210 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// A small render graph.  Passes declare which resources they
+// read and write, then the graph:
+//  - Culls passes whose results are never used
+//  - Works out the lifetime of each transient texture
+//  - Lets transient textures with matching descriptions share
+//    memory when their lifetimes don't overlap
+//  - Unbinds shader resources only when a pass is about to
+//    write something that's still bound as an input
+//
+// Nothing in here touches the graphics API directly; that's
+// all done through an IRenderGraphBackend.  The tests drive
+// it with RenderGraphRecordingBackend
+// --------------------------------------------------------
+
+// Handle to a resource declared in the graph
+typedef int RenderGraphResource;
+
+// Shader stages a resource can be read from
+enum class RenderGraphStage
+{
+	Vertex,
+	Pixel,
+	Compute
+};
+
+// Description of a transient texture.  Format holds the
+// raw DXGI_FORMAT value so this header stays API free
+struct RenderGraphTextureDesc
+{
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int Format;
+	bool DepthStencil;
+};
+
+inline bool operator==(const RenderGraphTextureDesc& a, const RenderGraphTextureDesc& b)
+{
+	return a.Width == b.Width && a.Height == b.Height && a.Format == b.Format && a.DepthStencil == b.DepthStencil;
+}
+inline bool operator!=(const RenderGraphTextureDesc& a, const RenderGraphTextureDesc& b) { return !(a == b); }
+
+// --------------------------------------------------------
+// What the graph needs from the graphics API
+// --------------------------------------------------------
+class IRenderGraphBackend
+{
+public:
+	virtual ~IRenderGraphBackend() = default;
+
+	// Creates the texture for an aliased (physical) slot,
+	// replacing whatever was there before
+	virtual void CreateTexture(unsigned int physicalIndex, const RenderGraphTextureDesc& desc) = 0;
+	virtual void ReleaseTexture(unsigned int physicalIndex) = 0;
+
+	// Clears a single shader resource slot
+	virtual void UnbindShaderResource(RenderGraphStage stage, unsigned int slot) = 0;
+
+	// Clears all bound render targets and depth buffer
+	virtual void UnbindRenderTargets() = 0;
+
+	// Called right before and after each pass that isn't culled runs
+	virtual void BeginPass(const std::string& /*name*/) {}
+	virtual void EndPass(const std::string& /*name*/) {}
+};
+
+// --------------------------------------------------------
+// Backend that only writes down what the graph asked for,
+// so pass order and hazard handling can be checked without
+// a GPU.  Events look like "Pass Scene" or "UnbindSRV 1 4"
+// --------------------------------------------------------
+class RenderGraphRecordingBackend : public IRenderGraphBackend
+{
+public:
+	void CreateTexture(unsigned int physicalIndex, const RenderGraphTextureDesc& desc) override;
+	void ReleaseTexture(unsigned int physicalIndex) override;
+	void UnbindShaderResource(RenderGraphStage stage, unsigned int slot) override;
+	void UnbindRenderTargets() override;
+	void BeginPass(const std::string& name) override;
+
+	// Names of the passes that ran, in order
+	std::vector<std::string> GetPassOrder();
+
+	std::vector<std::string> Events;
+};
+
+// A resource read by a pass.  Tracked reads remember which
+// slot they end up bound to so hazards can be resolved
+struct RenderGraphRead
+{
+	RenderGraphResource Resource;
+	bool Tracked;
+	RenderGraphStage Stage;
+	unsigned int Slot;
+};
+
+struct RenderGraphPassNode
+{
+	std::string Name;
+	std::vector<RenderGraphRead> Reads;
+	std::vector<RenderGraphResource> Writes;
+	std::vector<RenderGraphResource> Overwrites; // Also in Writes
+	bool SideEffects;
+	bool Culled;
+	std::function<void()> Execute;
+};
+
+struct RenderGraphResourceNode
+{
+	std::string Name;
+	bool Imported;
+	bool IsOutput;
+	RenderGraphTextureDesc Desc;
+	int FirstUse;		// Position in the execution order
+	int LastUse;
+	int PhysicalIndex;	// -1 for imported resources
+};
+
+// --------------------------------------------------------
+// Handed to a pass's setup function to declare its inputs
+// and outputs
+// --------------------------------------------------------
+class RenderGraphPassBuilder
+{
+public:
+	RenderGraphPassBuilder(RenderGraphPassNode& pass) : pass(pass) {}
+
+	// Read without tracking the binding (dependency only)
+	void Read(RenderGraphResource resource);
+
+	// Read that ends up bound to a specific shader slot
+	void Read(RenderGraphResource resource, RenderGraphStage stage, unsigned int slot);
+
+	// Render target, depth buffer or UAV output
+	void Write(RenderGraphResource resource);
+
+	// Write that replaces everything in the resource, like a
+	// clear.  Earlier writes to it are no longer needed, so
+	// passes that only made those get culled
+	void Overwrite(RenderGraphResource resource);
+
+	// Never cull this pass, even if nothing uses its output
+	void SetSideEffects();
+
+private:
+	RenderGraphPassNode& pass;
+};
+
+class RenderGraph
+{
+public:
+	RenderGraph();
+
+	// Clears all passes and resources, but keeps the physical
+	// textures and binding state so rebuilding every frame is cheap
+	void Reset();
+
+	// Declaring resources
+	RenderGraphResource ImportTexture(std::string name);
+	RenderGraphResource CreateTexture(std::string name, RenderGraphTextureDesc desc);
+	void MarkOutput(RenderGraphResource resource);
+
+	// Declaring passes
+	void AddPass(
+		std::string name,
+		std::function<void(RenderGraphPassBuilder&)> setup,
+		std::function<void()> execute);
+
+	// Culls, orders and aliases.  Pure CPU work
+	void Compile();
+
+	// Creates any physical textures that changed, then runs
+	// the passes, unbinding hazards as they come up
+	void Execute(IRenderGraphBackend& backend);
+
+	// Results of compiling
+	bool IsPassCulled(std::string name);
+	const std::vector<int>& GetExecutionOrder() { return executionOrder; }
+	const RenderGraphPassNode& GetPass(int index) { return passes[index]; }
+	const RenderGraphResourceNode& GetResource(RenderGraphResource resource) { return resources[resource]; }
+	int GetPhysicalIndex(RenderGraphResource resource);
+	unsigned int GetPhysicalTextureCount() { return (unsigned int)physicalDescs.size(); }
+
+	// Results of the last execute
+	unsigned int GetUnbindCount() { return unbindCount; }
+	unsigned int GetCulledPassCount();
+
+private:
+	std::vector<RenderGraphPassNode> passes;
+	std::vector<RenderGraphResourceNode> resources;
+	std::vector<int> executionOrder;
+	std::vector<RenderGraphTextureDesc> physicalDescs;
+	bool compiled;
+
+	// Persistent across Reset() so state carries between frames
+	std::vector<RenderGraphTextureDesc> realizedDescs;
+	std::unordered_map<std::string, int> importKeys;
+	std::map<std::pair<RenderGraphStage, unsigned int>, int> boundReads;
+	std::vector<int> boundOutputs;
+	unsigned int unbindCount;
+
+	int BindingKey(RenderGraphResource resource);
+};
@@ -0,0 +1,111 @@
+#include "RenderGraphBackendD3D11.h"
+#include "Graphics.h"
+
+// --------------------------------------------------------
+// Creates the texture (and views) for one physical slot.
+// Depth textures are typeless so they can also be sampled
+// --------------------------------------------------------
+void RenderGraphBackendD3D11::CreateTexture(unsigned int physicalIndex, const RenderGraphTextureDesc& desc)
+{
+	if (physicalIndex >= textures.size())
+		textures.resize(physicalIndex + 1);
+
+	PhysicalTexture& tex = textures[physicalIndex];
+	tex = {};
+
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = desc.Width;
+	textureDesc.Height = desc.Height;
+	textureDesc.ArraySize = 1;
+	textureDesc.MipLevels = 1;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.Format = desc.DepthStencil ? DXGI_FORMAT_R32_TYPELESS : (DXGI_FORMAT)desc.Format;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE |
+		(desc.DepthStencil ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET);
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Graphics::Api->CreateTexture2D(textureDesc, 0, texture.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+
+	if (desc.DepthStencil)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+		dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
+		dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		Graphics::Device->CreateDepthStencilView(texture.Get(), &dsvDesc, tex.DSV.GetAddressOf());
+		srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	}
+	else
+	{
+		Graphics::Device->CreateRenderTargetView(texture.Get(), 0, tex.RTV.GetAddressOf());
+		srvDesc.Format = textureDesc.Format;
+	}
+	Graphics::Device->CreateShaderResourceView(texture.Get(), &srvDesc, tex.SRV.GetAddressOf());
+}
+
+void RenderGraphBackendD3D11::ReleaseTexture(unsigned int physicalIndex)
+{
+	if (physicalIndex < textures.size())
+		textures[physicalIndex] = {};
+}
+
+void RenderGraphBackendD3D11::UnbindShaderResource(RenderGraphStage stage, unsigned int slot)
+{
+	ID3D11ShaderResourceView* nullSRV = 0;
+	switch (stage)
+	{
+	case RenderGraphStage::Vertex: Graphics::Context->VSSetShaderResources(slot, 1, &nullSRV); break;
+	case RenderGraphStage::Pixel: Graphics::Context->PSSetShaderResources(slot, 1, &nullSRV); break;
+	case RenderGraphStage::Compute: Graphics::Context->CSSetShaderResources(slot, 1, &nullSRV); break;
+	}
+}
+
+void RenderGraphBackendD3D11::UnbindRenderTargets()
+{
+	Graphics::Context->OMSetRenderTargets(0, 0, 0);
+}
+
+void RenderGraphBackendD3D11::BeginPass(const std::string& name)
+{
+	const char* scopeName = Profiler::Intern(name);
+	Profiler::BeginScope(scopeName);
+	if (gpuProfiler)
+		gpuProfiler->BeginScope(scopeName);
+}
+
+void RenderGraphBackendD3D11::EndPass(const std::string& /*name*/)
+{
+	if (gpuProfiler)
+		gpuProfiler->EndScope();
+	Profiler::EndScope();
+}
+
+void RenderGraphBackendD3D11::SetGpuProfiler(std::shared_ptr<GpuProfiler> profiler)
+{
+	gpuProfiler = profiler;
+}
+
+Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RenderGraphBackendD3D11::GetRenderTarget(int physicalIndex)
+{
+	if (physicalIndex < 0 || physicalIndex >= (int)textures.size())
+		return 0;
+	return textures[physicalIndex].RTV;
+}
+
+Microsoft::WRL::ComPtr<ID3D11DepthStencilView> RenderGraphBackendD3D11::GetDepthStencil(int physicalIndex)
+{
+	if (physicalIndex < 0 || physicalIndex >= (int)textures.size())
+		return 0;
+	return textures[physicalIndex].DSV;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> RenderGraphBackendD3D11::GetShaderResource(int physicalIndex)
+{
+	if (physicalIndex < 0 || physicalIndex >= (int)textures.size())
+		return 0;
+	return textures[physicalIndex].SRV;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "RenderGraph.h"
+#include "GpuProfiler.h"
+
+// --------------------------------------------------------
+// Render graph backend that creates real D3D11 textures and
+// unbinds through Graphics::Context.  Each pass is also a
+// CPU profiler scope, and a GPU one if a profiler is set
+// --------------------------------------------------------
+class RenderGraphBackendD3D11 : public IRenderGraphBackend
+{
+public:
+	void CreateTexture(unsigned int physicalIndex, const RenderGraphTextureDesc& desc) override;
+	void ReleaseTexture(unsigned int physicalIndex) override;
+	void UnbindShaderResource(RenderGraphStage stage, unsigned int slot) override;
+	void UnbindRenderTargets() override;
+	void BeginPass(const std::string& name) override;
+	void EndPass(const std::string& name) override;
+
+	void SetGpuProfiler(std::shared_ptr<GpuProfiler> profiler);
+
+	// Views of the physical textures, for pass execute functions
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> GetRenderTarget(int physicalIndex);
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> GetDepthStencil(int physicalIndex);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetShaderResource(int physicalIndex);
+
+private:
+	struct PhysicalTexture
+	{
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RTV;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DSV;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> SRV;
+	};
+	std::vector<PhysicalTexture> textures;
+	std::shared_ptr<GpuProfiler> gpuProfiler;
+};
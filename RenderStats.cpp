@@ -0,0 +1,64 @@
+#include "RenderStats.h"
+#include "GraphicsDevice.h"
+#include <atomic>
+
+namespace
+{
+	std::atomic<unsigned long long> shaderSets(0);
+	std::atomic<unsigned long long> constantBufferBytes(0);
+	std::atomic<unsigned long long> materialBinds(0);
+
+	// Main thread only
+	GraphicsDeviceStats lastTotals = {};
+	RenderStatsFrame lastFrame = {};
+	std::deque<RenderStatsFrame> history;
+}
+
+void RenderStats::CountShaderSet()
+{
+	shaderSets.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RenderStats::CountConstantBufferBytes(unsigned int bytes)
+{
+	constantBufferBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void RenderStats::CountMaterialBind()
+{
+	materialBinds.fetch_add(1, std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// The first frame is measured from the device's creation, so
+// it includes everything made while loading
+// --------------------------------------------------------
+void RenderStats::EndFrame(const GraphicsDeviceStats& deviceTotals)
+{
+	RenderStatsFrame frame = {};
+	frame.DrawCalls = deviceTotals.DrawCalls - lastTotals.DrawCalls;
+	frame.Triangles = deviceTotals.Triangles - lastTotals.Triangles;
+	frame.ShaderResourceBinds = deviceTotals.ShaderResourceBinds - lastTotals.ShaderResourceBinds;
+	frame.SamplerBinds = deviceTotals.SamplerBinds - lastTotals.SamplerBinds;
+	frame.ResourcesCreated = deviceTotals.ResourcesCreated - lastTotals.ResourcesCreated;
+	frame.ShaderSets = shaderSets.exchange(0, std::memory_order_relaxed);
+	frame.ConstantBufferBytes = constantBufferBytes.exchange(0, std::memory_order_relaxed);
+	frame.MaterialBinds = materialBinds.exchange(0, std::memory_order_relaxed);
+
+	lastTotals = deviceTotals;
+	lastFrame = frame;
+
+	history.push_back(frame);
+	while (history.size() > RENDER_STATS_HISTORY_FRAMES)
+		history.pop_front();
+}
+
+const RenderStatsFrame& RenderStats::GetLastFrame()
+{
+	return lastFrame;
+}
+
+const std::deque<RenderStatsFrame>& RenderStats::GetHistory()
+{
+	return history;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <deque>
+
+#define RENDER_STATS_HISTORY_FRAMES 240
+
+// Only read from, so this header stays API free
+struct GraphicsDeviceStats;
+
+// Submission work done in one frame
+struct RenderStatsFrame
+{
+	unsigned long long DrawCalls;
+	unsigned long long Triangles;
+	unsigned long long ShaderSets;			// ISimpleShader::SetShader() calls
+	unsigned long long ShaderResourceBinds;
+	unsigned long long SamplerBinds;
+	unsigned long long ConstantBufferBytes;	// Copied by CopyAllBufferData()/CopyBufferData()
+	unsigned long long MaterialBinds;		// Material::PrepareMaterials() calls
+	unsigned long long ResourcesCreated;
+};
+
+// --------------------------------------------------------
+// Per-frame counts of what the CPU asked the GPU to do, to
+// spot scenes that are bound by submission rather than by
+// the GPU.  Draws, triangles, binds and creations come from
+// the totals Graphics::Api keeps; the rest are counted by
+// the shader and material code itself.  Counting is safe
+// from any thread, as parallel recording needs
+// --------------------------------------------------------
+namespace RenderStats
+{
+	void CountShaderSet();
+	void CountConstantBufferBytes(unsigned int bytes);
+	void CountMaterialBind();
+
+	// Main thread, once per frame, with the device's running
+	// totals: closes this frame's counts and starts the next
+	void EndFrame(const GraphicsDeviceStats& deviceTotals);
+
+	// All zero until the first EndFrame()
+	const RenderStatsFrame& GetLastFrame();
+
+	// Most recent frames, oldest first
+	const std::deque<RenderStatsFrame>& GetHistory();
+}
@@ -0,0 +1,175 @@
+#include "SceneSimulation.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX;
+
+SceneSimulation::SceneSimulation(std::shared_ptr<JobSystem> jobs) :
+	jobs(jobs), frame(0), displayedFrame(0), displayedMs(0.0f), displayedSteps(0), displayedAlpha(0.0f)
+{
+}
+
+SceneSimulation::~SceneSimulation()
+{
+	// A simulation job may still be writing a frame packet
+	jobs->Wait(counter);
+}
+
+// --------------------------------------------------------
+// Starts the simulation over from where the entities are now.
+// It works on its own copy of everything it needs, so the
+// job never reads the entities themselves
+// --------------------------------------------------------
+void SceneSimulation::Reset(const std::vector<std::shared_ptr<GameEntity>>& entities)
+{
+	jobs->Wait(counter);
+	transforms.clear();
+	animations.clear();
+	origins.clear();
+	for (auto& e : entities)
+	{
+		transforms.push_back(*e->GetTransform());
+		animations.push_back(e->GetAnimation());
+		origins.push_back(e->GetTransform()->GetPosition());
+	}
+	previous.clear();
+}
+
+// --------------------------------------------------------
+// Whole fixed steps for the time that's passed.  What's left
+// over says how far to blend between the last two of them.
+// Finishes whatever's in flight, then hands the newest frame
+// to the entities.  Pipelined, the frame after it simulates
+// in the meantime
+// --------------------------------------------------------
+void SceneSimulation::Update(float deltaTime, const std::vector<std::shared_ptr<GameEntity>>& entities, bool animate, unsigned int grainSize)
+{
+	unsigned int steps = timestep.Advance(deltaTime);
+	float step = (float)timestep.GetStep();
+	float simTime = (float)timestep.GetTime();
+	float alpha = settings.Interpolate ? (float)timestep.GetAlpha() : 1.0f;
+
+	{
+		PROFILE_SCOPE("Wait for Simulation");
+		jobs->Wait(counter);
+	}
+	if (settings.Pipelined)
+	{
+		const FramePacket* packet = pipeline.AcquireLatest();
+		if (packet)
+			ApplyFramePacket(*packet, entities);
+		// As a background job so the waits below never pick it up
+		// and run it inline on this thread
+		jobs->RunBackground([this, steps, step, simTime, alpha, animate, grainSize]()
+			{
+				Simulate(steps, step, simTime, alpha, animate, grainSize);
+			}, counter);
+	}
+	else
+	{
+		Simulate(steps, step, simTime, alpha, animate, grainSize);
+		ApplyFramePacket(*pipeline.AcquireLatest(), entities);
+	}
+}
+
+// --------------------------------------------------------
+// The simulation stage: advances the transforms by whole
+// fixed steps and publishes them, along with the state from
+// before the latest step, as a frame packet.  It never reads
+// or writes anything the renderer uses, so it's safe to run
+// as a job while the previous frame draws
+// --------------------------------------------------------
+void SceneSimulation::Simulate(unsigned int steps, float step, float time, float alpha, bool animate, unsigned int grainSize)
+{
+	PROFILE_SCOPE("Simulate");
+	auto start = std::chrono::steady_clock::now();
+	unsigned int count = (unsigned int)transforms.size();
+
+	auto snapshot = [&](std::vector<EntitySnapshot>& snapshots)
+		{
+			snapshots.resize(count);
+			for (unsigned int i = 0; i < count; i++)
+			{
+				Transform& t = transforms[i];
+				snapshots[i] = { t.GetPosition(), t.GetPitchYawRoll(), t.GetScale() };
+			}
+		};
+
+	// Nothing to blend from yet
+	if (previous.size() != count)
+		snapshot(previous);
+
+	for (unsigned int s = 0; s < steps; s++)
+	{
+		if (s == steps - 1)
+			snapshot(previous);
+		if (!animate)
+			continue;
+
+		// Time at the end of this step
+		float stepTime = time - (steps - 1 - s) * step;
+		float wave = (float)sin(stepTime);
+		jobs->ParallelFor(count, grainSize, [&](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; i++)
+				{
+					unsigned int animation = animations[i];
+					if (animation & ENTITY_ANIMATE_SPIN)
+						transforms[i].Rotate(0, step, 0);
+					if (animation & (ENTITY_ANIMATE_BOB | ENTITY_ANIMATE_SWAY))
+					{
+						XMFLOAT3 pos = transforms[i].GetPosition();
+						if (animation & ENTITY_ANIMATE_BOB)
+							pos.y = origins[i].y + wave;
+						if (animation & ENTITY_ANIMATE_SWAY)
+							pos.x = origins[i].x + wave * 2;
+						transforms[i].SetPosition(pos);
+					}
+				}
+			});
+	}
+
+	FramePacket& packet = pipeline.BeginWrite();
+	packet.Frame = ++frame;
+	packet.DeltaTime = steps * step;
+	packet.TotalTime = time;
+	packet.Steps = steps;
+	packet.Alpha = alpha;
+	packet.Previous = previous;
+	snapshot(packet.Entities);
+	packet.SimulationMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	pipeline.Publish();
+}
+
+// --------------------------------------------------------
+// Copies a finished simulation frame onto the entities, which
+// everything after this renders from.  Each transform is
+// blended between the packet's last two steps, so motion
+// stays smooth when the frame rate and the simulation rate
+// don't line up
+// --------------------------------------------------------
+void SceneSimulation::ApplyFramePacket(const FramePacket& packet, const std::vector<std::shared_ptr<GameEntity>>& entities)
+{
+	for (size_t i = 0; i < packet.Entities.size() && i < entities.size(); i++)
+	{
+		const EntitySnapshot& to = packet.Entities[i];
+		const EntitySnapshot& from = i < packet.Previous.size() ? packet.Previous[i] : to;
+		auto blend = [&](const XMFLOAT3& a, const XMFLOAT3& b)
+			{
+				XMFLOAT3 result;
+				XMStoreFloat3(&result, XMVectorLerp(XMLoadFloat3(&a), XMLoadFloat3(&b), packet.Alpha));
+				return result;
+			};
+
+		XMFLOAT3 scale = blend(from.Scale, to.Scale);
+		std::shared_ptr<Transform> t = entities[i]->GetTransform();
+		t->SetPosition(blend(from.Position, to.Position));
+		t->SetRotation(blend(from.PitchYawRoll, to.PitchYawRoll));
+		t->SetScale(scale.x, scale.y, scale.z);
+	}
+	displayedFrame = packet.Frame;
+	displayedMs = packet.SimulationMs;
+	displayedSteps = packet.Steps;
+	displayedAlpha = packet.Alpha;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "FramePipeline.h"
+#include "FrameTiming.h"
+#include "GameEntity.h"
+#include "JobSystem.h"
+#include "Transform.h"
+
+// --------------------------------------------------------
+// Everything that can be changed from the UI
+// --------------------------------------------------------
+struct SceneSimulationSettings
+{
+	bool Pipelined = true;		// Simulate the next frame while this one renders
+	bool Interpolate = true;	// Blend between the last two steps
+};
+
+// --------------------------------------------------------
+// Entity animation in fixed steps, whatever the frame rate.
+// It runs on its own copy of the transforms and hands
+// finished frames to the renderer through a FramePipeline.
+// Pipelined, the next frame simulates as a background job
+// while this one renders.  What's drawn is blended between
+// the last two steps
+// --------------------------------------------------------
+class SceneSimulation
+{
+public:
+	SceneSimulation(std::shared_ptr<JobSystem> jobs);
+	~SceneSimulation();
+
+	// Starts the simulation over from where the entities are now
+	void Reset(const std::vector<std::shared_ptr<GameEntity>>& entities);
+
+	// Adds a frame's time, copies the newest finished frame onto
+	// the entities and starts simulating the next one
+	void Update(float deltaTime, const std::vector<std::shared_ptr<GameEntity>>& entities, bool animate, unsigned int grainSize);
+
+	// Getters
+	SceneSimulationSettings& GetSettings() { return settings; }
+	FixedTimestep& GetTimestep() { return timestep; }
+	FramePipeline& GetPipeline() { return pipeline; }
+
+	// About the frame the entities were last given
+	unsigned long long GetDisplayedFrame() { return displayedFrame; }
+	float GetDisplayedSimulationMs() { return displayedMs; }
+	unsigned int GetDisplayedSteps() { return displayedSteps; }
+	float GetDisplayedAlpha() { return displayedAlpha; }
+
+private:
+	void Simulate(unsigned int steps, float step, float time, float alpha, bool animate, unsigned int grainSize);
+	void ApplyFramePacket(const FramePacket& packet, const std::vector<std::shared_ptr<GameEntity>>& entities);
+
+	std::shared_ptr<JobSystem> jobs;
+	JobCounter counter;
+	SceneSimulationSettings settings;
+	FixedTimestep timestep;
+	FramePipeline pipeline;
+
+	// Only the simulation touches these
+	std::vector<Transform> transforms;
+	std::vector<unsigned int> animations; // Each entity's ENTITY_ANIMATE_ flags
+	std::vector<DirectX::XMFLOAT3> origins; // Where each entity started
+	std::vector<EntitySnapshot> previous; // State before the latest step
+	unsigned long long frame;
+
+	unsigned long long displayedFrame;
+	float displayedMs;
+	unsigned int displayedSteps;
+	float displayedAlpha;
+};
@@ -12,9 +12,34 @@ struct VertexShaderInput
 	//  |    |                |
 	//  v    v                v
     float3 localPosition : POSITION; // XYZ position
-    float2 uv : TEXCOORD;
-    float3 normal : NORMAL;
-    float3 tangent : TANGENT;
+    uint uv : TEXCOORD;     // Two halfs, see PackedVertex in Vertex.h
+    uint normal : NORMAL;   // Octahedral, two snorm16s
+    uint tangent : TANGENT; // Octahedral, two snorm16s
+};
+
+// Unpacks two halfs, x from the low 16 bits
+float2 DecodeHalf2(uint packed)
+{
+    return float2(f16tof32(packed), f16tof32(packed >> 16));
+}
+
+// Unpacks an octahedral encoded unit vector stored as two
+// snorm16s.  Must match VertexCompression::DecodeOctahedral()
+float3 DecodeOctahedral(uint packed)
+{
+    int2 bits = asint(uint2(packed << 16, packed)) >> 16; // Sign extend
+    float2 e = max(bits / 32767.0f, -1.0f);
+    float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0f);
+    v.xy += v.xy >= 0.0f ? -t : t;
+    return normalize(v);
+}
+
+// Input for depth only passes.  Only reads POSITION, so it works
+// with both the full vertex buffer and the position only stream
+struct VertexShaderPositionInput
+{
+    float3 localPosition : POSITION;
 };
 
 // Struct representing the data we're sending down the pipeline
@@ -35,7 +60,6 @@ struct VertexToPixel
     float3 normal : NORMAL;
     float3 tangent : TANGENT;
     float3 worldPos : POSITION;
-    float4 shadowMapPos : SHADOW_POSITION;
 };
 struct Sky_VertexToPixel
 {
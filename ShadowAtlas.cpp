@@ -0,0 +1,248 @@
+#include "ShadowAtlas.h"
+#include <algorithm>
+
+ShadowAtlas::ShadowAtlas(unsigned int atlasSize, unsigned int minTileSize) :
+	atlasSize(atlasSize), minTileSize(minTileSize), newTiles(0)
+{
+	freeTiles[atlasSize].insert({ 0, 0 });
+}
+
+// --------------------------------------------------------
+// Frees anything that went away or changed size first, so
+// the space is available, then goes through the groups in
+// order of importance.  A group that doesn't fit evicts the
+// least important groups still holding tiles, one at a time,
+// and gives up (keeping nothing) once there are none left
+// --------------------------------------------------------
+void ShadowAtlas::Update(std::vector<ShadowAtlasRequest> requests)
+{
+	// A group is as important as its most important request
+	std::vector<std::vector<ShadowAtlasRequest>> groups;
+	std::vector<float> importance;
+	std::map<unsigned int, size_t> groupIndex;
+	for (auto& r : requests)
+	{
+		auto it = groupIndex.find(r.Group);
+		if (it == groupIndex.end())
+		{
+			it = groupIndex.insert({ r.Group, groups.size() }).first;
+			groups.push_back({});
+			importance.push_back(r.Importance);
+		}
+		groups[it->second].push_back(r);
+		importance[it->second] = std::max(importance[it->second], r.Importance);
+	}
+
+	std::vector<size_t> order(groups.size());
+	for (size_t g = 0; g < order.size(); g++)
+		order[g] = g;
+	std::stable_sort(order.begin(), order.end(),
+		[&](size_t a, size_t b) { return importance[a] > importance[b]; });
+
+	std::map<unsigned int, unsigned int> wanted;
+	for (auto& r : requests)
+		wanted[r.Key] = std::clamp(r.Size, minTileSize, atlasSize);
+
+	for (auto it = allocated.begin(); it != allocated.end();)
+	{
+		auto w = wanted.find(it->first);
+		if (w == wanted.end() || w->second != it->second.Size)
+		{
+			Free(it->second);
+			it = allocated.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	newKeys.clear();
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const std::vector<ShadowAtlasRequest>& group = groups[order[i]];
+		size_t evict = order.size();
+		while (!AllocateGroup(group, wanted))
+		{
+			// Only ever less important groups, least important first
+			while (evict > i + 1 && !ReleaseGroup(groups[order[evict - 1]]))
+				evict--;
+			if (evict <= i + 1)
+			{
+				ReleaseGroup(group);
+				break;
+			}
+		}
+	}
+	newTiles = (unsigned int)newKeys.size();
+}
+
+// --------------------------------------------------------
+// Gives every request in the group that doesn't have a tile
+// one, shrinking them together until they fit.  If even the
+// smallest size doesn't fit, whatever this call allocated is
+// freed again and it returns false
+// --------------------------------------------------------
+bool ShadowAtlas::AllocateGroup(const std::vector<ShadowAtlasRequest>& group, const std::map<unsigned int, unsigned int>& wanted)
+{
+	unsigned int largest = 0;
+	for (auto& r : group)
+	{
+		if (!allocated.count(r.Key))
+			largest = std::max(largest, wanted.at(r.Key));
+	}
+	if (largest == 0)
+		return true;
+
+	for (unsigned int size = largest; size >= minTileSize; size /= 2)
+	{
+		std::vector<unsigned int> added;
+		bool fits = true;
+		for (auto& r : group)
+		{
+			if (allocated.count(r.Key))
+				continue;
+
+			ShadowAtlasTile tile = {};
+			if (!Allocate(std::min(size, wanted.at(r.Key)), tile))
+			{
+				fits = false;
+				break;
+			}
+			allocated[r.Key] = tile;
+			newKeys.insert(r.Key);
+			added.push_back(r.Key);
+		}
+		if (fits)
+			return true;
+
+		for (unsigned int key : added)
+		{
+			Free(allocated[key]);
+			allocated.erase(key);
+			newKeys.erase(key);
+		}
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// Frees every tile the group holds.  False if it held none
+// --------------------------------------------------------
+bool ShadowAtlas::ReleaseGroup(const std::vector<ShadowAtlasRequest>& group)
+{
+	bool released = false;
+	for (auto& r : group)
+	{
+		auto it = allocated.find(r.Key);
+		if (it == allocated.end())
+			continue;
+
+		Free(it->second);
+		allocated.erase(it);
+		newKeys.erase(r.Key);
+		released = true;
+	}
+	return released;
+}
+
+bool ShadowAtlas::GetTile(unsigned int key, ShadowAtlasTile& tile)
+{
+	auto it = allocated.find(key);
+	if (it == allocated.end())
+		return false;
+	tile = it->second;
+	return true;
+}
+
+bool ShadowAtlas::IsTileNew(unsigned int key)
+{
+	return newKeys.count(key) > 0;
+}
+
+unsigned int ShadowAtlas::SizeForImportance(float importance, unsigned int minTileSize, unsigned int maxTileSize)
+{
+	// Largest power of 2 no bigger than the wanted size
+	float wanted = std::clamp(importance, 0.0f, 1.0f) * maxTileSize;
+	unsigned int size = maxTileSize;
+	while (size > minTileSize && size > wanted)
+		size /= 2;
+	return size;
+}
+
+float ShadowAtlas::GetUsage()
+{
+	double used = 0;
+	for (auto& a : allocated)
+		used += (double)a.second.Size * a.second.Size;
+	return (float)(used / ((double)atlasSize * atlasSize));
+}
+
+// --------------------------------------------------------
+// Takes a free square of the right size, splitting bigger
+// ones into quarters as needed
+// --------------------------------------------------------
+bool ShadowAtlas::Allocate(unsigned int size, ShadowAtlasTile& tile)
+{
+	// Smallest free square that's at least this big
+	unsigned int from = size;
+	while (from <= atlasSize && freeTiles[from].empty())
+		from *= 2;
+	if (from > atlasSize)
+		return false;
+
+	std::pair<unsigned int, unsigned int> pos = *freeTiles[from].begin();
+	freeTiles[from].erase(freeTiles[from].begin());
+
+	// Split down, keeping the top left quarter each time
+	while (from > size)
+	{
+		from /= 2;
+		freeTiles[from].insert({ pos.first + from, pos.second });
+		freeTiles[from].insert({ pos.first, pos.second + from });
+		freeTiles[from].insert({ pos.first + from, pos.second + from });
+	}
+
+	tile.X = pos.first;
+	tile.Y = pos.second;
+	tile.Size = size;
+	return true;
+}
+
+// --------------------------------------------------------
+// Returns a square, merging it with its three siblings
+// whenever they're all free
+// --------------------------------------------------------
+void ShadowAtlas::Free(ShadowAtlasTile tile)
+{
+	unsigned int size = tile.Size;
+	std::pair<unsigned int, unsigned int> pos = { tile.X, tile.Y };
+
+	while (size < atlasSize)
+	{
+		unsigned int parentSize = size * 2;
+		unsigned int px = pos.first - pos.first % parentSize;
+		unsigned int py = pos.second - pos.second % parentSize;
+
+		std::pair<unsigned int, unsigned int> siblings[4] =
+		{
+			{ px, py }, { px + size, py }, { px, py + size }, { px + size, py + size }
+		};
+
+		bool allFree = true;
+		for (auto& s : siblings)
+		{
+			if (s != pos && !freeTiles[size].count(s))
+				allFree = false;
+		}
+		if (!allFree)
+			break;
+
+		for (auto& s : siblings)
+			freeTiles[size].erase(s);
+		size = parentSize;
+		pos = { px, py };
+	}
+
+	freeTiles[size].insert(pos);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Most atlas tiles the shaders can see at once (see PixelShader.hlsl)
+#define MAX_LOCAL_SHADOW_TILES 16
+
+// --------------------------------------------------------
+// Square region of the atlas, in texels
+// --------------------------------------------------------
+struct ShadowAtlasTile
+{
+	unsigned int X;
+	unsigned int Y;
+	unsigned int Size;
+};
+
+// --------------------------------------------------------
+// Something that wants a tile this frame.  Keys must be
+// stable across frames (like light index and cube face)
+// so tiles can be kept.  Requests that share a group (the
+// six faces of a point light, say) get tiles together or
+// not at all
+// --------------------------------------------------------
+struct ShadowAtlasRequest
+{
+	unsigned int Key;
+	unsigned int Group;
+	unsigned int Size;	// Wanted size, a power of 2
+	float Importance;	// Higher gets allocated first
+};
+
+// --------------------------------------------------------
+// Hands out square power-of-2 tiles of a shadow atlas using
+// a quadtree (buddy) allocator.  Tiles are freed and merged
+// back with their neighbors when no longer used, and anything
+// asking for the same size as last frame keeps its tile, so
+// static lights keep their shadows without re-rendering.
+// Keeping a tile never beats importance though: a group that
+// doesn't fit takes space from less important groups first
+// --------------------------------------------------------
+class ShadowAtlas
+{
+public:
+	ShadowAtlas(unsigned int atlasSize, unsigned int minTileSize);
+
+	// Allocates tiles for this frame's requests.  When the atlas
+	// fills up, less important groups get smaller tiles (down
+	// to the min size) or none at all
+	void Update(std::vector<ShadowAtlasRequest> requests);
+
+	// Tile for a key, false if it didn't get one
+	bool GetTile(unsigned int key, ShadowAtlasTile& tile);
+
+	// Did the key get a new tile this frame?  Its contents are
+	// garbage until rendered
+	bool IsTileNew(unsigned int key);
+
+	// Power of 2 tile size for a screen coverage from 0 to 1
+	static unsigned int SizeForImportance(float importance, unsigned int minTileSize, unsigned int maxTileSize);
+
+	unsigned int GetAtlasSize() { return atlasSize; }
+	unsigned int GetTileCount() { return (unsigned int)allocated.size(); }
+	unsigned int GetNewTileCount() { return newTiles; }
+	float GetUsage();
+
+private:
+	unsigned int atlasSize;
+	unsigned int minTileSize;
+
+	// Free squares at each size, keyed by position
+	std::map<unsigned int, std::set<std::pair<unsigned int, unsigned int>>> freeTiles;
+
+	std::map<unsigned int, ShadowAtlasTile> allocated;
+	std::set<unsigned int> newKeys;
+	unsigned int newTiles;
+
+	bool Allocate(unsigned int size, ShadowAtlasTile& tile);
+	void Free(ShadowAtlasTile tile);
+	bool AllocateGroup(const std::vector<ShadowAtlasRequest>& group, const std::map<unsigned int, unsigned int>& wanted);
+	bool ReleaseGroup(const std::vector<ShadowAtlasRequest>& group);
+};
@@ -0,0 +1,14 @@
+// Defines the input to this pixel shader
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// Clears just the current viewport of a depth buffer (one
+// shadow atlas tile), since ClearDepthStencilView can only
+// clear the whole thing
+float main(VertexToPixel input) : SV_Depth
+{
+    return 1.0f;
+}
@@ -0,0 +1,142 @@
+#include "ShadowCascades.h"
+#include <cmath>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// The "practical" split scheme: a blend of logarithmic
+// splits (even texel density) and uniform ones
+// --------------------------------------------------------
+void ShadowCascades::ComputeSplits(float nearClip, float farClip, int count, float lambda, float* splits)
+{
+	splits[0] = nearClip;
+	for (int i = 1; i <= count; i++)
+	{
+		float t = (float)i / count;
+		float logSplit = nearClip * powf(farClip / nearClip, t);
+		float uniformSplit = nearClip + (farClip - nearClip) * t;
+		splits[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+	}
+	splits[count] = farClip;
+}
+
+void ShadowCascades::GetFrustumSliceCorners(
+	XMFLOAT3 position,
+	XMFLOAT3 forward,
+	XMFLOAT3 up,
+	XMFLOAT3 right,
+	float fov,
+	float aspectRatio,
+	float nearDepth,
+	float farDepth,
+	XMFLOAT3 corners[8])
+{
+	XMVECTOR pos = XMLoadFloat3(&position);
+	XMVECTOR f = XMVector3Normalize(XMLoadFloat3(&forward));
+	XMVECTOR u = XMVector3Normalize(XMLoadFloat3(&up));
+	XMVECTOR r = XMVector3Normalize(XMLoadFloat3(&right));
+
+	float tanHalfY = tanf(fov * 0.5f);
+	float tanHalfX = tanHalfY * aspectRatio;
+
+	const float depths[2] = { nearDepth, farDepth };
+	for (int d = 0; d < 2; d++)
+	{
+		XMVECTOR center = XMVectorAdd(pos, XMVectorScale(f, depths[d]));
+		XMVECTOR halfRight = XMVectorScale(r, tanHalfX * depths[d]);
+		XMVECTOR halfUp = XMVectorScale(u, tanHalfY * depths[d]);
+
+		XMStoreFloat3(&corners[d * 4 + 0], XMVectorSubtract(XMVectorAdd(center, halfUp), halfRight));
+		XMStoreFloat3(&corners[d * 4 + 1], XMVectorAdd(XMVectorAdd(center, halfUp), halfRight));
+		XMStoreFloat3(&corners[d * 4 + 2], XMVectorAdd(XMVectorSubtract(center, halfUp), halfRight));
+		XMStoreFloat3(&corners[d * 4 + 3], XMVectorSubtract(XMVectorSubtract(center, halfUp), halfRight));
+	}
+}
+
+ShadowCascades::Cascade ShadowCascades::FitCascade(
+	const XMFLOAT3 corners[8],
+	XMFLOAT3 lightDirection,
+	unsigned int resolution,
+	float casterDistance)
+{
+	Cascade cascade = {};
+
+	// Bounding sphere around the centroid.  Rounding the radius up
+	// keeps float noise from changing the texel size frame to frame
+	XMVECTOR center = XMVectorZero();
+	for (int i = 0; i < 8; i++)
+		center = XMVectorAdd(center, XMLoadFloat3(&corners[i]));
+	center = XMVectorScale(center, 1.0f / 8);
+
+	float radius = 0.0f;
+	for (int i = 0; i < 8; i++)
+	{
+		float dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&corners[i]), center)));
+		radius = fmaxf(radius, dist);
+	}
+	radius = ceilf(radius * 16.0f) / 16.0f;
+
+	// The box has room for the sphere to drift half a step either
+	// way from the snapped center.  The step is an even number of
+	// texels, so the center (half a step into a grid cell) is
+	// still on a texel corner
+	float halfWidth = radius * (1.0f + SHADOW_CASCADE_SNAP_FRACTION);
+	float texelSize = (halfWidth * 2.0f) / resolution;
+	float snapTexels = fmaxf(2.0f, 2.0f * floorf(radius * SHADOW_CASCADE_SNAP_FRACTION / texelSize * 0.5f));
+	float snap = snapTexels * texelSize;
+
+	// Light view is a pure rotation, so snapping in its space is
+	// the same as snapping to the shadow map's texel grid
+	XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+	XMVECTOR up = fabsf(XMVectorGetY(dir)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+	XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), dir, up);
+
+	XMFLOAT3 lc;
+	XMStoreFloat3(&lc, XMVector3TransformCoord(center, view));
+	cascade.GridX = (int)floorf(lc.x / snap);
+	cascade.GridY = (int)floorf(lc.y / snap);
+	cascade.GridZ = (int)floorf(lc.z / snap);
+	lc.x = (cascade.GridX + 0.5f) * snap;
+	lc.y = (cascade.GridY + 0.5f) * snap;
+	lc.z = (cascade.GridZ + 0.5f) * snap;
+
+	XMMATRIX proj = XMMatrixOrthographicOffCenterLH(
+		lc.x - halfWidth, lc.x + halfWidth,
+		lc.y - halfWidth, lc.y + halfWidth,
+		lc.z - halfWidth - casterDistance, lc.z + halfWidth);
+
+	XMStoreFloat4x4(&cascade.View, view);
+	XMStoreFloat4x4(&cascade.Projection, proj);
+	XMStoreFloat4x4(&cascade.ViewProjection, XMMatrixMultiply(view, proj));
+	cascade.LightSpaceCenter = lc;
+	cascade.Radius = halfWidth;
+	cascade.TexelSize = texelSize;
+	cascade.SnapSize = snap;
+	cascade.CasterDistance = casterDistance;
+	XMStoreFloat3(&cascade.LightDirection, dir);
+	return cascade;
+}
+
+bool ShadowCascades::SameFit(const Cascade& a, const Cascade& b)
+{
+	return
+		a.GridX == b.GridX && a.GridY == b.GridY && a.GridZ == b.GridZ &&
+		a.SnapSize == b.SnapSize && a.Radius == b.Radius &&
+		a.LightDirection.x == b.LightDirection.x &&
+		a.LightDirection.y == b.LightDirection.y &&
+		a.LightDirection.z == b.LightDirection.z &&
+		a.CasterDistance == b.CasterDistance;
+}
+
+bool ShadowCascades::CasterVisible(const Cascade& cascade, XMFLOAT3 center, float radius)
+{
+	XMFLOAT3 p;
+	XMStoreFloat3(&p, XMVector3TransformCoord(XMLoadFloat3(&center), XMLoadFloat4x4(&cascade.View)));
+
+	const XMFLOAT3& lc = cascade.LightSpaceCenter;
+	float reach = cascade.Radius + radius;
+	return
+		fabsf(p.x - lc.x) <= reach &&
+		fabsf(p.y - lc.y) <= reach &&
+		p.z - radius <= lc.z + cascade.Radius;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <DirectXMath.h>
+
+// Most cascades the shaders support (see PixelShader.hlsl)
+#define MAX_SHADOW_CASCADES 4
+
+// A cascade only moves once its slice has moved this fraction
+// of its radius (in any direction, depth included), so cached
+// static casters survive a slowly moving camera.  The ortho
+// box grows by half a step to cover the slack
+#define SHADOW_CASCADE_SNAP_FRACTION 0.125f
+
+// --------------------------------------------------------
+// Cascaded shadow map math for a directional light.  No
+// API calls, so Tests/ShadowCascadesTests.cpp runs it as is
+// --------------------------------------------------------
+namespace ShadowCascades
+{
+	// One fitted cascade
+	struct Cascade
+	{
+		DirectX::XMFLOAT4X4 View;
+		DirectX::XMFLOAT4X4 Projection;
+		DirectX::XMFLOAT4X4 ViewProjection;
+		DirectX::XMFLOAT3 LightSpaceCenter; // Snapped to the grid below
+		float Radius;		// Half the width of the ortho box
+		float TexelSize;	// World units per shadow map texel
+		float SplitNear;	// View depth this cascade covers
+		float SplitFar;
+
+		// Light space grid cell the center was snapped to, in
+		// steps of SnapSize.  Together with the light direction,
+		// radius and caster distance this is everything the fit
+		// depends on
+		int GridX;
+		int GridY;
+		int GridZ;
+		float SnapSize;
+		DirectX::XMFLOAT3 LightDirection;
+		float CasterDistance;
+	};
+
+	// Fills splits[0..count] with view depths between the
+	// near and far planes.  lambda blends between an even
+	// split (0) and a logarithmic one (1)
+	void ComputeSplits(float nearClip, float farClip, int count, float lambda, float* splits);
+
+	// World space corners of the part of a camera frustum
+	// between two view depths (near 4 first, then far 4)
+	void GetFrustumSliceCorners(
+		DirectX::XMFLOAT3 position,
+		DirectX::XMFLOAT3 forward,
+		DirectX::XMFLOAT3 up,
+		DirectX::XMFLOAT3 right,
+		float fov,
+		float aspectRatio,
+		float nearDepth,
+		float farDepth,
+		DirectX::XMFLOAT3 corners[8]);
+
+	// Fits an orthographic light projection around a bounding
+	// sphere of the corners.  The sphere doesn't change as the
+	// camera rotates and the center is snapped to a grid of whole
+	// texels in x and y (and to the same step in depth), so the
+	// shadows don't shimmer and the fit only changes once the
+	// slice has moved a step
+	//
+	// casterDistance - How far behind the slice to keep casters
+	Cascade FitCascade(
+		const DirectX::XMFLOAT3 corners[8],
+		DirectX::XMFLOAT3 lightDirection,
+		unsigned int resolution,
+		float casterDistance);
+
+	// Do two fits render exactly the same view?  Compares the
+	// snapped parameters rather than the matrices
+	bool SameFit(const Cascade& a, const Cascade& b);
+
+	// Can a caster with this bounding sphere throw a shadow
+	// into the cascade?  Casters between the light and the
+	// near plane still count, they're flattened onto it
+	bool CasterVisible(const Cascade& cascade, DirectX::XMFLOAT3 center, float radius);
+}
@@ -5,7 +5,7 @@ cbuffer externalData : register(b0)
     matrix view;
     matrix projection;
 };
-float4 main( VertexShaderInput input ) : SV_POSITION
+float4 main( VertexShaderPositionInput input ) : SV_POSITION
 {
     matrix wvp = mul(projection, mul(view, world));
     return mul(wvp, float4(input.localPosition, 1.0f));
@@ -1,8 +1,12 @@
 #include "SimpleShader.h"
+#include "Graphics.h"
+#include "RenderStats.h"
 
 // Default error reporting state
 bool ISimpleShader::ReportErrors = false;
 bool ISimpleShader::ReportWarnings = false;
+std::unordered_set<std::string> ISimpleShader::SharedConstantBuffers;
+std::atomic<unsigned int> ISimpleShader::contextRecording = 1;
 
 // To enable error reporting, use either or both 
 // of the following lines somewhere in your program, 
@@ -56,6 +60,7 @@ void ISimpleShader::CleanUp()
 		delete[] constantBuffers;
 		constantBufferCount = 0;
 	}
+	contextData.clear();
 
 	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
 		delete shaderResourceViews[i];
@@ -188,15 +193,19 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		constantBuffers[b].Name = bufferDesc.Name;
 		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
 
-		// Create this constant buffer
-		D3D11_BUFFER_DESC newBuffDesc = {};
-		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = ((bufferDesc.Size + 15) / 16) * 16; // Quick and dirty 16-byte alignment using integer division
-		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		newBuffDesc.CPUAccessFlags = 0;
-		newBuffDesc.MiscFlags = 0;
-		newBuffDesc.StructureByteStride = 0;
-		device->CreateBuffer(&newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
+		// Create this constant buffer, unless it belongs to the application
+		constantBuffers[b].Shared = SharedConstantBuffers.count(constantBuffers[b].Name) > 0;
+		if (!constantBuffers[b].Shared)
+		{
+			D3D11_BUFFER_DESC newBuffDesc = {};
+			newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
+			newBuffDesc.ByteWidth = ((bufferDesc.Size + 15) / 16) * 16; // Quick and dirty 16-byte alignment using integer division
+			newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			newBuffDesc.CPUAccessFlags = 0;
+			newBuffDesc.MiscFlags = 0;
+			newBuffDesc.StructureByteStride = 0;
+			Graphics::Api->CreateBuffer(newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
+		}
 
 		// Set up the data buffer for this constant buffer
 		constantBuffers[b].Size = bufferDesc.Size;
@@ -325,14 +334,56 @@ void ISimpleShader::LogWarningW(std::wstring message) { LogW(message, FOREGROUND
 // --------------------------------------------------------
 // Sets the shader and associated constant buffers in Direct3D
 // --------------------------------------------------------
-void ISimpleShader::SetShader()
+void ISimpleShader::SetShader(ID3D11DeviceContext* context)
 {
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
 	// Set the shader and any relevant constant buffers, which
 	// is an overloaded method in a subclass
-	SetShaderAndCBs();
+	SetShaderAndCBs(ResolveContext(context));
+	RenderStats::CountShaderSet();
+}
+
+// --------------------------------------------------------
+// Null means the context this shader was created with
+// --------------------------------------------------------
+ID3D11DeviceContext* ISimpleShader::ResolveContext(ID3D11DeviceContext* context)
+{
+	return context ? context : deviceContext.Get();
+}
+
+// --------------------------------------------------------
+// Starts a new recording for every shader's other contexts
+// --------------------------------------------------------
+void ISimpleShader::BeginContextRecording()
+{
+	contextRecording++;
+}
+
+// --------------------------------------------------------
+// Gets the local data for one constant buffer as seen by the
+// given context.  Other contexts get their own copy, taken
+// from the creating context's data the first time they're
+// used in each recording
+// --------------------------------------------------------
+unsigned char* ISimpleShader::GetLocalData(unsigned int index, ID3D11DeviceContext* context)
+{
+	context = ResolveContext(context);
+	if (context == deviceContext.Get())
+		return constantBuffers[index].LocalDataBuffer;
+
+	std::lock_guard<std::mutex> lock(contextDataLock);
+	ContextLocalData& data = contextData[context];
+	unsigned int recording = contextRecording;
+	if (data.Recording != recording)
+	{
+		data.Buffers.resize(constantBufferCount);
+		for (unsigned int i = 0; i < constantBufferCount; i++)
+			data.Buffers[i].assign(constantBuffers[i].LocalDataBuffer, constantBuffers[i].LocalDataBuffer + constantBuffers[i].Size);
+		data.Recording = recording;
+	}
+	return data.Buffers[index].data();
 }
 
 // --------------------------------------------------------
@@ -340,7 +391,7 @@ void ISimpleShader::SetShader()
 // shader's constant buffers.  To just copy one
 // buffer, use CopyBufferData()
 // --------------------------------------------------------
-void ISimpleShader::CopyAllBufferData()
+void ISimpleShader::CopyAllBufferData(ID3D11DeviceContext* context)
 {
 	// Ensure the shader is valid
 	if (!shaderValid) return;
@@ -348,10 +399,16 @@ void ISimpleShader::CopyAllBufferData()
 	// Loop through the constant buffers and copy all data
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
+		// The application fills shared buffers itself
+		if (constantBuffers[i].Shared)
+			continue;
+
 		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		Graphics::Api->UpdateSubresource(
+			ResolveContext(context),
+			constantBuffers[i].ConstantBuffer.Get(), 0,
+			GetLocalData(i, context), constantBuffers[i].Size);
+		RenderStats::CountConstantBufferBytes(constantBuffers[i].Size);
 	}
 }
 
@@ -366,7 +423,7 @@ void ISimpleShader::CopyAllBufferData()
 //       as its register, especially if you have buffers
 //       bound to non-sequential registers!
 // --------------------------------------------------------
-void ISimpleShader::CopyBufferData(unsigned int index)
+void ISimpleShader::CopyBufferData(unsigned int index, ID3D11DeviceContext* context)
 {
 	// Ensure the shader is valid
 	if (!shaderValid) return;
@@ -377,12 +434,14 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 
 	// Check for the buffer
 	SimpleConstantBuffer* cb = &this->constantBuffers[index];
-	if (!cb) return;
+	if (!cb || cb->Shared) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	Graphics::Api->UpdateSubresource(
+		ResolveContext(context),
+		cb->ConstantBuffer.Get(), 0,
+		GetLocalData(index, context), cb->Size);
+	RenderStats::CountConstantBufferBytes(cb->Size);
 }
 
 // --------------------------------------------------------
@@ -392,7 +451,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 //              Useful for updating more frequently-changing
 //              variables without having to re-copy all buffers.
 // --------------------------------------------------------
-void ISimpleShader::CopyBufferData(std::string bufferName)
+void ISimpleShader::CopyBufferData(std::string bufferName, ID3D11DeviceContext* context)
 {
 	// Ensure the shader is valid
 	if (!shaderValid) return;
@@ -402,9 +461,7 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	CopyBufferData((unsigned int)(cb - constantBuffers), context);
 }
 
 
@@ -417,7 +474,7 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 //
 // Returns true if data is copied, false if variable doesn't exist
 // --------------------------------------------------------
-bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
+bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	SimpleShaderVariable* var = FindVariable(name, -1);
@@ -447,7 +504,7 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 
 	// Set the data in the local data buffer
 	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
+		GetLocalData(var->ConstantBufferIndex, context) + var->ByteOffset,
 		data,
 		size);
 
@@ -458,81 +515,81 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 // --------------------------------------------------------
 // Sets INTEGER data
 // --------------------------------------------------------
-bool ISimpleShader::SetInt(std::string name, int data)
+bool ISimpleShader::SetInt(std::string name, int data, ID3D11DeviceContext* context)
 {
-	return this->SetData(name, (void*)(&data), sizeof(int));
+	return this->SetData(name, (void*)(&data), sizeof(int), context);
 }
 
 // --------------------------------------------------------
 // Sets a FLOAT variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat(std::string name, float data)
+bool ISimpleShader::SetFloat(std::string name, float data, ID3D11DeviceContext* context)
 {
-	return this->SetData(name, (void*)(&data), sizeof(float));
+	return this->SetData(name, (void*)(&data), sizeof(float), context);
 }
 
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const float data[2])
+bool ISimpleShader::SetFloat2(std::string name, const float data[2], ID3D11DeviceContext* context)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 2);
+	return this->SetData(name, (void*)data, sizeof(float) * 2, context);
 }
 
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
+bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data, ID3D11DeviceContext* context)
 {
-	return this->SetData(name, &data, sizeof(float) * 2);
+	return this->SetData(name, &data, sizeof(float) * 2, context);
 }
 
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const float data[3])
+bool ISimpleShader::SetFloat3(std::string name, const float data[3], ID3D11DeviceContext* context)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 3);
+	return this->SetData(name, (void*)data, sizeof(float) * 3, context);
 }
 
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
+bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data, ID3D11DeviceContext* context)
 {
-	return this->SetData(name, &data, sizeof(float) * 3);
+	return this->SetData(name, &data, sizeof(float) * 3, context);
 }
 
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const float data[4])
+bool ISimpleShader::SetFloat4(std::string name, const float data[4], ID3D11DeviceContext* context)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 4);
+	return this->SetData(name, (void*)data, sizeof(float) * 4, context);
 }
 
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
+bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data, ID3D11DeviceContext* context)
 {
-	return this->SetData(name, &data, sizeof(float) * 4);
+	return this->SetData(name, &data, sizeof(float) * 4, context);
 }
 
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
+bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16], ID3D11DeviceContext* context)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 16);
+	return this->SetData(name, (void*)data, sizeof(float) * 16, context);
 }
 
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data)
+bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data, ID3D11DeviceContext* context)
 {
-	return this->SetData(name, &data, sizeof(float) * 16);
+	return this->SetData(name, &data, sizeof(float) * 16, context);
 }
 
 // --------------------------------------------------------
@@ -863,24 +920,27 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 // Sets the vertex shader, input layout and constant buffers
 // for future  Direct3D drawing
 // --------------------------------------------------------
-void SimpleVertexShader::SetShaderAndCBs()
+void SimpleVertexShader::SetShaderAndCBs(ID3D11DeviceContext* context)
 {
 	// Is shader valid?
 	if (!shaderValid) return;
 
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout.Get());
-	deviceContext->VSSetShader(shader.Get(), 0, 0);
+	Graphics::Api->SetInputLayout(context, inputLayout.Get());
+	Graphics::Api->SetShader(context, ShaderStage::Vertex, shader.Get());
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
+		// Skip "buffers" that aren't true constant buffers,
+		// and ones the application binds itself
+		if (constantBuffers[i].Type != D3D11_CT_CBUFFER || constantBuffers[i].Shared)
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->VSSetConstantBuffers(
+		Graphics::Api->SetConstantBuffers(
+			context,
+			ShaderStage::Vertex,
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -895,7 +955,7 @@ void SimpleVertexShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -911,7 +971,7 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	Graphics::Api->SetShaderResources(ResolveContext(context), ShaderStage::Vertex, srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -925,7 +985,7 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -941,7 +1001,7 @@ bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	Graphics::Api->SetSamplers(ResolveContext(context), ShaderStage::Vertex, sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1006,23 +1066,26 @@ bool SimplePixelShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob
 // Sets the pixel shader and constant buffers for
 // future  Direct3D drawing
 // --------------------------------------------------------
-void SimplePixelShader::SetShaderAndCBs()
+void SimplePixelShader::SetShaderAndCBs(ID3D11DeviceContext* context)
 {
 	// Is shader valid?
 	if (!shaderValid) return;
 	
 	// Set the shader
-	deviceContext->PSSetShader(shader.Get(), 0, 0);
+	Graphics::Api->SetShader(context, ShaderStage::Pixel, shader.Get());
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
+		// Skip "buffers" that aren't true constant buffers,
+		// and ones the application binds itself
+		if (constantBuffers[i].Type != D3D11_CT_CBUFFER || constantBuffers[i].Shared)
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->PSSetConstantBuffers(
+		Graphics::Api->SetConstantBuffers(
+			context,
+			ShaderStage::Pixel,
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1037,7 +1100,7 @@ void SimplePixelShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1053,7 +1116,7 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	Graphics::Api->SetShaderResources(ResolveContext(context), ShaderStage::Pixel, srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1067,7 +1130,7 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1083,7 +1146,7 @@ bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	Graphics::Api->SetSamplers(ResolveContext(context), ShaderStage::Pixel, sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1150,23 +1213,26 @@ bool SimpleDomainShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 // Sets the domain shader and constant buffers for
 // future  Direct3D drawing
 // --------------------------------------------------------
-void SimpleDomainShader::SetShaderAndCBs()
+void SimpleDomainShader::SetShaderAndCBs(ID3D11DeviceContext* context)
 {
 	// Is shader valid?
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->DSSetShader(shader.Get(), 0, 0);
+	Graphics::Api->SetShader(context, ShaderStage::Domain, shader.Get());
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
+		// Skip "buffers" that aren't true constant buffers,
+		// and ones the application binds itself
+		if (constantBuffers[i].Type != D3D11_CT_CBUFFER || constantBuffers[i].Shared)
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->DSSetConstantBuffers(
+		Graphics::Api->SetConstantBuffers(
+			context,
+			ShaderStage::Domain,
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1181,7 +1247,7 @@ void SimpleDomainShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1197,7 +1263,7 @@ bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	Graphics::Api->SetShaderResources(ResolveContext(context), ShaderStage::Domain, srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1211,7 +1277,7 @@ bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1227,7 +1293,7 @@ bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	Graphics::Api->SetSamplers(ResolveContext(context), ShaderStage::Domain, sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1293,23 +1359,26 @@ bool SimpleHullShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
 // Sets the hull shader and constant buffers for
 // future  Direct3D drawing
 // --------------------------------------------------------
-void SimpleHullShader::SetShaderAndCBs()
+void SimpleHullShader::SetShaderAndCBs(ID3D11DeviceContext* context)
 {
 	// Is shader valid?
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->HSSetShader(shader.Get(), 0, 0);
+	Graphics::Api->SetShader(context, ShaderStage::Hull, shader.Get());
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
+		// Skip "buffers" that aren't true constant buffers,
+		// and ones the application binds itself
+		if (constantBuffers[i].Type != D3D11_CT_CBUFFER || constantBuffers[i].Shared)
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->HSSetConstantBuffers(
+		Graphics::Api->SetConstantBuffers(
+			context,
+			ShaderStage::Hull,
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1324,7 +1393,7 @@ void SimpleHullShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1340,7 +1409,7 @@ bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::C
 	}
 
 	// Set the shader resource view
-	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	Graphics::Api->SetShaderResources(ResolveContext(context), ShaderStage::Hull, srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1354,7 +1423,7 @@ bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::C
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1370,7 +1439,7 @@ bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<
 	}
 
 	// Set the shader resource view
-	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	Graphics::Api->SetSamplers(ResolveContext(context), ShaderStage::Hull, sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1549,7 +1618,7 @@ bool SimpleGeometryShader::CreateCompatibleStreamOutBuffer(Microsoft::WRL::ComPt
 	desc.Usage               = D3D11_USAGE_DEFAULT;
 
 	// Attempt to create the buffer and return the result
-	HRESULT result = device->CreateBuffer(&desc, 0, buffer.GetAddressOf());
+	HRESULT result = Graphics::Api->CreateBuffer(desc, 0, buffer.GetAddressOf());
 	return (result == S_OK);
 }
 
@@ -1567,23 +1636,26 @@ void SimpleGeometryShader::UnbindStreamOutStage(Microsoft::WRL::ComPtr<ID3D11Dev
 // Sets the geometry shader and constant buffers for
 // future  Direct3D drawing
 // --------------------------------------------------------
-void SimpleGeometryShader::SetShaderAndCBs()
+void SimpleGeometryShader::SetShaderAndCBs(ID3D11DeviceContext* context)
 {
 	// Is shader valid?
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->GSSetShader(shader.Get(), 0, 0);
+	Graphics::Api->SetShader(context, ShaderStage::Geometry, shader.Get());
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
+		// Skip "buffers" that aren't true constant buffers,
+		// and ones the application binds itself
+		if (constantBuffers[i].Type != D3D11_CT_CBUFFER || constantBuffers[i].Shared)
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->GSSetConstantBuffers(
+		Graphics::Api->SetConstantBuffers(
+			context,
+			ShaderStage::Geometry,
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1598,7 +1670,7 @@ void SimpleGeometryShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1614,7 +1686,7 @@ bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WR
 	}
 
 	// Set the shader resource view
-	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	Graphics::Api->SetShaderResources(ResolveContext(context), ShaderStage::Geometry, srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1628,7 +1700,7 @@ bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WR
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1644,7 +1716,7 @@ bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::Com
 	}
 
 	// Set the shader resource view
-	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	Graphics::Api->SetSamplers(ResolveContext(context), ShaderStage::Geometry, sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1777,23 +1849,26 @@ bool SimpleComputeShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBl
 // Sets the Compute shader and constant buffers for
 // future  Direct3D drawing
 // --------------------------------------------------------
-void SimpleComputeShader::SetShaderAndCBs()
+void SimpleComputeShader::SetShaderAndCBs(ID3D11DeviceContext* context)
 {
 	// Is shader valid?
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->CSSetShader(shader.Get(), 0, 0);
+	Graphics::Api->SetShader(context, ShaderStage::Compute, shader.Get());
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
+		// Skip "buffers" that aren't true constant buffers,
+		// and ones the application binds itself
+		if (constantBuffers[i].Type != D3D11_CT_CBUFFER || constantBuffers[i].Shared)
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->CSSetConstantBuffers(
+		Graphics::Api->SetConstantBuffers(
+			context,
+			ShaderStage::Compute,
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1869,7 +1944,7 @@ bool SimpleComputeShader::HasUnorderedAccessView(std::string name)
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1885,7 +1960,7 @@ bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL
 	}
 
 	// Set the shader resource view
-	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	Graphics::Api->SetShaderResources(ResolveContext(context), ShaderStage::Compute, srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1899,7 +1974,7 @@ bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1915,7 +1990,7 @@ bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComP
 	}
 
 	// Set the shader resource view
-	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	Graphics::Api->SetSamplers(ResolveContext(context), ShaderStage::Compute, sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
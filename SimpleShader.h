@@ -8,6 +8,9 @@
 #include <wrl/client.h>
 
 #include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
 #include <vector>
 #include <string>
 
@@ -37,6 +40,7 @@ struct SimpleConstantBuffer
 	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;
 	unsigned char* LocalDataBuffer = 0;
 	std::vector<SimpleShaderVariable> Variables;
+	bool Shared = false; // See ISimpleShader::SharedConstantBuffers
 };
 
 // --------------------------------------------------------
@@ -69,29 +73,34 @@ public:
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
 
-	// Activating the shader and copying data
-	void SetShader();
-	void CopyAllBufferData();
-	void CopyBufferData(unsigned int index);
-	void CopyBufferData(std::string bufferName);
-
-	// Sets arbitrary shader data
-	bool SetData(std::string name, const void* data, unsigned int size);
-
-	bool SetInt(std::string name, int data);
-	bool SetFloat(std::string name, float data);
-	bool SetFloat2(std::string name, const float data[2]);
-	bool SetFloat2(std::string name, const DirectX::XMFLOAT2 data);
-	bool SetFloat3(std::string name, const float data[3]);
-	bool SetFloat3(std::string name, const DirectX::XMFLOAT3 data);
-	bool SetFloat4(std::string name, const float data[4]);
-	bool SetFloat4(std::string name, const DirectX::XMFLOAT4 data);
-	bool SetMatrix4x4(std::string name, const float data[16]);
-	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
+	// Activating the shader and copying data.  These (and the
+	// setters below) can target a specific context, like a
+	// deferred context recording on another thread.  Null means
+	// the context the shader was created with
+	void SetShader(ID3D11DeviceContext* context = 0);
+	void CopyAllBufferData(ID3D11DeviceContext* context = 0);
+	void CopyBufferData(unsigned int index, ID3D11DeviceContext* context = 0);
+	void CopyBufferData(std::string bufferName, ID3D11DeviceContext* context = 0);
+
+	// Sets arbitrary shader data.  Each context has its own copy of
+	// the local data, so threads recording different contexts can
+	// fill in the same shader at the same time
+	bool SetData(std::string name, const void* data, unsigned int size, ID3D11DeviceContext* context = 0);
+
+	bool SetInt(std::string name, int data, ID3D11DeviceContext* context = 0);
+	bool SetFloat(std::string name, float data, ID3D11DeviceContext* context = 0);
+	bool SetFloat2(std::string name, const float data[2], ID3D11DeviceContext* context = 0);
+	bool SetFloat2(std::string name, const DirectX::XMFLOAT2 data, ID3D11DeviceContext* context = 0);
+	bool SetFloat3(std::string name, const float data[3], ID3D11DeviceContext* context = 0);
+	bool SetFloat3(std::string name, const DirectX::XMFLOAT3 data, ID3D11DeviceContext* context = 0);
+	bool SetFloat4(std::string name, const float data[4], ID3D11DeviceContext* context = 0);
+	bool SetFloat4(std::string name, const DirectX::XMFLOAT4 data, ID3D11DeviceContext* context = 0);
+	bool SetMatrix4x4(std::string name, const float data[16], ID3D11DeviceContext* context = 0);
+	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data, ID3D11DeviceContext* context = 0);
 
 	// Setting shader resources
-	virtual bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
-	virtual bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) = 0;
+	virtual bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context = 0) = 0;
+	virtual bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context = 0) = 0;
 
 	// Simple resource checking
 	bool HasVariable(std::string name);
@@ -122,6 +131,20 @@ public:
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Constant buffers with these names are filled and bound by the
+	// application itself (once a frame, say), so shaders don't make,
+	// copy or bind their own.  Set before loading any shaders
+	static std::unordered_set<std::string> SharedConstantBuffers;
+
+	// Call on the main thread before recording on other contexts.
+	// Each context's copy of the local data is re-synced from the
+	// creating context's the next time it's used, so a recording
+	// always starts from the data the immediate context had when
+	// it began.  Anything a recording changes from there only
+	// lasts until the next one, so it must set every variable it
+	// relies on rather than count on an earlier recording's
+	static void BeginContextRecording();
+
 protected:
 	
 	bool shaderValid;
@@ -141,12 +164,26 @@ protected:
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
+	// Local data for contexts other than the one we were created
+	// with, one array per constant buffer, and the recording it
+	// was last synced for (see BeginContextRecording())
+	struct ContextLocalData
+	{
+		unsigned int Recording = 0;
+		std::vector<std::vector<unsigned char>> Buffers;
+	};
+	static std::atomic<unsigned int> contextRecording;
+	std::mutex contextDataLock;
+	std::unordered_map<ID3D11DeviceContext*, ContextLocalData> contextData;
+	ID3D11DeviceContext* ResolveContext(ID3D11DeviceContext* context);
+	unsigned char* GetLocalData(unsigned int index, ID3D11DeviceContext* context);
+
 	// Initialization method
 	bool LoadShaderFile(LPCWSTR shaderFile);
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
-	virtual void SetShaderAndCBs() = 0;
+	virtual void SetShaderAndCBs(ID3D11DeviceContext* context) = 0;
 
 	virtual void CleanUp();
 
@@ -178,15 +215,15 @@ public:
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout() { return inputLayout; }
 	bool GetPerInstanceCompatible() { return perInstanceCompatible; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context = 0);
+	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context = 0);
 
 protected:
 	bool perInstanceCompatible;
 	 Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
 	 Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
+	void SetShaderAndCBs(ID3D11DeviceContext* context);
 	void CleanUp();
 };
 
@@ -201,13 +238,13 @@ public:
 	~SimplePixelShader();
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context = 0);
+	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context = 0);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
+	void SetShaderAndCBs(ID3D11DeviceContext* context);
 	void CleanUp();
 };
 
@@ -221,13 +258,13 @@ public:
 	~SimpleDomainShader();
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context = 0);
+	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context = 0);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
+	void SetShaderAndCBs(ID3D11DeviceContext* context);
 	void CleanUp();
 };
 
@@ -241,13 +278,13 @@ public:
 	~SimpleHullShader();
 	Microsoft::WRL::ComPtr<ID3D11HullShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context = 0);
+	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context = 0);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11HullShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
+	void SetShaderAndCBs(ID3D11DeviceContext* context);
 	void CleanUp();
 };
 
@@ -261,8 +298,8 @@ public:
 	~SimpleGeometryShader();
 	Microsoft::WRL::ComPtr<ID3D11GeometryShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context = 0);
+	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context = 0);
 
 	bool CreateCompatibleStreamOutBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, int vertexCount);
 
@@ -279,7 +316,7 @@ protected:
 
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	bool CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
+	void SetShaderAndCBs(ID3D11DeviceContext* context);
 	void CleanUp();
 
 	// Helpers
@@ -302,8 +339,8 @@ public:
 
 	bool HasUnorderedAccessView(std::string name);
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ID3D11DeviceContext* context = 0);
+	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, ID3D11DeviceContext* context = 0);
 	bool SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
 
 	int GetUnorderedAccessViewIndex(std::string name);
@@ -318,6 +355,6 @@ protected:
 	unsigned int threadsTotal;
 
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
+	void SetShaderAndCBs(ID3D11DeviceContext* context);
 	void CleanUp();
 };
\ No newline at end of file
@@ -70,7 +70,7 @@ Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Sky::CreateCubemap(const wchar_
 	cubeDesc.SampleDesc.Quality = 0;
 	// Create the final texture resource to hold the cube map
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> cubeMapTexture;
-	Graphics::Device->CreateTexture2D(&cubeDesc, 0, cubeMapTexture.GetAddressOf());
+	Graphics::Api->CreateTexture2D(cubeDesc, 0, cubeMapTexture.GetAddressOf());
 	// Loop through the individual face textures and copy them,
 	// one at a time, to the cube map texure
 	for (int i = 0; i < 6; i++)
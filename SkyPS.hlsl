@@ -4,6 +4,8 @@ SamplerState BasicSampler : register(s0);
 
 float4 main(Sky_VertexToPixel input) : SV_TARGET
 {
-    return CubeMap.Sample(BasicSampler, input.samplerDir);
+    // Sky textures are gamma encoded, the scene target is linear
+    float3 color = pow(CubeMap.Sample(BasicSampler, input.samplerDir).rgb, 2.2);
+    return float4(color, 1);
 
 }
\ No newline at end of file
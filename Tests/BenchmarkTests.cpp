@@ -0,0 +1,73 @@
+#include "TestFramework.h"
+#include "../Benchmark.h"
+#include "../Lights.h"
+
+TEST(CommandLineDefaultsToNoBenchmark)
+{
+	BenchmarkSettings settings = Benchmark::ParseCommandLine("");
+	CHECK(!settings.Enabled);
+	CHECK(settings.Entities == 64);
+	CHECK(settings.Frames == 600);
+	CHECK(settings.Output == "benchmark.json");
+}
+
+TEST(CommandLineReadsEverySwitch)
+{
+	BenchmarkSettings settings = Benchmark::ParseCommandLine(
+		"-benchmark -entities 500 -lights 3 -materials 7 -frames 120 -warmup 10 "
+		"-timestep 0.02 -seed 42 -warp -nosubmit -output out.json");
+	CHECK(settings.Enabled);
+	CHECK(settings.Entities == 500);
+	CHECK(settings.Lights == 3);
+	CHECK(settings.Materials == 7);
+	CHECK(settings.Frames == 120);
+	CHECK(settings.WarmupFrames == 10);
+	CHECK_NEAR(settings.TimeStep, 0.02, 1e-7);
+	CHECK(settings.Seed == 42);
+	CHECK(settings.Warp);
+	CHECK(settings.NoSubmit);
+	CHECK(settings.Output == "out.json");
+}
+
+TEST(CommandLineClampsToWhatCanRun)
+{
+	BenchmarkSettings settings = Benchmark::ParseCommandLine(
+		"-some-other-switch -benchmark -entities 0 -lights 1000 -materials 0 -frames 0 -timestep -1");
+	CHECK(settings.Enabled);
+	CHECK(settings.Entities == 1);
+	CHECK(settings.Lights == MAX_LIGHTS);
+	CHECK(settings.Materials == 1);
+	CHECK(settings.Frames == 1);
+	CHECK_NEAR(settings.TimeStep, 1.0 / 60.0, 1e-7);
+}
+
+TEST(SummarizeUsesNearestRankPercentiles)
+{
+	// 1 to 100, out of order
+	std::vector<double> samples;
+	for (int i = 0; i < 100; i++)
+		samples.push_back((i * 37) % 100 + 1);
+
+	BenchmarkStats stats = Benchmark::Summarize(samples);
+	CHECK_NEAR(stats.Mean, 50.5, 1e-9);
+	CHECK(stats.Min == 1);
+	CHECK(stats.Max == 100);
+	CHECK(stats.P50 == 50);
+	CHECK(stats.P95 == 95);
+	CHECK(stats.P99 == 99);
+
+	// Ranks round up: the 50th percentile of 3 is the 2nd
+	stats = Benchmark::Summarize({ 5, 1, 3 });
+	CHECK(stats.P50 == 3);
+	CHECK(stats.P95 == 5);
+	CHECK(stats.P99 == 5);
+}
+
+TEST(SummarizeHandlesFewSamples)
+{
+	BenchmarkStats none = Benchmark::Summarize({});
+	CHECK(none.Mean == 0 && none.Min == 0 && none.Max == 0 && none.P50 == 0 && none.P99 == 0);
+
+	BenchmarkStats one = Benchmark::Summarize({ 4.5 });
+	CHECK(one.Mean == 4.5 && one.Min == 4.5 && one.Max == 4.5 && one.P50 == 4.5 && one.P99 == 4.5);
+}
@@ -0,0 +1,115 @@
+#include "TestFramework.h"
+#include "../Bloom.h"
+
+using namespace DirectX;
+
+namespace
+{
+	Bloom::Image Constant(unsigned int width, unsigned int height, XMFLOAT3 color)
+	{
+		Bloom::Image image(width, height);
+		for (XMFLOAT3& p : image.Pixels)
+			p = color;
+		return image;
+	}
+
+	double Sum(const Bloom::Image& image)
+	{
+		double total = 0;
+		for (const XMFLOAT3& p : image.Pixels)
+			total += p.x;
+		return total;
+	}
+}
+
+TEST(FiltersKeepAConstantImage)
+{
+	Bloom::Image source = Constant(16, 12, XMFLOAT3(0.25f, 1.5f, 3.0f));
+	Bloom::Image down = Bloom::Downsample13(source);
+	CHECK(down.Width == 8 && down.Height == 6);
+	for (const XMFLOAT3& p : down.Pixels)
+	{
+		CHECK_NEAR(p.x, 0.25f, 1e-5);
+		CHECK_NEAR(p.y, 1.5f, 1e-5);
+		CHECK_NEAR(p.z, 3.0f, 1e-5);
+	}
+
+	// Tent onto an empty level above is just the filtered level below
+	Bloom::Image up = Bloom::UpsampleTent(down, Bloom::Image(16, 12), 1.0f);
+	CHECK(up.Width == 16 && up.Height == 12);
+	for (const XMFLOAT3& p : up.Pixels)
+	{
+		CHECK_NEAR(p.x, 0.25f, 1e-5);
+		CHECK_NEAR(p.y, 1.5f, 1e-5);
+		CHECK_NEAR(p.z, 3.0f, 1e-5);
+	}
+
+	// And onto a level with something in it, added
+	up = Bloom::UpsampleTent(down, Constant(16, 12, XMFLOAT3(1, 1, 1)), 1.0f);
+	CHECK_NEAR(up.At(5, 5).x, 1.25f, 1e-5);
+}
+
+TEST(RoundTripKeepsTheEnergy)
+{
+	// A single bright texel well away from the edges, so
+	// clamping never folds any of it back in
+	Bloom::Image source(32, 32);
+	source.At(13, 18) = XMFLOAT3(100, 0, 0);
+
+	Bloom::Image down = Bloom::Downsample13(source);
+	CHECK_NEAR(Sum(down) * 4, Sum(source), 1e-3);
+
+	Bloom::Image up = Bloom::UpsampleTent(down, Bloom::Image(32, 32), 1.0f);
+	CHECK_NEAR(Sum(up), Sum(source), 1e-3);
+
+	// Spread out, not just copied back
+	CHECK(up.At(13, 18).x < 100.0f);
+	CHECK(up.At(13, 18).x > 0.0f);
+}
+
+TEST(SamplingClampsAtTheEdges)
+{
+	Bloom::Image image(4, 2);
+	image.At(0, 0) = XMFLOAT3(1, 0, 0);
+	image.At(3, 1) = XMFLOAT3(0, 0, 1);
+	CHECK(Bloom::SampleBilinear(image, -1.0f, -1.0f).x == 1.0f);
+	CHECK(Bloom::SampleBilinear(image, 2.0f, 2.0f).z == 1.0f);
+
+	// Left half lit: the outermost output columns only ever see
+	// their own side, which wrapping would not give
+	Bloom::Image halves(8, 8);
+	for (unsigned int y = 0; y < 8; y++)
+		for (unsigned int x = 0; x < 4; x++)
+			halves.At(x, y) = XMFLOAT3(1, 1, 1);
+
+	Bloom::Image down = Bloom::Downsample13(halves);
+	for (unsigned int y = 0; y < down.Height; y++)
+	{
+		CHECK_NEAR(down.At(0, y).x, 1.0f, 1e-6);
+		CHECK_NEAR(down.At(3, y).x, 0.0f, 1e-6);
+	}
+
+	// Left column lit.  The first output pixel's taps land
+	// three quarters of a texel past the edge, a quarter in and
+	// a texel and a quarter in: 1, 1 and 0.25, weighted 1:2:1.
+	// Reading zeros past the edge would give 0.4375
+	Bloom::Image low(4, 4);
+	for (unsigned int y = 0; y < 4; y++)
+		low.At(0, y) = XMFLOAT3(1, 1, 1);
+	Bloom::Image up = Bloom::UpsampleTent(low, Bloom::Image(8, 8), 1.0f);
+	for (unsigned int y = 0; y < up.Height; y++)
+	{
+		CHECK_NEAR(up.At(0, y).x, 0.8125f, 1e-6);
+		CHECK_NEAR(up.At(7, y).x, 0.0f, 1e-6);
+	}
+}
+
+TEST(PrefilterOnlyPassesBrightColors)
+{
+	CHECK(Bloom::Prefilter(XMFLOAT3(0.2f, 0.2f, 0.2f), 1.0f, 0.5f).x == 0.0f);
+	CHECK_NEAR(Bloom::Prefilter(XMFLOAT3(3, 3, 3), 1.0f, 0.5f).x, 2.0f, 1e-5);
+
+	// Inside the knee it's soft, not cut off
+	XMFLOAT3 knee = Bloom::Prefilter(XMFLOAT3(0.9f, 0.9f, 0.9f), 1.0f, 0.5f);
+	CHECK(knee.x > 0.0f && knee.x < 0.9f);
+}
@@ -0,0 +1,130 @@
+#include "TestFramework.h"
+#include "../CommandRecorder.h"
+#include <atomic>
+#include <chrono>
+
+namespace
+{
+	// Every item recorded once, by the chunk it belongs to
+	bool CoversEachItemOnce(const std::vector<std::atomic<unsigned int>>& owners, unsigned int chunkSize)
+	{
+		for (unsigned int i = 0; i < owners.size(); i++)
+			if (owners[i] != i / chunkSize + 1)
+				return false;
+		return true;
+	}
+}
+
+TEST(ChunksSplitTheSameForAnyWorkerCount)
+{
+	const unsigned int workerCounts[] = { 1, 2, 3, 8 };
+	for (unsigned int workers : workerCounts)
+	{
+		auto jobs = std::make_shared<JobSystem>(workers);
+		ParallelCommandRecorder recorder(jobs);
+		NullCommandRecordingBackend backend;
+
+		std::vector<std::atomic<unsigned int>> owners(103);
+		std::vector<unsigned int> chunkSizes(11, 0);
+		recorder.Record(backend, 103, 10, [&](ID3D11DeviceContext* context, unsigned int begin, unsigned int end)
+			{
+				CHECK(context == 0);
+				for (unsigned int i = begin; i < end; i++)
+					owners[i] = begin / 10 + 1;
+				chunkSizes[begin / 10] = end - begin;
+			});
+
+		CHECK(recorder.GetChunkCount() == 11);
+		CHECK(CoversEachItemOnce(owners, 10));
+		for (unsigned int c = 0; c < 10; c++)
+			CHECK(chunkSizes[c] == 10);
+		CHECK(chunkSizes[10] == 3);
+		CHECK(backend.Events.front() == "Reserve 11");
+		CHECK(backend.GetRecordingThreadCount() >= 1);
+	}
+}
+
+TEST(ChunksExecuteInSubmissionOrder)
+{
+	auto jobs = std::make_shared<JobSystem>(4);
+	ParallelCommandRecorder recorder(jobs);
+	NullCommandRecordingBackend backend;
+
+	// Later chunks finish first
+	recorder.Record(backend, 8, 1, [](ID3D11DeviceContext*, unsigned int begin, unsigned int)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds((8 - begin) * 3));
+		});
+
+	std::vector<unsigned int> order = backend.GetExecutionOrder();
+	CHECK(order.size() == 8);
+	for (unsigned int i = 0; i < order.size(); i++)
+		CHECK(order[i] == i);
+
+	// And nothing plays back until every chunk has ended
+	size_t lastEnd = 0;
+	size_t firstExecute = backend.Events.size();
+	for (size_t e = 0; e < backend.Events.size(); e++)
+	{
+		if (backend.Events[e].rfind("End ", 0) == 0)
+			lastEnd = e;
+		else if (backend.Events[e].rfind("Execute ", 0) == 0 && e < firstExecute)
+			firstExecute = e;
+	}
+	CHECK(lastEnd < firstExecute);
+}
+
+TEST(EmptyDrawListRecordsNothing)
+{
+	auto jobs = std::make_shared<JobSystem>(2);
+	ParallelCommandRecorder recorder(jobs);
+	NullCommandRecordingBackend backend;
+
+	bool called = false;
+	recorder.Record(backend, 0, 16, [&](ID3D11DeviceContext*, unsigned int, unsigned int) { called = true; });
+	CHECK(!called);
+	CHECK(recorder.GetChunkCount() == 0);
+	CHECK(backend.Events.empty());
+
+	// A chunk size of zero is treated as one
+	std::vector<std::atomic<unsigned int>> owners(3);
+	recorder.Record(backend, 3, 0, [&](ID3D11DeviceContext*, unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				owners[i] = begin + 1;
+		});
+	CHECK(recorder.GetChunkCount() == 3);
+	CHECK(CoversEachItemOnce(owners, 1));
+}
+
+TEST(MoreChunksThanWorkers)
+{
+	auto jobs = std::make_shared<JobSystem>(2);
+	ParallelCommandRecorder recorder(jobs);
+	NullCommandRecordingBackend backend;
+
+	std::vector<std::atomic<unsigned int>> owners(500);
+	recorder.Record(backend, 500, 3, [&](ID3D11DeviceContext*, unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				owners[i] = begin / 3 + 1;
+		});
+
+	CHECK(recorder.GetChunkCount() == 167);
+	CHECK(CoversEachItemOnce(owners, 3));
+	std::vector<unsigned int> order = backend.GetExecutionOrder();
+	CHECK(order.size() == 167);
+	bool inOrder = true;
+	for (unsigned int i = 0; i < order.size(); i++)
+		inOrder = inOrder && order[i] == i;
+	CHECK(inOrder);
+
+	// Each chunk began and ended exactly once
+	unsigned int begins = 0, ends = 0;
+	for (auto& e : backend.Events)
+	{
+		begins += e.rfind("Begin ", 0) == 0;
+		ends += e.rfind("End ", 0) == 0;
+	}
+	CHECK(begins == 167 && ends == 167);
+}
@@ -0,0 +1,165 @@
+#include "TestFramework.h"
+#include "../FrameTiming.h"
+
+namespace
+{
+	// --------------------------------------------------------
+	// Clock that only moves when told to.  Sleeps wake up late
+	// by a fixed amount and a zero sleep (a spin) costs a tick,
+	// like a real scheduler would
+	// --------------------------------------------------------
+	class FakeFrameClock : public IFrameClock
+	{
+	public:
+		double Time = 10.0;
+		double Oversleep = 0.0;
+		double SpinTick = 0.0001;
+		int Sleeps = 0;
+		int Spins = 0;
+
+		double Now() override { return Time; }
+		void Sleep(double seconds) override
+		{
+			if (seconds > 0.0)
+			{
+				Time += seconds + Oversleep;
+				Sleeps++;
+			}
+			else
+			{
+				Time += SpinTick;
+				Spins++;
+			}
+		}
+	};
+}
+
+TEST(FixedTimestepCarriesLeftoverTime)
+{
+	FixedTimestep timestep(0.01, 8);
+	CHECK(timestep.Advance(0.025) == 2);
+	CHECK_NEAR(timestep.GetAlpha(), 0.5, 1e-9);
+	CHECK(timestep.Advance(0.005) == 1);
+	CHECK_NEAR(timestep.GetAlpha(), 0.0, 1e-9);
+	CHECK(timestep.Advance(0.004) == 0);
+	CHECK(timestep.GetStepCount() == 3);
+	CHECK_NEAR(timestep.GetTime(), 0.03, 1e-9);
+}
+
+TEST(FixedTimestepIgnoresNegativeTime)
+{
+	FixedTimestep timestep(0.01, 8);
+	CHECK(timestep.Advance(-1.0) == 0);
+	CHECK_NEAR(timestep.GetAlpha(), 0.0, 1e-12);
+}
+
+TEST(FixedTimestepDropsLongStalls)
+{
+	FixedTimestep timestep(0.01, 4);
+	CHECK(timestep.Advance(1.0045) == 4);
+
+	// 4 steps run, the rest of the whole steps are dropped and the
+	// remainder is kept
+	CHECK_NEAR(timestep.GetDroppedTime(), 0.96, 1e-9);
+	CHECK_NEAR(timestep.GetAlpha(), 0.45, 1e-6);
+	CHECK(timestep.Advance(0.0) == 0);
+}
+
+TEST(FixedTimestepKeepsTimeWhenStepChanges)
+{
+	FixedTimestep timestep(0.01, 8);
+	timestep.Advance(0.055);
+	CHECK(timestep.GetStepCount() == 5);
+
+	timestep.SetStep(0.02);
+	CHECK_NEAR(timestep.GetTime() + timestep.GetAlpha() * timestep.GetStep(), 0.055, 1e-9);
+	CHECK(timestep.GetStepCount() == 2);
+}
+
+TEST(FixedTimestepKeepsWaitingTimeWhenStepShrinks)
+{
+	FixedTimestep timestep(0.02, 8);
+	CHECK(timestep.Advance(0.039) == 1);
+
+	// 0.019 was waiting: three whole steps of the new size, and
+	// none of it is lost
+	timestep.SetStep(0.005);
+	CHECK(timestep.GetStepCount() == 4);
+	CHECK(timestep.Advance(0.0) == 3);
+	CHECK(timestep.GetStepCount() == 7);
+	CHECK_NEAR(timestep.GetTime() + timestep.GetAlpha() * timestep.GetStep(), 0.039, 1e-9);
+	CHECK_NEAR(timestep.GetAlpha(), 0.8, 1e-6);
+	CHECK(timestep.GetDroppedTime() == 0.0);
+}
+
+TEST(FramePacerWithoutLimitNeverWaits)
+{
+	auto clock = std::make_shared<FakeFrameClock>();
+	FramePacer pacer(clock);
+	CHECK(pacer.WaitForNextFrame() == clock->Time);
+	CHECK(pacer.WaitForNextFrame() == clock->Time);
+	CHECK(clock->Sleeps == 0 && clock->Spins == 0);
+	CHECK(pacer.GetLastWait() == 0.0);
+}
+
+TEST(FramePacerHoldsTheGridDespiteOversleep)
+{
+	auto clock = std::make_shared<FakeFrameClock>();
+	clock->Oversleep = 0.001;
+	FramePacer pacer(clock);
+	pacer.SetTargetFrameRate(100.0);
+	pacer.SetSpinTime(0.002);
+
+	double first = pacer.WaitForNextFrame();
+	for (int frame = 1; frame <= 50; frame++)
+	{
+		// Each frame's work takes 3ms of the 10ms
+		clock->Time += 0.003;
+		double start = pacer.WaitForNextFrame();
+
+		// Spinning finishes the job within a tick, so wake up errors
+		// never build up across frames
+		double due = first + frame * 0.01;
+		CHECK(start >= due - 1e-9);
+		CHECK(start < due + clock->SpinTick + 1e-9);
+	}
+	CHECK(clock->Sleeps == 50);
+}
+
+TEST(FramePacerMovesTheGridAfterALongFrame)
+{
+	auto clock = std::make_shared<FakeFrameClock>();
+	FramePacer pacer(clock);
+	pacer.SetTargetFrameRate(100.0);
+
+	pacer.WaitForNextFrame();
+	clock->Time += 0.035;
+	double late = pacer.WaitForNextFrame();
+	CHECK(pacer.GetLastWait() == 0.0);
+
+	// The next frame is a whole interval after the late one, rather
+	// than a burst of frames catching up to the old grid
+	double next = pacer.WaitForNextFrame();
+	CHECK(next >= late + 0.01 - 1e-9);
+	CHECK(next < late + 0.01 + clock->SpinTick + 1e-9);
+}
+
+TEST(InputLatencyAveragesTheOldestEventEachSecond)
+{
+	const long long ms = 1000000;
+	InputLatencyTracker latency;
+	latency.Record(1000 * ms, 0, 0, 0); // Starts the first window
+
+	latency.Record(1010 * ms, 1005 * ms, 1002 * ms, 1008 * ms);
+	CHECK_NEAR(latency.GetNewestMs(), 5.0, 1e-3);
+	CHECK_NEAR(latency.GetOldestMs(), 8.0, 1e-3);
+	CHECK_NEAR(latency.GetLatchMs(), 2.0, 1e-3);
+	CHECK_NEAR(latency.GetMaxMs(), 0.0, 1e-9);
+
+	// Frames without input don't count toward the average
+	latency.Record(1500 * ms, 0, 0, 0);
+	CHECK_NEAR(latency.GetLatchMs(), 0.0, 1e-9);
+	latency.Record(2000 * ms, 1990 * ms, 1984 * ms, 0);
+	CHECK_NEAR(latency.GetAverageMs(), 12.0, 1e-3);
+	CHECK_NEAR(latency.GetMaxMs(), 16.0, 1e-3);
+}
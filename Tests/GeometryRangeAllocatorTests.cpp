@@ -0,0 +1,75 @@
+#include "TestFramework.h"
+#include "../GeometryRangeAllocator.h"
+
+TEST(AllocatorTakesTheFirstRangeThatFits)
+{
+	GeometryRangeAllocator allocator(100);
+	CHECK(allocator.Allocate(10) == 0);
+	CHECK(allocator.Allocate(20) == 10);
+	CHECK(allocator.Allocate(10) == 30);
+	CHECK(allocator.Allocate(30) == 40);
+	CHECK(allocator.Allocate(10) == 70);
+	CHECK(allocator.GetUsed() == 80);
+
+	// Holes of 20 at 10 and 30 at 40, then the 20 left at the end
+	allocator.Free(10, 20);
+	allocator.Free(40, 30);
+	CHECK(allocator.GetFreeRangeCount() == 3);
+	CHECK(allocator.GetLargestFreeRange() == 30);
+
+	// Too big for the first hole, so it goes in the second
+	CHECK(allocator.Allocate(25) == 40);
+
+	// Small enough for the first, which it splits
+	CHECK(allocator.Allocate(5) == 10);
+	CHECK(allocator.Allocate(15) == 15);
+	CHECK(allocator.GetFreeRangeCount() == 2);
+
+	CHECK(allocator.Allocate(31) == GeometryRangeAllocator::Invalid);
+	CHECK(allocator.Allocate(0) == GeometryRangeAllocator::Invalid);
+	CHECK(allocator.GetUsed() == 75);
+}
+
+TEST(FreeMergesWithBothNeighbors)
+{
+	GeometryRangeAllocator allocator(60);
+	unsigned int a = allocator.Allocate(20);
+	unsigned int b = allocator.Allocate(20);
+	unsigned int c = allocator.Allocate(20);
+	CHECK(allocator.GetFreeRangeCount() == 0);
+
+	allocator.Free(a, 20);
+	allocator.Free(c, 20);
+	CHECK(allocator.GetFreeRangeCount() == 2);
+
+	// Freeing the middle joins all three into one
+	allocator.Free(b, 20);
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.GetLargestFreeRange() == 60);
+	CHECK(allocator.GetUsed() == 0);
+	CHECK(allocator.Allocate(60) == 0);
+}
+
+TEST(GrowMergesWithAFreeTail)
+{
+	GeometryRangeAllocator allocator(50);
+	CHECK(allocator.Allocate(40) == 0);
+
+	// The 10 left at the end and the new 50 become one range
+	allocator.Grow(100);
+	CHECK(allocator.GetCapacity() == 100);
+	CHECK(allocator.GetUsed() == 40);
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.Allocate(60) == 40);
+
+	// With nothing free at the end it's a range of its own
+	allocator.Grow(120);
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.GetLargestFreeRange() == 20);
+	allocator.Free(0, 40);
+	CHECK(allocator.GetFreeRangeCount() == 2);
+
+	// Never shrinks
+	allocator.Grow(10);
+	CHECK(allocator.GetCapacity() == 120);
+}
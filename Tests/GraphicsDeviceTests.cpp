@@ -0,0 +1,143 @@
+#include "TestFramework.h"
+#include "../GraphicsDevice.h"
+#include "../GraphicsDeviceNull.h"
+#include <wrl/client.h>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	D3D11_BUFFER_DESC BufferDesc(unsigned int bytes)
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = bytes;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		return desc;
+	}
+
+	D3D11_TEXTURE2D_DESC TextureDesc(unsigned int width, unsigned int height, unsigned int mips, DXGI_FORMAT format)
+	{
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = mips;
+		desc.ArraySize = 1;
+		desc.Format = format;
+		desc.SampleDesc.Count = 1;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		return desc;
+	}
+}
+
+TEST(TextureBytesCoverEveryMip)
+{
+	// 4x4, 2x2 and 1x1 at 4 bytes a pixel
+	CHECK(GetTextureBytes(TextureDesc(4, 4, 0, DXGI_FORMAT_R8G8B8A8_UNORM)) == (16 + 4 + 1) * 4);
+	CHECK(GetTextureBytes(TextureDesc(4, 4, 1, DXGI_FORMAT_R8G8B8A8_UNORM)) == 16 * 4);
+
+	// Block compressed mips never go below one 4x4 block
+	CHECK(GetTextureBytes(TextureDesc(8, 8, 0, DXGI_FORMAT_BC1_UNORM)) == (4 + 1 + 1 + 1) * 8);
+}
+
+TEST(NullDeviceTracksLiveResources)
+{
+	NullGraphicsDevice device;
+	ComPtr<ID3D11Buffer> buffer;
+	ComPtr<ID3D11Texture2D> texture;
+	CHECK(device.CreateBuffer(BufferDesc(256), 0, buffer.GetAddressOf()) == S_OK);
+	CHECK(device.CreateTexture2D(TextureDesc(4, 4, 1, DXGI_FORMAT_R8G8B8A8_UNORM), 0, texture.GetAddressOf()) == S_OK);
+	CHECK(device.GetLiveResources() == 2);
+	CHECK(device.GetLiveBytes() == 256 + 64);
+
+	// Still alive while anything holds a reference
+	ComPtr<ID3D11Buffer> copy = buffer;
+	buffer.Reset();
+	CHECK(device.GetLiveBytes() == 256 + 64);
+	copy.Reset();
+	CHECK(device.GetLiveResources() == 1);
+	CHECK(device.GetLiveBytes() == 64);
+	texture.Reset();
+	CHECK(device.GetLiveResources() == 0);
+	CHECK(device.GetLiveBytes() == 0);
+
+	// Validation only, as in D3D11
+	CHECK(device.CreateBuffer(BufferDesc(256), 0, 0) == S_FALSE);
+	CHECK(device.GetLiveResources() == 0);
+}
+
+TEST(NullResourcesBehaveLikeResources)
+{
+	NullGraphicsDevice device;
+	ComPtr<ID3D11Texture2D> texture;
+	device.CreateTexture2D(TextureDesc(32, 16, 1, DXGI_FORMAT_R16G16B16A16_FLOAT), 0, texture.GetAddressOf());
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	texture->GetDesc(&desc);
+	CHECK(desc.Width == 32 && desc.Height == 16 && desc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT);
+
+	D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	texture->GetType(&dimension);
+	CHECK(dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D);
+
+	ComPtr<ID3D11Resource> resource;
+	CHECK(texture->QueryInterface(__uuidof(ID3D11Resource), (void**)resource.GetAddressOf()) == S_OK);
+	ComPtr<ID3D11Buffer> buffer;
+	CHECK(texture->QueryInterface(__uuidof(ID3D11Buffer), (void**)buffer.GetAddressOf()) == E_NOINTERFACE);
+	CHECK(!buffer);
+
+	const GUID guid = { 1, 2, 3, { 4, 5, 6, 7, 8, 9, 10, 11 } };
+	unsigned int value = 42;
+	CHECK(texture->SetPrivateData(guid, sizeof(value), &value) == S_OK);
+	unsigned int read = 0;
+	UINT size = sizeof(read);
+	CHECK(texture->GetPrivateData(guid, &size, &read) == S_OK);
+	CHECK(read == 42 && size == sizeof(read));
+
+	const GUID missing = { 9, 9, 9, { 9, 9, 9, 9, 9, 9, 9, 9 } };
+	CHECK(texture->GetPrivateData(missing, &size, &read) == DXGI_ERROR_NOT_FOUND);
+}
+
+TEST(RecordingDeviceSubtractsReleasedBytes)
+{
+	// No inner device means a null one
+	RecordingGraphicsDevice device;
+	ComPtr<ID3D11Buffer> buffer;
+	ComPtr<ID3D11Texture2D> texture;
+	unsigned char data[128] = {};
+	D3D11_SUBRESOURCE_DATA initialData = { data };
+	CHECK(device.CreateBuffer(BufferDesc(128), &initialData, buffer.GetAddressOf()) == S_OK);
+	CHECK(buffer);
+	CHECK(device.CreateTexture2D(TextureDesc(8, 8, 1, DXGI_FORMAT_R8G8B8A8_UNORM), 0, texture.GetAddressOf()) == S_OK);
+
+	GraphicsDeviceStats stats = device.GetStats();
+	CHECK(stats.ResourcesCreated == 2);
+	CHECK(stats.ResourceBytes == 128 + 256);
+	CHECK(stats.BytesUploaded == 128);
+
+	buffer.Reset();
+	CHECK(device.GetStats().ResourceBytes == 256);
+	texture.Reset();
+	stats = device.GetStats();
+	CHECK(stats.ResourceBytes == 0);
+	CHECK(stats.ResourcesCreated == 2);
+
+	// Failed or validation-only creation isn't counted
+	CHECK(device.CreateBuffer(BufferDesc(64), 0, 0) == S_FALSE);
+	CHECK(device.GetStats().ResourcesCreated == 2);
+}
+
+TEST(RecordingDeviceCountsDroppedSubmission)
+{
+	RecordingGraphicsDevice device(std::make_shared<NullGraphicsDevice>(), false);
+	CHECK(!device.IsSubmitting());
+	device.Draw(0, 36, 0);
+	device.DrawIndexed(0, 300, 0, 0);
+	device.SetShader(0, ShaderStage::Pixel, 0);
+	device.UpdateSubresource(0, 0, 0, 0, 64);
+
+	GraphicsDeviceStats stats = device.GetStats();
+	CHECK(stats.DrawCalls == 2);
+	CHECK(stats.Triangles == 12 + 100);
+	CHECK(stats.ShaderBinds == 1);
+	CHECK(stats.BytesUploaded == 64);
+}
@@ -0,0 +1,147 @@
+#include "TestFramework.h"
+#include "../InputEvents.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace
+{
+	InputEvent Numbered(int n)
+	{
+		InputEvent e = {};
+		e.Type = InputEventType::KeyDown;
+		e.Code = n;
+		e.TimeNs = n;
+		return e;
+	}
+}
+
+TEST(FullQueueDropsNewEvents)
+{
+	auto queue = std::make_unique<InputEventQueue>();
+	for (int i = 0; i < INPUT_EVENT_QUEUE_SIZE; i++)
+		CHECK(queue->Push(Numbered(i)));
+	CHECK(queue->GetDroppedCount() == 0);
+
+	CHECK(!queue->Push(Numbered(-1)));
+	CHECK(!queue->Push(Numbered(-2)));
+	CHECK(queue->GetDroppedCount() == 2);
+
+	// The oldest events survive, not the dropped ones
+	InputEvent e;
+	for (int i = 0; i < INPUT_EVENT_QUEUE_SIZE; i++)
+	{
+		CHECK(queue->Pop(e));
+		CHECK(e.Code == i);
+	}
+	CHECK(!queue->Pop(e));
+
+	// And there's room again
+	CHECK(queue->Push(Numbered(7)));
+	CHECK(queue->Pop(e) && e.Code == 7);
+}
+
+TEST(QueueWrapsAroundInOrder)
+{
+	auto queue = std::make_unique<InputEventQueue>();
+	int pushed = 0;
+	int popped = 0;
+
+	// Batches that don't divide the size, so the ends land all
+	// over the ring as it goes round several times
+	for (int batch = 0; batch < 10; batch++)
+	{
+		for (int i = 0; i < 700; i++)
+			CHECK(queue->Push(Numbered(pushed++)));
+
+		InputEvent e;
+		while (queue->Pop(e))
+			CHECK(e.Code == popped++);
+	}
+	CHECK(popped == pushed);
+	CHECK(pushed > INPUT_EVENT_QUEUE_SIZE * 6);
+	CHECK(queue->GetDroppedCount() == 0);
+}
+
+TEST(ProducerAndConsumerThreadsKeepOrder)
+{
+	const int count = 200000;
+	auto queue = std::make_unique<InputEventQueue>();
+
+	// The producer retries what's dropped, so everything arrives
+	unsigned long long failedPushes = 0;
+	std::thread producer([&]()
+		{
+			for (int i = 0; i < count; i++)
+			{
+				while (!queue->Push(Numbered(i)))
+				{
+					failedPushes++;
+					std::this_thread::yield();
+				}
+			}
+		});
+
+	int next = 0;
+	bool inOrder = true;
+	while (next < count)
+	{
+		InputEvent e;
+		if (!queue->Pop(e))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		inOrder = inOrder && e.Code == next && e.TimeNs == next;
+		next++;
+	}
+	producer.join();
+
+	CHECK(inOrder);
+	CHECK(queue->GetDroppedCount() == failedPushes);
+	InputEvent e;
+	CHECK(!queue->Pop(e));
+}
+
+TEST(DroppedEventsAreCountedUnderLoad)
+{
+	const int count = 100000;
+	auto queue = std::make_unique<InputEventQueue>();
+
+	// No retries this time: whatever doesn't fit is gone
+	std::atomic<bool> done(false);
+	int accepted = 0;
+	std::thread producer([&]()
+		{
+			for (int i = 0; i < count; i++)
+				accepted += queue->Push(Numbered(i));
+			done = true;
+		});
+
+	// A slow consumer, so the queue fills up
+	int received = 0;
+	int last = -1;
+	bool increasing = true;
+	auto consume = [&](const InputEvent& e)
+		{
+			increasing = increasing && e.Code > last;
+			last = e.Code;
+			received++;
+		};
+
+	InputEvent e;
+	while (!done)
+	{
+		if (queue->Pop(e))
+			consume(e);
+		if (received % 64 == 0)
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+	producer.join();
+	while (queue->Pop(e))
+		consume(e);
+
+	CHECK(increasing);
+	CHECK(received == accepted);
+	CHECK(queue->GetDroppedCount() == (unsigned long long)(count - accepted));
+}
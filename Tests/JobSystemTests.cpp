@@ -0,0 +1,123 @@
+#include "TestFramework.h"
+#include "../JobSystem.h"
+
+TEST(RunAndWaitFinishesEveryJob)
+{
+	JobSystem jobs(4);
+	std::atomic<int> sum(0);
+	JobCounter counter;
+	for (int i = 1; i <= 1000; i++)
+		jobs.Run([&sum, i]() { sum += i; }, counter);
+	jobs.Wait(counter);
+
+	CHECK(counter.Pending == 0);
+	CHECK(sum == 500500);
+}
+
+TEST(ParallelForCoversEachIndexOnce)
+{
+	JobSystem jobs(4);
+	const unsigned int grainSizes[] = { 0, 1, 7, 64, 5000 };
+	for (unsigned int grain : grainSizes)
+	{
+		std::vector<std::atomic<int>> hits(1000);
+		jobs.ParallelFor(1000, grain, [&hits](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				hits[i]++;
+		});
+
+		bool once = true;
+		for (auto& h : hits)
+			once = once && h == 1;
+		CHECK(once);
+	}
+
+	bool called = false;
+	jobs.ParallelFor(0, 8, [&called](unsigned int, unsigned int) { called = true; });
+	CHECK(!called);
+}
+
+TEST(JobsCanWaitOnTheirOwnJobs)
+{
+	JobSystem jobs(3);
+	std::atomic<int> leaves(0);
+	JobCounter outer;
+	for (int i = 0; i < 16; i++)
+	{
+		jobs.Run([&jobs, &leaves]()
+		{
+			JobCounter inner;
+			for (int j = 0; j < 16; j++)
+				jobs.Run([&leaves]() { leaves++; }, inner);
+			jobs.Wait(inner);
+		}, outer);
+	}
+	jobs.Wait(outer);
+	CHECK(leaves == 256);
+}
+
+TEST(SingleWorkerRunsEverythingInline)
+{
+	JobSystem jobs(1);
+	CHECK(jobs.GetWorkerCount() == 1);
+
+	// No worker threads, so Wait() has to run background jobs too
+	int ran = 0;
+	JobCounter counter;
+	jobs.Run([&ran]() { ran++; }, counter);
+	jobs.RunBackground([&ran]() { ran++; }, counter);
+	jobs.Wait(counter);
+	CHECK(ran == 2);
+}
+
+TEST(WaitDoesNotPickUpBackgroundJobs)
+{
+	JobSystem jobs(2);
+
+	// The background job can't finish until the caller has waited
+	// on its own batch, which it couldn't do if Wait() ran it inline
+	std::atomic<bool> release(false);
+	std::atomic<bool> backgroundThread(false);
+	std::thread::id caller = std::this_thread::get_id();
+	JobCounter background;
+	jobs.RunBackground([&]()
+	{
+		backgroundThread = std::this_thread::get_id() != caller;
+		while (!release)
+			std::this_thread::yield();
+	}, background);
+
+	std::atomic<int> ran(0);
+	JobCounter frame;
+	for (int i = 0; i < 100; i++)
+		jobs.Run([&ran]() { ran++; }, frame);
+	jobs.Wait(frame);
+	CHECK(ran == 100);
+	CHECK(background.Pending == 1);
+
+	release = true;
+	jobs.Wait(background);
+	CHECK(backgroundThread);
+}
+
+TEST(StatsCountEveryJob)
+{
+	JobSystem jobs(4);
+	jobs.ResetStats();
+
+	JobCounter counter;
+	for (int i = 0; i < 200; i++)
+		jobs.Run([]() {}, counter);
+	jobs.Wait(counter);
+
+	unsigned long long total = 0;
+	for (unsigned int w = 0; w < jobs.GetWorkerCount(); w++)
+	{
+		JobWorkerStats stats = jobs.GetWorkerStats(w);
+		total += stats.JobsRun;
+		CHECK(stats.Steals <= stats.JobsRun);
+		CHECK(stats.Utilization >= 0.0f);
+	}
+	CHECK(total == 200);
+}
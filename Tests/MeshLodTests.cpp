@@ -0,0 +1,186 @@
+#include "TestFramework.h"
+#include "../MeshLod.h"
+#include <set>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// UV sphere with a seam down one side and duplicated pole
+	// vertices, laid out the way sphere.obj is
+	// --------------------------------------------------------
+	void BuildSphere(int segments, int rings, std::vector<Vertex>& verts, std::vector<unsigned int>& indices)
+	{
+		for (int r = 0; r <= rings; r++)
+		{
+			for (int s = 0; s <= segments; s++)
+			{
+				float theta = XM_PI * r / rings;
+				float phi = XM_2PI * (s % segments) / segments;
+				Vertex v = {};
+				v.Position = XMFLOAT3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+				if (r == 0)
+					v.Position = XMFLOAT3(0, 1, 0);
+				if (r == rings)
+					v.Position = XMFLOAT3(0, -1, 0);
+				v.Normal = v.Position;
+				v.UV = XMFLOAT2((float)s / segments, (float)r / rings);
+				verts.push_back(v);
+			}
+		}
+
+		for (int r = 0; r < rings; r++)
+		{
+			for (int s = 0; s < segments; s++)
+			{
+				unsigned int a = r * (segments + 1) + s;
+				unsigned int b = a + 1;
+				unsigned int c = a + segments + 1;
+				unsigned int d = c + 1;
+				if (r > 0)
+					indices.insert(indices.end(), { a, b, c });
+				if (r < rings - 1)
+					indices.insert(indices.end(), { b, d, c });
+			}
+		}
+	}
+
+	// Flat, open grid of size x size quads in the xz plane
+	void BuildGrid(int size, std::vector<Vertex>& verts, std::vector<unsigned int>& indices)
+	{
+		for (int z = 0; z <= size; z++)
+		{
+			for (int x = 0; x <= size; x++)
+			{
+				Vertex v = {};
+				v.Position = XMFLOAT3((float)x, 0, (float)z);
+				v.Normal = XMFLOAT3(0, 1, 0);
+				v.UV = XMFLOAT2((float)x / size, (float)z / size);
+				verts.push_back(v);
+			}
+		}
+
+		for (int z = 0; z < size; z++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				unsigned int a = z * (size + 1) + x;
+				unsigned int c = a + size + 1;
+				indices.insert(indices.end(), { a, c, a + 1, a + 1, c, c + 1 });
+			}
+		}
+	}
+}
+
+TEST(SimplifyStaysWithinTolerance)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	BuildSphere(48, 24, verts, indices);
+
+	for (int level = 1; level <= 3; level++)
+	{
+		int target = (int)indices.size() >> level;
+		target -= target % 3;
+		MeshLod::SimplifyResult result = MeshLod::Simplify(verts.data(), (int)verts.size(), indices.data(), (int)indices.size(), target, 0.2f);
+
+		CHECK(result.Indices.size() % 3 == 0);
+		CHECK(result.Indices.size() <= indices.size());
+		CHECK(result.Error <= 0.2f);
+
+		// Same vertex buffer, so every index must still be valid
+		for (unsigned int i : result.Indices)
+			CHECK(i < verts.size());
+
+		float deviation = MeshLod::MeasureDeviation(verts.data(), indices.data(), (int)indices.size(), result.Indices.data(), (int)result.Indices.size());
+		CHECK(deviation < 0.1f);
+	}
+}
+
+TEST(SimplifyHalvesTheSphere)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	BuildSphere(48, 24, verts, indices);
+
+	int target = (int)indices.size() / 2;
+	target -= target % 3;
+	MeshLod::SimplifyResult result = MeshLod::Simplify(verts.data(), (int)verts.size(), indices.data(), (int)indices.size(), target, 0.2f);
+	CHECK(result.Indices.size() <= (size_t)target);
+}
+
+TEST(SimplifyKeepsSeams)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	BuildSphere(48, 24, verts, indices);
+
+	int target = (int)indices.size() / 4;
+	target -= target % 3;
+	MeshLod::SimplifyResult result = MeshLod::Simplify(verts.data(), (int)verts.size(), indices.data(), (int)indices.size(), target, 0.2f);
+
+	// Both copies of every vertex on the UV seam are left where they are
+	std::set<unsigned int> used(result.Indices.begin(), result.Indices.end());
+	for (int r = 1; r < 24; r++)
+	{
+		CHECK(used.count(r * 49) == 1);
+		CHECK(used.count(r * 49 + 48) == 1);
+	}
+}
+
+TEST(SimplifyStopsAtMaxError)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	BuildSphere(48, 24, verts, indices);
+
+	// A curved surface can't lose anything for free
+	MeshLod::SimplifyResult result = MeshLod::Simplify(verts.data(), (int)verts.size(), indices.data(), (int)indices.size(), 3, 1e-6f);
+	CHECK(result.Indices.size() > indices.size() / 2);
+	CHECK(result.Error <= 1e-6f);
+}
+
+TEST(SimplifyKeepsOpenBorders)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	BuildGrid(8, verts, indices);
+
+	MeshLod::SimplifyResult result = MeshLod::Simplify(verts.data(), (int)verts.size(), indices.data(), (int)indices.size(), 0, 0.01f);
+
+	// Flat, so the inside collapses for free, but the outline stays
+	CHECK(result.Indices.size() < indices.size() / 2);
+	std::set<unsigned int> used(result.Indices.begin(), result.Indices.end());
+	for (unsigned int i = 0; i < verts.size(); i++)
+	{
+		const XMFLOAT3& p = verts[i].Position;
+		bool border = p.x == 0.0f || p.x == 8.0f || p.z == 0.0f || p.z == 8.0f;
+		if (border)
+			CHECK(used.count(i) == 1);
+	}
+}
+
+TEST(ProjectedSizeFillsTheScreenWhenClose)
+{
+	CHECK(MeshLod::ProjectedSize(1.0f, 0.5f, XM_PIDIV2) == 1.0f);
+	CHECK_NEAR(MeshLod::ProjectedSize(1.0f, 10.0f, XM_PIDIV2), 0.1f, 1e-6);
+	CHECK(MeshLod::ProjectedSize(1.0f, 20.0f, XM_PIDIV2) < MeshLod::ProjectedSize(1.0f, 10.0f, XM_PIDIV2));
+}
+
+TEST(SelectLodHasHysteresis)
+{
+	const float thresholds[3] = { 0.5f, 0.25f, 0.12f };
+
+	// Within 10% of a threshold stays put, further past it switches
+	CHECK(MeshLod::SelectLod(0, 0.47f, thresholds, 4, 0.1f) == 0);
+	CHECK(MeshLod::SelectLod(0, 0.44f, thresholds, 4, 0.1f) == 1);
+	CHECK(MeshLod::SelectLod(1, 0.52f, thresholds, 4, 0.1f) == 1);
+	CHECK(MeshLod::SelectLod(1, 0.56f, thresholds, 4, 0.1f) == 0);
+
+	// Big jumps skip levels, and the ends clamp
+	CHECK(MeshLod::SelectLod(0, 0.05f, thresholds, 4, 0.1f) == 3);
+	CHECK(MeshLod::SelectLod(3, 0.9f, thresholds, 4, 0.1f) == 0);
+	CHECK(MeshLod::SelectLod(7, 0.05f, thresholds, 4, 0.1f) == 3);
+	CHECK(MeshLod::SelectLod(0, 0.0f, thresholds, 1, 0.1f) == 0);
+}
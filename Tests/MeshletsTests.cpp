@@ -0,0 +1,201 @@
+#include "TestFramework.h"
+#include "../Meshlets.h"
+#include <algorithm>
+#include <array>
+#include <set>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Flat grid of quads in the z = 0 plane, two triangles each,
+	// wound so they face -Z (toward a camera in front of them)
+	// --------------------------------------------------------
+	void BuildGrid(unsigned int quads, std::vector<Vertex>& verts, std::vector<unsigned int>& indices)
+	{
+		unsigned int side = quads + 1;
+		verts.clear();
+		indices.clear();
+		for (unsigned int y = 0; y < side; y++)
+		{
+			for (unsigned int x = 0; x < side; x++)
+			{
+				Vertex v = {};
+				v.Position = XMFLOAT3((float)x, (float)y, 0.0f);
+				verts.push_back(v);
+			}
+		}
+		for (unsigned int y = 0; y < quads; y++)
+		{
+			for (unsigned int x = 0; x < quads; x++)
+			{
+				unsigned int i = y * side + x;
+				unsigned int quad[6] = { i, i + side, i + 1, i + 1, i + side, i + side + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	// Looking down +Z from the origin, 90 degrees both ways
+	void CameraPlanes(XMFLOAT4 planes[6])
+	{
+		XMFLOAT4X4 proj;
+		XMStoreFloat4x4(&proj, XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 100.0f));
+		Meshlets::ExtractFrustumPlanes(proj, planes);
+	}
+
+	Meshlets::Meshlet Sphere(XMFLOAT3 center, float radius)
+	{
+		Meshlets::Meshlet m = {};
+		m.Center = center;
+		m.Radius = radius;
+		m.ConeCutoff = 1.0f;
+		return m;
+	}
+}
+
+TEST(BuildRespectsLimitsAndKeepsEveryTriangle)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	BuildGrid(10, verts, indices);
+
+	const unsigned int limits[][2] = { { 16, 12 }, { 64, 124 }, { 3, 1 }, { 8, 100 } };
+	for (auto& limit : limits)
+	{
+		std::vector<unsigned int> reordered;
+		std::vector<Meshlets::Meshlet> meshlets = Meshlets::Build(verts.data(), indices.data(), (int)indices.size(), reordered, limit[0], limit[1]);
+		CHECK(reordered.size() == indices.size());
+
+		unsigned int next = 0;
+		for (auto& m : meshlets)
+		{
+			CHECK(m.TriangleCount >= 1);
+			CHECK(m.TriangleCount <= limit[1]);
+			CHECK(m.VertexCount <= limit[0]);
+			CHECK(m.StartIndex == next);
+			next += m.TriangleCount * 3;
+
+			std::set<unsigned int> unique(reordered.begin() + m.StartIndex, reordered.begin() + m.StartIndex + m.TriangleCount * 3);
+			CHECK(unique.size() == m.VertexCount);
+		}
+		CHECK(next == reordered.size());
+
+		// Same triangles, same winding, each exactly once
+		std::vector<std::array<unsigned int, 3>> before, after;
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			before.push_back({ indices[t], indices[t + 1], indices[t + 2] });
+			after.push_back({ reordered[t], reordered[t + 1], reordered[t + 2] });
+		}
+		std::sort(before.begin(), before.end());
+		std::sort(after.begin(), after.end());
+		CHECK(before == after);
+	}
+}
+
+TEST(FlatPatchIsOnlyCulledFromBehind)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	BuildGrid(4, verts, indices);
+	std::vector<unsigned int> reordered;
+	std::vector<Meshlets::Meshlet> meshlets = Meshlets::Build(verts.data(), indices.data(), (int)indices.size(), reordered);
+	CHECK(meshlets.size() == 1);
+
+	const Meshlets::Meshlet& m = meshlets[0];
+	CHECK_NEAR(m.ConeAxis.z, -1.0f, 1e-5);
+	CHECK_NEAR(m.ConeCutoff, 0.0f, 1e-5);
+	CHECK_NEAR(m.Center.x, 2.0f, 1e-5);
+	CHECK_NEAR(m.Radius, sqrtf(8.0f), 1e-5);
+
+	CHECK(!Meshlets::IsBackFacing(m, XMFLOAT3(2, 2, -10)));
+	CHECK(Meshlets::IsBackFacing(m, XMFLOAT3(2, 2, 10)));
+
+	// Behind but closer than the sphere's radius, or edge on:
+	// the test stays conservative and keeps it
+	CHECK(!Meshlets::IsBackFacing(m, XMFLOAT3(2, 2, 1)));
+	CHECK(!Meshlets::IsBackFacing(m, XMFLOAT3(20, 2, 0)));
+}
+
+TEST(FrustumPlanesFromAKnownProjection)
+{
+	XMFLOAT4 planes[6];
+	CameraPlanes(planes);
+
+	const float s = sqrtf(0.5f);
+	const XMFLOAT4 expected[6] =
+	{
+		{ s, 0, s, 0 },		// Left
+		{ -s, 0, s, 0 },	// Right
+		{ 0, s, s, 0 },		// Bottom
+		{ 0, -s, s, 0 },	// Top
+		{ 0, 0, 1, -1 },	// Near
+		{ 0, 0, -1, 100 }	// Far
+	};
+	for (int i = 0; i < 6; i++)
+	{
+		CHECK_NEAR(planes[i].x, expected[i].x, 1e-4);
+		CHECK_NEAR(planes[i].y, expected[i].y, 1e-4);
+		CHECK_NEAR(planes[i].z, expected[i].z, 1e-4);
+		CHECK_NEAR(planes[i].w, expected[i].w, 1e-3);
+	}
+
+	CHECK(!Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(0, 0, 10), 1), planes));
+	CHECK(Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(0, 0, -5), 1), planes));
+	CHECK(Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(0, 0, 102), 1), planes));
+	CHECK(Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(20, 0, 10), 1), planes));
+	CHECK(Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(0, -20, 10), 1), planes));
+
+	// Straddling a plane is still inside
+	CHECK(!Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(10.5f, 0, 10), 1), planes));
+	CHECK(!Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(0, 0, 100.5f), 1), planes));
+	CHECK(!Meshlets::IsOutsideFrustum(Sphere(XMFLOAT3(0, 0, 0.5f), 1), planes));
+}
+
+TEST(CullMergesAdjacentRanges)
+{
+	XMFLOAT4 planes[6];
+	CameraPlanes(planes);
+	XMFLOAT3 camera(0, 0, 0);
+
+	std::vector<Meshlets::Meshlet> meshlets;
+	auto add = [&](unsigned int start, unsigned int triangles, XMFLOAT3 center)
+		{
+			Meshlets::Meshlet m = Sphere(center, 1);
+			m.StartIndex = start;
+			m.TriangleCount = triangles;
+			meshlets.push_back(m);
+		};
+	add(0, 2, XMFLOAT3(0, 0, 10));
+	add(6, 1, XMFLOAT3(1, 0, 10));		// Follows on, merged
+	add(9, 3, XMFLOAT3(0, 0, -10));		// Behind the camera
+	add(18, 1, XMFLOAT3(0, 0, 20));		// A gap before it
+	add(21, 2, XMFLOAT3(0, 1, 20));		// Merged again
+
+	// Facing straight away from the camera
+	Meshlets::Meshlet away = Sphere(XMFLOAT3(0, 0, 30), 1);
+	away.StartIndex = 27;
+	away.TriangleCount = 4;
+	away.ConeAxis = XMFLOAT3(0, 0, 1);
+	away.ConeCutoff = 0.0f;
+	meshlets.push_back(away);
+	add(39, 1, XMFLOAT3(0, 0, 40));
+
+	std::vector<Meshlets::Range> ranges;
+	Meshlets::CullStats stats = Meshlets::Cull(meshlets, camera, planes, ranges);
+	CHECK(stats.FrustumCulled == 1);
+	CHECK(stats.BackFaceCulled == 1);
+	CHECK(stats.TrianglesKept == 2 + 1 + 1 + 2 + 1);
+
+	CHECK(ranges.size() == 3);
+	CHECK(ranges[0].StartIndex == 0 && ranges[0].IndexCount == 9);
+	CHECK(ranges[1].StartIndex == 18 && ranges[1].IndexCount == 9);
+	CHECK(ranges[2].StartIndex == 39 && ranges[2].IndexCount == 3);
+
+	// Nothing left over from a previous call
+	meshlets.resize(1);
+	Meshlets::Cull(meshlets, camera, planes, ranges);
+	CHECK(ranges.size() == 1 && ranges[0].IndexCount == 6);
+}
@@ -0,0 +1,156 @@
+#include "TestFramework.h"
+#include "../Occlusion.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Looking down +Z from the origin, 90 degrees both ways
+	XMFLOAT4X4 CameraViewProj()
+	{
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 0.1f, 100.0f));
+		return viewProj;
+	}
+
+	// Two triangles facing the camera at the given depth
+	void RasterizeQuad(Occlusion::DepthBuffer& buffer, float minX, float maxX, float minY, float maxY, float z, const XMFLOAT4X4& viewProj)
+	{
+		XMFLOAT3 positions[4] = { { minX, minY, z }, { maxX, minY, z }, { maxX, maxY, z }, { minX, maxY, z } };
+		unsigned int indices[6] = { 0, 1, 2, 0, 2, 3 };
+		Occlusion::RasterizeOccluder(buffer, positions, indices, 6, viewProj);
+	}
+}
+
+TEST(RasterizeFillsAQuad)
+{
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	Occlusion::DepthBuffer buffer;
+	buffer.Resize(16, 16);
+
+	// Clip space straight through: x and y from -0.5 to 0.5 is
+	// pixels 4 to 11 of 16, both ways
+	RasterizeQuad(buffer, -0.5f, 0.5f, -0.5f, 0.5f, 0.25f, identity);
+	for (unsigned int y = 0; y < 16; y++)
+	{
+		for (unsigned int x = 0; x < 16; x++)
+		{
+			bool inside = x >= 4 && x <= 11 && y >= 4 && y <= 11;
+			CHECK(buffer.At(x, y) == (inside ? 0.25f : 1.0f));
+		}
+	}
+}
+
+TEST(RasterizeClipsAgainstTheNearPlane)
+{
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	Occlusion::DepthBuffer buffer;
+	buffer.Resize(16, 16);
+
+	// Depth runs from -1 on the left edge to 1 on the right, so
+	// only the right half is in front of the near plane
+	XMFLOAT3 positions[4] = { { -1, -1, -1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, -1 } };
+	unsigned int indices[6] = { 0, 1, 2, 0, 2, 3 };
+	Occlusion::RasterizeOccluder(buffer, positions, indices, 6, identity);
+
+	for (unsigned int x = 0; x < 8; x++)
+		CHECK(buffer.At(x, 8) == 1.0f);
+	for (unsigned int x = 8; x < 16; x++)
+	{
+		float ndcX = (x + 0.5f) / 16.0f * 2.0f - 1.0f;
+		CHECK_NEAR(buffer.At(x, 8), ndcX, 1e-5);
+	}
+}
+
+TEST(PyramidKeepsTheMaxOverOddSizes)
+{
+	Occlusion::DepthBuffer base;
+	base.Resize(5, 3, 0.1f);
+	base.At(4, 0) = 0.7f; // Odd column, folded into the last texel
+	base.At(2, 2) = 0.9f; // Odd row
+
+	Occlusion::DepthPyramid pyramid;
+	pyramid.Build(base);
+	CHECK(pyramid.Levels.size() == 3);
+
+	const Occlusion::DepthBuffer& half = pyramid.Levels[1];
+	CHECK(half.Width == 2 && half.Height == 1);
+	CHECK(half.At(0, 0) == 0.1f);
+	CHECK(half.At(1, 0) == 0.9f);
+
+	const Occlusion::DepthBuffer& last = pyramid.Levels[2];
+	CHECK(last.Width == 1 && last.Height == 1);
+	CHECK(last.At(0, 0) == 0.9f);
+
+	// Without the odd row the last texel still sees the odd column
+	base.At(2, 2) = 0.1f;
+	pyramid.Build(base);
+	CHECK(pyramid.Levels[1].At(1, 0) == 0.7f);
+}
+
+TEST(SphereCrossingTheNearPlaneIsNotValid)
+{
+	XMFLOAT4X4 viewProj = CameraViewProj();
+	CHECK(!Occlusion::ProjectSphere(XMFLOAT3(0, 0, 0.3f), 0.5f, viewProj, 64, 64).Valid);
+	CHECK(!Occlusion::ProjectSphere(XMFLOAT3(0, 0, -5), 1.0f, viewProj, 64, 64).Valid);
+
+	Occlusion::ScreenBounds bounds = Occlusion::ProjectSphere(XMFLOAT3(0, 0, 10), 1.0f, viewProj, 64, 64);
+	CHECK(bounds.Valid);
+	CHECK(bounds.MinX < 32 && bounds.MaxX > 32);
+	CHECK(bounds.MinY < 32 && bounds.MaxY > 32);
+	CHECK(bounds.MinDepth > 0.0f && bounds.MinDepth < 1.0f);
+}
+
+TEST(SphereBehindAFullScreenOccluderIsHidden)
+{
+	XMFLOAT4X4 viewProj = CameraViewProj();
+	Occlusion::DepthBuffer buffer;
+	buffer.Resize(64, 64);
+	RasterizeQuad(buffer, -10, 10, -10, 10, 5, viewProj);
+	Occlusion::DepthPyramid pyramid;
+	pyramid.Build(buffer);
+
+	CHECK(Occlusion::IsOccluded(pyramid, Occlusion::ProjectSphere(XMFLOAT3(0, 0, 20), 1.0f, viewProj, 64, 64)));
+	CHECK(Occlusion::IsOccluded(pyramid, Occlusion::ProjectSphere(XMFLOAT3(3, -2, 40), 2.0f, viewProj, 64, 64)));
+
+	// In front of it, and poking through it
+	CHECK(!Occlusion::IsOccluded(pyramid, Occlusion::ProjectSphere(XMFLOAT3(0, 0, 2), 0.5f, viewProj, 64, 64)));
+	CHECK(!Occlusion::IsOccluded(pyramid, Occlusion::ProjectSphere(XMFLOAT3(0, 0, 5.5f), 1.0f, viewProj, 64, 64)));
+}
+
+TEST(SpherePartlyUncoveredIsNotHidden)
+{
+	XMFLOAT4X4 viewProj = CameraViewProj();
+	Occlusion::DepthBuffer buffer;
+	buffer.Resize(64, 64);
+	RasterizeQuad(buffer, -10, 0, -10, 10, 5, viewProj); // Left half of the screen
+	Occlusion::DepthPyramid pyramid;
+	pyramid.Build(buffer);
+
+	CHECK(Occlusion::IsOccluded(pyramid, Occlusion::ProjectSphere(XMFLOAT3(-8, 0, 20), 2.0f, viewProj, 64, 64)));
+	CHECK(!Occlusion::IsOccluded(pyramid, Occlusion::ProjectSphere(XMFLOAT3(0, 0, 20), 2.0f, viewProj, 64, 64)));
+	CHECK(!Occlusion::IsOccluded(pyramid, Occlusion::ProjectSphere(XMFLOAT3(8, 0, 20), 2.0f, viewProj, 64, 64)));
+}
+
+TEST(SphereOffTheEdgeIsOnlyTestedInPart)
+{
+	XMFLOAT4X4 viewProj = CameraViewProj();
+	Occlusion::DepthBuffer buffer;
+	buffer.Resize(64, 64);
+	RasterizeQuad(buffer, -10, 10, -10, 10, 5, viewProj);
+	Occlusion::DepthPyramid pyramid;
+	pyramid.Build(buffer);
+
+	// Half of it is past the left edge, where nothing was
+	// rasterized, yet the part on screen reads as hidden
+	Occlusion::ScreenBounds edge = Occlusion::ProjectSphere(XMFLOAT3(-20, 0, 20), 2.0f, viewProj, 64, 64);
+	CHECK(edge.Valid);
+	CHECK(Occlusion::IsOccluded(pyramid, edge));
+	CHECK(Occlusion::CrossesEdge(edge, 64, 64));
+
+	Occlusion::ScreenBounds inside = Occlusion::ProjectSphere(XMFLOAT3(3, -2, 40), 2.0f, viewProj, 64, 64);
+	CHECK(!Occlusion::CrossesEdge(inside, 64, 64));
+	CHECK(Occlusion::CrossesEdge(Occlusion::ProjectSphere(XMFLOAT3(0, 30, 20), 2.0f, viewProj, 64, 64), 64, 64));
+}
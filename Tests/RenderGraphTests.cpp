@@ -0,0 +1,318 @@
+#include "TestFramework.h"
+#include "../RenderGraph.h"
+#include <algorithm>
+
+namespace
+{
+	const RenderGraphTextureDesc hdrDesc = { 1280, 720, 10, false };
+	const RenderGraphTextureDesc halfDesc = { 640, 360, 10, false };
+
+	int CountEvents(const RenderGraphRecordingBackend& backend, const std::string& event)
+	{
+		return (int)std::count(backend.Events.begin(), backend.Events.end(), event);
+	}
+
+	// Position of an event, or -1
+	int FindEvent(const RenderGraphRecordingBackend& backend, const std::string& event)
+	{
+		auto it = std::find(backend.Events.begin(), backend.Events.end(), event);
+		return it == backend.Events.end() ? -1 : (int)(it - backend.Events.begin());
+	}
+
+	// --------------------------------------------------------
+	// A bloom-like chain: scene -> bright -> blur -> composite.
+	// The scene is read again at the end, so it lives the whole
+	// frame
+	// --------------------------------------------------------
+	struct Chain
+	{
+		RenderGraphResource BackBuffer;
+		RenderGraphResource Scene;
+		RenderGraphResource Bright;
+		RenderGraphResource Blur;
+	};
+
+	Chain BuildChain(RenderGraph& graph, RenderGraphTextureDesc brightDesc)
+	{
+		Chain c = {};
+		c.BackBuffer = graph.ImportTexture("BackBuffer");
+		c.Scene = graph.CreateTexture("Scene", hdrDesc);
+		c.Bright = graph.CreateTexture("Bright", brightDesc);
+		c.Blur = graph.CreateTexture("Blur", halfDesc);
+		graph.MarkOutput(c.BackBuffer);
+
+		graph.AddPass("Scene", [&](RenderGraphPassBuilder& b) { b.Write(c.Scene); }, nullptr);
+		graph.AddPass("Bright", [&](RenderGraphPassBuilder& b) { b.Read(c.Scene, RenderGraphStage::Pixel, 0); b.Write(c.Bright); }, nullptr);
+		graph.AddPass("Blur", [&](RenderGraphPassBuilder& b) { b.Read(c.Bright, RenderGraphStage::Pixel, 0); b.Write(c.Blur); }, nullptr);
+		graph.AddPass("Composite", [&](RenderGraphPassBuilder& b)
+		{
+			b.Read(c.Scene, RenderGraphStage::Pixel, 0);
+			b.Read(c.Blur, RenderGraphStage::Pixel, 1);
+			b.Write(c.BackBuffer);
+		}, nullptr);
+		return c;
+	}
+
+	// --------------------------------------------------------
+	// The frame Game::BuildRenderGraph() declares around the
+	// depth pre-pass.  The scene pass only clears depth when
+	// the pre-pass was culled, as Game does
+	// --------------------------------------------------------
+	void BuildPrepassFrame(RenderGraph& graph, bool prepass, bool hiZ, bool& sceneClearedDepth)
+	{
+		RenderGraphResource backBuffer = graph.ImportTexture("BackBuffer");
+		RenderGraphResource depth = graph.ImportTexture("Depth");
+		RenderGraphResource scene = graph.ImportTexture("Scene");
+		graph.MarkOutput(backBuffer);
+
+		graph.AddPass("DepthPrepass", [=](RenderGraphPassBuilder& b) { b.Write(depth); }, nullptr);
+		graph.AddPass("Scene", [=](RenderGraphPassBuilder& b)
+		{
+			b.Write(scene);
+			if (prepass)
+			{
+				b.Read(depth);
+				b.Write(depth);
+			}
+			else
+				b.Overwrite(depth);
+		}, [&graph, &sceneClearedDepth]() { sceneClearedDepth = graph.IsPassCulled("DepthPrepass"); });
+		graph.AddPass("Sky", [=](RenderGraphPassBuilder& b) { b.Write(scene); b.Write(depth); }, nullptr);
+		if (hiZ)
+			graph.AddPass("HiZ", [=](RenderGraphPassBuilder& b) { b.Read(depth, RenderGraphStage::Pixel, 0); b.SetSideEffects(); }, nullptr);
+		graph.AddPass("PostProcess", [=](RenderGraphPassBuilder& b) { b.Read(scene); b.Write(backBuffer); }, nullptr);
+	}
+}
+
+TEST(UnusedPassesAreCulled)
+{
+	RenderGraph graph;
+	RenderGraphResource backBuffer = graph.ImportTexture("BackBuffer");
+	RenderGraphResource scene = graph.CreateTexture("Scene", hdrDesc);
+	RenderGraphResource debug = graph.CreateTexture("Debug", hdrDesc);
+	RenderGraphResource debug2 = graph.CreateTexture("Debug2", hdrDesc);
+	graph.MarkOutput(backBuffer);
+
+	bool debugRan = false;
+	graph.AddPass("Scene", [&](RenderGraphPassBuilder& b) { b.Write(scene); }, nullptr);
+	graph.AddPass("Debug", [&](RenderGraphPassBuilder& b) { b.Read(scene); b.Write(debug); }, [&]() { debugRan = true; });
+	graph.AddPass("Debug2", [&](RenderGraphPassBuilder& b) { b.Read(debug); b.Write(debug2); }, nullptr);
+	graph.AddPass("Readback", [&](RenderGraphPassBuilder& b) { b.Read(scene); b.SetSideEffects(); }, nullptr);
+	graph.AddPass("Present", [&](RenderGraphPassBuilder& b) { b.Read(scene, RenderGraphStage::Pixel, 0); b.Write(backBuffer); }, nullptr);
+
+	RenderGraphRecordingBackend backend;
+	graph.Execute(backend);
+
+	// Debug only feeds Debug2, which feeds nothing
+	CHECK(graph.IsPassCulled("Debug"));
+	CHECK(graph.IsPassCulled("Debug2"));
+	CHECK(!graph.IsPassCulled("Readback"));
+	CHECK(!debugRan);
+	CHECK(graph.GetCulledPassCount() == 2);
+	CHECK((backend.GetPassOrder() == std::vector<std::string>{ "Scene", "Readback", "Present" }));
+
+	// Culled transients never get memory
+	CHECK(graph.GetPhysicalIndex(debug) == -1);
+	CHECK(graph.GetPhysicalTextureCount() == 1);
+}
+
+TEST(TransientsShareMemoryWhenLifetimesDontOverlap)
+{
+	RenderGraph graph;
+	Chain c = BuildChain(graph, halfDesc);
+	graph.Compile();
+
+	// Blur is written by the pass that reads Bright, so their
+	// lifetimes overlap even though they match
+	CHECK(graph.GetPhysicalIndex(c.Scene) != graph.GetPhysicalIndex(c.Bright));
+	CHECK(graph.GetPhysicalIndex(c.Bright) != graph.GetPhysicalIndex(c.Blur));
+	CHECK(graph.GetPhysicalIndex(c.BackBuffer) == -1);
+	CHECK(graph.GetPhysicalTextureCount() == 3);
+
+	// Passes added after the composite can reuse memory that's
+	// dead by then: a half size step takes Bright's, and a full
+	// size one takes Scene's
+	graph.Reset();
+	c = BuildChain(graph, halfDesc);
+	RenderGraphResource blur2 = graph.CreateTexture("Blur2", halfDesc);
+	RenderGraphResource output = graph.CreateTexture("Output", hdrDesc);
+	graph.AddPass("Blur2", [&](RenderGraphPassBuilder& b) { b.Read(c.Blur, RenderGraphStage::Pixel, 0); b.Write(blur2); }, nullptr);
+	graph.AddPass("Output", [&](RenderGraphPassBuilder& b) { b.Read(blur2, RenderGraphStage::Pixel, 0); b.Write(output); b.SetSideEffects(); }, nullptr);
+	graph.Compile();
+
+	CHECK(graph.GetPhysicalIndex(blur2) == graph.GetPhysicalIndex(c.Bright));
+	CHECK(graph.GetPhysicalIndex(output) == graph.GetPhysicalIndex(c.Scene));
+	CHECK(graph.GetPhysicalTextureCount() == 3);
+}
+
+TEST(DifferentDescriptionsNeverShare)
+{
+	RenderGraph graph;
+	RenderGraphResource a = graph.CreateTexture("A", hdrDesc);
+	RenderGraphResource b = graph.CreateTexture("B", halfDesc);
+	RenderGraphResource c = graph.CreateTexture("C", hdrDesc);
+	graph.AddPass("A", [&](RenderGraphPassBuilder& p) { p.Write(a); }, nullptr);
+	graph.AddPass("B", [&](RenderGraphPassBuilder& p) { p.Read(a); p.Write(b); }, nullptr);
+	graph.AddPass("C", [&](RenderGraphPassBuilder& p) { p.Read(b); p.Write(c); p.SetSideEffects(); }, nullptr);
+	graph.Compile();
+
+	// A is dead by the time C starts, and they match
+	CHECK(graph.GetPhysicalIndex(a) == graph.GetPhysicalIndex(c));
+	CHECK(graph.GetPhysicalIndex(b) != graph.GetPhysicalIndex(a));
+	CHECK(graph.GetPhysicalTextureCount() == 2);
+}
+
+TEST(PhysicalTexturesAreOnlyCreatedWhenTheyChange)
+{
+	RenderGraph graph;
+	RenderGraphRecordingBackend backend;
+
+	BuildChain(graph, halfDesc);
+	graph.Execute(backend);
+	CHECK(CountEvents(backend, "CreateTexture 0") == 1);
+	CHECK(CountEvents(backend, "CreateTexture 2") == 1);
+
+	// Same graph next frame: nothing to create
+	backend.Events.clear();
+	graph.Reset();
+	BuildChain(graph, halfDesc);
+	graph.Execute(backend);
+	CHECK(FindEvent(backend, "CreateTexture 0") == -1);
+	CHECK(FindEvent(backend, "CreateTexture 1") == -1);
+	CHECK(FindEvent(backend, "CreateTexture 2") == -1);
+
+	// Bright changes size, so only its texture is remade
+	backend.Events.clear();
+	graph.Reset();
+	Chain c = BuildChain(graph, hdrDesc);
+	graph.Execute(backend);
+	CHECK(CountEvents(backend, "CreateTexture " + std::to_string(graph.GetPhysicalIndex(c.Bright))) == 1);
+	CHECK(FindEvent(backend, "CreateTexture " + std::to_string(graph.GetPhysicalIndex(c.Scene))) == -1);
+
+	// A smaller graph releases what it no longer needs
+	backend.Events.clear();
+	graph.Reset();
+	RenderGraphResource only = graph.CreateTexture("Only", hdrDesc);
+	graph.AddPass("Only", [&](RenderGraphPassBuilder& b) { b.Write(only); b.SetSideEffects(); }, nullptr);
+	graph.Execute(backend);
+	CHECK(CountEvents(backend, "ReleaseTexture 2") == 1);
+	CHECK(CountEvents(backend, "ReleaseTexture 1") == 1);
+	CHECK(FindEvent(backend, "ReleaseTexture 0") == -1);
+}
+
+TEST(HazardsAreUnboundOnlyWhenNeeded)
+{
+	RenderGraph graph;
+	RenderGraphRecordingBackend backend;
+	BuildChain(graph, halfDesc);
+	graph.Execute(backend);
+
+	// Each pass reads what the one before it just wrote, so the
+	// render targets come off before Bright, Blur and Composite
+	CHECK(CountEvents(backend, "UnbindRenderTargets") == 3);
+	CHECK(FindEvent(backend, "UnbindRenderTargets") < FindEvent(backend, "Pass Bright"));
+
+	// Nothing written this frame is still bound as an input, so
+	// no shader resources need clearing
+	CHECK(FindEvent(backend, "UnbindSRV 1 0") == -1);
+	CHECK(graph.GetUnbindCount() == 3);
+
+	// Next frame the scene pass writes Scene while the composite
+	// still has it bound at pixel slot 0 from last frame
+	backend.Events.clear();
+	graph.Reset();
+	BuildChain(graph, halfDesc);
+	graph.Execute(backend);
+	int unbind = FindEvent(backend, "UnbindSRV 1 0");
+	CHECK(unbind != -1);
+	CHECK(unbind < FindEvent(backend, "Pass Scene"));
+}
+
+TEST(ImportsAreTrackedByNameAcrossFrames)
+{
+	RenderGraph graph;
+	RenderGraphRecordingBackend backend;
+
+	RenderGraphResource shadow = graph.ImportTexture("ShadowMap");
+	RenderGraphResource backBuffer = graph.ImportTexture("BackBuffer");
+	graph.MarkOutput(backBuffer);
+	graph.AddPass("Lighting", [&](RenderGraphPassBuilder& b) { b.Read(shadow, RenderGraphStage::Pixel, 4); b.Write(backBuffer); }, nullptr);
+	graph.Execute(backend);
+	CHECK(FindEvent(backend, "UnbindSRV 1 4") == -1);
+
+	// A new frame declares the imports in a different order, but
+	// the shadow map is still the one bound at slot 4
+	backend.Events.clear();
+	graph.Reset();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	shadow = graph.ImportTexture("ShadowMap");
+	graph.MarkOutput(backBuffer);
+	graph.AddPass("Shadows", [&](RenderGraphPassBuilder& b) { b.Write(shadow); }, nullptr);
+	graph.AddPass("Lighting", [&](RenderGraphPassBuilder& b) { b.Read(shadow, RenderGraphStage::Pixel, 4); b.Write(backBuffer); }, nullptr);
+	graph.Execute(backend);
+	CHECK(FindEvent(backend, "UnbindSRV 1 4") != -1);
+	CHECK(FindEvent(backend, "UnbindSRV 1 4") < FindEvent(backend, "Pass Shadows"));
+}
+
+TEST(DepthPrepassRunsBeforeTheSceneOnlyWhenEnabled)
+{
+	for (bool hiZ : { false, true })
+	{
+		RenderGraph graph;
+		RenderGraphRecordingBackend backend;
+		bool sceneClearedDepth = true;
+		BuildPrepassFrame(graph, true, hiZ, sceneClearedDepth);
+		graph.Execute(backend);
+
+		int prepass = FindEvent(backend, "Pass DepthPrepass");
+		CHECK(prepass != -1);
+		CHECK(prepass < FindEvent(backend, "Pass Scene"));
+		CHECK(!sceneClearedDepth);
+
+		// Turned off, the scene's clear makes the pre-pass pointless,
+		// even with Hi-Z reading depth at the end of the frame
+		graph.Reset();
+		backend.Events.clear();
+		sceneClearedDepth = false;
+		BuildPrepassFrame(graph, false, hiZ, sceneClearedDepth);
+		graph.Execute(backend);
+
+		CHECK(graph.IsPassCulled("DepthPrepass"));
+		CHECK(FindEvent(backend, "Pass DepthPrepass") == -1);
+		CHECK(FindEvent(backend, "Pass Scene") != -1);
+		CHECK(!graph.IsPassCulled("Sky"));
+		CHECK(sceneClearedDepth);
+	}
+}
+
+TEST(OverwritesOnlyCullEarlierWriters)
+{
+	RenderGraph graph;
+	RenderGraphResource backBuffer = graph.ImportTexture("BackBuffer");
+	RenderGraphResource scene = graph.CreateTexture("Scene", hdrDesc);
+	RenderGraphResource mask = graph.CreateTexture("Mask", halfDesc);
+	graph.MarkOutput(backBuffer);
+
+	graph.AddPass("EarlyMask", [&](RenderGraphPassBuilder& b) { b.Write(mask); }, nullptr);
+	graph.AddPass("Scene", [&](RenderGraphPassBuilder& b) { b.Read(mask); b.Overwrite(scene); }, nullptr);
+	graph.AddPass("Decals", [&](RenderGraphPassBuilder& b) { b.Write(scene); }, nullptr);
+	graph.AddPass("Present", [&](RenderGraphPassBuilder& b) { b.Read(scene); b.Write(backBuffer); }, nullptr);
+
+	// What the overwriting pass reads is still needed
+	RenderGraphRecordingBackend backend;
+	graph.Execute(backend);
+	CHECK((backend.GetPassOrder() == std::vector<std::string>{ "EarlyMask", "Scene", "Decals", "Present" }));
+
+	// An overwrite after the scene leaves nothing before it
+	graph.Reset();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	scene = graph.CreateTexture("Scene", hdrDesc);
+	graph.MarkOutput(backBuffer);
+	graph.AddPass("Scene", [&](RenderGraphPassBuilder& b) { b.Write(scene); }, nullptr);
+	graph.AddPass("Clear", [&](RenderGraphPassBuilder& b) { b.Overwrite(scene); }, nullptr);
+	graph.AddPass("Present", [&](RenderGraphPassBuilder& b) { b.Read(scene); b.Write(backBuffer); }, nullptr);
+	backend.Events.clear();
+	graph.Execute(backend);
+	CHECK(graph.IsPassCulled("Scene"));
+	CHECK((backend.GetPassOrder() == std::vector<std::string>{ "Clear", "Present" }));
+}
@@ -0,0 +1,166 @@
+#include "TestFramework.h"
+#include "../ShadowAtlas.h"
+
+namespace
+{
+	// Six faces of a point light, all in the light's group
+	void AddPointLight(std::vector<ShadowAtlasRequest>& requests, unsigned int light, unsigned int size, float importance)
+	{
+		for (unsigned int face = 0; face < 6; face++)
+			requests.push_back({ light * 6 + face, light, size, importance });
+	}
+
+	bool Overlap(const ShadowAtlasTile& a, const ShadowAtlasTile& b)
+	{
+		return a.X < b.X + b.Size && b.X < a.X + a.Size && a.Y < b.Y + b.Size && b.Y < a.Y + a.Size;
+	}
+
+	// Every tile handed out is inside the atlas and on its own
+	bool TilesAreValid(ShadowAtlas& atlas, const std::vector<ShadowAtlasRequest>& requests)
+	{
+		std::vector<ShadowAtlasTile> tiles;
+		for (auto& r : requests)
+		{
+			ShadowAtlasTile tile;
+			if (!atlas.GetTile(r.Key, tile))
+				continue;
+			if (tile.X + tile.Size > atlas.GetAtlasSize() || tile.Y + tile.Size > atlas.GetAtlasSize())
+				return false;
+			if (tile.X % tile.Size != 0 || tile.Y % tile.Size != 0)
+				return false;
+			for (auto& other : tiles)
+			{
+				if (Overlap(tile, other))
+					return false;
+			}
+			tiles.push_back(tile);
+		}
+		return true;
+	}
+
+	int CountTiles(ShadowAtlas& atlas, unsigned int light)
+	{
+		int count = 0;
+		ShadowAtlasTile tile;
+		for (unsigned int face = 0; face < 6; face++)
+			count += atlas.GetTile(light * 6 + face, tile) ? 1 : 0;
+		return count;
+	}
+}
+
+TEST(TilesNeverOverlap)
+{
+	ShadowAtlas atlas(4096, 128);
+	std::vector<ShadowAtlasRequest> requests;
+	const unsigned int sizes[] = { 1024, 512, 512, 256, 2048, 128, 256, 1024 };
+	for (unsigned int i = 0; i < 8; i++)
+		requests.push_back({ i, i, sizes[i], 1.0f - i * 0.1f });
+
+	atlas.Update(requests);
+	CHECK(atlas.GetTileCount() == 8);
+	CHECK(atlas.GetNewTileCount() == 8);
+	CHECK(TilesAreValid(atlas, requests));
+}
+
+TEST(UnchangedRequestsKeepTheirTiles)
+{
+	ShadowAtlas atlas(2048, 128);
+	std::vector<ShadowAtlasRequest> requests = { { 1, 1, 512, 0.5f }, { 2, 2, 256, 0.3f } };
+	atlas.Update(requests);
+
+	ShadowAtlasTile before;
+	CHECK(atlas.GetTile(1, before));
+
+	// Key 2 changes size, key 1 doesn't
+	requests[1].Size = 1024;
+	atlas.Update(requests);
+	ShadowAtlasTile after;
+	CHECK(atlas.GetTile(1, after));
+	CHECK(after.X == before.X && after.Y == before.Y && after.Size == before.Size);
+	CHECK(!atlas.IsTileNew(1));
+	CHECK(atlas.IsTileNew(2));
+	CHECK(atlas.GetNewTileCount() == 1);
+	CHECK(TilesAreValid(atlas, requests));
+}
+
+TEST(FreedTilesMergeBack)
+{
+	ShadowAtlas atlas(1024, 64);
+	std::vector<ShadowAtlasRequest> requests;
+	for (unsigned int i = 0; i < 16; i++)
+		requests.push_back({ i, i, 64, 1.0f });
+	atlas.Update(requests);
+	CHECK(atlas.GetTileCount() == 16);
+
+	// Once they're gone the whole atlas is one square again
+	atlas.Update({ { 100, 100, 1024, 1.0f } });
+	ShadowAtlasTile tile;
+	CHECK(atlas.GetTile(100, tile));
+	CHECK(tile.Size == 1024);
+	CHECK_NEAR(atlas.GetUsage(), 1.0f, 1e-6);
+}
+
+TEST(GroupsShrinkTogetherToFit)
+{
+	// Six 512s don't fit in a 1024 atlas, six 256s do
+	ShadowAtlas atlas(1024, 128);
+	std::vector<ShadowAtlasRequest> requests;
+	AddPointLight(requests, 0, 512, 1.0f);
+	atlas.Update(requests);
+
+	CHECK(CountTiles(atlas, 0) == 6);
+	for (unsigned int face = 0; face < 6; face++)
+	{
+		ShadowAtlasTile tile;
+		atlas.GetTile(face, tile);
+		CHECK(tile.Size == 256);
+	}
+	CHECK(TilesAreValid(atlas, requests));
+}
+
+TEST(GroupsGetAllFacesOrNone)
+{
+	// Room for sixteen 256 tiles: two lights fit, the third doesn't
+	ShadowAtlas atlas(1024, 256);
+	std::vector<ShadowAtlasRequest> requests;
+	AddPointLight(requests, 0, 256, 0.9f);
+	AddPointLight(requests, 1, 256, 0.5f);
+	AddPointLight(requests, 2, 256, 0.1f);
+	atlas.Update(requests);
+
+	CHECK(CountTiles(atlas, 0) == 6);
+	CHECK(CountTiles(atlas, 1) == 6);
+	CHECK(CountTiles(atlas, 2) == 0);
+	CHECK(atlas.GetTileCount() == 12);
+	CHECK(TilesAreValid(atlas, requests));
+}
+
+TEST(ImportanceBeatsKeepingATile)
+{
+	ShadowAtlas atlas(1024, 256);
+	std::vector<ShadowAtlasRequest> requests;
+	AddPointLight(requests, 0, 256, 0.2f);
+	AddPointLight(requests, 1, 256, 0.1f);
+	atlas.Update(requests);
+	CHECK(CountTiles(atlas, 0) == 6 && CountTiles(atlas, 1) == 6);
+
+	// A more important light shows up: the least important one
+	// gives its tiles up, even though it had them first
+	AddPointLight(requests, 2, 256, 0.8f);
+	atlas.Update(requests);
+	CHECK(CountTiles(atlas, 2) == 6);
+	CHECK(CountTiles(atlas, 0) == 6);
+	CHECK(CountTiles(atlas, 1) == 0);
+	CHECK(!atlas.IsTileNew(0));
+	CHECK(atlas.IsTileNew(2 * 6));
+	CHECK(TilesAreValid(atlas, requests));
+}
+
+TEST(SizeForImportanceIsAPowerOfTwo)
+{
+	CHECK(ShadowAtlas::SizeForImportance(1.0f, 128, 1024) == 1024);
+	CHECK(ShadowAtlas::SizeForImportance(0.6f, 128, 1024) == 512);
+	CHECK(ShadowAtlas::SizeForImportance(0.3f, 128, 1024) == 256);
+	CHECK(ShadowAtlas::SizeForImportance(0.0f, 128, 1024) == 128);
+	CHECK(ShadowAtlas::SizeForImportance(5.0f, 128, 1024) == 1024);
+}
@@ -0,0 +1,150 @@
+#include "TestFramework.h"
+#include "../ShadowCascades.h"
+
+using namespace DirectX;
+
+namespace
+{
+	void GetSlice(XMFLOAT3 position, float nearDepth, float farDepth, XMFLOAT3 corners[8])
+	{
+		ShadowCascades::GetFrustumSliceCorners(
+			position, XMFLOAT3(0, 0, 1), XMFLOAT3(0, 1, 0), XMFLOAT3(1, 0, 0),
+			XM_PIDIV2, 16.0f / 9.0f, nearDepth, farDepth, corners);
+	}
+
+	XMFLOAT3 ToClip(const ShadowCascades::Cascade& cascade, XMFLOAT3 p)
+	{
+		XMFLOAT3 clip;
+		XMStoreFloat3(&clip, XMVector3TransformCoord(XMLoadFloat3(&p), XMLoadFloat4x4(&cascade.ViewProjection)));
+		return clip;
+	}
+
+	bool InsideCascade(const ShadowCascades::Cascade& cascade, const XMFLOAT3 corners[8])
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			XMFLOAT3 c = ToClip(cascade, corners[i]);
+			if (fabsf(c.x) > 1.0f || fabsf(c.y) > 1.0f || c.z < 0.0f || c.z > 1.0f)
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST(SplitsCoverTheWholeRange)
+{
+	float splits[5];
+	ShadowCascades::ComputeSplits(0.1f, 100.0f, 4, 0.7f, splits);
+	CHECK(splits[0] == 0.1f);
+	CHECK(splits[4] == 100.0f);
+	for (int i = 1; i <= 4; i++)
+		CHECK(splits[i] > splits[i - 1]);
+}
+
+TEST(SplitsBlendUniformAndLogarithmic)
+{
+	float uniform[3];
+	ShadowCascades::ComputeSplits(1.0f, 100.0f, 2, 0.0f, uniform);
+	CHECK_NEAR(uniform[1], 50.5f, 1e-4);
+
+	float logarithmic[3];
+	ShadowCascades::ComputeSplits(1.0f, 100.0f, 2, 1.0f, logarithmic);
+	CHECK_NEAR(logarithmic[1], 10.0f, 1e-4);
+}
+
+TEST(SliceCornersMatchTheFrustum)
+{
+	XMFLOAT3 corners[8];
+	ShadowCascades::GetFrustumSliceCorners(
+		XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 1), XMFLOAT3(0, 1, 0), XMFLOAT3(1, 0, 0),
+		XM_PIDIV2, 1.0f, 1.0f, 2.0f, corners);
+
+	// 90 degrees wide, so each corner is as far out as it is deep
+	for (int i = 0; i < 8; i++)
+	{
+		float depth = i < 4 ? 1.0f : 2.0f;
+		CHECK_NEAR(corners[i].z, depth, 1e-5);
+		CHECK_NEAR(fabsf(corners[i].x), depth, 1e-5);
+		CHECK_NEAR(fabsf(corners[i].y), depth, 1e-5);
+	}
+}
+
+TEST(FitContainsTheSlice)
+{
+	XMFLOAT3 corners[8];
+	GetSlice(XMFLOAT3(3, 2, -7), 5.0f, 20.0f, corners);
+
+	XMFLOAT3 lightDirections[] = { XMFLOAT3(1, -1, 0.5f), XMFLOAT3(0, -1, 0), XMFLOAT3(-0.3f, -0.2f, 1) };
+	for (XMFLOAT3 light : lightDirections)
+	{
+		ShadowCascades::Cascade cascade = ShadowCascades::FitCascade(corners, light, 1024, 50.0f);
+		CHECK(InsideCascade(cascade, corners));
+		CHECK_NEAR(cascade.TexelSize, cascade.Radius * 2.0f / 1024.0f, 1e-6);
+	}
+}
+
+TEST(FitIsOnTheTexelGrid)
+{
+	XMFLOAT3 corners[8];
+	GetSlice(XMFLOAT3(1.37f, 0.5f, 2.91f), 1.0f, 10.0f, corners);
+	ShadowCascades::Cascade cascade = ShadowCascades::FitCascade(corners, XMFLOAT3(1, -2, 1), 2048, 20.0f);
+
+	// The left and bottom edges of the ortho box land on whole texels
+	float left = (cascade.LightSpaceCenter.x - cascade.Radius) / cascade.TexelSize;
+	float bottom = (cascade.LightSpaceCenter.y - cascade.Radius) / cascade.TexelSize;
+	CHECK_NEAR(left, roundf(left), 1e-2);
+	CHECK_NEAR(bottom, roundf(bottom), 1e-2);
+}
+
+TEST(SmallMovesKeepTheSameFit)
+{
+	XMFLOAT3 light(0.4f, -1, 0.3f);
+	XMFLOAT3 corners[8];
+	GetSlice(XMFLOAT3(0, 0, 0), 1.0f, 15.0f, corners);
+	ShadowCascades::Cascade start = ShadowCascades::FitCascade(corners, light, 1024, 30.0f);
+
+	// Walk forward in small steps: the fit only changes every so
+	// often, and it always still covers the slice
+	int changes = 0;
+	ShadowCascades::Cascade previous = start;
+	for (int i = 1; i <= 200; i++)
+	{
+		GetSlice(XMFLOAT3(0, 0, i * 0.01f), 1.0f, 15.0f, corners);
+		ShadowCascades::Cascade cascade = ShadowCascades::FitCascade(corners, light, 1024, 30.0f);
+		CHECK(InsideCascade(cascade, corners));
+		if (!ShadowCascades::SameFit(cascade, previous))
+			changes++;
+		previous = cascade;
+	}
+	CHECK(changes > 0);
+	CHECK(changes < 20);
+}
+
+TEST(SameFitNoticesLightCasterAndSliceChanges)
+{
+	XMFLOAT3 corners[8];
+	GetSlice(XMFLOAT3(0, 0, 0), 1.0f, 15.0f, corners);
+	ShadowCascades::Cascade a = ShadowCascades::FitCascade(corners, XMFLOAT3(0.4f, -1, 0.3f), 1024, 30.0f);
+	CHECK(ShadowCascades::SameFit(a, ShadowCascades::FitCascade(corners, XMFLOAT3(0.4f, -1, 0.3f), 1024, 30.0f)));
+	CHECK(!ShadowCascades::SameFit(a, ShadowCascades::FitCascade(corners, XMFLOAT3(0.5f, -1, 0.3f), 1024, 30.0f)));
+	CHECK(!ShadowCascades::SameFit(a, ShadowCascades::FitCascade(corners, XMFLOAT3(0.4f, -1, 0.3f), 1024, 40.0f)));
+
+	XMFLOAT3 longer[8];
+	GetSlice(XMFLOAT3(0, 0, 0), 1.0f, 25.0f, longer);
+	CHECK(!ShadowCascades::SameFit(a, ShadowCascades::FitCascade(longer, XMFLOAT3(0.4f, -1, 0.3f), 1024, 30.0f)));
+}
+
+TEST(CastersBetweenTheLightAndTheSliceCount)
+{
+	XMFLOAT3 corners[8];
+	GetSlice(XMFLOAT3(0, 0, 0), 1.0f, 15.0f, corners);
+	ShadowCascades::Cascade cascade = ShadowCascades::FitCascade(corners, XMFLOAT3(0, -1, 0), 1024, 30.0f);
+
+	// Straight up from the slice (toward the light), even far past
+	// the near plane, still casts into it
+	CHECK(ShadowCascades::CasterVisible(cascade, XMFLOAT3(0, 200, 8), 1.0f));
+
+	// Off to the side or underneath it doesn't
+	CHECK(!ShadowCascades::CasterVisible(cascade, XMFLOAT3(500, 0, 8), 1.0f));
+	CHECK(!ShadowCascades::CasterVisible(cascade, XMFLOAT3(0, -200, 8), 1.0f));
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cmath>
+#include <vector>
+
+// --------------------------------------------------------
+// Just enough of a test harness for the modules that don't
+// touch the graphics API.  TEST(name) registers a function,
+// CHECK() reports a failure and keeps going, and TestMain.cpp
+// runs everything and returns the number of failed tests
+// --------------------------------------------------------
+namespace Tests
+{
+	struct TestCase
+	{
+		const char* Name;
+		void (*Run)();
+	};
+
+	std::vector<TestCase>& Registry();
+	void Fail(const char* file, int line, const char* expression);
+
+	struct Registrar
+	{
+		Registrar(const char* name, void (*run)()) { Registry().push_back({ name, run }); }
+	};
+}
+
+#define TEST(name) \
+	static void name(); \
+	static Tests::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) Tests::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	CHECK(std::fabs((double)(a) - (double)(b)) <= (double)(tolerance))
@@ -0,0 +1,37 @@
+#include "TestFramework.h"
+#include <cstdio>
+
+namespace
+{
+	// Failures reported by the test that's currently running
+	int currentFailures = 0;
+}
+
+std::vector<Tests::TestCase>& Tests::Registry()
+{
+	// Function local so registration order between files doesn't matter
+	static std::vector<TestCase> registry;
+	return registry;
+}
+
+void Tests::Fail(const char* file, int line, const char* expression)
+{
+	printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+	currentFailures++;
+}
+
+int main()
+{
+	int failedTests = 0;
+	for (const Tests::TestCase& test : Tests::Registry())
+	{
+		currentFailures = 0;
+		test.Run();
+		printf("%s %s\n", currentFailures == 0 ? "[pass]" : "[FAIL]", test.Name);
+		if (currentFailures > 0)
+			failedTests++;
+	}
+
+	printf("%d of %d tests failed\n", failedTests, (int)Tests::Registry().size());
+	return failedTests;
+}
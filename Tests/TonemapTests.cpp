@@ -0,0 +1,87 @@
+#include "TestFramework.h"
+#include "../Tonemap.h"
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	const Tonemap::Operator Operators[] = { Tonemap::TONEMAP_NONE, Tonemap::TONEMAP_REINHARD, Tonemap::TONEMAP_ACES };
+}
+
+TEST(BlackStaysBlack)
+{
+	for (Tonemap::Operator op : Operators)
+	{
+		CHECK(Tonemap::Apply(op, 0.0f) == 0.0f);
+		XMFLOAT3 pixel = Tonemap::TonemapPixel(XMFLOAT3(0, 0, 0), 4.0f, op);
+		CHECK(pixel.x == 0.0f && pixel.y == 0.0f && pixel.z == 0.0f);
+	}
+}
+
+TEST(CurvesNeverGetDarkerAsInputGrows)
+{
+	for (Tonemap::Operator op : Operators)
+	{
+		float last = Tonemap::Apply(op, 0.0f);
+		for (float x = 0.01f; x < 100.0f; x *= 1.1f)
+		{
+			float value = Tonemap::Apply(op, x);
+			CHECK(value >= last);
+			CHECK(value <= 1.0f);
+			last = value;
+		}
+	}
+
+	float last = Tonemap::LinearToSRGB(0.0f);
+	for (float x = 0.0001f; x <= 1.0f; x += 0.0001f)
+	{
+		float value = Tonemap::LinearToSRGB(x);
+		CHECK(value >= last);
+		last = value;
+	}
+}
+
+TEST(BrightInputSaturatesTowardOne)
+{
+	CHECK(Tonemap::Reinhard(1000.0f) > 0.999f);
+	CHECK(Tonemap::ACESFilmic(1000.0f) == 1.0f);
+	CHECK(Tonemap::Apply(Tonemap::TONEMAP_NONE, 5.0f) == 1.0f);
+	CHECK_NEAR(Tonemap::LinearToSRGB(1.0f), 1.0f, 1e-6);
+}
+
+TEST(CurvesMatchTheShaderFormulas)
+{
+	// x / (1 + x)
+	CHECK_NEAR(Tonemap::Reinhard(1.0f), 0.5f, 1e-6);
+	CHECK_NEAR(Tonemap::Reinhard(3.0f), 0.75f, 1e-6);
+
+	// (x(2.51x + 0.03)) / (x(2.43x + 0.59) + 0.14), saturated
+	CHECK_NEAR(Tonemap::ACESFilmic(1.0f), 2.54 / 3.16, 1e-6);
+	CHECK_NEAR(Tonemap::ACESFilmic(0.18f), (0.18 * (2.51 * 0.18 + 0.03)) / (0.18 * (2.43 * 0.18 + 0.59) + 0.14), 1e-6);
+
+	// Linear segment below the cutoff, power curve above it
+	CHECK_NEAR(Tonemap::LinearToSRGB(0.002f), 0.002 * 12.92, 1e-7);
+	CHECK_NEAR(Tonemap::LinearToSRGB(0.5f), 1.055 * pow(0.5, 1.0 / 2.4) - 0.055, 1e-6);
+	for (float x = 0.0f; x <= 1.0f; x += 0.05f)
+		CHECK_NEAR(Tonemap::SRGBToLinear(Tonemap::LinearToSRGB(x)), x, 1e-5);
+
+	XMFLOAT3 pixel = Tonemap::TonemapPixel(XMFLOAT3(0.5f, 1.0f, 2.0f), 2.0f, Tonemap::TONEMAP_REINHARD);
+	CHECK_NEAR(pixel.x, Tonemap::LinearToSRGB(0.5f), 1e-6);
+	CHECK_NEAR(pixel.y, Tonemap::LinearToSRGB(2.0f / 3.0f), 1e-6);
+	CHECK_NEAR(pixel.z, Tonemap::LinearToSRGB(0.8f), 1e-6);
+}
+
+TEST(ExposureMapsTheAverageToTheKey)
+{
+	// A scene that already averages middle grey needs no change
+	CHECK_NEAR(Tonemap::ExposureFromAverageLogLuminance(logf(0.18f), 0.18f, 0.01f, 100.0f, 0.0f), 1.0f, 1e-5);
+	CHECK_NEAR(Tonemap::ExposureFromAverageLogLuminance(logf(0.045f), 0.18f, 0.01f, 100.0f, 0.0f), 4.0f, 1e-4);
+
+	// Clamped first, then offset by whole stops
+	CHECK_NEAR(Tonemap::ExposureFromAverageLogLuminance(logf(0.001f), 0.18f, 0.01f, 10.0f, 0.0f), 10.0f, 1e-5);
+	CHECK_NEAR(Tonemap::ExposureFromAverageLogLuminance(logf(0.001f), 0.18f, 0.01f, 10.0f, 1.0f), 20.0f, 1e-4);
+	CHECK_NEAR(Tonemap::ExposureFromAverageLogLuminance(logf(0.18f), 0.18f, 0.01f, 100.0f, -2.0f), 0.25f, 1e-5);
+
+	CHECK_NEAR(Tonemap::Luminance(XMFLOAT3(1, 1, 1)), 1.0f, 1e-6);
+}
@@ -0,0 +1,97 @@
+#include "TestFramework.h"
+#include "../VertexCompression.h"
+#include <random>
+
+using namespace DirectX;
+
+TEST(PackedVertexIs24Bytes)
+{
+	CHECK(sizeof(PackedVertex) == 24);
+}
+
+TEST(HalfRoundTripsExactValues)
+{
+	const float exact[] = { 0.0f, 1.0f, -2.5f, 0.5f, 1024.0f, 65504.0f, -65504.0f };
+	for (float f : exact)
+		CHECK(VertexCompression::HalfToFloat(VertexCompression::FloatToHalf(f)) == f);
+}
+
+TEST(HalfRoundsAndClamps)
+{
+	// 1 + 2^-11 is exactly halfway between two halfs; ties go to even
+	CHECK(VertexCompression::FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3C00);
+	CHECK(VertexCompression::FloatToHalf(1.0f + 3.0f / 2048.0f) == 0x3C02);
+
+	// Past the largest half goes to infinity, tiny values to a denormal
+	CHECK(VertexCompression::FloatToHalf(100000.0f) == 0x7C00);
+	CHECK(VertexCompression::FloatToHalf(-100000.0f) == 0xFC00);
+	CHECK(VertexCompression::FloatToHalf(ldexpf(1.0f, -24)) == 0x0001);
+	CHECK(VertexCompression::HalfToFloat(0x0001) == ldexpf(1.0f, -24));
+	CHECK(VertexCompression::FloatToHalf(1e-10f) == 0);
+}
+
+TEST(HalfRoundTripStaysWithinPrecision)
+{
+	for (float f = -4.0f; f <= 4.0f; f += 0.01f)
+	{
+		float back = VertexCompression::HalfToFloat(VertexCompression::FloatToHalf(f));
+		CHECK_NEAR(back, f, fmaxf(fabsf(f), 1.0f / 16384.0f) / 2048.0f);
+	}
+}
+
+TEST(OctahedralRoundTripsAxes)
+{
+	const XMFLOAT3 axes[] =
+	{
+		XMFLOAT3(1, 0, 0), XMFLOAT3(-1, 0, 0),
+		XMFLOAT3(0, 1, 0), XMFLOAT3(0, -1, 0),
+		XMFLOAT3(0, 0, 1), XMFLOAT3(0, 0, -1)
+	};
+	for (const XMFLOAT3& a : axes)
+	{
+		XMFLOAT3 b = VertexCompression::DecodeOctahedral(VertexCompression::EncodeOctahedral(a));
+		CHECK_NEAR(b.x, a.x, 1e-4);
+		CHECK_NEAR(b.y, a.y, 1e-4);
+		CHECK_NEAR(b.z, a.z, 1e-4);
+	}
+}
+
+TEST(RoundTripErrorIsSmall)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<Vertex> verts(10000);
+	for (Vertex& v : verts)
+	{
+		XMFLOAT3 n(unit(random), unit(random), unit(random));
+		float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+		if (len < 1e-3f)
+		{
+			n = XMFLOAT3(0, 1, 0);
+			len = 1.0f;
+		}
+		v.Normal = XMFLOAT3(n.x / len, n.y / len, n.z / len);
+		v.Tangent = XMFLOAT3(v.Normal.y, -v.Normal.x, v.Normal.z);
+		v.UV = XMFLOAT2(unit(random) + 1.0f, unit(random) + 1.0f);
+		v.Position = XMFLOAT3(unit(random) * 5.0f, unit(random) * 5.0f, unit(random) * 5.0f);
+	}
+
+	VertexCompression::RoundTripError error = VertexCompression::MeasureRoundTrip(verts.data(), (int)verts.size());
+	CHECK(error.MaxNormalDegrees < 0.05f);
+	CHECK(error.MaxTangentDegrees < 0.05f);
+	CHECK(error.MaxUV <= 1.0f / 2048.0f);
+	CHECK(error.MaxPosition16 < 10.0f * sqrtf(3.0f) / 65535.0f);
+}
+
+TEST(PackKeepsPositionsExact)
+{
+	Vertex v = {};
+	v.Position = XMFLOAT3(1.2345678f, -9876.54f, 3.0e-7f);
+	v.Normal = XMFLOAT3(0, 0, 1);
+	v.Tangent = XMFLOAT3(1, 0, 0);
+	Vertex u = VertexCompression::Unpack(VertexCompression::Pack(v));
+	CHECK(u.Position.x == v.Position.x);
+	CHECK(u.Position.y == v.Position.y);
+	CHECK(u.Position.z == v.Position.z);
+}
@@ -0,0 +1,71 @@
+#include "Tonemap.h"
+#include <cmath>
+
+float Tonemap::Luminance(DirectX::XMFLOAT3 color)
+{
+	return color.x * 0.2126f + color.y * 0.7152f + color.z * 0.0722f;
+}
+
+// --------------------------------------------------------
+// Standard "key value" auto exposure.  The average is a
+// geometric mean, so a few very bright pixels don't drag
+// the whole image dark
+// --------------------------------------------------------
+float Tonemap::ExposureFromAverageLogLuminance(float averageLogLuminance, float key, float minExposure, float maxExposure, float compensationEV)
+{
+	float averageLuminance = expf(averageLogLuminance);
+	float exposure = key / fmaxf(averageLuminance, 0.0001f);
+	exposure = fminf(fmaxf(exposure, minExposure), maxExposure);
+	return exposure * exp2f(compensationEV);
+}
+
+float Tonemap::Reinhard(float x)
+{
+	return x / (1.0f + x);
+}
+
+// --------------------------------------------------------
+// Krzysztof Narkowicz's fit of the ACES filmic curve
+// --------------------------------------------------------
+float Tonemap::ACESFilmic(float x)
+{
+	const float a = 2.51f;
+	const float b = 0.03f;
+	const float c = 2.43f;
+	const float d = 0.59f;
+	const float e = 0.14f;
+	float result = (x * (a * x + b)) / (x * (c * x + d) + e);
+	return fminf(fmaxf(result, 0.0f), 1.0f);
+}
+
+float Tonemap::Apply(Operator op, float x)
+{
+	switch (op)
+	{
+	case TONEMAP_REINHARD: return Reinhard(x);
+	case TONEMAP_ACES: return ACESFilmic(x);
+	default: return fminf(fmaxf(x, 0.0f), 1.0f);
+	}
+}
+
+float Tonemap::LinearToSRGB(float x)
+{
+	if (x <= 0.0031308f)
+		return x * 12.92f;
+	return 1.055f * powf(x, 1.0f / 2.4f) - 0.055f;
+}
+
+float Tonemap::SRGBToLinear(float x)
+{
+	if (x <= 0.04045f)
+		return x / 12.92f;
+	return powf((x + 0.055f) / 1.055f, 2.4f);
+}
+
+DirectX::XMFLOAT3 Tonemap::TonemapPixel(DirectX::XMFLOAT3 color, float exposure, Operator op)
+{
+	return DirectX::XMFLOAT3(
+		LinearToSRGB(Apply(op, color.x * exposure)),
+		LinearToSRGB(Apply(op, color.y * exposure)),
+		LinearToSRGB(Apply(op, color.z * exposure)));
+}
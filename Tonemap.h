@@ -0,0 +1,39 @@
+#pragma once
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// CPU versions of the exposure and tonemapping math used by
+// TonemapPS.hlsl.  The shader and these functions should
+// always agree, so any change to one belongs in the other
+// --------------------------------------------------------
+namespace Tonemap
+{
+	// Tonemapping operators (must match TONEMAP_* in TonemapPS.hlsl)
+	enum Operator
+	{
+		TONEMAP_NONE = 0,
+		TONEMAP_REINHARD = 1,
+		TONEMAP_ACES = 2
+	};
+
+	// Rec. 709 luminance of a linear color
+	float Luminance(DirectX::XMFLOAT3 color);
+
+	// Exposure that maps the scene's average luminance to the
+	// middle grey "key", clamped and then offset by some EV
+	//
+	// averageLogLuminance - Average of log(luminance) over the screen
+	float ExposureFromAverageLogLuminance(float averageLogLuminance, float key, float minExposure, float maxExposure, float compensationEV);
+
+	// Single channel curves
+	float Reinhard(float x);
+	float ACESFilmic(float x);
+	float Apply(Operator op, float x);
+
+	// sRGB transfer functions (the exact piecewise versions)
+	float LinearToSRGB(float x);
+	float SRGBToLinear(float x);
+
+	// Full per-pixel path: exposure, curve, then sRGB encode
+	DirectX::XMFLOAT3 TonemapPixel(DirectX::XMFLOAT3 color, float exposure, Operator op);
+}
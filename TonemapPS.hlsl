@@ -0,0 +1,88 @@
+// Must match Tonemap::Operator on the C++ side
+#define TONEMAP_NONE 0
+#define TONEMAP_REINHARD 1
+#define TONEMAP_ACES 2
+
+cbuffer ExternalData : register(b0)
+{
+    int tonemapOperator;
+    int autoExposure;
+    float manualExposure;
+    float exposureKey;
+    float minExposure;
+    float maxExposure;
+    float exposureCompensation; // In EV (stops)
+    float bloomIntensity;
+}
+
+// Defines the input to this pixel shader
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// Textures and such
+Texture2D PixelColors : register(t0); // Linear HDR scene
+Texture2D Luminance : register(t1);   // Small log luminance target
+Texture2D Bloom : register(t2);       // Top of the bloom upsample chain
+SamplerState BasicSampler : register(s0);
+
+// Krzysztof Narkowicz's fit of the ACES filmic curve
+float3 ACESFilmic(float3 x)
+{
+    const float a = 2.51f;
+    const float b = 0.03f;
+    const float c = 2.43f;
+    const float d = 0.59f;
+    const float e = 0.14f;
+    return saturate((x * (a * x + b)) / (x * (c * x + d) + e));
+}
+
+float3 LinearToSRGB(float3 x)
+{
+    float3 low = x * 12.92f;
+    float3 high = 1.055f * pow(abs(x), 1.0f / 2.4f) - 0.055f;
+    return (x <= 0.0031308f) ? low : high;
+}
+
+// Average log luminance of the whole screen, from a 4x4 grid
+// of bilinear taps over the already reduced luminance target
+float AverageLogLuminance()
+{
+    float total = 0;
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            float2 uv = (float2(x, y) + 0.5f) / 4.0f;
+            total += Luminance.SampleLevel(BasicSampler, uv, 0).r;
+        }
+    }
+    return total / 16;
+}
+
+// Entry point for this pixel shader
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    float3 color = PixelColors.Sample(BasicSampler, input.uv).rgb;
+    if (bloomIntensity > 0)
+        color += Bloom.Sample(BasicSampler, input.uv).rgb * bloomIntensity;
+
+    float exposure = manualExposure;
+    if (autoExposure)
+    {
+        float averageLuminance = exp(AverageLogLuminance());
+        exposure = clamp(exposureKey / max(averageLuminance, 0.0001f), minExposure, maxExposure);
+    }
+    color *= exposure * exp2(exposureCompensation);
+
+    switch (tonemapOperator)
+    {
+        case TONEMAP_REINHARD: color = color / (1 + color); break;
+        case TONEMAP_ACES: color = ACESFilmic(color); break;
+        default: color = saturate(color); break;
+    }
+
+    return float4(LinearToSRGB(color), 1);
+}
@@ -13,6 +13,7 @@ Transform::Transform()
 
     isMatrixDirty = false;
     isDirectionDirty = false;
+    version = 0;
 
     XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
     XMStoreFloat4x4(&worldInverseMatrix, XMMatrixIdentity());
@@ -52,6 +53,11 @@ DirectX::XMFLOAT3 Transform::GetFoward()
     return foward;
 }
 
+unsigned long long Transform::GetVersion()
+{
+    return version;
+}
+
 XMFLOAT4X4 Transform::GetWorldMatrix()
 {
     UpdateMatrices();
@@ -70,12 +76,14 @@ void Transform::SetPosition(float x, float y, float z)
     position.y = y;
     position.z = z;
     isMatrixDirty = true;
+    version++;
 }
 
 void Transform::SetPosition(DirectX::XMFLOAT3 pos)
 {
     this->position = pos;
     isMatrixDirty = true;
+    version++;
    
 }
 
@@ -85,6 +93,7 @@ void Transform::SetRotation(float pitch, float yaw, float roll)
     pitchYawRoll.y = yaw;
     pitchYawRoll.z = roll;
     isMatrixDirty = true;
+    version++;
     isDirectionDirty = true;
     
 }
@@ -100,13 +109,14 @@ void Transform::SetScale(float x, float y, float z)
     scale.y = y;
     scale.z = z;
     isMatrixDirty = true;
+    version++;
     
 
 }
 
 void Transform::SetScale(XMFLOAT3 scale)
 {
-    this->scale = scale;
+    SetScale(scale.x, scale.y, scale.z);
 }
 
 void Transform::MoveAbsolute(float x, float y, float z)
@@ -115,6 +125,7 @@ void Transform::MoveAbsolute(float x, float y, float z)
     position.y += y;
     position.z += z;
     isMatrixDirty = true;
+    version++;
 }
 
 void Transform::MoveAbsolute(XMFLOAT3 offset)
@@ -128,7 +139,8 @@ void Transform::MoveRelative(float x, float y, float z)
     XMVECTOR Qrot = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&pitchYawRoll));
     XMVECTOR dir = XMVector3Rotate(move, Qrot);
     XMStoreFloat3(&position, XMLoadFloat3(&position) + dir);
-    
+    isMatrixDirty = true;
+    version++;
 }
 
 void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
@@ -142,6 +154,7 @@ void Transform::Rotate(float pitch, float yaw, float roll)
     pitchYawRoll.y += yaw;
     pitchYawRoll.z += roll;
     isMatrixDirty = true;
+    version++;
     isDirectionDirty = true;
 }
 
@@ -151,6 +164,7 @@ void Transform::Rotate(XMFLOAT3 rotation)
     pitchYawRoll.y += rotation.y;
     pitchYawRoll.z += rotation.z;
     isMatrixDirty = true;
+    version++;
     isDirectionDirty = true;
 }
 
@@ -160,6 +174,7 @@ void Transform::Scale(float x, float y, float z)
     scale.y *= y;
     scale.z *= z;
     isMatrixDirty = true;
+    version++;
 }
 
 void Transform::Scale(XMFLOAT3 scaleBy)
@@ -17,6 +17,10 @@ class Transform
 		DirectX::XMFLOAT4X4 GetWorldMatrix();
 		DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
 
+		// Goes up every time the transform changes, so anything
+		// built from it can tell when it needs rebuilding
+		unsigned long long GetVersion();
+
 		//setters
 		void SetPosition(float x, float y, float z);
 		void SetPosition(DirectX::XMFLOAT3 pos);
@@ -52,6 +56,7 @@ class Transform
 
 		bool isMatrixDirty;
 		bool isDirectionDirty;
+		unsigned long long version;
 		DirectX::XMFLOAT4X4 worldMatrix;
 		DirectX::XMFLOAT4X4 worldInverseMatrix;
 
@@ -13,4 +13,25 @@ struct Vertex
 	DirectX::XMFLOAT2 UV;        // The uv of the vertex
 	DirectX::XMFLOAT3 Normal;	//the normal of the vertex
 	DirectX::XMFLOAT3 Tangent;
-};
\ No newline at end of file
+};
+
+// Which vertex buffer a draw reads from.  Depth only passes
+// just need positions, so they can skip the rest of the vertex
+enum class MeshStream
+{
+	Full,		// Interleaved PackedVertex (24 bytes)
+	Position	// Tightly packed XMFLOAT3 (12 bytes)
+};
+
+// --------------------------------------------------------
+// Compressed version of Vertex that actually goes to the GPU
+// (24 bytes instead of 44).  Decoded in VertexShader.hlsl,
+// see VertexCompression.h for the encoding
+// --------------------------------------------------------
+struct PackedVertex
+{
+	DirectX::XMFLOAT3 Position;	// Full precision, so depth only passes match exactly
+	unsigned int UV;		// Two halfs, u in the low 16 bits
+	unsigned int Normal;		// Octahedral, two snorm16s
+	unsigned int Tangent;		// Octahedral, two snorm16s
+};
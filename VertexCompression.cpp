@@ -0,0 +1,225 @@
+#include "VertexCompression.h"
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	float SignNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+	unsigned int ToSnorm16(float v)
+	{
+		v = fminf(fmaxf(v, -1.0f), 1.0f);
+		return (unsigned int)(short)lroundf(v * 32767.0f) & 0xFFFF;
+	}
+
+	float FromSnorm16(unsigned int bits)
+	{
+		return fmaxf((short)(bits & 0xFFFF) / 32767.0f, -1.0f);
+	}
+
+	float AngleDegrees(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		float lenA = sqrtf(a.x * a.x + a.y * a.y + a.z * a.z);
+		float lenB = sqrtf(b.x * b.x + b.y * b.y + b.z * b.z);
+		if (lenA == 0.0f || lenB == 0.0f)
+			return 0.0f;
+		float d = (a.x * b.x + a.y * b.y + a.z * b.z) / (lenA * lenB);
+		return acosf(fminf(fmaxf(d, -1.0f), 1.0f)) * 57.2957795f;
+	}
+}
+
+// --------------------------------------------------------
+// Projects the vector onto an octahedron, then folds the
+// bottom half over the top so it fits in a square
+// --------------------------------------------------------
+unsigned int VertexCompression::EncodeOctahedral(XMFLOAT3 v)
+{
+	float sum = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+	if (sum == 0.0f)
+		return 0;
+
+	float x = v.x / sum;
+	float y = v.y / sum;
+	if (v.z < 0.0f)
+	{
+		float fx = (1.0f - fabsf(y)) * SignNotZero(x);
+		float fy = (1.0f - fabsf(x)) * SignNotZero(y);
+		x = fx;
+		y = fy;
+	}
+	return ToSnorm16(x) | (ToSnorm16(y) << 16);
+}
+
+// --------------------------------------------------------
+// Same math as DecodeOctahedral() in ShaderInclude.hlsli
+// --------------------------------------------------------
+XMFLOAT3 VertexCompression::DecodeOctahedral(unsigned int packed)
+{
+	float x = FromSnorm16(packed);
+	float y = FromSnorm16(packed >> 16);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	float t = fmaxf(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	float len = sqrtf(x * x + y * y + z * z);
+	return XMFLOAT3(x / len, y / len, z / len);
+}
+
+unsigned short VertexCompression::FloatToHalf(float f)
+{
+	unsigned int bits;
+	memcpy(&bits, &f, sizeof(bits));
+
+	unsigned int sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	unsigned int mantissa = bits & 0x7FFFFF;
+
+	// NaN and infinity
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return (unsigned short)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+	// Too big, clamp to infinity
+	if (exponent >= 31)
+		return (unsigned short)(sign | 0x7C00);
+
+	// Too small for a normal half, so make a denormal (or zero)
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return (unsigned short)sign;
+		mantissa |= 0x800000;
+		unsigned int shift = (unsigned int)(14 - exponent);
+		unsigned int half = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+		return (unsigned short)(sign | half);
+	}
+
+	// Round to nearest even.  A carry out of the mantissa bumps
+	// the exponent, which is exactly what should happen
+	unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+	unsigned int rest = mantissa & 0x1FFF;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		half++;
+	return (unsigned short)(sign | half);
+}
+
+float VertexCompression::HalfToFloat(unsigned short h)
+{
+	unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+	unsigned int exponent = (h >> 10) & 0x1F;
+	unsigned int mantissa = h & 0x3FF;
+
+	unsigned int bits;
+	if (exponent == 0x1F)
+	{
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else if (exponent == 0)
+	{
+		// Zero or denormal
+		float value = ldexpf((float)mantissa, -24);
+		return (h & 0x8000) ? -value : value;
+	}
+	else
+	{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+unsigned int VertexCompression::PackHalf2(XMFLOAT2 v)
+{
+	return (unsigned int)FloatToHalf(v.x) | ((unsigned int)FloatToHalf(v.y) << 16);
+}
+
+XMFLOAT2 VertexCompression::UnpackHalf2(unsigned int packed)
+{
+	return XMFLOAT2(HalfToFloat(packed & 0xFFFF), HalfToFloat(packed >> 16));
+}
+
+void VertexCompression::QuantizePosition(XMFLOAT3 position, XMFLOAT3 boundsMin, XMFLOAT3 boundsMax, unsigned short out[3])
+{
+	float p[3] = { position.x, position.y, position.z };
+	float lo[3] = { boundsMin.x, boundsMin.y, boundsMin.z };
+	float hi[3] = { boundsMax.x, boundsMax.y, boundsMax.z };
+	for (int i = 0; i < 3; i++)
+	{
+		float extent = hi[i] - lo[i];
+		float t = extent > 0.0f ? (p[i] - lo[i]) / extent : 0.0f;
+		t = fminf(fmaxf(t, 0.0f), 1.0f);
+		out[i] = (unsigned short)lroundf(t * 65535.0f);
+	}
+}
+
+XMFLOAT3 VertexCompression::DequantizePosition(const unsigned short q[3], XMFLOAT3 boundsMin, XMFLOAT3 boundsMax)
+{
+	return XMFLOAT3(
+		boundsMin.x + q[0] / 65535.0f * (boundsMax.x - boundsMin.x),
+		boundsMin.y + q[1] / 65535.0f * (boundsMax.y - boundsMin.y),
+		boundsMin.z + q[2] / 65535.0f * (boundsMax.z - boundsMin.z));
+}
+
+PackedVertex VertexCompression::Pack(const Vertex& v)
+{
+	PackedVertex p = {};
+	p.Position = v.Position;
+	p.UV = PackHalf2(v.UV);
+	p.Normal = EncodeOctahedral(v.Normal);
+	p.Tangent = EncodeOctahedral(v.Tangent);
+	return p;
+}
+
+Vertex VertexCompression::Unpack(const PackedVertex& v)
+{
+	Vertex u = {};
+	u.Position = v.Position;
+	u.UV = UnpackHalf2(v.UV);
+	u.Normal = DecodeOctahedral(v.Normal);
+	u.Tangent = DecodeOctahedral(v.Tangent);
+	return u;
+}
+
+// --------------------------------------------------------
+// Packs and unpacks every vertex, keeping the worst error
+// for each attribute.  Cheap enough to run on every load
+// --------------------------------------------------------
+VertexCompression::RoundTripError VertexCompression::MeasureRoundTrip(const Vertex* verts, int count)
+{
+	RoundTripError error = {};
+	if (count <= 0)
+		return error;
+
+	XMFLOAT3 boundsMin = verts[0].Position;
+	XMFLOAT3 boundsMax = verts[0].Position;
+	for (int i = 1; i < count; i++)
+	{
+		boundsMin = XMFLOAT3(fminf(boundsMin.x, verts[i].Position.x), fminf(boundsMin.y, verts[i].Position.y), fminf(boundsMin.z, verts[i].Position.z));
+		boundsMax = XMFLOAT3(fmaxf(boundsMax.x, verts[i].Position.x), fmaxf(boundsMax.y, verts[i].Position.y), fmaxf(boundsMax.z, verts[i].Position.z));
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		Vertex u = Unpack(Pack(verts[i]));
+		error.MaxNormalDegrees = fmaxf(error.MaxNormalDegrees, AngleDegrees(verts[i].Normal, u.Normal));
+		error.MaxTangentDegrees = fmaxf(error.MaxTangentDegrees, AngleDegrees(verts[i].Tangent, u.Tangent));
+		error.MaxUV = fmaxf(error.MaxUV, fmaxf(fabsf(verts[i].UV.x - u.UV.x), fabsf(verts[i].UV.y - u.UV.y)));
+
+		unsigned short q[3];
+		QuantizePosition(verts[i].Position, boundsMin, boundsMax, q);
+		XMFLOAT3 p = DequantizePosition(q, boundsMin, boundsMax);
+		float dx = p.x - verts[i].Position.x;
+		float dy = p.y - verts[i].Position.y;
+		float dz = p.z - verts[i].Position.z;
+		error.MaxPosition16 = fmaxf(error.MaxPosition16, sqrtf(dx * dx + dy * dy + dz * dz));
+	}
+	return error;
+}
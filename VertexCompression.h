@@ -0,0 +1,43 @@
+#pragma once
+#include <DirectXMath.h>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Packing and unpacking for PackedVertex.  The decode side
+// mirrors the functions in ShaderInclude.hlsli so the error
+// the GPU sees can be measured on the CPU
+//  - Normals and tangents: octahedral encoding, 16 bits per axis
+//  - UVs: half precision floats
+//  - Positions: full floats on the GPU.  16 bit positions
+//    relative to the mesh bounds are available here to
+//    measure what they'd cost
+// --------------------------------------------------------
+namespace VertexCompression
+{
+	// Unit vector <-> two snorm16s (x in the low 16 bits)
+	unsigned int EncodeOctahedral(DirectX::XMFLOAT3 v);
+	DirectX::XMFLOAT3 DecodeOctahedral(unsigned int packed);
+
+	// IEEE half floats, rounding to nearest
+	unsigned short FloatToHalf(float f);
+	float HalfToFloat(unsigned short h);
+	unsigned int PackHalf2(DirectX::XMFLOAT2 v);
+	DirectX::XMFLOAT2 UnpackHalf2(unsigned int packed);
+
+	// Position <-> unorm16 per axis, relative to a bounding box
+	void QuantizePosition(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax, unsigned short out[3]);
+	DirectX::XMFLOAT3 DequantizePosition(const unsigned short q[3], DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax);
+
+	PackedVertex Pack(const Vertex& v);
+	Vertex Unpack(const PackedVertex& v);
+
+	// Worst case error of a full round trip over a set of vertices
+	struct RoundTripError
+	{
+		float MaxNormalDegrees;
+		float MaxTangentDegrees;
+		float MaxUV;
+		float MaxPosition16;	// World units, if positions were 16 bit
+	};
+	RoundTripError MeasureRoundTrip(const Vertex* verts, int count);
+}
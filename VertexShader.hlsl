@@ -1,20 +1,17 @@
 #include "ShaderInclude.hlsli"
 #include "LightsInclude.hlsli"
+#include "CameraInclude.hlsli"
 
 cbuffer ExternalData : register(b0)
 {
     matrix world;
     matrix worldInvTranspose;
-    matrix view;
-    matrix projection;
-	
-    matrix lightView;
-    matrix lightProjection;
 }
 
 
 
 
+
 // Struct representing a single vertex worth of data
 // - This should match the vertex definition in our C++ code
 // - By "match", I mean the size, order and number of members
@@ -42,16 +39,13 @@ VertexToPixel main( VertexShaderInput input )
 	// - Each of these components is then automatically divided by the W component, 
 	//   which we're leaving at 1.0 for now (this is more useful when dealing with 
 	//   a perspective projection matrix, which we'll get to in the future).
-    matrix wvp = mul(projection, mul(view, world));
-    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+    // Must stay the same math as DepthPrepassVS.hlsl (see CameraInclude.hlsli)
+    output.screenPosition = LocalToClip(world, input.localPosition, output.worldPos);
 	
-    output.uv = input.uv;
-    output.normal = normalize(mul((float3x3)worldInvTranspose, input.normal));
-    output.tangent = normalize(mul((float3x3) world, input.tangent));
-    output.worldPos = mul(world, float4(input.localPosition, 1.0f)).xyz;
-   
-    matrix shadowWVP = mul(lightProjection, mul(lightView, world));
-    output.shadowMapPos = mul(shadowWVP, float4(input.localPosition, 1.0f));
+    // Attributes come in compressed (see PackedVertex in Vertex.h)
+    output.uv = DecodeHalf2(input.uv);
+    output.normal = normalize(mul((float3x3)worldInvTranspose, DecodeOctahedral(input.normal)));
+    output.tangent = normalize(mul((float3x3) world, DecodeOctahedral(input.tangent)));
 
 
 	// Whatever we return will make its way through the pipeline to the
@@ -260,6 +260,8 @@ void Window::CreateConsoleWindow(int bufferLines, int bufferColumns, int windowL
 // --------------------------------------------------------
 LRESULT Window::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
+	// Input sees everything first, so nothing goes missing from its queue
+	Input::ProcessMessage(uMsg, wParam, lParam);
 	if (ImGui_ImplWin32_WndProcHandler(hWnd, uMsg, wParam, lParam))
 		return true;
 	// Check the incoming message and handle any we care about
@@ -300,9 +302,8 @@ LRESULT Window::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 
 		return 0;
 
-		// Has the mouse wheel been scrolled?
+		// Has the mouse wheel been scrolled?  (Input has already queued it)
 	case WM_MOUSEWHEEL:
-		Input::SetWheelDelta(GET_WHEEL_DELTA_WPARAM(wParam) / (float)WHEEL_DELTA);
 		return 0;
 
 		// Is our focus state changing?